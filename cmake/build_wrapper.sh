@@ -0,0 +1,28 @@
+#!/bin/sh -e
+# This is used for renaming symbols for the fat runtime, don't call directly.
+#
+# usage: build_wrapper.sh <prefix> <keep.syms> <compile command...>
+#
+# Runs the compile command, then renames every global symbol in the resulting
+# object (defined or referenced) to <prefix>_<symbol>, except for those that
+# match a pattern in <keep.syms> or are exported by libc.
+PREFIX=$1
+KEEPSYMS_IN=$2
+shift 2
+OUT=$(echo "$@" | sed 's/.* -o \([^ ]*\.o\).*/\1/')
+SYMSFILE=$(mktemp "${TMPDIR:-/tmp}/${PREFIX}_rename.syms.XXXXXX")
+KEEPSYMS=$(mktemp "${TMPDIR:-/tmp}/keep.syms.XXXXXX")
+trap 'rm -f "${SYMSFILE}" "${KEEPSYMS}"' EXIT
+# find me a libc; the first word of the command is the compiler
+LIBC_SO=$($1 --print-file-name=libc.so.6)
+grep -v '^#' "${KEEPSYMS_IN}" > "${KEEPSYMS}"
+# get all symbols from libc and turn them into patterns
+nm -f p -g -D "${LIBC_SO}" | sed 's/\([^ @]*\).*/^\1$/' >> "${KEEPSYMS}"
+# build the object
+"$@"
+# rename the symbols in the object
+nm -f p -g "${OUT}" | cut -f1 -d' ' | grep -v -f "${KEEPSYMS}" \
+    | sed -e "s/\(.*\)/\1 ${PREFIX}_\1/" > "${SYMSFILE}" || true
+if test -s "${SYMSFILE}"; then
+    objcopy --redefine-syms="${SYMSFILE}" "${OUT}"
+fi
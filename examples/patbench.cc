@@ -53,6 +53,10 @@
  * stream state size (only available in streaming mode), compile time and
  * bytecode size respectively.
  *
+ * The -M flag counts matches per pattern with hs_scan_count() and friends
+ * rather than delivering each match to a callback, so that the cost of the
+ * two approaches can be compared on the same pattern set.
+ *
  * This utility will also not produce good results if all the patterns are
  * roughly equally expensive.
  *
@@ -275,7 +279,16 @@ private:
 
     // Count of matches found while scanning
     size_t matchCount = 0;
+
+    // If set, matches are counted per pattern with the counting scan
+    // functions rather than with a callback
+    bool countMode = false;
+
+    // Per-pattern match counts, used in count mode
+    vector<unsigned long long> counts;
 public:
+    explicit Benchmark(bool count_mode) : countMode(count_mode) {}
+
     ~Benchmark() {
         hs_free_scratch(scratch);
         hs_free_database(db);
@@ -293,6 +306,16 @@ public:
             cerr << "ERROR: could not allocate scratch space. Exiting." << endl;
             exit(-1);
         }
+        if (countMode) {
+            unsigned int counterCount;
+            err = hs_counter_size(db, &counterCount);
+            if (err != HS_SUCCESS) {
+                cerr << "ERROR: could not query counter size. Exiting."
+                     << endl;
+                exit(-1);
+            }
+            counts.assign(counterCount, 0);
+        }
     }
     const hs_database_t *getDatabase() const {
         return db;
@@ -355,12 +378,17 @@ public:
 
     // Return the number of matches found.
     size_t matches() const {
-        return matchCount;
+        size_t sum = matchCount;
+        for (const auto &count : counts) {
+            sum += count;
+        }
+        return sum;
     }
 
     // Clear the number of matches found.
     void clearMatches() {
         matchCount = 0;
+        std::fill(counts.begin(), counts.end(), 0);
     }
 
     // Open a Hyperscan stream for each stream in stream_ids
@@ -379,8 +407,9 @@ public:
     // end-anchored matches)
     void closeStreams() {
         for (auto &stream : streams) {
-            hs_error_t err =
-                hs_close_stream(stream, scratch, onMatch, &matchCount);
+            hs_error_t err = countMode
+                ? hs_close_stream_count(stream, scratch, counts.data())
+                : hs_close_stream(stream, scratch, onMatch, &matchCount);
             if (err != HS_SUCCESS) {
                 cerr << "ERROR: Unable to close stream. Exiting." << endl;
                 exit(-1);
@@ -393,9 +422,16 @@ public:
     void scanStreams() {
         for (size_t i = 0; i != packets.size(); ++i) {
             const std::string &pkt = packets[i];
-            hs_error_t err = hs_scan_stream(streams[stream_ids[i]],
-                                            pkt.c_str(), pkt.length(), 0,
-                                            scratch, onMatch, &matchCount);
+            hs_error_t err;
+            if (countMode) {
+                err = hs_scan_stream_count(streams[stream_ids[i]],
+                                           pkt.c_str(), pkt.length(), 0,
+                                           scratch, counts.data());
+            } else {
+                err = hs_scan_stream(streams[stream_ids[i]], pkt.c_str(),
+                                     pkt.length(), 0, scratch, onMatch,
+                                     &matchCount);
+            }
             if (err != HS_SUCCESS) {
                 cerr << "ERROR: Unable to scan packet. Exiting." << endl;
                 exit(-1);
@@ -408,8 +444,14 @@ public:
     void scanBlock() {
         for (size_t i = 0; i != packets.size(); ++i) {
             const std::string &pkt = packets[i];
-            hs_error_t err = hs_scan(db, pkt.c_str(), pkt.length(), 0,
-                                     scratch, onMatch, &matchCount);
+            hs_error_t err;
+            if (countMode) {
+                err = hs_scan_count(db, pkt.c_str(), pkt.length(), 0, scratch,
+                                    counts.data());
+            } else {
+                err = hs_scan(db, pkt.c_str(), pkt.length(), 0, scratch,
+                              onMatch, &matchCount);
+            }
             if (err != HS_SUCCESS) {
                 cerr << "ERROR: Unable to scan packet. Exiting." << endl;
                 exit(-1);
@@ -502,13 +544,15 @@ static
 void usage(const char *) {
     cerr << "Usage:" << endl << endl;
     cerr << "  patbench [-n repeats] [ -G generations] [ -C criterion ]" << endl
-         << "           [ -F factor_group_size ] [ -N | -S ] "
+         << "           [ -F factor_group_size ] [ -N | -S ] [ -M ] "
          << "<pattern file> <pcap file>" << endl << endl
          << "    -n repeats sets the number of times the PCAP is repeatedly "
             "scanned" << endl << "       with the pattern." << endl
          << "    -G generations sets the number of generations that the "
             "algorithm is" << endl << "       run for." << endl
          << "    -N sets non-streaming mode, -S sets streaming mode (default)."
+         << endl << "    -M counts matches per pattern with the counting scan "
+                    "functions" << endl << "       instead of a match callback."
          << endl << "    -F sets the factor group size (must be >0); this "
                     "allows the detection" << endl
          << "       of multiple interacting factors." << endl << "" << endl
@@ -612,9 +656,10 @@ int main(int argc, char **argv) {
     Criterion criterion = CRITERION_THROUGHPUT;
     unsigned int gen_max = 10;
     unsigned int factor_max = 1;
+    bool countMode = false;
     // Process command line arguments.
     int opt;
-    while ((opt = getopt(argc, argv, "SNn:G:F:C:")) != -1) {
+    while ((opt = getopt(argc, argv, "SNMn:G:F:C:")) != -1) {
         switch (opt) {
         case 'F':
             factor_max = atoi(optarg);
@@ -628,6 +673,9 @@ int main(int argc, char **argv) {
         case 'N':
             mode = HS_MODE_NOSTREAM;
             break;
+        case 'M':
+            countMode = true;
+            break;
         case 'C':
             switch (optarg[0]) {
             case 't':
@@ -669,7 +717,7 @@ int main(int argc, char **argv) {
     const char *pcapFile = argv[optind + 1];
 
     // Read our input PCAP file in
-    Benchmark bench;
+    Benchmark bench(countMode);
     if (criterion == CRITERION_THROUGHPUT) {
         if (!bench.readStreams(pcapFile)) {
             cerr << "Unable to read packets from PCAP file. Exiting." << endl;
@@ -693,6 +741,9 @@ int main(int argc, char **argv) {
     } else {
         cout << "\tMode: block";
     }
+    if (countMode) {
+        cout << "\tMatches: counted";
+    }
     cout << endl;
 
     Sigdata sigs(patternFile);
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Per-scan work budget.
+ *
+ * The budget set with hs_set_scratch_budget() is checked at a few cheap
+ * points in the scan: in the literal callbacks, between engine runs during
+ * catch-up, at each engine queue run and as matches are reported. When it runs
+ * out, core_info.broken is set to BROKEN_BUDGET, which makes the scan unwind
+ * in the same way as a user termination.
+ *
+ * The timestamp counter is only read once every BUDGET_CHECK_INTERVAL events,
+ * to keep the cost of the checks down.
+ */
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include "scratch.h"
+#include "ue2common.h"
+
+#if defined(HAVE_C_X86INTRIN_H)
+#include <x86intrin.h>
+#elif defined(HAVE_C_INTRIN_H)
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** \brief Number of budget events between reads of the timestamp counter. */
+#define BUDGET_CHECK_INTERVAL 64
+
+/** \brief Value of the per-scan literal limit when there is no limit. There
+ * is no deadline when it is zero, so that a zeroed scratch (as mocked up by
+ * engine unit tests) is never stopped. */
+#define BUDGET_UNLIMITED (~0ULL)
+
+/** \brief Disable the budget checks, for scans that are not limited such as
+ * the end of data processing in hs_close_stream(). */
+static really_inline
+void budgetDisable(struct hs_scratch *s) {
+    struct scan_budget *b = &s->budget;
+    b->literal_limit = BUDGET_UNLIMITED;
+    b->deadline = 0;
+}
+
+/** \brief Arm the budget at the start of a block scan or stream write. */
+static really_inline
+void budgetStart(struct hs_scratch *s) {
+    struct scan_budget *b = &s->budget;
+    b->literals = 0;
+    b->ticks = 0;
+    b->literal_limit = b->max_literals ? b->max_literals : BUDGET_UNLIMITED;
+    b->deadline = b->max_cycles ? __rdtsc() + b->max_cycles : 0;
+}
+
+/** \brief Stop the scan at absolute \a offset; always returns 1. */
+static really_inline
+char budgetStop(struct hs_scratch *s, u64a offset) {
+    DEBUG_PRINTF("scan budget exceeded at offset %llu\n", offset);
+    s->budget.offset = offset;
+    s->core_info.broken = BROKEN_BUDGET;
+    return 1;
+}
+
+/** \brief Account for a unit of work at absolute \a offset, checking the
+ * deadline periodically. Returns 1 if the scan must stop. */
+static really_inline
+char budgetTick(struct hs_scratch *s, u64a offset) {
+    struct scan_budget *b = &s->budget;
+    if (likely(++b->ticks < BUDGET_CHECK_INTERVAL)) {
+        return 0;
+    }
+    b->ticks = 0;
+    if (!b->deadline || __rdtsc() < b->deadline) {
+        return 0;
+    }
+    return budgetStop(s, offset);
+}
+
+/** \brief Account for a Rose literal match ending at absolute \a offset.
+ * Returns 1 if the scan must stop. */
+static really_inline
+char budgetLiteral(struct hs_scratch *s, u64a offset) {
+    struct scan_budget *b = &s->budget;
+    if (unlikely(++b->literals > b->literal_limit)) {
+        return budgetStop(s, offset);
+    }
+    return budgetTick(s, offset);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* BUDGET_H */
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Compile cache: artefacts from earlier compiles, reused by later ones.
+ */
+#include "compile_cache.h"
+
+#include "compiler/compiler.h"
+#include "nfa/nfa_internal.h"
+#include "nfa/rdfa.h"
+#include "nfagraph/ng_holder.h"
+#include "nfagraph/ng_util.h"
+#include "util/charreach.h"
+#include "util/container.h"
+#include "util/make_unique.h"
+#include "util/report.h"
+#include "util/report_manager.h"
+#include "util/verify_types.h"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+using namespace std;
+
+namespace ue2 {
+
+namespace {
+
+/** \brief Builds an exact, byte-string encoding of the inputs to a
+ * construction, for use as a cache key. */
+class KeyBuilder {
+public:
+    explicit KeyBuilder(char type) : key(1, type) {}
+
+    void add(u64a v) {
+        key.append(reinterpret_cast<const char *>(&v), sizeof(v));
+    }
+
+    void add(const CharReach &cr) {
+        u64a words[4] = {0, 0, 0, 0};
+        for (size_t c = cr.find_first(); c != CharReach::npos;
+             c = cr.find_next(c)) {
+            words[c / 64] |= 1ULL << (c % 64);
+        }
+        for (const auto &w : words) {
+            add(w);
+        }
+    }
+
+    void add(const vector<vector<CharReach>> &seqs) {
+        add(seqs.size());
+        for (const auto &seq : seqs) {
+            add(seq.size());
+            for (const auto &cr : seq) {
+                add(cr);
+            }
+        }
+    }
+
+    void add(const Report &ir) {
+        add(ir.type);
+        add(ir.quashSom);
+        add(ir.minOffset);
+        add(ir.maxOffset);
+        add(ir.minLength);
+        add(ir.ekey);
+        add((u32)ir.offsetAdjust);
+        add(ir.onmatch);
+        add(ir.revNfaIndex);
+        add(ir.somDistance);
+        add(ir.topSquashDistance);
+    }
+
+    /** Encodes the graph in vertex index order; graphs that are equal but
+     * numbered differently will simply produce different keys. The full
+     * report structure is included when a report manager is in use, as
+     * construction may depend on it (e.g. for highlander squashing). */
+    void add(const NGHolder &g, const ReportManager *rm) {
+        add(g.kind);
+        add(num_vertices(g));
+
+        vector<NFAVertex> verts;
+        verts.reserve(num_vertices(g));
+        insert(&verts, verts.end(), vertices(g));
+        sort(verts.begin(), verts.end(), make_index_ordering(g));
+
+        vector<tuple<u32, u32, u32>> succs;
+        for (auto v : verts) {
+            add(g[v].index);
+            add(g[v].char_reach);
+            add(g[v].assert_flags);
+
+            add(g[v].reports.size());
+            for (ReportID id : g[v].reports) {
+                add(id);
+                if (rm) {
+                    add(rm->getReport(id));
+                }
+            }
+
+            succs.clear();
+            for (const auto &e : out_edges_range(v, g)) {
+                succs.emplace_back(g[target(e, g)].index, g[e].top,
+                                   g[e].assert_flags);
+            }
+            sort(succs.begin(), succs.end());
+            add(succs.size());
+            for (const auto &s : succs) {
+                add(get<0>(s));
+                add(get<1>(s));
+                add(get<2>(s));
+            }
+        }
+    }
+
+    string key;
+};
+
+} // namespace
+
+string nfaCacheKey(const NGHolder &g, const ReportManager *rm,
+                   const map<u32, u32> &fixed_depth_tops,
+                   const map<u32, vector<vector<CharReach>>> &triggers,
+                   bool compress_state) {
+    if (!generates_callbacks(g)) {
+        rm = nullptr;
+    }
+
+    KeyBuilder kb('N');
+    kb.add(g, rm);
+    kb.add(fixed_depth_tops.size());
+    for (const auto &m : fixed_depth_tops) {
+        kb.add(m.first);
+        kb.add(m.second);
+    }
+    kb.add(triggers.size());
+    for (const auto &m : triggers) {
+        kb.add(m.first);
+        kb.add(m.second);
+    }
+    kb.add(compress_state);
+    return move(kb.key);
+}
+
+string dfaCacheKey(const NGHolder &g, const ReportManager *rm,
+                   bool single_trigger,
+                   const vector<vector<CharReach>> &triggers,
+                   bool finalChance) {
+    if (!generates_callbacks(g)) {
+        rm = nullptr;
+    }
+
+    KeyBuilder kb('D');
+    kb.add(g, rm);
+    kb.add(single_trigger);
+    kb.add(triggers);
+    kb.add(finalChance);
+    return move(kb.key);
+}
+
+static
+string expressionKey(const char *expression, unsigned flags,
+                     const hs_expr_ext *ext) {
+    KeyBuilder kb('E');
+    kb.add(flags);
+    if (ext) {
+        kb.add(ext->flags);
+        if (ext->flags & HS_EXT_FLAG_MIN_OFFSET) {
+            kb.add(ext->min_offset);
+        }
+        if (ext->flags & HS_EXT_FLAG_MAX_OFFSET) {
+            kb.add(ext->max_offset);
+        }
+        if (ext->flags & HS_EXT_FLAG_MIN_LENGTH) {
+            kb.add(ext->min_length);
+        }
+    } else {
+        kb.add(0);
+    }
+    kb.key.append(expression);
+    return move(kb.key);
+}
+
+static
+aligned_unique_ptr<NFA> copyNfa(const NFA *nfa) {
+    if (!nfa) {
+        return nullptr;
+    }
+    auto rv = aligned_zmalloc_unique<NFA>(nfa->length);
+    memcpy(rv.get(), nfa, nfa->length);
+    return rv;
+}
+
+static
+unique_ptr<raw_dfa> copyDfa(const raw_dfa *rdfa) {
+    if (!rdfa) {
+        return nullptr;
+    }
+    return ue2::make_unique<raw_dfa>(*rdfa);
+}
+
+CompileCache::CompileCache() {
+    memset(&counts, 0, sizeof(counts));
+}
+
+CompileCache::~CompileCache() = default;
+
+void CompileCache::clear() {
+    expressions.clear();
+    nfas.clear();
+    dfas.clear();
+}
+
+bool CompileCache::startCompile(const CompileContext &cc) {
+    lock_guard<mutex> guard(lock);
+    if (in_use) {
+        return false;
+    }
+    in_use = true;
+
+    if (have_context && (streaming != cc.streaming || vectored != cc.vectored
+                         || !(target == cc.target_info))) {
+        DEBUG_PRINTF("mode or platform changed, dropping cache\n");
+        clear();
+    }
+    have_context = true;
+    streaming = cc.streaming;
+    vectored = cc.vectored;
+    target = cc.target_info;
+
+    generation++;
+    memset(&counts, 0, sizeof(counts));
+    return true;
+}
+
+template<class Map>
+static
+void evictUnused(Map &m, u32 generation) {
+    for (auto it = m.begin(); it != m.end();) {
+        if (it->second.generation != generation) {
+            it = m.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CompileCache::finishCompile(bool success) {
+    lock_guard<mutex> guard(lock);
+    assert(in_use);
+    in_use = false;
+
+    if (success) {
+        evictUnused(expressions, generation);
+        evictUnused(nfas, generation);
+        evictUnused(dfas, generation);
+    }
+}
+
+unique_ptr<ParsedExpression>
+CompileCache::findExpression(unsigned index, const char *expression,
+                             unsigned flags, const hs_expr_ext *ext,
+                             ReportID id) {
+    const string key = expressionKey(expression, flags, ext);
+
+    lock_guard<mutex> guard(lock);
+    auto it = expressions.find(key);
+    if (it == expressions.end()) {
+        counts.expression_misses++;
+        return nullptr;
+    }
+    counts.expression_hits++;
+    it->second.generation = generation;
+    return ue2::make_unique<ParsedExpression>(*it->second.value, index, id);
+}
+
+void CompileCache::addExpression(const char *expression, unsigned flags,
+                                 const hs_expr_ext *ext,
+                                 const ParsedExpression &expr) {
+    string key = expressionKey(expression, flags, ext);
+    auto copy = ue2::make_unique<ParsedExpression>(expr, expr.index, expr.id);
+
+    lock_guard<mutex> guard(lock);
+    auto &entry = expressions[move(key)];
+    entry.value = move(copy);
+    entry.generation = generation;
+}
+
+bool CompileCache::findNfa(const string &key, aligned_unique_ptr<NFA> *nfa) {
+    lock_guard<mutex> guard(lock);
+    auto it = nfas.find(key);
+    if (it == nfas.end()) {
+        counts.engine_misses++;
+        return false;
+    }
+    counts.engine_hits++;
+    it->second.generation = generation;
+    *nfa = copyNfa(it->second.value.get());
+    return true;
+}
+
+void CompileCache::addNfa(const string &key, const NFA *nfa) {
+    auto copy = copyNfa(nfa);
+
+    lock_guard<mutex> guard(lock);
+    auto &entry = nfas[key];
+    entry.value = move(copy);
+    entry.generation = generation;
+}
+
+bool CompileCache::findDfa(const string &key, unique_ptr<raw_dfa> *rdfa) {
+    lock_guard<mutex> guard(lock);
+    auto it = dfas.find(key);
+    if (it == dfas.end()) {
+        counts.engine_misses++;
+        return false;
+    }
+    counts.engine_hits++;
+    it->second.generation = generation;
+    *rdfa = copyDfa(it->second.value.get());
+    return true;
+}
+
+void CompileCache::addDfa(const string &key, const raw_dfa *rdfa) {
+    auto copy = copyDfa(rdfa);
+
+    lock_guard<mutex> guard(lock);
+    auto &entry = dfas[key];
+    entry.value = move(copy);
+    entry.generation = generation;
+}
+
+hs_compile_cache_stats_t CompileCache::stats() const {
+    lock_guard<mutex> guard(lock);
+    hs_compile_cache_stats_t rv = counts;
+    rv.expressions_cached = verify_u32(expressions.size());
+    rv.engines_cached = verify_u32(nfas.size() + dfas.size());
+    return rv;
+}
+
+} // namespace ue2
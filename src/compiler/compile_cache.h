@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Compile cache: artefacts from earlier compiles, reused by later ones.
+ *
+ * A cache holds two kinds of artefact:
+ *
+ *  - parsed expressions, after component tree optimisation, keyed by the
+ *    expression text, flags and extended parameters;
+ *  - engines built from NFA graphs (LimEx NFAs and McClellan raw DFAs),
+ *    keyed by an exact encoding of the graph and of every other input that
+ *    the construction depends on.
+ *
+ * Everything else in a compile depends on the pattern set as a whole and is
+ * always rebuilt. Failed engine constructions are cached too, as these are
+ * often the most expensive (e.g. a determinisation that hits the state
+ * limit).
+ *
+ * The mode, platform and grey box of a compile are not part of the keys;
+ * instead, the cache is emptied when a compile arrives with a different mode
+ * or platform from the one before. Callers must always use the same Grey with
+ * a given cache.
+ */
+
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include "hs_compile.h"
+#include "ue2common.h"
+#include "util/alloc.h"
+#include "util/compile_context.h"
+#include "util/target_info.h"
+#include "util/ue2_containers.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+struct NFA;
+
+namespace ue2 {
+
+class CharReach;
+class NGHolder;
+class ParsedExpression;
+class ReportManager;
+struct raw_dfa;
+
+/**
+ * \brief Store of compile artefacts shared between successive compiles.
+ *
+ * Lookups and insertions are thread-safe, so engines built in parallel may
+ * use the cache directly; a cache may only be used by one compile at a time,
+ * however, which is enforced by \ref startCompile.
+ */
+class CompileCache : boost::noncopyable {
+public:
+    CompileCache();
+    ~CompileCache();
+
+    /**
+     * \brief Marks the start of a compile using this cache.
+     *
+     * Returns false if the cache is already in use by another compile.
+     * Otherwise the per-compile statistics are reset, and the cache is
+     * emptied if the mode or platform differs from those of the previous
+     * compile.
+     */
+    bool startCompile(const CompileContext &cc);
+
+    /**
+     * \brief Marks the end of a compile using this cache.
+     *
+     * After a successful compile, any artefacts that it did not use are
+     * evicted, so that the cache tracks the pattern set as it changes rather
+     * than growing without bound.
+     */
+    void finishCompile(bool success);
+
+    /** \brief Returns a copy of a cached parsed expression for the given
+     * input, with its index and ID replaced, or nullptr on a miss. */
+    std::unique_ptr<ParsedExpression>
+    findExpression(unsigned index, const char *expression, unsigned flags,
+                   const hs_expr_ext *ext, ReportID id);
+
+    /** \brief Adds a parsed expression (which must not yet have been used to
+     * build a graph) to the cache. */
+    void addExpression(const char *expression, unsigned flags,
+                       const hs_expr_ext *ext, const ParsedExpression &expr);
+
+    /** \brief Looks up an NFA engine. On a hit, returns true and places a copy
+     * of the engine (which may be nullptr, if construction failed) in
+     * \a nfa. */
+    bool findNfa(const std::string &key, aligned_unique_ptr<NFA> *nfa);
+
+    /** \brief Adds an NFA engine, or nullptr for a failed construction. */
+    void addNfa(const std::string &key, const NFA *nfa);
+
+    /** \brief Looks up a raw DFA. On a hit, returns true and places a copy of
+     * the DFA (which may be nullptr, if construction failed) in \a rdfa. */
+    bool findDfa(const std::string &key, std::unique_ptr<raw_dfa> *rdfa);
+
+    /** \brief Adds a raw DFA, or nullptr for a failed construction. */
+    void addDfa(const std::string &key, const raw_dfa *rdfa);
+
+    /** \brief Statistics for the most recent compile. */
+    hs_compile_cache_stats_t stats() const;
+
+private:
+    template<class T>
+    struct Entry {
+        T value;
+        u32 generation; //!< last compile that used this entry
+    };
+
+    void clear();
+
+    mutable std::mutex lock;
+
+    bool in_use = false;
+    bool have_context = false;
+    bool streaming = false;
+    bool vectored = false;
+    target_t target{hs_platform_info()};
+
+    /** \brief Incremented by each compile using the cache. */
+    u32 generation = 0;
+
+    ue2::unordered_map<std::string, Entry<std::unique_ptr<ParsedExpression>>>
+        expressions;
+    ue2::unordered_map<std::string, Entry<aligned_unique_ptr<NFA>>> nfas;
+    ue2::unordered_map<std::string, Entry<std::unique_ptr<raw_dfa>>> dfas;
+
+    hs_compile_cache_stats_t counts;
+};
+
+/** \brief Holds a compile cache (if any) for the lifetime of a compile; the
+ * compile is treated as failed unless \ref succeeded is called. */
+class CompileCacheScope : boost::noncopyable {
+public:
+    explicit CompileCacheScope(CompileCache *cache_in) : cache(cache_in) {}
+    ~CompileCacheScope() {
+        if (cache) {
+            cache->finishCompile(success);
+        }
+    }
+    void succeeded() { success = true; }
+
+private:
+    CompileCache *cache;
+    bool success = false;
+};
+
+/** \brief Key for the NFA built by \ref constructNFA for these inputs. */
+std::string
+nfaCacheKey(const NGHolder &g, const ReportManager *rm,
+            const std::map<u32, u32> &fixed_depth_tops,
+            const std::map<u32, std::vector<std::vector<CharReach>>> &triggers,
+            bool compress_state);
+
+/** \brief Key for the raw DFA built by \ref buildMcClellan for these
+ * inputs. */
+std::string dfaCacheKey(const NGHolder &g, const ReportManager *rm,
+                        bool single_trigger,
+                        const std::vector<std::vector<CharReach>> &triggers,
+                        bool finalChance);
+
+} // namespace ue2
+
+/** \brief The public compile cache handle, \ref hs_compile_cache_t. */
+struct hs_compile_cache {
+    ue2::CompileCache cache;
+};
+
+#endif
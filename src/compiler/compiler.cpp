@@ -30,6 +30,7 @@
  * \brief Compiler front-end interface.
  */
 #include "asserts.h"
+#include "compile_cache.h"
 #include "compiler.h"
 #include "database.h"
 #include "grey.h"
@@ -57,8 +58,11 @@
 #include "rose/rose_build_dump.h"
 #include "som/slot_manager_dump.h"
 #include "util/alloc.h"
+#include "util/compile_context.h"
 #include "util/compile_error.h"
+#include "util/make_unique.h"
 #include "util/target_info.h"
+#include "util/ue2string.h"
 #include "util/verify_types.h"
 
 #include <algorithm>
@@ -177,6 +181,20 @@ ParsedExpression::ParsedExpression(unsigned index_in, const char *expression,
     }
 }
 
+ParsedExpression::ParsedExpression(const ParsedExpression &other,
+                                   unsigned index_in, ReportID actionId)
+    : utf8(other.utf8),
+      component(other.component->clone()),
+      allow_vacuous(other.allow_vacuous),
+      highlander(other.highlander),
+      prefilter(other.prefilter),
+      som(other.som),
+      index(index_in),
+      id(actionId),
+      min_offset(other.min_offset),
+      max_offset(other.max_offset),
+      min_length(other.min_length) {}
+
 #if defined(DUMP_SUPPORT) || defined(DEBUG)
 /**
  * \brief Dumps the parse tree to screen in debug mode and to disk in dump
@@ -219,10 +237,11 @@ void optimise(ParsedExpression &expr) {
     expr.component->optimise(true /* root is connected to sds */);
 }
 
-void addExpression(NG &ng, unsigned index, const char *expression,
-                   unsigned flags, const hs_expr_ext *ext, ReportID id) {
+unique_ptr<ParsedExpression>
+parseExpression(const CompileContext &cc, unsigned index,
+                const char *expression, unsigned flags,
+                const hs_expr_ext *ext, ReportID id) {
     assert(expression);
-    const CompileContext &cc = ng.cc;
     DEBUG_PRINTF("index=%u, id=%u, flags=%u, expr='%s'\n", index, id, flags,
                  expression);
 
@@ -231,30 +250,56 @@ void addExpression(NG &ng, unsigned index, const char *expression,
         throw CompileError("Pattern length exceeds limit.");
     }
 
+    if (cc.cache) {
+        auto cached = cc.cache->findExpression(index, expression, flags, ext,
+                                               id);
+        if (cached) {
+            DEBUG_PRINTF("using cached expression\n");
+            return cached;
+        }
+    }
+
     // Do per-expression processing: errors here will result in an exception
     // being thrown up to our caller
-    ParsedExpression expr(index, expression, flags, id, ext);
-    dumpExpression(expr, "orig", cc.grey);
+    auto expr = ue2::make_unique<ParsedExpression>(index, expression, flags,
+                                                   id, ext);
+    dumpExpression(*expr, "orig", cc.grey);
 
     // Apply prefiltering transformations if desired.
-    if (expr.prefilter) {
-        prefilterTree(expr.component, ParseMode(flags));
-        dumpExpression(expr, "prefiltered", cc.grey);
+    if (expr->prefilter) {
+        prefilterTree(expr->component, ParseMode(flags));
+        dumpExpression(*expr, "prefiltered", cc.grey);
     }
 
     // Expressions containing zero-width assertions and other extended pcre
     // types aren't supported yet. This call will throw a ParseError exception
     // if the component tree contains such a construct.
-    checkUnsupported(*expr.component);
+    checkUnsupported(*expr->component);
 
-    expr.component->checkEmbeddedStartAnchor(true);
-    expr.component->checkEmbeddedEndAnchor(true);
+    expr->component->checkEmbeddedStartAnchor(true);
+    expr->component->checkEmbeddedEndAnchor(true);
 
     if (cc.grey.optimiseComponentTree) {
-        optimise(expr);
-        dumpExpression(expr, "opt", cc.grey);
+        optimise(*expr);
+        dumpExpression(*expr, "opt", cc.grey);
     }
 
+    if (cc.cache) {
+        cc.cache->addExpression(expression, flags, ext, *expr);
+    }
+
+    return expr;
+}
+
+void addExpression(NG &ng, unsigned index, const char *expression,
+                   unsigned flags, const hs_expr_ext *ext, ReportID id) {
+    auto expr = parseExpression(ng.cc, index, expression, flags, ext, id);
+    addExpression(ng, *expr);
+}
+
+void addExpression(NG &ng, ParsedExpression &expr) {
+    const CompileContext &cc = ng.cc;
+
     DEBUG_PRINTF("component=%p, nfaId=%u, reportId=%u\n",
                  expr.component.get(), expr.index, expr.id);
 
@@ -292,6 +337,86 @@ void addExpression(NG &ng, unsigned index, const char *expression,
     }
 }
 
+void validateLiteral(unsigned index, const char *literal, size_t len,
+                     unsigned flags) {
+    static const unsigned ALL_LIT_FLAGS = HS_FLAG_CASELESS |
+                                          HS_FLAG_SINGLEMATCH |
+                                          HS_FLAG_SOM_LEFTMOST;
+
+    if (!literal) {
+        throw CompileError(index, "Invalid parameter: expression is NULL");
+    }
+
+    if (flags & ~ALL_LIT_FLAGS) {
+        DEBUG_PRINTF("Unsupported flag, flags=%u.\n", flags);
+        throw CompileError(index, "Unsupported flag for a pure literal.");
+    }
+
+    if (!len) {
+        throw CompileError(index, "Pure literal must not be empty.");
+    }
+
+    // FIXME: we disallow highlander + SOM, see UE-1850.
+    if ((flags & HS_FLAG_SINGLEMATCH) && (flags & HS_FLAG_SOM_LEFTMOST)) {
+        throw CompileError(index, "HS_FLAG_SINGLEMATCH is not supported in "
+                                  "combination with HS_FLAG_SOM_LEFTMOST.");
+    }
+}
+
+void addLiteral(NG &ng, unsigned index, const char *literal, size_t len,
+                unsigned flags, ReportID id) {
+    const CompileContext &cc = ng.cc;
+
+    validateLiteral(index, literal, len, flags);
+
+    const bool highlander = flags & HS_FLAG_SINGLEMATCH;
+    const som_type som = (flags & HS_FLAG_SOM_LEFTMOST) ? SOM_LEFT : SOM_NONE;
+
+    if (som != SOM_NONE && cc.streaming && !ng.ssm.somPrecision()) {
+        throw CompileError(index, "To use a SOM expression flag in streaming "
+                                  "mode, an SOM precision mode (e.g. "
+                                  "HS_MODE_SOM_HORIZON_LARGE) must be "
+                                  "specified.");
+    }
+
+    const ue2_literal lit(string(literal, len), flags & HS_FLAG_CASELESS);
+    DEBUG_PRINTF("literal %s, index=%u, id=%u\n", dumpString(lit).c_str(),
+                 index, id);
+
+    // As in the literal shortcut pass, single-byte highlander literals are
+    // left to the graph path.
+    if (cc.grey.allowRose && !(highlander && lit.length() <= 1) &&
+        ng.addLiteral(lit, index, id, highlander, som)) {
+        DEBUG_PRINTF("added literal directly to rose\n");
+        return;
+    }
+
+    // Otherwise, build the trivial graph for the literal without going
+    // through the parser and Glushkov construction.
+    auto g = ue2::make_unique<NGWrapper>(index, highlander, false, false, som,
+                                         id, 0, MAX_OFFSET, 0);
+    NFAVertex u = NGHolder::null_vertex();
+    for (const auto &c : lit) {
+        NFAVertex v = add_vertex(*g);
+        (*g)[v].char_reach = c;
+        if (u == NGHolder::null_vertex()) {
+            add_edge(g->start, v, *g);
+            add_edge(g->startDs, v, *g);
+        } else {
+            add_edge(u, v, *g);
+        }
+        u = v;
+    }
+    add_edge(u, g->accept, *g);
+    (*g)[u].reports.insert(ng.rm.getInternalId(
+        ng.rm.getBasicInternalReport(*g)));
+
+    if (!ng.addGraph(*g)) {
+        DEBUG_PRINTF("NFA addGraph failed on ID %u.\n", id);
+        throw CompileError(index, "Error compiling expression.");
+    }
+}
+
 static
 aligned_unique_ptr<RoseEngine> generateRoseEngine(NG &ng) {
     const u32 minWidth =
@@ -61,6 +61,11 @@ public:
     ParsedExpression(unsigned index, const char *expression, unsigned flags,
                      ReportID actionId, const hs_expr_ext *ext = nullptr);
 
+    /** \brief Copies \a other, which must not yet have been used to build a
+     * graph, for use as the expression with the given index and ID. */
+    ParsedExpression(const ParsedExpression &other, unsigned index,
+                     ReportID actionId);
+
     bool utf8; //!< UTF-8 mode flag specified
 
     /** \brief root node of parsed component tree. */
@@ -80,6 +85,43 @@ public:
     u64a min_length;   //!< 0 if not used
 };
 
+/**
+ * Parse an expression and run the per-expression checks and component tree
+ * optimisations on it. This does not touch any state shared between
+ * expressions, so it may be run for several expressions concurrently.
+ *
+ * @param cc
+ *      The compile context.
+ * @param index
+ *      The index of the expression (used for errors)
+ * @param expression
+ *      NULL-terminated PCRE expression
+ * @param flags
+ *      The full set of Hyperscan flags associated with this rule.
+ * @param ext
+ *      Struct containing extra parameters for this expression, or NULL if
+ *      none.
+ * @param actionId
+ *      The identifier to associate with the expression; returned by engine on
+ *      match.
+ * @return
+ *      The parsed expression, ready for \ref addExpression.
+ */
+std::unique_ptr<ParsedExpression>
+parseExpression(const CompileContext &cc, unsigned index,
+                const char *expression, unsigned flags,
+                const hs_expr_ext *ext, ReportID actionId);
+
+/**
+ * Add a parsed expression to the compiler.
+ *
+ * @param ng
+ *      The global NG object.
+ * @param expr
+ *      The expression, as returned by \ref parseExpression.
+ */
+void addExpression(NG &ng, ParsedExpression &expr);
+
 /**
  * Add an expression to the compiler.
  *
@@ -101,6 +143,43 @@ public:
 void addExpression(NG &ng, unsigned index, const char *expression,
                    unsigned flags, const hs_expr_ext *ext, ReportID actionId);
 
+/**
+ * Check that a pure literal and its flags can be compiled. Throws a
+ * CompileError naming the literal's index if they can't.
+ *
+ * @param index
+ *      The index of the literal (used for errors)
+ * @param literal
+ *      The literal bytes, which need not be NULL-terminated.
+ * @param len
+ *      The length of the literal in bytes.
+ * @param flags
+ *      The Hyperscan flags associated with this literal.
+ */
+void validateLiteral(unsigned index, const char *literal, size_t len,
+                     unsigned flags);
+
+/**
+ * Add a pure literal to the compiler. The literal is handed directly to Rose
+ * where possible, bypassing the parser and NFA graph construction entirely.
+ *
+ * @param ng
+ *      The global NG object.
+ * @param index
+ *      The index of the literal (used for errors)
+ * @param literal
+ *      The literal bytes, which need not be NULL-terminated.
+ * @param len
+ *      The length of the literal in bytes.
+ * @param flags
+ *      The Hyperscan flags associated with this literal.
+ * @param actionId
+ *      The identifier to associate with the literal; returned by engine on
+ *      match.
+ */
+void addLiteral(NG &ng, unsigned index, const char *literal, size_t len,
+                unsigned flags, ReportID actionId);
+
 /**
  * Build a Hyperscan database out of the expressions we've been given. A
  * fatal error will result in an exception being thrown.
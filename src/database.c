@@ -53,6 +53,10 @@ hs_error_t hs_free_database(hs_database_t *db) {
     if (db && db->magic != HS_DB_MAGIC) {
         return HS_INVALID;
     }
+    if (db && (db->flags & HS_DB_FLAG_IMAGE)) {
+        // Database images live in memory owned by the caller.
+        return HS_SUCCESS;
+    }
     hs_database_free(db);
 
     return HS_SUCCESS;
@@ -96,7 +100,7 @@ hs_error_t hs_serialize_database(const hs_database_t *db, char **bytes,
     buf += 2;
     *buf = db->crc32;
     buf++;
-    *buf = db->reserved0;
+    *buf = db->flags & ~HS_DB_FLAG_IMAGE;
     buf++;
     *buf = db->reserved1;
     buf++;
@@ -163,7 +167,7 @@ hs_error_t db_decode_header(const char **bytes, const size_t length,
     header->platform = unaligned_load_u64a(buf);
     buf += 2;
     header->crc32 = unaligned_load_u32(buf++);
-    header->reserved0 = unaligned_load_u32(buf++);
+    header->flags = unaligned_load_u32(buf++) & ~HS_DB_FLAG_IMAGE;
     header->reserved1 = unaligned_load_u32(buf++);
 
     *bytes = (const char *)buf;
@@ -318,7 +322,9 @@ hs_error_t hs_serialized_database_size(const char *bytes, const size_t length,
     return HS_SUCCESS;
 }
 
-hs_error_t dbIsValid(const hs_database_t *db) {
+// Checks everything except the CRC.
+static
+hs_error_t db_check_header(const hs_database_t *db) {
     if (db->magic != HS_DB_MAGIC) {
         DEBUG_PRINTF("bad magic\n");
         return HS_INVALID;
@@ -339,7 +345,23 @@ hs_error_t dbIsValid(const hs_database_t *db) {
         return HS_INVALID;
     }
 
-    hs_error_t rv = db_check_crc(db);
+    return HS_SUCCESS;
+}
+
+hs_error_t dbIsValid(const hs_database_t *db) {
+    hs_error_t rv = db_check_header(db);
+    if (rv != HS_SUCCESS) {
+        return rv;
+    }
+
+    // A database image may be a large mapping shared between processes; its
+    // CRC is checked by hs_map_database() or hs_verify_database() at the
+    // caller's discretion rather than on every scratch allocation.
+    if (db->flags & HS_DB_FLAG_IMAGE) {
+        return HS_SUCCESS;
+    }
+
+    rv = db_check_crc(db);
     if (rv != HS_SUCCESS) {
         DEBUG_PRINTF("bad crc\n");
         return rv;
@@ -348,6 +370,118 @@ hs_error_t dbIsValid(const hs_database_t *db) {
     return HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t hs_serialize_database_image(const hs_database_t *db, char **bytes,
+                                       size_t *length) {
+    if (!db || !bytes || !length) {
+        return HS_INVALID;
+    }
+
+    if (!db_correctly_aligned(db)) {
+        return HS_BAD_ALIGN;
+    }
+
+    hs_error_t ret = validDatabase(db);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    size_t image_len = sizeof(struct hs_database) + db->length;
+    char *out = hs_misc_alloc(image_len);
+    ret = hs_check_alloc(out);
+    if (ret != HS_SUCCESS) {
+        hs_misc_free(out);
+        return ret;
+    }
+
+    memset(out, 0, image_len);
+
+    // The image is laid out as the database would be at a cacheline-aligned
+    // address, which is where it must be placed in order to be used.
+    struct hs_database *image = (struct hs_database *)out;
+    image->magic = db->magic;
+    image->version = db->version;
+    image->length = db->length;
+    image->platform = db->platform;
+    image->crc32 = db->crc32;
+    image->flags = db->flags | HS_DB_FLAG_IMAGE;
+    image->reserved1 = db->reserved1;
+    image->bytecode = ROUNDUP_CL(offsetof(struct hs_database, padding));
+    assert(image->bytecode <= offsetof(struct hs_database, bytes));
+
+    memcpy(out + image->bytecode, hs_get_bytecode(db), db->length);
+
+    *bytes = out;
+    *length = image_len;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_map_database(const char *bytes, const size_t length,
+                           unsigned int flags, const hs_database_t **db) {
+    if (!bytes || !db) {
+        return HS_INVALID;
+    }
+
+    *db = NULL;
+
+    if (flags & ~HS_MAP_FLAG_NO_VERIFY) {
+        return HS_INVALID;
+    }
+
+    // The bytecode is used in place, so it must be correctly aligned.
+    if (!ISALIGNED_CL(bytes)) {
+        return HS_BAD_ALIGN;
+    }
+
+    if (length < sizeof(struct hs_database)) {
+        return HS_INVALID;
+    }
+
+    const struct hs_database *image = (const struct hs_database *)bytes;
+    hs_error_t ret = validDatabase(image);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    if (!(image->flags & HS_DB_FLAG_IMAGE)
+        || length != sizeof(struct hs_database) + image->length
+        || image->bytecode > offsetof(struct hs_database, bytes)) {
+        DEBUG_PRINTF("not a database image\n");
+        return HS_INVALID;
+    }
+
+    ret = db_check_header(image);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    if (!(flags & HS_MAP_FLAG_NO_VERIFY)) {
+        ret = db_check_crc(image);
+        if (ret != HS_SUCCESS) {
+            return ret;
+        }
+    }
+
+    *db = image;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_verify_database(const hs_database_t *db) {
+    hs_error_t ret = validDatabase(db);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    ret = db_check_header(db);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    return db_check_crc(db);
+}
+
 /** \brief Encapsulate the given bytecode (RoseEngine) in a newly-allocated
  * \ref hs_database, ensuring that it is padded correctly to give cacheline
  * alignment.  */
@@ -71,6 +71,11 @@ const platform_t hs_current_platform_no_avx2 = {
     0,
 };
 
+/** \brief Database flag: this database is a database image (see \ref
+ * hs_serialize_database_image), used in place in memory that Hyperscan did not
+ * allocate. */
+#define HS_DB_FLAG_IMAGE            1U
+
 /*
  * a header to enclose the actual bytecode - useful for keeping info about the
  * compiled data.
@@ -81,7 +86,7 @@ struct hs_database {
     u32 length;
     u64a platform;
     u32 crc32;
-    u32 reserved0;
+    u32 flags;       // HS_DB_FLAG_* values
     u32 reserved1;
     u32 bytecode;    // offset relative to db start
     u32 padding[16];
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Fat runtime: dispatch of the API entry points to the runtime built
+ * for the best instruction set supported by the host.
+ *
+ * In a fat runtime build, the runtime sources are compiled once per target
+ * and every global symbol in those objects is given a target prefix (see
+ * cmake/build_wrapper.sh). Each entry point below is an ifunc whose resolver
+ * runs once, at load time, and binds the symbol to the prefixed
+ * implementation for the most capable target the CPU supports.
+ */
+
+#include "config.h"
+#include "database.h"
+#include "hs_common.h"
+#include "hs_compile.h"
+#include "hs_runtime.h"
+#include "ue2common.h"
+#include "util/cpuid_flags.h"
+
+#if defined(BUILD_AVX512)
+#define DISPATCH_AVX512(NAME)                                                  \
+    if (cpuid_flags() & HS_CPU_FEATURES_AVX512) {                              \
+        return avx512_##NAME;                                                  \
+    }
+#define DECLARE_AVX512(RTYPE, NAME, ...) RTYPE avx512_##NAME(__VA_ARGS__);
+#else
+#define DISPATCH_AVX512(NAME)
+#define DECLARE_AVX512(RTYPE, NAME, ...)
+#endif
+
+#define CREATE_RESOLVER(RTYPE, NAME, ...)                                      \
+    /* prefixed implementations, one per target */                             \
+    DECLARE_AVX512(RTYPE, NAME, __VA_ARGS__)                                   \
+    RTYPE avx2_##NAME(__VA_ARGS__);                                            \
+    RTYPE core2_##NAME(__VA_ARGS__);                                           \
+                                                                               \
+    /* resolver */                                                             \
+    static RTYPE (*resolve_##NAME(void))(__VA_ARGS__) {                        \
+        DISPATCH_AVX512(NAME)                                                  \
+        if (cpuid_flags() & HS_CPU_FEATURES_AVX2) {                            \
+            return avx2_##NAME;                                                \
+        }                                                                      \
+        /* anything else is fail-safe */                                       \
+        return core2_##NAME;                                                   \
+    }
+
+#define CREATE_DISPATCH(RTYPE, NAME, ...)                                      \
+    CREATE_RESOLVER(RTYPE, NAME, __VA_ARGS__)                                  \
+    HS_PUBLIC_API                                                              \
+    RTYPE NAME(__VA_ARGS__) __attribute__((ifunc("resolve_" #NAME)))
+
+CREATE_DISPATCH(hs_error_t, hs_scan, const hs_database_t *db, const char *data,
+                unsigned length, unsigned flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *userCtx);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_batch, const hs_database_t *db,
+                const hs_block_t *blocks, unsigned int count,
+                unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_small, const hs_database_t *db,
+                const char *data, unsigned length, unsigned flags,
+                match_event_handler onEvent, void *userCtx);
+
+CREATE_DISPATCH(hs_error_t, hs_open_block_scan, const hs_database_t *db,
+                const char *data, unsigned long long length, unsigned flags,
+                hs_scratch_t *scratch, match_event_handler onEvent,
+                void *context, hs_block_scan_t **scan);
+
+CREATE_DISPATCH(hs_error_t, hs_advance_block_scan, hs_block_scan_t *scan,
+                unsigned long long max_bytes, unsigned long long *offset);
+
+CREATE_DISPATCH(hs_error_t, hs_finish_block_scan, hs_block_scan_t *scan);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_buffered, const hs_database_t *db,
+                const char *data, unsigned length, unsigned flags,
+                hs_scratch_t *scratch, match_batch_handler onBatch,
+                void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_counter_size, const hs_database_t *db,
+                unsigned int *count);
+
+CREATE_DISPATCH(hs_error_t, hs_counter_index, const hs_database_t *db,
+                unsigned int id, unsigned int *index);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_count, const hs_database_t *db,
+                const char *data, unsigned length, unsigned flags,
+                hs_scratch_t *scratch, unsigned long long *counts);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_vector, const hs_database_t *db,
+                const char *const *data, const unsigned int *length,
+                unsigned int count, unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onevent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_open_stream, const hs_database_t *db,
+                unsigned flags, hs_stream_t **stream);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_stream, hs_stream_t *id, const char *data,
+                unsigned int length, unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *ctxt);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_streams, const hs_stream_block_t *blocks,
+                unsigned int count, unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent);
+
+CREATE_DISPATCH(hs_error_t, hs_close_stream, hs_stream_t *id,
+                hs_scratch_t *scratch, match_event_handler onEvent,
+                void *ctxt);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_stream_buffered, hs_stream_t *id,
+                const char *data, unsigned int length, unsigned int flags,
+                hs_scratch_t *scratch, match_batch_handler onBatch,
+                void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_close_stream_buffered, hs_stream_t *id,
+                hs_scratch_t *scratch, match_batch_handler onBatch,
+                void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_stream_count, hs_stream_t *id,
+                const char *data, unsigned int length, unsigned int flags,
+                hs_scratch_t *scratch, unsigned long long *counts);
+
+CREATE_DISPATCH(hs_error_t, hs_close_stream_count, hs_stream_t *id,
+                hs_scratch_t *scratch, unsigned long long *counts);
+
+CREATE_DISPATCH(hs_error_t, hs_open_stream_at, const hs_database_t *db,
+                unsigned flags, void *buf, size_t buf_size,
+                hs_stream_t **stream);
+
+CREATE_DISPATCH(hs_error_t, hs_close_stream_at, hs_stream_t *id,
+                hs_scratch_t *scratch, match_event_handler onEvent,
+                void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_alloc_stream_pool, const hs_database_t *db,
+                unsigned int count, hs_stream_pool_t **pool);
+
+CREATE_DISPATCH(hs_error_t, hs_free_stream_pool, hs_stream_pool_t *pool);
+
+CREATE_DISPATCH(hs_error_t, hs_open_stream_pooled, hs_stream_pool_t *pool,
+                unsigned flags, hs_stream_t **stream);
+
+CREATE_DISPATCH(hs_error_t, hs_close_stream_pooled, hs_stream_pool_t *pool,
+                hs_stream_t *id, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_reset_stream, hs_stream_t *id,
+                unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_copy_stream, hs_stream_t **to_id,
+                const hs_stream_t *from_id);
+
+CREATE_DISPATCH(hs_error_t, hs_reset_and_copy_stream, hs_stream_t *to_id,
+                const hs_stream_t *from_id, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_compress_stream, const hs_stream_t *stream,
+                char *buf, size_t buf_space, size_t *used_space);
+
+CREATE_DISPATCH(hs_error_t, hs_expand_stream, const hs_database_t *db,
+                hs_stream_t **stream, const char *buf, size_t buf_size);
+
+CREATE_DISPATCH(hs_error_t, hs_reset_and_expand_stream, hs_stream_t *to_stream,
+                const char *buf, size_t buf_size, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_stream_size, const hs_database_t *database,
+                size_t *stream_size);
+
+CREATE_DISPATCH(hs_error_t, hs_alloc_scratch, const hs_database_t *db,
+                hs_scratch_t **scratch);
+
+CREATE_DISPATCH(hs_error_t, hs_clone_scratch, const hs_scratch_t *src,
+                hs_scratch_t **dest);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_size, const hs_scratch_t *scratch,
+                size_t *scratch_size);
+
+CREATE_DISPATCH(hs_error_t, hs_free_scratch, hs_scratch_t *scratch);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_profile, const hs_scratch_t *scratch,
+                hs_profile_t *profile);
+
+CREATE_DISPATCH(hs_error_t, hs_reset_scratch_profile, hs_scratch_t *scratch);
+
+CREATE_DISPATCH(hs_error_t, hs_set_scratch_budget, hs_scratch_t *scratch,
+                const hs_scan_budget_t *budget);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_budget_offset,
+                const hs_scratch_t *scratch, unsigned long long *offset);
+
+CREATE_DISPATCH(hs_error_t, hs_free_database, hs_database_t *db);
+
+CREATE_DISPATCH(hs_error_t, hs_serialize_database, const hs_database_t *db,
+                char **bytes, size_t *length);
+
+CREATE_DISPATCH(hs_error_t, hs_deserialize_database, const char *bytes,
+                const size_t length, hs_database_t **db);
+
+CREATE_DISPATCH(hs_error_t, hs_deserialize_database_at, const char *bytes,
+                const size_t length, hs_database_t *db);
+
+CREATE_DISPATCH(hs_error_t, hs_database_size, const hs_database_t *database,
+                size_t *database_size);
+
+CREATE_DISPATCH(hs_error_t, hs_serialize_database_image,
+                const hs_database_t *db, char **bytes, size_t *length);
+
+CREATE_DISPATCH(hs_error_t, hs_map_database, const char *bytes,
+                const size_t length, unsigned int flags,
+                const hs_database_t **db);
+
+CREATE_DISPATCH(hs_error_t, hs_verify_database, const hs_database_t *db);
+
+CREATE_DISPATCH(hs_error_t, hs_serialized_database_size, const char *bytes,
+                const size_t length, size_t *deserialized_size);
+
+CREATE_DISPATCH(hs_error_t, hs_database_info, const hs_database_t *database,
+                char **info);
+
+CREATE_DISPATCH(hs_error_t, hs_serialized_database_info, const char *bytes,
+                size_t length, char **info);
+
+/** INTERNALS **/
+
+/* used by the compiler to wrap the bytecode it builds */
+CREATE_RESOLVER(struct hs_database *, dbCreate, const char *in_bytecode,
+                size_t len, u64a platform)
+struct hs_database *dbCreate(const char *in_bytecode, size_t len,
+                             u64a platform)
+    __attribute__((ifunc("resolve_dbCreate")));
@@ -45,6 +45,11 @@
 #define FAKE_HISTORY_SIZE 16
 static const u8 fake_history[FAKE_HISTORY_SIZE];
 
+u32 fdrMaxLength(const struct FDR *fdr) {
+    /* Teddy engines share the leading fields of the FDR header. */
+    return fdr->maxStringLen;
+}
+
 hwlm_error_t fdrExec(const struct FDR *fdr, const u8 *buf, size_t len, size_t start,
                      HWLMCallback cb, void *ctxt, hwlm_group_t groups) {
 
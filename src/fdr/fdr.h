@@ -46,6 +46,9 @@ struct FDR;
 /** \brief Returns size in bytes of the given FDR engine. */
 size_t fdrSize(const struct FDR *fdr);
 
+/** \brief Returns the length of the longest literal in the given FDR engine. */
+u32 fdrMaxLength(const struct FDR *fdr);
+
 /** \brief Returns non-zero if the contents of the stream state indicate that
  * there is active FDR history beyond the regularly used history. */
 u32 fdrStreamStateActive(const struct FDR *fdr, const u8 *stream_state);
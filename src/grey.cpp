@@ -63,6 +63,8 @@ Grey::Grey(void) :
                    fdrAllowTeddy(true),
                    puffImproveHead(true),
                    castleExclusive(true),
+                   allowTamarama(true),
+                   tamaChunkSize(100),
                    mergeSEP(true), /* short exhaustible passthroughs */
                    mergeRose(true), // roses inside rose
                    mergeSuffixes(true), // suffix nfas inside rose
@@ -70,6 +72,9 @@ Grey::Grey(void) :
                    onlyOneOutfix(false),
                    allowShermanStates(true),
                    allowMcClellan8(true),
+                   allowSheng(true),
+                   allowMcSheng(true),
+                   allowWideMcClellan(true),
                    highlanderPruneDFA(true),
                    minimizeDFA(true),
                    accelerateDFA(true),
@@ -216,6 +221,8 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(fdrAllowTeddy);
         G_UPDATE(puffImproveHead);
         G_UPDATE(castleExclusive);
+        G_UPDATE(allowTamarama);
+        G_UPDATE(tamaChunkSize);
         G_UPDATE(mergeSEP);
         G_UPDATE(mergeRose);
         G_UPDATE(mergeSuffixes);
@@ -223,6 +230,9 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(onlyOneOutfix);
         G_UPDATE(allowShermanStates);
         G_UPDATE(allowMcClellan8);
+        G_UPDATE(allowSheng);
+        G_UPDATE(allowMcSheng);
+        G_UPDATE(allowWideMcClellan);
         G_UPDATE(highlanderPruneDFA);
         G_UPDATE(minimizeDFA);
         G_UPDATE(accelerateDFA);
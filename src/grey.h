@@ -65,6 +65,8 @@ struct Grey {
 
     bool puffImproveHead;
     bool castleExclusive; // enable castle mutual exclusion analysis
+    bool allowTamarama; // enable suffix mutual exclusion analysis
+    u32 tamaChunkSize; // max suffixes considered together for exclusion
 
     bool mergeSEP;
     bool mergeRose;
@@ -74,6 +76,9 @@ struct Grey {
 
     bool allowShermanStates;
     bool allowMcClellan8;
+    bool allowSheng;
+    bool allowMcSheng;
+    bool allowWideMcClellan;
     bool highlanderPruneDFA;
     bool minimizeDFA;
 
@@ -35,6 +35,7 @@
 #include "hs_compile.h"
 #include "hs_internal.h"
 #include "database.h"
+#include "compiler/compile_cache.h"
 #include "compiler/compiler.h"
 #include "compiler/error.h"
 #include "nfagraph/ng.h"
@@ -42,16 +43,21 @@
 #include "parser/parse_error.h"
 #include "parser/Parser.h"
 #include "parser/prefilter.h"
+#include "rose/rose_build.h"
 #include "util/compile_error.h"
 #include "util/cpuid_flags.h"
 #include "util/depth.h"
+#include "util/parallel.h"
 #include "util/popcount.h"
 #include "util/target_info.h"
 
 #include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <exception>
 #include <limits.h>
+#include <memory>
+#include <new>
 #include <string>
 #include <vector>
 
@@ -66,7 +72,8 @@ bool validModeFlags(unsigned int mode) {
                                        | HS_MODE_VECTORED
                                        | HS_MODE_SOM_HORIZON_LARGE
                                        | HS_MODE_SOM_HORIZON_MEDIUM
-                                       | HS_MODE_SOM_HORIZON_SMALL;
+                                       | HS_MODE_SOM_HORIZON_SMALL
+                                       | HS_MODE_ANYMATCH;
 
     return !(mode & ~allModeFlags);
 }
@@ -119,7 +126,7 @@ bool checkMode(unsigned int mode, hs_compile_error **comp_error) {
 static
 bool checkPlatform(const hs_platform_info *p, hs_compile_error **comp_error) {
 #define HS_TUNE_LAST HS_TUNE_FAMILY_BDW
-#define HS_CPU_FEATURES_ALL (HS_CPU_FEATURES_AVX2)
+#define HS_CPU_FEATURES_ALL (HS_CPU_FEATURES_AVX2 | HS_CPU_FEATURES_AVX512)
 
     if (!p) {
         return true;
@@ -158,6 +165,28 @@ unsigned getSomPrecision(unsigned mode) {
     return 0;
 }
 
+/** \brief Expression flags as seen by the compiler: with \ref
+ * HS_MODE_ANYMATCH, every expression is single-match and SOM is never
+ * tracked. */
+static
+unsigned compileFlags(const unsigned *flags, unsigned i, unsigned mode) {
+    unsigned f = flags ? flags[i] : 0;
+    if (mode & HS_MODE_ANYMATCH) {
+        f = (f | HS_FLAG_SINGLEMATCH) & ~HS_FLAG_SOM_LEFTMOST;
+    }
+    return f;
+}
+
+/** \brief Expression ID as seen by the compiler: with \ref HS_MODE_ANYMATCH,
+ * all expressions share ID zero, so they are merged into a single report. */
+static
+unsigned compileId(const unsigned *ids, unsigned i, unsigned mode) {
+    if (mode & HS_MODE_ANYMATCH) {
+        return 0;
+    }
+    return ids ? ids[i] : 0;
+}
+
 namespace ue2 {
 
 hs_error_t
@@ -165,7 +194,8 @@ hs_compile_multi_int(const char *const *expressions, const unsigned *flags,
                      const unsigned *ids, const hs_expr_ext *const *ext,
                      unsigned elements, unsigned mode,
                      const hs_platform_info_t *platform, hs_database_t **db,
-                     hs_compile_error_t **comp_error, const Grey &g) {
+                     hs_compile_error_t **comp_error, const Grey &g,
+                     unsigned threads, CompileCache *cache) {
     // Check the args: note that it's OK for flags, ids or ext to be null.
     if (!comp_error) {
         if (db) {
@@ -217,15 +247,48 @@ hs_compile_multi_int(const char *const *expressions, const unsigned *flags,
     target_t target_info = platform ? target_t(*platform)
                                     : get_current_target();
 
-    CompileContext cc(isStreaming, isVectored, target_info, g);
+    CompileContext cc(isStreaming, isVectored, target_info, g,
+                      resolveThreadCount(threads), cache);
+
+    if (cache && !cache->startCompile(cc)) {
+        *db = nullptr;
+        *comp_error = generateCompileError("Invalid parameter: cache is in "
+                                           "use by another compile", -1);
+        return HS_COMPILER_ERROR;
+    }
+    CompileCacheScope cache_scope(cache);
+
     NG ng(cc, somPrecision);
+    if (mode & HS_MODE_ANYMATCH) {
+        ng.rose->setAnyMatch();
+    }
 
     try {
+        // Parsing and component tree optimisation are independent for each
+        // expression, so they can be spread across threads. Errors are held
+        // back so that they are reported in expression order, exactly as they
+        // would be if each expression were parsed just before it is added.
+        vector<unique_ptr<ParsedExpression>> parsed(elements);
+        vector<exception_ptr> parse_errors(elements);
+        parallel_for(elements, cc.numThreads, [&](size_t i) {
+            try {
+                parsed[i] = parseExpression(cc, i, expressions[i],
+                                            compileFlags(flags, i, mode),
+                                            ext ? ext[i] : nullptr,
+                                            compileId(ids, i, mode));
+            } catch (...) {
+                parse_errors[i] = current_exception();
+            }
+        });
+
         for (unsigned int i = 0; i < elements; i++) {
             // Add this expression to the compiler
             try {
-                addExpression(ng, i, expressions[i], flags ? flags[i] : 0,
-                              ext ? ext[i] : nullptr, ids ? ids[i] : 0);
+                if (parse_errors[i]) {
+                    rethrow_exception(parse_errors[i]);
+                }
+                addExpression(ng, *parsed[i]);
+                parsed[i].reset();
             } catch (CompileError &e) {
                 /* Caught a parse error:
                  * throw it upstream as a CompileError with a specific index */
@@ -242,6 +305,7 @@ hs_compile_multi_int(const char *const *expressions, const unsigned *flags,
 
         *db = out;
         *comp_error = nullptr;
+        cache_scope.succeeded();
 
         return HS_SUCCESS;
     }
@@ -265,6 +329,118 @@ hs_compile_multi_int(const char *const *expressions, const unsigned *flags,
     }
 }
 
+hs_error_t
+hs_compile_lit_multi_int(const char *const *expressions, const unsigned *flags,
+                         const unsigned *ids, const size_t *lens,
+                         unsigned elements, unsigned mode,
+                         const hs_platform_info_t *platform, hs_database_t **db,
+                         hs_compile_error_t **comp_error, const Grey &g) {
+    // Check the args: note that it's OK for flags or ids to be null.
+    if (!comp_error) {
+        if (db) {
+            *db = nullptr;
+        }
+        // nowhere to write the string, but we can still report an error code
+        return HS_COMPILER_ERROR;
+    }
+    if (!db) {
+        *comp_error = generateCompileError("Invalid parameter: db is NULL", -1);
+        return HS_COMPILER_ERROR;
+    }
+    if (!expressions) {
+        *db = nullptr;
+        *comp_error
+            = generateCompileError("Invalid parameter: expressions is NULL",
+                                   -1);
+        return HS_COMPILER_ERROR;
+    }
+    if (!lens) {
+        *db = nullptr;
+        *comp_error = generateCompileError("Invalid parameter: len is NULL",
+                                           -1);
+        return HS_COMPILER_ERROR;
+    }
+    if (elements == 0) {
+        *db = nullptr;
+        *comp_error = generateCompileError("Invalid parameter: elements is zero", -1);
+        return HS_COMPILER_ERROR;
+    }
+
+    if (!checkMode(mode, comp_error)) {
+        *db = nullptr;
+        assert(*comp_error); // set by checkMode.
+        return HS_COMPILER_ERROR;
+    }
+
+    if (!checkPlatform(platform, comp_error)) {
+        *db = nullptr;
+        assert(*comp_error); // set by checkPlatform.
+        return HS_COMPILER_ERROR;
+    }
+
+    if (elements > g.limitPatternCount) {
+        *db = nullptr;
+        *comp_error = generateCompileError("Number of patterns too large", -1);
+        return HS_COMPILER_ERROR;
+    }
+
+    bool isStreaming = mode & (HS_MODE_STREAM | HS_MODE_VECTORED);
+    bool isVectored = mode & HS_MODE_VECTORED;
+    unsigned somPrecision = getSomPrecision(mode);
+
+    target_t target_info = platform ? target_t(*platform)
+                                    : get_current_target();
+
+    CompileContext cc(isStreaming, isVectored, target_info, g);
+    NG ng(cc, somPrecision);
+    if (mode & HS_MODE_ANYMATCH) {
+        ng.rose->setAnyMatch();
+    }
+
+    try {
+        // Check every literal before adding any of them to the compiler.
+        for (unsigned int i = 0; i < elements; i++) {
+            validateLiteral(i, expressions[i], lens[i],
+                            compileFlags(flags, i, mode));
+        }
+
+        for (unsigned int i = 0; i < elements; i++) {
+            // Literals need no parsing: add each one straight to the compiler.
+            addLiteral(ng, i, expressions[i], lens[i],
+                       compileFlags(flags, i, mode), compileId(ids, i, mode));
+        }
+
+        unsigned length = 0;
+        struct hs_database *out = build(ng, &length);
+
+        assert(out);    // should have thrown exception on error
+        assert(length);
+
+        *db = out;
+        *comp_error = nullptr;
+
+        return HS_SUCCESS;
+    }
+    catch (const CompileError &e) {
+        // Compiler error occurred
+        *db = nullptr;
+        *comp_error = generateCompileError(e.reason,
+                                           e.hasIndex ? (int)e.index : -1);
+        return HS_COMPILER_ERROR;
+    }
+    catch (const std::bad_alloc &) {
+        *db = nullptr;
+        *comp_error = const_cast<hs_compile_error_t *>(&hs_enomem);
+        return HS_COMPILER_ERROR;
+    }
+    catch (...) {
+        assert(!"Internal error, unexpected exception");
+        *db = nullptr;
+        *comp_error = const_cast<hs_compile_error_t *>(&hs_einternal);
+        return HS_COMPILER_ERROR;
+    }
+}
+
 } // namespace ue2
 
 extern "C" HS_PUBLIC_API
@@ -308,6 +484,94 @@ hs_error_t hs_compile_ext_multi(const char * const *expressions,
                                 platform, db, error, Grey());
 }
 
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_ext_multi_threaded(const char * const *expressions,
+                                         const unsigned *flags,
+                                         const unsigned *ids,
+                                         const hs_expr_ext * const *ext,
+                                         unsigned elements, unsigned mode,
+                                         const hs_platform_info_t *platform,
+                                         unsigned threads, hs_database_t **db,
+                                         hs_compile_error_t **error) {
+    return hs_compile_multi_int(expressions, flags, ids, ext, elements, mode,
+                                platform, db, error, Grey(), threads);
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_ext_multi_cached(const char * const *expressions,
+                                       const unsigned *flags,
+                                       const unsigned *ids,
+                                       const hs_expr_ext * const *ext,
+                                       unsigned elements, unsigned mode,
+                                       const hs_platform_info_t *platform,
+                                       unsigned threads,
+                                       hs_compile_cache_t *cache,
+                                       hs_database_t **db,
+                                       hs_compile_error_t **error) {
+    return hs_compile_multi_int(expressions, flags, ids, ext, elements, mode,
+                                platform, db, error, Grey(), threads,
+                                cache ? &cache->cache : nullptr);
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_lit(const char *expression, unsigned flags, size_t len,
+                          unsigned mode, const hs_platform_info_t *platform,
+                          hs_database_t **db, hs_compile_error_t **error) {
+    if (expression == nullptr) {
+        *db = nullptr;
+        *error = generateCompileError("Invalid parameter: expression is NULL",
+                                      -1);
+        return HS_COMPILER_ERROR;
+    }
+
+    unsigned id = 0; // single expressions get zero as an ID
+
+    return hs_compile_lit_multi_int(&expression, &flags, &id, &len, 1, mode,
+                                    platform, db, error, Grey());
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_lit_multi(const char * const *expressions,
+                                const unsigned *flags, const unsigned *ids,
+                                const size_t *lens, unsigned elements,
+                                unsigned mode,
+                                const hs_platform_info_t *platform,
+                                hs_database_t **db,
+                                hs_compile_error_t **error) {
+    return hs_compile_lit_multi_int(expressions, flags, ids, lens, elements,
+                                    mode, platform, db, error, Grey());
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_alloc_compile_cache(hs_compile_cache_t **cache) {
+    if (!cache) {
+        return HS_INVALID;
+    }
+
+    *cache = new (std::nothrow) hs_compile_cache_t;
+    if (!*cache) {
+        return HS_NOMEM;
+    }
+    return HS_SUCCESS;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_free_compile_cache(hs_compile_cache_t *cache) {
+    delete cache;
+    return HS_SUCCESS;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_cache_stats(const hs_compile_cache_t *cache,
+                                  hs_compile_cache_stats_t *stats) {
+    if (!cache || !stats) {
+        return HS_INVALID;
+    }
+
+    *stats = cache->cache.stats();
+    return HS_SUCCESS;
+}
+
 static
 hs_error_t hs_expression_info_int(const char *expression, unsigned int flags,
                                   unsigned int mode, hs_expr_info_t **info,
@@ -222,6 +222,103 @@ hs_error_t hs_database_size(const hs_database_t *database,
 hs_error_t hs_serialized_database_size(const char *bytes, const size_t length,
                                        size_t *deserialized_size);
 
+/**
+ * Serialize a pattern database into a database image: a byte array that can
+ * be stored (for example, in a file) and later used for scanning in place,
+ * without being copied or deserialized.
+ *
+ * A database image is intended for very large databases that are shared
+ * between many processes: the file containing it can be mapped read-only into
+ * each process with mmap(), so that all of the processes share the same
+ * physical pages. See @ref hs_map_database() for details.
+ *
+ * Database images and the byte streams produced by @ref
+ * hs_serialize_database() are not interchangeable.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param bytes
+ *      On success, a pointer to an array of bytes will be returned here.
+ *      These bytes can be subsequently relocated or written to disk. The
+ *      caller is responsible for freeing this block.
+ *
+ * @param length
+ *      On success, the number of bytes in the generated byte array will be
+ *      returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_NOMEM if the byte array cannot be
+ *      allocated, other values may be returned if errors are detected.
+ */
+hs_error_t hs_serialize_database_image(const hs_database_t *db, char **bytes,
+                                       size_t *length);
+
+/**
+ * Use a database image, previously generated by @ref
+ * hs_serialize_database_image(), as a pattern database in place.
+ *
+ * No copy of the database is made and no memory is allocated: the database
+ * returned is simply the image itself, which must remain valid and unchanged
+ * for as long as the database is in use. The image may be in read-only
+ * memory, such as a read-only mapping of a file.
+ *
+ * The image must be placed at a 64-byte aligned address; memory returned by
+ * mmap() is suitably aligned.
+ *
+ * The database image is checked for integrity (with a checksum over the whole
+ * image) unless the @ref HS_MAP_FLAG_NO_VERIFY flag is supplied. As this check
+ * reads every page of the image, an application that needs to start quickly
+ * may skip it, and perform it later with @ref hs_verify_database().
+ *
+ * The database returned need not be freed with @ref hs_free_database() (which
+ * does nothing for a database image); the caller is responsible for unmapping
+ * or freeing the memory holding the image.
+ *
+ * @param bytes
+ *      A 64-byte aligned byte array generated by @ref
+ *      hs_serialize_database_image().
+ *
+ * @param length
+ *      The length of the byte array, as returned by @ref
+ *      hs_serialize_database_image().
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function: zero, or @ref
+ *      HS_MAP_FLAG_NO_VERIFY.
+ *
+ * @param db
+ *      On success, a pointer to the database will be returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_BAD_ALIGN if the image is not
+ *      correctly aligned, other values on failure.
+ */
+hs_error_t hs_map_database(const char *bytes, const size_t length,
+                           unsigned int flags, const hs_database_t **db);
+
+/**
+ * Flag for @ref hs_map_database(): do not check the integrity of the database
+ * image when mapping it.
+ */
+#define HS_MAP_FLAG_NO_VERIFY 1
+
+/**
+ * Check the integrity of a pattern database.
+ *
+ * This computes a checksum over the whole of the database and compares it
+ * with the checksum recorded when the database was compiled. It is intended
+ * for use with database images mapped by @ref hs_map_database() with the @ref
+ * HS_MAP_FLAG_NO_VERIFY flag.
+ *
+ * @param db
+ *      A pattern database.
+ *
+ * @return
+ *      @ref HS_SUCCESS if the database is intact, other values on failure.
+ */
+hs_error_t hs_verify_database(const hs_database_t *db);
+
 /**
  * Utility function providing information about a database.
  *
@@ -500,6 +597,33 @@ const char *hs_version(void);
  */
 #define HS_BAD_ALLOC            (-9)
 
+/**
+ * The database cannot be scanned without scratch space.
+ *
+ * This error is returned by @ref hs_scan_small() for databases that need the
+ * full scratch space to be scanned. Such databases must be scanned with @ref
+ * hs_scan() instead.
+ */
+#define HS_SCRATCH_REQUIRED     (-10)
+
+/**
+ * The provided buffer was too small.
+ *
+ * This error is returned by @ref hs_compress_stream() when the buffer given
+ * is not large enough for the stream image. The required size is returned in
+ * the @a used_space parameter.
+ */
+#define HS_INSUFFICIENT_SPACE   (-11)
+
+/**
+ * The scan exceeded the budget set with @ref hs_set_scratch_budget().
+ *
+ * This return value indicates that the target buffer was partially scanned.
+ * The offset that was reached can be retrieved with @ref
+ * hs_scratch_budget_offset().
+ */
+#define HS_SCAN_BUDGET_EXCEEDED (-12)
+
 /** @} */
 
 #ifdef __cplusplus
@@ -256,6 +256,52 @@ typedef struct hs_expr_ext {
 
 /** @} */
 
+/**
+ * A compile cache, which holds intermediate artefacts of a compile so that
+ * they may be reused by later compiles of a similar pattern set.
+ *
+ * A compile cache is allocated with @ref hs_alloc_compile_cache(), used with
+ * @ref hs_compile_ext_multi_cached() and freed with @ref
+ * hs_free_compile_cache(). It is an opaque structure.
+ */
+typedef struct hs_compile_cache hs_compile_cache_t;
+
+/**
+ * A structure describing the use made of a compile cache by the most recent
+ * compile, filled in by @ref hs_compile_cache_stats().
+ */
+typedef struct hs_compile_cache_stats {
+    /**
+     * The number of expressions whose parsed form was found in the cache.
+     */
+    unsigned int expression_hits;
+
+    /**
+     * The number of expressions that had to be parsed.
+     */
+    unsigned int expression_misses;
+
+    /**
+     * The number of engine constructions whose result was found in the cache.
+     */
+    unsigned int engine_hits;
+
+    /**
+     * The number of engine constructions that had to be performed.
+     */
+    unsigned int engine_misses;
+
+    /**
+     * The number of parsed expressions currently held by the cache.
+     */
+    unsigned int expressions_cached;
+
+    /**
+     * The number of engines currently held by the cache.
+     */
+    unsigned int engines_cached;
+} hs_compile_cache_stats_t;
+
 /**
  * The basic regular expression compiler.
  *
@@ -487,6 +533,336 @@ hs_error_t hs_compile_ext_multi(const char *const *expressions,
                                 const hs_platform_info_t *platform,
                                 hs_database_t **db, hs_compile_error_t **error);
 
+/**
+ * The multiple regular expression compiler with extended pattern support,
+ * using several threads.
+ *
+ * This function call compiles a group of expressions into a database in the
+ * same way as @ref hs_compile_ext_multi(), but allows the independent parts of
+ * the compile (such as the parsing and optimisation of each expression, and
+ * the construction of each of the engines that make up the database) to be
+ * spread across a number of threads. This is useful for large pattern sets,
+ * where compile time may otherwise be considerable.
+ *
+ * The number of threads used does not change any of the decisions made by the
+ * compiler: the database produced matches exactly as the one produced by @ref
+ * hs_compile_ext_multi() for the same arguments would. Errors are also
+ * reported in the same way: if more than one
+ * expression fails to compile, the error for the expression that @ref
+ * hs_compile_ext_multi() would have reported is returned.
+ *
+ * @param expressions
+ *      Array of NULL-terminated expressions to compile, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param flags
+ *      Array of flags which modify the behaviour of each expression, as for
+ *      @ref hs_compile_ext_multi().
+ *
+ * @param ids
+ *      An array of integers specifying the ID number to be associated with the
+ *      corresponding pattern in the expressions array, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param ext
+ *      An array of pointers to filled @ref hs_expr_ext_t structures, as for
+ *      @ref hs_compile_ext_multi().
+ *
+ * @param elements
+ *      The number of elements in the input arrays.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole. See @ref
+ *      hs_compile_ext_multi() for details.
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the database. If NULL, a database suitable for running
+ *      on the current host platform is produced.
+ *
+ * @param threads
+ *      The maximum number of threads to use for the compile, including the
+ *      calling thread. A value of one compiles on the calling thread alone; a
+ *      value of zero uses one thread for each hardware thread on the host.
+ *
+ * @param db
+ *      On success, a pointer to the generated database will be returned in
+ *      this parameter, or NULL on failure. The caller is responsible for
+ *      deallocating the buffer using the @ref hs_free_database() function.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The caller is
+ *      responsible for deallocating the buffer using the @ref
+ *      hs_free_compile_error() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ *
+ */
+hs_error_t hs_compile_ext_multi_threaded(const char *const *expressions,
+                                         const unsigned int *flags,
+                                         const unsigned int *ids,
+                                         const hs_expr_ext_t *const *ext,
+                                         unsigned int elements,
+                                         unsigned int mode,
+                                         const hs_platform_info_t *platform,
+                                         unsigned int threads,
+                                         hs_database_t **db,
+                                         hs_compile_error_t **error);
+
+/**
+ * The multiple regular expression compiler with extended pattern support,
+ * reusing the work of earlier compiles.
+ *
+ * This function call compiles a group of expressions into a database in the
+ * same way as @ref hs_compile_ext_multi_threaded(), but keeps intermediate
+ * artefacts of the compile in the given compile cache: the parsed form of
+ * each expression, and the automata built for the engines that make up the
+ * database. Later compiles using the same cache reuse any of these that they
+ * also require, which can greatly reduce compile time when a large pattern
+ * set is recompiled after a small number of changes.
+ *
+ * After a successful compile, the cache holds only the artefacts used by that
+ * compile, so a cache should be used for successive versions of one pattern
+ * set. The cache is emptied if it is used for a compile with a different mode
+ * or platform from the previous compile. A cache may only be used by one
+ * compile at a time.
+ *
+ * The use of a cache does not change the database produced: it matches
+ * exactly as a database produced by @ref hs_compile_ext_multi() for the same
+ * arguments would.
+ *
+ * @param expressions
+ *      Array of NULL-terminated expressions to compile, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param flags
+ *      Array of flags which modify the behaviour of each expression, as for
+ *      @ref hs_compile_ext_multi().
+ *
+ * @param ids
+ *      An array of integers specifying the ID number to be associated with the
+ *      corresponding pattern in the expressions array, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param ext
+ *      An array of pointers to filled @ref hs_expr_ext_t structures, as for
+ *      @ref hs_compile_ext_multi().
+ *
+ * @param elements
+ *      The number of elements in the input arrays.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole. See @ref
+ *      hs_compile_ext_multi() for details.
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the database. If NULL, a database suitable for running
+ *      on the current host platform is produced.
+ *
+ * @param threads
+ *      The maximum number of threads to use for the compile, as for @ref
+ *      hs_compile_ext_multi_threaded().
+ *
+ * @param cache
+ *      The compile cache to use, allocated by @ref hs_alloc_compile_cache().
+ *      If NULL, no cache is used.
+ *
+ * @param db
+ *      On success, a pointer to the generated database will be returned in
+ *      this parameter, or NULL on failure. The caller is responsible for
+ *      deallocating the buffer using the @ref hs_free_database() function.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The caller is
+ *      responsible for deallocating the buffer using the @ref
+ *      hs_free_compile_error() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ */
+hs_error_t hs_compile_ext_multi_cached(const char *const *expressions,
+                                       const unsigned int *flags,
+                                       const unsigned int *ids,
+                                       const hs_expr_ext_t *const *ext,
+                                       unsigned int elements,
+                                       unsigned int mode,
+                                       const hs_platform_info_t *platform,
+                                       unsigned int threads,
+                                       hs_compile_cache_t *cache,
+                                       hs_database_t **db,
+                                       hs_compile_error_t **error);
+
+/**
+ * The pure literal compiler.
+ *
+ * This is the function call with which a single literal byte string is
+ * compiled into a database. Unlike @ref hs_compile(), the pattern is not
+ * parsed as a regular expression: every byte of it, including NUL bytes and
+ * regular expression metacharacters, is matched literally. This makes
+ * compilation of plain string signatures considerably cheaper in both time
+ * and memory.
+ *
+ * @param expression
+ *      The literal to compile, which need not be NULL-terminated and may
+ *      contain any byte value.
+ *
+ * @param flags
+ *      Flags which modify the behaviour of the literal. Multiple flags may be
+ *      used by ORing them together. Valid values are:
+ *       - HS_FLAG_CASELESS - Matching will be performed case-insensitively.
+ *       - HS_FLAG_SINGLEMATCH - Only one match will be generated for the
+ *                               literal per stream.
+ *       - HS_FLAG_SOM_LEFTMOST - Report the leftmost start of match offset
+ *                                when a match is found.
+ *
+ * @param len
+ *      The length of the literal in bytes, which must be non-zero.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole, as for @ref
+ *      hs_compile().
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the database. If NULL, a database suitable for running
+ *      on the current host platform is produced.
+ *
+ * @param db
+ *      On success, a pointer to the generated database will be returned in
+ *      this parameter, or NULL on failure. The caller is responsible for
+ *      deallocating the buffer using the @ref hs_free_database() function.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The caller is
+ *      responsible for deallocating the buffer using the @ref
+ *      hs_free_compile_error() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ */
+hs_error_t hs_compile_lit(const char *expression, unsigned int flags,
+                          size_t len, unsigned int mode,
+                          const hs_platform_info_t *platform,
+                          hs_database_t **db, hs_compile_error_t **error);
+
+/**
+ * The multiple pure literal compiler.
+ *
+ * This function call compiles a set of literal byte strings into a database
+ * in the same way as @ref hs_compile_multi(), except that the patterns are
+ * matched literally and are not parsed as regular expressions (see @ref
+ * hs_compile_lit()). Each literal can be labelled with a unique integer which
+ * is passed into the match callback to identify the pattern that has matched.
+ *
+ * @param expressions
+ *      Array of literals to compile. The literals need not be NULL-terminated
+ *      and may contain any byte value.
+ *
+ * @param flags
+ *      Array of flags which modify the behaviour of each literal. Specifying
+ *      the NULL pointer in place of an array will set the flags value for all
+ *      literals to zero. Valid values are HS_FLAG_CASELESS,
+ *      HS_FLAG_SINGLEMATCH and HS_FLAG_SOM_LEFTMOST, as for @ref
+ *      hs_compile_lit().
+ *
+ * @param ids
+ *      An array of integers specifying the ID number to be associated with the
+ *      corresponding literal in the expressions array. Specifying the NULL
+ *      pointer in place of an array will set the ID value for all literals to
+ *      zero.
+ *
+ * @param lens
+ *      Array of literal lengths in bytes, each of which must be non-zero.
+ *
+ * @param elements
+ *      The number of elements in the input arrays.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole, as for @ref
+ *      hs_compile_multi().
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the database. If NULL, a database suitable for running
+ *      on the current host platform is produced.
+ *
+ * @param db
+ *      On success, a pointer to the generated database will be returned in
+ *      this parameter, or NULL on failure. The caller is responsible for
+ *      deallocating the buffer using the @ref hs_free_database() function.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The caller is
+ *      responsible for deallocating the buffer using the @ref
+ *      hs_free_compile_error() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ */
+hs_error_t hs_compile_lit_multi(const char *const *expressions,
+                                const unsigned int *flags,
+                                const unsigned int *ids, const size_t *lens,
+                                unsigned int elements, unsigned int mode,
+                                const hs_platform_info_t *platform,
+                                hs_database_t **db,
+                                hs_compile_error_t **error);
+
+/**
+ * Allocate an empty compile cache.
+ *
+ * @param cache
+ *      On success, a pointer to the new compile cache will be returned in this
+ *      parameter. The caller is responsible for deallocating it using the @ref
+ *      hs_free_compile_cache() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_NOMEM if the cache could not be
+ *      allocated, other values on failure.
+ */
+hs_error_t hs_alloc_compile_cache(hs_compile_cache_t **cache);
+
+/**
+ * Free a compile cache and everything held in it.
+ *
+ * @param cache
+ *      The compile cache to be freed. NULL may also be safely provided.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_free_compile_cache(hs_compile_cache_t *cache);
+
+/**
+ * Retrieve statistics describing the use made of a compile cache by the most
+ * recent compile that used it, and the number of artefacts it holds.
+ *
+ * @param cache
+ *      The compile cache.
+ *
+ * @param stats
+ *      On success, the statistics are written to the structure pointed to by
+ *      this parameter.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_compile_cache_stats(const hs_compile_cache_t *cache,
+                                  hs_compile_cache_stats_t *stats);
+
 /**
  * Free an error structure generated by @ref hs_compile(), @ref
  * hs_compile_multi() or @ref hs_compile_ext_multi().
@@ -707,6 +1083,15 @@ hs_error_t hs_populate_platform(hs_platform_info_t *platform);
  */
 #define HS_CPU_FEATURES_AVX2             (1ULL << 2)
 
+/**
+ * CPU features flag - Intel(R) Advanced Vector Extensions 512 (Intel(R)
+ * AVX-512), Foundation and Byte/Word instructions
+ *
+ * Setting this flag indicates that the target platform supports AVX512F and
+ * AVX512BW instructions.
+ */
+#define HS_CPU_FEATURES_AVX512           (1ULL << 3)
+
 /** @} */
 
 /**
@@ -839,6 +1224,24 @@ hs_error_t hs_populate_platform(hs_platform_info_t *platform);
  */
 #define HS_MODE_SOM_HORIZON_SMALL   (1U << 26)
 
+/**
+ * Compiler mode flag: build a database that only reports whether any of its
+ * expressions match.
+ *
+ * Every expression is treated as though it had been compiled with the @ref
+ * HS_FLAG_SINGLEMATCH flag and an ID of zero, and the @ref
+ * HS_FLAG_SOM_LEFTMOST flag is ignored. This allows the compiler to discard
+ * much of the work that would be needed to report individual matches, giving
+ * a smaller database and faster scans.
+ *
+ * At runtime, the match callback is called at most once for each block (or
+ * stream), with an ID of zero. Scanning stops after the first match, and
+ * further writes to the stream produce no matches; the scan functions return
+ * @ref HS_SUCCESS in this case, unless the callback asked for scanning to be
+ * terminated.
+ */
+#define HS_MODE_ANYMATCH            (1U << 27)
+
 /** @} */
 
 #ifdef __cplusplus
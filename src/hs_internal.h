@@ -40,17 +40,32 @@
 
 namespace ue2 {
 
+class CompileCache;
 struct Grey;
 
 /** \brief Internal use only: takes a Grey argument so that we can use it in
- * tools. */
+ * tools. A \a threads value of zero means one thread per hardware thread.
+ * A given \a cache must always be used with the same Grey. */
 hs_error_t hs_compile_multi_int(const char *const *expressions,
                                 const unsigned *flags, const unsigned *ids,
                                 const hs_expr_ext *const *ext,
                                 unsigned elements, unsigned mode,
                                 const hs_platform_info_t *platform,
                                 hs_database_t **db,
-                                hs_compile_error_t **comp_error, const Grey &g);
+                                hs_compile_error_t **comp_error, const Grey &g,
+                                unsigned threads = 1,
+                                CompileCache *cache = nullptr);
+
+/** \brief Internal use only: takes a Grey argument so that we can use it in
+ * tools. */
+hs_error_t hs_compile_lit_multi_int(const char *const *expressions,
+                                    const unsigned *flags, const unsigned *ids,
+                                    const size_t *lens, unsigned elements,
+                                    unsigned mode,
+                                    const hs_platform_info_t *platform,
+                                    hs_database_t **db,
+                                    hs_compile_error_t **comp_error,
+                                    const Grey &g);
 
 } // namespace ue2
 
@@ -65,6 +65,20 @@ struct hs_scratch;
  */
 typedef struct hs_scratch hs_scratch_t;
 
+struct hs_stream_pool;
+
+/**
+ * A pool of fixed-size stream slots, allocated by @ref hs_alloc_stream_pool().
+ */
+typedef struct hs_stream_pool hs_stream_pool_t;
+
+struct hs_block_scan;
+
+/**
+ * A resumable block mode scan, opened by @ref hs_open_block_scan().
+ */
+typedef struct hs_block_scan hs_block_scan_t;
+
 /**
  * Definition of the match event callback function type.
  *
@@ -166,8 +180,8 @@ hs_error_t hs_open_stream(const hs_database_t *db, unsigned int flags,
  *      The number of bytes to scan.
  *
  * @param flags
- *      Flags modifying the behaviour of the stream. This parameter is provided
- *      for future use and is unused at present.
+ *      Flags modifying the behaviour of the stream. This may be zero or
+ *      @ref HS_SCAN_FLAG_UNORDERED.
  *
  * @param scratch
  *      A per-thread scratch space allocated by @ref hs_alloc_scratch().
@@ -190,6 +204,79 @@ hs_error_t hs_scan_stream(hs_stream_t *id, const char *data,
                           hs_scratch_t *scratch, match_event_handler onEvent,
                           void *ctxt);
 
+/**
+ * A single write of data to a stream, as passed to @ref hs_scan_streams().
+ */
+typedef struct hs_stream_block {
+    /**
+     * The stream ID (returned by @ref hs_open_stream()) to which the data will
+     * be written.
+     */
+    hs_stream_t *id;
+
+    /**
+     * Pointer to the data to be scanned.
+     */
+    const char *data;
+
+    /**
+     * The number of bytes to scan.
+     */
+    unsigned int length;
+
+    /**
+     * The user defined pointer which will be passed to the callback function
+     * for matches found in this stream write.
+     */
+    void *context;
+} hs_stream_block_t;
+
+/**
+ * Write data to be scanned to a number of opened streams.
+ *
+ * This function is equivalent to calling @ref hs_scan_stream() for each of the
+ * given writes in turn, but overlaps the memory accesses needed to begin each
+ * write: the stream state and data for the next write are prefetched while the
+ * current write is being scanned. This hides much of the cost of touching cold
+ * stream state when scanning writes spread across a large number of streams.
+ *
+ * The writes may refer to streams opened against different databases, as long
+ * as the scratch space is suitable for all of them. Writes to the same stream
+ * are scanned in the order in which they appear in the array.
+ *
+ * If the callback returns non-zero for a write, that stream is terminated just
+ * as it would be by @ref hs_scan_stream(), and scanning continues with the next
+ * write in the array.
+ *
+ * @param blocks
+ *      An array of stream writes to be scanned.
+ *
+ * @param count
+ *      Number of writes to scan. This should correspond to the size of the @a
+ *      blocks array.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the streams. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch().
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop for at least one of
+ *      the writes (or a write was made to an already terminated stream); other
+ *      values on error, in which case writes after the failing one have not
+ *      been scanned.
+ */
+hs_error_t hs_scan_streams(const hs_stream_block_t *blocks, unsigned int count,
+                           unsigned int flags, hs_scratch_t *scratch,
+                           match_event_handler onEvent);
+
 /**
  * Close a stream.
  *
@@ -226,6 +313,171 @@ hs_error_t hs_scan_stream(hs_stream_t *id, const char *data,
 hs_error_t hs_close_stream(hs_stream_t *id, hs_scratch_t *scratch,
                            match_event_handler onEvent, void *ctxt);
 
+/**
+ * Open and initialise a stream in memory provided by the caller.
+ *
+ * This is equivalent to @ref hs_open_stream(), but no memory is allocated:
+ * the stream is placed at the start of @a buf, which must remain valid until
+ * the stream is closed with @ref hs_close_stream_at(). The number of bytes
+ * required is given by @ref hs_stream_size().
+ *
+ * Streams opened with this function must not be passed to @ref
+ * hs_close_stream(). All other stream operations may be used on them.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the stream. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param buf
+ *      Memory for the stream, aligned to at least eight bytes.
+ *
+ * @param buf_size
+ *      The size of @a buf in bytes.
+ *
+ * @param stream
+ *      On success, a pointer to the stream (which is equal to @a buf) will be
+ *      returned; NULL on failure.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_BAD_ALIGN if @a buf is not
+ *      suitably aligned, @ref HS_INSUFFICIENT_SPACE if @a buf_size is smaller
+ *      than the stream size, other values on failure.
+ */
+hs_error_t hs_open_stream_at(const hs_database_t *db, unsigned int flags,
+                             void *buf, size_t buf_size,
+                             hs_stream_t **stream);
+
+/**
+ * Close a stream opened with @ref hs_open_stream_at().
+ *
+ * This reports any matches at the end of the data stream, as @ref
+ * hs_close_stream() does, but does not free the memory holding the stream,
+ * which is returned to the caller.
+ *
+ * @param id
+ *      The stream ID returned by @ref hs_open_stream_at().
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch(). This is
+ *      allowed to be NULL only if the @a onEvent callback is also NULL.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function
+ *      when a match occurs.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_close_stream_at(hs_stream_t *id, hs_scratch_t *scratch,
+                              match_event_handler onEvent, void *context);
+
+/**
+ * Allocate a pool of stream slots for the given database.
+ *
+ * The pool is a single allocation, made with the stream allocator, holding
+ * @a count cache-line aligned slots of the size required by the database.
+ * Streams are opened in it with @ref hs_open_stream_pooled() and released
+ * with @ref hs_close_stream_pooled(), both of which take constant time and
+ * do not call the allocator.
+ *
+ * Like scratch space, a pool is not thread-safe: it must only be used by one
+ * thread at a time, which makes a pool per thread the usual arrangement.
+ *
+ * @param db
+ *      A compiled pattern database, which must be a streaming database.
+ *
+ * @param count
+ *      The number of streams the pool can hold at once. Must be non-zero.
+ *
+ * @param pool
+ *      On success, a pointer to the pool will be returned here; NULL on
+ *      failure.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_alloc_stream_pool(const hs_database_t *db, unsigned int count,
+                                hs_stream_pool_t **pool);
+
+/**
+ * Free a stream pool.
+ *
+ * Any streams still open in the pool become invalid; no end-of-data matches
+ * are reported for them.
+ *
+ * @param pool
+ *      The pool to free, as allocated by @ref hs_alloc_stream_pool(). NULL is
+ *      accepted and ignored.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_free_stream_pool(hs_stream_pool_t *pool);
+
+/**
+ * Open and initialise a stream in a free slot of a stream pool.
+ *
+ * Streams opened with this function must be closed with @ref
+ * hs_close_stream_pooled() on the same pool. All other stream operations may
+ * be used on them.
+ *
+ * @param pool
+ *      A stream pool allocated by @ref hs_alloc_stream_pool().
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the stream. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param stream
+ *      On success, a pointer to the stream will be returned; NULL on
+ *      failure.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_NOMEM if every slot of the pool is
+ *      in use, other values on failure.
+ */
+hs_error_t hs_open_stream_pooled(hs_stream_pool_t *pool, unsigned int flags,
+                                 hs_stream_t **stream);
+
+/**
+ * Close a stream opened with @ref hs_open_stream_pooled(), returning its slot
+ * to the pool.
+ *
+ * End-of-data matches are reported as for @ref hs_close_stream().
+ *
+ * @param pool
+ *      The pool that the stream was opened in.
+ *
+ * @param id
+ *      The stream ID returned by @ref hs_open_stream_pooled().
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch(). This is
+ *      allowed to be NULL only if the @a onEvent callback is also NULL.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function
+ *      when a match occurs.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_INVALID if the stream is not open
+ *      in this pool, other values on failure.
+ */
+hs_error_t hs_close_stream_pooled(hs_stream_pool_t *pool, hs_stream_t *id,
+                                  hs_scratch_t *scratch,
+                                  match_event_handler onEvent, void *context);
+
 /**
  * Reset a stream to an initial state.
  *
@@ -320,6 +572,120 @@ hs_error_t hs_reset_and_copy_stream(hs_stream_t *to_id,
                                     match_event_handler onEvent,
                                     void *context);
 
+/**
+ * Creates a compressed representation of the provided stream in the buffer
+ * provided. This compressed representation can be converted back into a
+ * stream state by using @ref hs_expand_stream() or @ref
+ * hs_reset_and_expand_stream().
+ *
+ * The image holds only the live parts of the stream state: the history that
+ * has been seen so far and the state of the engines that are currently
+ * active. It is usually much smaller than the size reported by @ref
+ * hs_stream_size(), which makes it suitable for parking idle streams or for
+ * moving a stream to another thread. The image may be used on any host that
+ * is running the same version of Hyperscan with the same database.
+ *
+ * @param stream
+ *      The stream (as created by @ref hs_open_stream()) to be compressed.
+ *
+ * @param buf
+ *      Buffer to write the compressed representation into. Note: if the call
+ *      is just being used to determine the amount of space required, it is
+ *      allowed to pass NULL here and @a buf_space as 0.
+ *
+ * @param buf_space
+ *      The number of bytes in @a buf. If buf_space is too small, the call will
+ *      fail with @ref HS_INSUFFICIENT_SPACE.
+ *
+ * @param used_space
+ *      Pointer to where the amount of used space will be written to. The used
+ *      buffer space is always less than or equal to @a buf_space. If the call
+ *      fails with @ref HS_INSUFFICIENT_SPACE, this pointer will be used to
+ *      write out the amount of buffer space required.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_INSUFFICIENT_SPACE if the provided
+ *      buffer is too small.
+ */
+hs_error_t hs_compress_stream(const hs_stream_t *stream, char *buf,
+                              size_t buf_space, size_t *used_space);
+
+/**
+ * Decompresses a compressed representation created by @ref
+ * hs_compress_stream() into a new stream.
+ *
+ * Note: @a buf must correspond to a complete compressed representation
+ * created by @ref hs_compress_stream() of a stream that was opened against
+ * @a db. It is not always possible to detect misuse of this API and behaviour
+ * is undefined if these properties are not satisfied.
+ *
+ * @param db
+ *      The compiled pattern database that the compressed stream was opened
+ *      against.
+ *
+ * @param stream
+ *      On success, a pointer to the expanded @ref hs_stream_t will be
+ *      returned; NULL on failure.
+ *
+ * @param buf
+ *      A compressed representation of a stream. These compressed forms are
+ *      created by @ref hs_compress_stream().
+ *
+ * @param buf_size
+ *      The size in bytes of the compressed representation.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_expand_stream(const hs_database_t *db, hs_stream_t **stream,
+                            const char *buf, size_t buf_size);
+
+/**
+ * Decompresses a compressed representation created by @ref
+ * hs_compress_stream() on top of the 'to' stream. The 'to' stream will first
+ * be reset (reporting any EOD matches if a non-NULL @a onEvent callback
+ * handler is provided).
+ *
+ * Note: the 'to' stream must be opened against the same database as the
+ * compressed stream.
+ *
+ * Note: @a buf must correspond to a complete compressed representation
+ * created by @ref hs_compress_stream() of a stream that was opened against
+ * the same database. It is not always possible to detect misuse of this API
+ * and behaviour is undefined if these properties are not satisfied.
+ *
+ * @param to_stream
+ *      A pointer to a valid stream state. The stream is left unmodified if
+ *      the compressed representation is rejected.
+ *
+ * @param buf
+ *      A compressed representation of a stream. These compressed forms are
+ *      created by @ref hs_compress_stream().
+ *
+ * @param buf_size
+ *      The size in bytes of the compressed representation.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch(). This is
+ *      allowed to be NULL only if the @a onEvent callback is also NULL.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function
+ *      when a match occurs.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_reset_and_expand_stream(hs_stream_t *to_stream,
+                                      const char *buf, size_t buf_size,
+                                      hs_scratch_t *scratch,
+                                      match_event_handler onEvent,
+                                      void *context);
+
 /**
  * The block (non-streaming) regular expression scanner.
  *
@@ -336,8 +702,8 @@ hs_error_t hs_reset_and_copy_stream(hs_stream_t *to_id,
  *      The number of bytes to scan.
  *
  * @param flags
- *      Flags modifying the behaviour of this function. This parameter is
- *      provided for future use and is unused at present.
+ *      Flags modifying the behaviour of this function. This may be zero or
+ *      @ref HS_SCAN_FLAG_UNORDERED.
  *
  * @param scratch
  *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for this
@@ -380,8 +746,8 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data,
  *      of the @a data and @a length arrays.
  *
  * @param flags
- *      Flags modifying the behaviour of this function. This parameter is
- *      provided for future use and is unused at present.
+ *      Flags modifying the behaviour of this function. This may be zero or
+ *      @ref HS_SCAN_FLAG_UNORDERED.
  *
  * @param scratch
  *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for
@@ -404,57 +770,584 @@ hs_error_t hs_scan_vector(const hs_database_t *db, const char *const *data,
                           match_event_handler onEvent, void *context);
 
 /**
- * Allocate a "scratch" space for use by Hyperscan.
+ * A single, independent block of data to be scanned by @ref hs_scan_batch().
+ */
+typedef struct hs_block {
+    /**
+     * Pointer to the data to be scanned.
+     */
+    const char *data;
+
+    /**
+     * The number of bytes to scan.
+     */
+    unsigned int length;
+
+    /**
+     * The user defined pointer which will be passed to the callback function
+     * for matches found in this block.
+     */
+    void *context;
+} hs_block_t;
+
+/**
+ * The batched block (non-streaming) regular expression scanner.
  *
- * This is required for runtime use, and one scratch space per thread, or
- * concurrent caller, is required. Any allocator callback set by @ref
- * hs_set_scratch_allocator() or @ref hs_set_allocator() will be used by this
- * function.
+ * This function scans each of the given blocks against a block-mode pattern
+ * database, exactly as if @ref hs_scan() had been called once for each block
+ * in turn. The database and scratch checks and the scratch set-up are performed
+ * once for the whole batch rather than once per block, and the data of the next
+ * block is prefetched while the current block is scanned, which makes this
+ * call considerably cheaper than many calls to @ref hs_scan() on small blocks
+ * such as network packets.
+ *
+ * Each block is independent: matches are reported with offsets relative to the
+ * start of that block, and are passed the context pointer of that block. If
+ * the callback returns non-zero, scanning of the current block ceases and
+ * scanning continues with the next block in the batch.
+ *
+ * Every block is checked before the first is scanned: if any block has a NULL
+ * data pointer, @ref HS_INVALID is returned and no blocks are scanned.
  *
  * @param db
- *      The database, as produced by @ref hs_compile().
+ *      A compiled pattern database.
+ *
+ * @param blocks
+ *      An array of blocks to be scanned.
+ *
+ * @param count
+ *      Number of blocks to scan. This should correspond to the size of the @a
+ *      blocks array.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
  *
  * @param scratch
- *      On first allocation, a pointer to NULL should be provided so a new
- *      scratch can be allocated. If a scratch block has been previously
- *      allocated, then a pointer to it should be passed back in to see if it
- *      is valid for this database block. If a new scratch block is required,
- *      the original will be freed and the new one returned, otherwise the
- *      previous scratch block will be returned. On success, the scratch block
- *      will be suitable for use with the provided database in addition to any
- *      databases that original scratch space was suitable for.
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for this
+ *      database.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
  *
  * @return
- *      @ref HS_SUCCESS on successful allocation; @ref HS_NOMEM if the
- *      allocation fails.  Other errors may be returned if invalid parameters
- *      are specified.
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop for at least one of
+ *      the blocks; other values on error.
  */
-hs_error_t hs_alloc_scratch(const hs_database_t *db, hs_scratch_t **scratch);
+hs_error_t hs_scan_batch(const hs_database_t *db, const hs_block_t *blocks,
+                         unsigned int count, unsigned int flags,
+                         hs_scratch_t *scratch, match_event_handler onEvent);
 
 /**
- * Allocate a scratch space that is a clone of an existing scratch space.
+ * The block (non-streaming) regular expression scanner for small databases,
+ * which does not require a scratch space.
+ *
+ * Some simple databases, such as those consisting only of literal patterns or
+ * of a single pattern that compiles to a DFA, need very little working state
+ * to be scanned. For these databases, this function scans the given block
+ * using a small context on the stack instead of a scratch space allocated by
+ * @ref hs_alloc_scratch(), which avoids the cost of setting up the full scratch
+ * space on every call and the need to allocate one per thread.
+ *
+ * Matches are identical to those that @ref hs_scan() would report. Databases
+ * that cannot be scanned this way are rejected with @ref HS_SCRATCH_REQUIRED,
+ * which does not depend on the data being scanned; callers may therefore try
+ * this function once for a database and fall back to @ref hs_scan() if it is
+ * refused.
  *
- * This is useful when multiple concurrent threads will be using the same set
- * of compiled databases, and another scratch space is required. Any allocator
- * callback set by @ref hs_set_scratch_allocator() or @ref hs_set_allocator()
- * will be used by this function.
+ * @param db
+ *      A compiled pattern database.
  *
- * @param src
- *      The existing @ref hs_scratch_t to be cloned.
+ * @param data
+ *      Pointer to the data to be scanned.
  *
- * @param dest
- *      A pointer to the new scratch space will be returned here.
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
  *
  * @return
- *      @ref HS_SUCCESS on success; @ref HS_NOMEM if the allocation fails.
- *      Other errors may be returned if invalid parameters are specified.
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop; @ref
+ *      HS_SCRATCH_REQUIRED if the database requires a scratch space to be
+ *      scanned; other values on error.
  */
-hs_error_t hs_clone_scratch(const hs_scratch_t *src, hs_scratch_t **dest);
+hs_error_t hs_scan_small(const hs_database_t *db, const char *data,
+                         unsigned int length, unsigned int flags,
+                         match_event_handler onEvent, void *context);
 
 /**
- * Provides the size of the given scratch space.
+ * Open a resumable scan of a block of data with a block mode database.
  *
- * @param scratch
+ * The block is scanned a piece at a time by calls to @ref
+ * hs_advance_block_scan(), with each call scanning as much of the block as the
+ * caller allows, and the scan is completed by @ref hs_finish_block_scan().
+ * Between calls, the caller is free to do other work. The matches reported
+ * are the same as those that a single call to @ref hs_scan() over the whole
+ * block would report, and unlike @ref hs_scan(), the block may be longer than
+ * 4GB.
+ *
+ * The data must remain valid and unchanged, and the scratch space must not be
+ * used for any other scan, until @ref hs_finish_block_scan() has been called.
+ * A caller that interleaves other scans with a resumable scan should give the
+ * resumable scan its own scratch space with @ref hs_clone_scratch().
+ *
+ * No data is scanned by this function.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the scan. This may be zero or @ref
+ *      HS_SCAN_FLAG_UNORDERED.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for this
+ *      database, reserved for this scan until it is finished.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @param scan
+ *      On success, a pointer to the resumable scan will be returned.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_open_block_scan(const hs_database_t *db, const char *data,
+                              unsigned long long length, unsigned int flags,
+                              hs_scratch_t *scratch,
+                              match_event_handler onEvent, void *context,
+                              hs_block_scan_t **scan);
+
+/**
+ * Continue a resumable block scan opened by @ref hs_open_block_scan().
+ *
+ * Scans up to the given number of further bytes of the block, delivering
+ * matches to the callback as they are found. Some databases, and blocks too
+ * short to be worth dividing, are scanned in their entirety by the first call
+ * to this function.
+ *
+ * @param scan
+ *      The resumable scan to continue.
+ *
+ * @param max_bytes
+ *      The maximum number of further bytes to scan.
+ *
+ * @param offset
+ *      If not NULL, the number of bytes of the block scanned so far is
+ *      returned here. The scan has reached the end of the block when this is
+ *      equal to its length.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop, in which case
+ *      further calls will scan nothing and return the same value; other values
+ *      on error.
+ */
+hs_error_t hs_advance_block_scan(hs_block_scan_t *scan,
+                                 unsigned long long max_bytes,
+                                 unsigned long long *offset);
+
+/**
+ * Finish a resumable block scan opened by @ref hs_open_block_scan().
+ *
+ * Any part of the block not yet scanned is scanned, matches that depend on
+ * the end of the block are delivered, and the resources of the scan are
+ * released. The scratch space is then free for other scans.
+ *
+ * @param scan
+ *      The resumable scan to finish. This pointer is invalid after this call,
+ *      whatever the return value.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop; other values on
+ *      error.
+ */
+hs_error_t hs_finish_block_scan(hs_block_scan_t *scan);
+
+/**
+ * A single match, as delivered to a @ref match_batch_handler.
+ */
+typedef struct hs_match {
+    /**
+     * The start of match offset, with the same meaning as the @a from
+     * argument to a @ref match_event_handler.
+     */
+    unsigned long long from;
+
+    /**
+     * The offset after the last byte that matches the expression.
+     */
+    unsigned long long to;
+
+    /**
+     * The ID number of the expression that matched.
+     */
+    unsigned int id;
+} hs_match_t;
+
+/**
+ * Definition of the batched match callback function type.
+ *
+ * A callback function matching the defined type must be provided by the
+ * application calling the @ref hs_scan_buffered(), @ref
+ * hs_scan_stream_buffered() or @ref hs_close_stream_buffered() functions.
+ *
+ * Rather than calling back into the application for every match, these
+ * functions collect matches in an array held in the scratch space and hand
+ * them to this callback a batch at a time: whenever the array fills up, and
+ * once more at the end of the call for any matches that remain. Matches are
+ * delivered in the same order in which a @ref match_event_handler would have
+ * seen them.
+ *
+ * The restrictions on a @ref match_event_handler apply equally to this
+ * callback. The array is owned by the scratch space and is only valid for the
+ * duration of the call.
+ *
+ * @param matches
+ *      An array of matches.
+ *
+ * @param count
+ *      The number of matches in the @a matches array; always greater than
+ *      zero.
+ *
+ * @param context
+ *      The pointer supplied by the user to the function that produced the
+ *      matches.
+ *
+ * @return
+ *      Non-zero if the matching should cease, else zero. The effect of a
+ *      non-zero return is the same as for a @ref match_event_handler; matches
+ *      that would have been found after the last match in the batch are not
+ *      delivered.
+ */
+typedef int (*match_batch_handler)(const hs_match_t *matches,
+                                   unsigned int count, void *context);
+
+/**
+ * The block (non-streaming) regular expression scanner, delivering matches in
+ * batches.
+ *
+ * This function is equivalent to @ref hs_scan(), except that matches are
+ * collected in the scratch space and passed to @a onBatch as arrays, which
+ * keeps application code out of the scanning loop for databases that produce
+ * a high rate of matches.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for
+ *      this database.
+ *
+ * @param onBatch
+ *      Pointer to a batched match callback function. This may not be NULL.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop; other values on
+ *      error.
+ */
+hs_error_t hs_scan_buffered(const hs_database_t *db, const char *data,
+                            unsigned int length, unsigned int flags,
+                            hs_scratch_t *scratch, match_batch_handler onBatch,
+                            void *context);
+
+/**
+ * Write data to be scanned to the opened stream, delivering matches in
+ * batches.
+ *
+ * This function is equivalent to @ref hs_scan_stream(), except that matches
+ * are passed to @a onBatch as arrays, as described for @ref
+ * hs_scan_buffered(). All matches found by a write have been delivered by the
+ * time this function returns.
+ *
+ * @param id
+ *      The stream ID (returned by @ref hs_open_stream()) to which the data
+ *      will be written.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the stream. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch().
+ *
+ * @param onBatch
+ *      Pointer to a batched match callback function. This may not be NULL.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop; other values on
+ *      error.
+ */
+hs_error_t hs_scan_stream_buffered(hs_stream_t *id, const char *data,
+                                   unsigned int length, unsigned int flags,
+                                   hs_scratch_t *scratch,
+                                   match_batch_handler onBatch, void *context);
+
+/**
+ * Close a stream, delivering any end of data matches in batches.
+ *
+ * This function is equivalent to @ref hs_close_stream(), except that matches
+ * are passed to @a onBatch as arrays, as described for @ref
+ * hs_scan_buffered(). The stream is freed even if the callback returns
+ * non-zero.
+ *
+ * @param id
+ *      The stream ID returned by @ref hs_open_stream().
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch().
+ *
+ * @param onBatch
+ *      Pointer to a batched match callback function. This may not be NULL.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_close_stream_buffered(hs_stream_t *id, hs_scratch_t *scratch,
+                                    match_batch_handler onBatch,
+                                    void *context);
+
+/**
+ * Provides the number of match counters required by the counting scan
+ * functions for the given database.
+ *
+ * The counting scan functions, @ref hs_scan_count(), @ref
+ * hs_scan_stream_count() and @ref hs_close_stream_count(), take an array with
+ * one counter for each distinct expression ID in the database. Counters are
+ * indexed densely, in increasing order of expression ID; @ref
+ * hs_counter_index() gives the index for a given ID.
+ *
+ * @param database
+ *      Pointer to compiled expression database.
+ *
+ * @param count
+ *      On success, the number of counters is placed in this parameter.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_counter_size(const hs_database_t *database,
+                           unsigned int *count);
+
+/**
+ * Provides the index of the match counter for the given expression ID.
+ *
+ * @param database
+ *      Pointer to compiled expression database.
+ *
+ * @param id
+ *      An expression ID used when the database was compiled.
+ *
+ * @param index
+ *      On success, the index of the counter for @a id is placed in this
+ *      parameter. It is less than the count given by @ref hs_counter_size().
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INVALID if @a id is not used by
+ *      the database; other values on failure.
+ */
+hs_error_t hs_counter_index(const hs_database_t *database, unsigned int id,
+                            unsigned int *index);
+
+/**
+ * The block (non-streaming) regular expression scanner, counting matches per
+ * expression.
+ *
+ * This function is equivalent to @ref hs_scan(), except that no callback is
+ * made: instead, each match adds one to the counter for the matching
+ * expression in @a counts. Counters are added to rather than cleared, so that
+ * results may be accumulated over several calls. The counts are identical to
+ * the number of callbacks @ref hs_scan() would make for each expression.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for
+ *      this database.
+ *
+ * @param counts
+ *      An array of counters, with the number of entries given by @ref
+ *      hs_counter_size() for this database.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_scan_count(const hs_database_t *db, const char *data,
+                         unsigned int length, unsigned int flags,
+                         hs_scratch_t *scratch, unsigned long long *counts);
+
+/**
+ * Write data to be scanned to the opened stream, counting matches per
+ * expression.
+ *
+ * This function is equivalent to @ref hs_scan_stream(), except that matches
+ * are counted in @a counts as described for @ref hs_scan_count().
+ *
+ * @param id
+ *      The stream ID (returned by @ref hs_open_stream()) to which the data
+ *      will be written.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the stream. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch().
+ *
+ * @param counts
+ *      An array of counters, with the number of entries given by @ref
+ *      hs_counter_size() for the stream's database.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_scan_stream_count(hs_stream_t *id, const char *data,
+                                unsigned int length, unsigned int flags,
+                                hs_scratch_t *scratch,
+                                unsigned long long *counts);
+
+/**
+ * Close a stream, counting any end of data matches per expression.
+ *
+ * This function is equivalent to @ref hs_close_stream(), except that matches
+ * are counted in @a counts as described for @ref hs_scan_count().
+ *
+ * @param id
+ *      The stream ID returned by @ref hs_open_stream().
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch().
+ *
+ * @param counts
+ *      An array of counters, with the number of entries given by @ref
+ *      hs_counter_size() for the stream's database.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_close_stream_count(hs_stream_t *id, hs_scratch_t *scratch,
+                                 unsigned long long *counts);
+
+/**
+ * Allocate a "scratch" space for use by Hyperscan.
+ *
+ * This is required for runtime use, and one scratch space per thread, or
+ * concurrent caller, is required. Any allocator callback set by @ref
+ * hs_set_scratch_allocator() or @ref hs_set_allocator() will be used by this
+ * function.
+ *
+ * @param db
+ *      The database, as produced by @ref hs_compile().
+ *
+ * @param scratch
+ *      On first allocation, a pointer to NULL should be provided so a new
+ *      scratch can be allocated. If a scratch block has been previously
+ *      allocated, then a pointer to it should be passed back in to see if it
+ *      is valid for this database block. If a new scratch block is required,
+ *      the original will be freed and the new one returned, otherwise the
+ *      previous scratch block will be returned. On success, the scratch block
+ *      will be suitable for use with the provided database in addition to any
+ *      databases that original scratch space was suitable for.
+ *
+ * @return
+ *      @ref HS_SUCCESS on successful allocation; @ref HS_NOMEM if the
+ *      allocation fails.  Other errors may be returned if invalid parameters
+ *      are specified.
+ */
+hs_error_t hs_alloc_scratch(const hs_database_t *db, hs_scratch_t **scratch);
+
+/**
+ * Allocate a scratch space that is a clone of an existing scratch space.
+ *
+ * This is useful when multiple concurrent threads will be using the same set
+ * of compiled databases, and another scratch space is required. Any allocator
+ * callback set by @ref hs_set_scratch_allocator() or @ref hs_set_allocator()
+ * will be used by this function.
+ *
+ * @param src
+ *      The existing @ref hs_scratch_t to be cloned.
+ *
+ * @param dest
+ *      A pointer to the new scratch space will be returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_NOMEM if the allocation fails.
+ *      Other errors may be returned if invalid parameters are specified.
+ */
+hs_error_t hs_clone_scratch(const hs_scratch_t *src, hs_scratch_t **dest);
+
+/**
+ * Provides the size of the given scratch space.
+ *
+ * @param scratch
  *      A per-thread scratch space allocated by @ref hs_alloc_scratch() or @ref
  *      hs_clone_scratch().
  *
@@ -482,12 +1375,236 @@ hs_error_t hs_scratch_size(const hs_scratch_t *scratch, size_t *scratch_size);
  */
 hs_error_t hs_free_scratch(hs_scratch_t *scratch);
 
+/**
+ * @defgroup HS_PROFILE_STAGE Profiled scan stages
+ *
+ * Indices into the @ref hs_profile_t::stages array.
+ *
+ * @{
+ */
+
+/** The literal matchers, including the work done from their match callbacks. */
+#define HS_PROFILE_LITERAL_MATCHER  0
+
+/** The anchored pattern table, run over the start of each block or stream. */
+#define HS_PROFILE_ANCHORED         1
+
+/** Evaluation of the roles triggered by each literal match. */
+#define HS_PROFILE_ROLES            2
+
+/** Catching up the engines for non-literal components to the current offset. */
+#define HS_PROFILE_CATCHUP          3
+
+/** Start of match tracking. */
+#define HS_PROFILE_SOM              4
+
+/** The number of profiled stages. */
+#define HS_PROFILE_STAGE_COUNT      5
+
+/** @} */
+
+/**
+ * Counters for a single profiled stage of scanning, as returned in @ref
+ * hs_profile_t.
+ */
+typedef struct hs_profile_stage {
+    /** The number of times this stage was entered. */
+    unsigned long long calls;
+
+    /** The number of CPU timestamp counter cycles spent in this stage. */
+    unsigned long long cycles;
+} hs_profile_stage_t;
+
+/**
+ * The profiling counters of a scratch space, as returned by @ref
+ * hs_scratch_profile().
+ */
+typedef struct hs_profile {
+    /** The number of blocks and stream writes scanned. */
+    unsigned long long scans;
+
+    /** The number of bytes scanned. */
+    unsigned long long bytes;
+
+    /** The number of matches delivered to the match callback. */
+    unsigned long long matches;
+
+    /**
+     * Per-stage counters, indexed by the @ref HS_PROFILE_STAGE values. Stages
+     * may run from within one another, in which case the time is counted in
+     * both.
+     */
+    hs_profile_stage_t stages[HS_PROFILE_STAGE_COUNT];
+
+    /** The number of entries in the @a queue_calls array. */
+    unsigned int queue_count;
+
+    /**
+     * The number of times the engine on each internal queue was invoked. This
+     * array belongs to the scratch space and is only valid while the scratch
+     * space is neither freed nor reallocated by @ref hs_alloc_scratch().
+     */
+    const unsigned long long *queue_calls;
+
+    /** The number of entries in the @a literal_hits array. */
+    unsigned int literal_count;
+
+    /**
+     * The number of matches of each internal literal. As with @a queue_calls,
+     * this array belongs to the scratch space.
+     */
+    const unsigned long long *literal_hits;
+} hs_profile_t;
+
+/**
+ * Read the profiling counters of a scratch space.
+ *
+ * The counters are only available if the library was built with profiling
+ * support (the ENABLE_PROFILING build option), which adds some overhead to
+ * every scan. They accumulate across all scans using this scratch space until
+ * @ref hs_reset_scratch_profile() is called, or the scratch space is
+ * reallocated by @ref hs_alloc_scratch(). Scans by @ref hs_scan_small() do not
+ * use scratch and are not counted.
+ *
+ * Queue and literal indices are internal to the database; they are intended
+ * to be matched up with the output of the Hyperscan dump tools.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() or @ref
+ *      hs_clone_scratch().
+ *
+ * @param profile
+ *      On success, the counters are placed in this structure.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INVALID if the library was built
+ *      without profiling support, or on invalid parameters.
+ */
+hs_error_t hs_scratch_profile(const hs_scratch_t *scratch,
+                              hs_profile_t *profile);
+
+/**
+ * Reset the profiling counters of a scratch space to zero.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() or @ref
+ *      hs_clone_scratch().
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INVALID if the library was built
+ *      without profiling support, or on invalid parameters.
+ */
+hs_error_t hs_reset_scratch_profile(hs_scratch_t *scratch);
+
+/**
+ * Limits on the work done by a single scan call, as set with @ref
+ * hs_set_scratch_budget().
+ *
+ * A value of zero in any field means that there is no limit of that kind.
+ */
+typedef struct hs_scan_budget {
+    /**
+     * The maximum number of literal matches that may be processed by a single
+     * block scan or stream write. Each literal match may trigger further work
+     * in the engines for the patterns that contain that literal, so this
+     * bounds the cost of inputs that flood the literal matcher.
+     */
+    unsigned long long max_literal_matches;
+
+    /**
+     * The maximum number of CPU timestamp counter cycles that a single block
+     * scan or stream write may run for. The deadline is checked periodically
+     * rather than continuously: as literals are matched, as engines are run
+     * and as matches are reported. An engine scanning a long stretch of data
+     * without matching is not interrupted, so a scan may overrun the
+     * deadline.
+     */
+    unsigned long long max_cycles;
+} hs_scan_budget_t;
+
+/**
+ * Set the work budget applied to scans that use the given scratch space.
+ *
+ * When a scan by @ref hs_scan(), @ref hs_scan_vector() or @ref
+ * hs_scan_stream() (or their batched, buffered and counting variants) exceeds
+ * its budget, scanning stops and the call returns @ref
+ * HS_SCAN_BUDGET_EXCEEDED. The offset that the scan had reached can then be
+ * retrieved with @ref hs_scratch_budget_offset(). Matches that end before
+ * that offset may already have been delivered; no matches are delivered from
+ * the remainder of the data.
+ *
+ * A stream on which the budget was exceeded remains usable: its offset is
+ * advanced past the data that was written, and the next write starts with
+ * all pattern state cleared, as though the stream had been restarted at that
+ * offset. Matches that span the point at which the budget was exceeded are
+ * lost.
+ *
+ * The budget is kept in the scratch space, and carried over by @ref
+ * hs_alloc_scratch() and @ref hs_clone_scratch(). It is not applied by @ref
+ * hs_close_stream(), @ref hs_scan_small() or the resumable block scan
+ * functions.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() or @ref
+ *      hs_clone_scratch().
+ *
+ * @param budget
+ *      The limits to apply. If this is NULL, any existing budget is removed.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_INVALID on invalid parameters.
+ */
+hs_error_t hs_set_scratch_budget(hs_scratch_t *scratch,
+                                 const hs_scan_budget_t *budget);
+
+/**
+ * Retrieve the offset that the last scan using this scratch space had reached
+ * when it returned @ref HS_SCAN_BUDGET_EXCEEDED.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() or @ref
+ *      hs_clone_scratch().
+ *
+ * @param offset
+ *      On success, the offset is written here. For streams, this is an offset
+ *      from the start of the stream.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_INVALID on invalid parameters.
+ */
+hs_error_t hs_scratch_budget_offset(const hs_scratch_t *scratch,
+                                    unsigned long long *offset);
+
 /**
  * Callback 'from' return value, indicating that the start of this match was
  * too early to be tracked with the requested SOM_HORIZON precision.
  */
 #define HS_OFFSET_PAST_HORIZON    (~0ULL)
 
+/**
+ * Scan flag: matches may be delivered out of order.
+ *
+ * By default, Hyperscan reports matches in order of increasing end offset,
+ * which requires the engines that run behind the literal matcher to be caught
+ * up every time a match is reported. When this flag is passed to @ref
+ * hs_scan(), @ref hs_scan_vector() or @ref hs_scan_stream(), matches found by
+ * the literal matcher are reported as soon as they are found and the
+ * remaining engines are only caught up when Rose requires it (usually at the
+ * end of the scan call), which reduces the scanning overhead for databases
+ * with many such engines.
+ *
+ * In this mode:
+ *  - matches are not necessarily reported in order of end offset;
+ *  - identical matches (same ID and end offset) are not suppressed and may be
+ *    reported more than once;
+ *  - for patterns compiled with @ref HS_FLAG_SINGLEMATCH, the single match
+ *    reported is not necessarily the earliest one.
+ *
+ * The flag is ignored for databases that contain patterns compiled with @ref
+ * HS_FLAG_SOM_LEFTMOST, which always report matches in order.
+ */
+#define HS_SCAN_FLAG_UNORDERED    1U
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -32,6 +32,7 @@
 #include "hwlm.h"
 #include "hwlm_internal.h"
 #include "noodle_engine.h"
+#include "noodle_internal.h"
 #include "scratch.h"
 #include "ue2common.h"
 #include "fdr/fdr.h"
@@ -192,6 +193,16 @@ hwlm_error_t hwlmExec(const struct HWLM *t, const u8 *buf, size_t len,
     }
 }
 
+size_t hwlmMaxLength(const struct HWLM *t) {
+    if (t->type == HWLM_ENGINE_NOOD) {
+        const struct noodTable *n = HWLM_C_DATA(t);
+        return n->len;
+    }
+
+    assert(t->type == HWLM_ENGINE_FDR);
+    return fdrMaxLength(HWLM_C_DATA(t));
+}
+
 hwlm_error_t hwlmExecStreaming(const struct HWLM *t, struct hs_scratch *scratch,
                                size_t len, size_t start, HWLMCallback cb,
                                void *ctxt, hwlm_group_t groups,
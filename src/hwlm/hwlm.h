@@ -113,6 +113,12 @@ hwlm_error_t hwlmExec(const struct HWLM *tab, const u8 *buf, size_t len,
                       size_t start, HWLMCallback callback, void *context,
                       hwlm_group_t groups);
 
+/** \brief Returns the length of the longest literal in the table.
+ *
+ * A caller resuming a block scan part way through a buffer must restart the
+ * scan this many bytes, less one, before the resume point. */
+size_t hwlmMaxLength(const struct HWLM *tab);
+
 /** \brief As for \ref hwlmExec, but a streaming case across two buffers.
  *
  * \p scratch is used to access fdr_temp_buf and to access the history buffer,
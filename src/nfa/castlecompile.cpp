@@ -42,6 +42,7 @@
 #include "nfagraph/ng_redundancy.h"
 #include "nfagraph/ng_util.h"
 #include "util/alloc.h"
+#include "util/clique.h"
 #include "util/compile_context.h"
 #include "util/container.h"
 #include "util/dump_charclass.h"
@@ -52,7 +53,6 @@
 #include "util/verify_types.h"
 #include "grey.h"
 
-#include <stack>
 #include <cassert>
 
 #include <boost/range/adaptor/map.hpp>
@@ -107,139 +107,6 @@ void writeCastleScanEngine(const CharReach &cr, Castle *c) {
     truffleBuildMasks(negated, &c->u.truffle.mask1, &c->u.truffle.mask2);
 }
 
-static
-bool literalOverlap(const vector<CharReach> &a, const vector<CharReach> &b,
-                    const size_t dist) {
-    for (size_t i = 0; i < b.size(); i++) {
-        if (i > dist) {
-            return true;
-        }
-        size_t overlap_len = b.size() - i;
-        if (overlap_len <= a.size()) {
-            if (matches(a.end() - overlap_len, a.end(), b.begin(),
-                        b.end() - i)) {
-                return false;
-            }
-        } else {
-            assert(overlap_len > a.size());
-            if (matches(a.begin(), a.end(), b.end() - i - a.size(),
-                        b.end() - i)) {
-                return false;
-            }
-        }
-    }
-
-    return b.size() > dist;
-}
-
-struct CliqueVertexProps {
-    CliqueVertexProps() {}
-    explicit CliqueVertexProps(u32 state_in) : stateId(state_in) {}
-
-    u32 stateId = ~0U;
-};
-
-typedef boost::adjacency_list<boost::listS, boost::listS, boost::undirectedS,
-                              CliqueVertexProps> CliqueGraph;
-typedef CliqueGraph::vertex_descriptor CliqueVertex;
-
-static
-void getNeighborInfo(const CliqueGraph &g, vector<u32> &neighbor,
-                     const CliqueVertex &cv, const set<u32> &group) {
-    u32 id = g[cv].stateId;
-    ue2::unordered_set<u32> neighborId;
-
-    // find neighbors for cv
-    for (const auto &v : adjacent_vertices_range(cv, g)) {
-        if (g[v].stateId != id && contains(group, g[v].stateId)){
-            neighbor.push_back(g[v].stateId);
-            neighborId.insert(g[v].stateId);
-            DEBUG_PRINTF("Neighbor:%u\n", g[v].stateId);
-        }
-    }
-}
-
-static
-void findCliqueGroup(CliqueGraph &cg, vector<u32> &clique) {
-    stack<vector<u32>> gStack;
-
-    // Create mapping between vertex and id
-    map<u32, CliqueVertex> vertexMap;
-    vector<u32> init;
-    for (const auto &v : vertices_range(cg)) {
-        vertexMap[cg[v].stateId] = v;
-        init.push_back(cg[v].stateId);
-    }
-    gStack.push(init);
-
-    // Get the vertex to start from
-    CliqueGraph::vertex_iterator vi, ve;
-    tie(vi, ve) = vertices(cg);
-    while (!gStack.empty()) {
-        vector<u32> g = gStack.top();
-        gStack.pop();
-
-        // Choose a vertex from the graph
-        u32 id = g[0];
-        const CliqueVertex &n = vertexMap.at(id);
-        clique.push_back(id);
-        // Corresponding vertex in the original graph
-        vector<u32> neighbor;
-        set<u32> subgraphId(g.begin(), g.end());
-        getNeighborInfo(cg, neighbor, n, subgraphId);
-        // Get graph consisting of neighbors for left branch
-        if (!neighbor.empty()) {
-            gStack.push(neighbor);
-        }
-    }
-}
-
-template<typename Graph>
-bool graph_empty(const Graph &g) {
-    typename Graph::vertex_iterator vi, ve;
-    tie(vi, ve) = vertices(g);
-    return vi == ve;
-}
-
-static
-vector<u32> removeClique(CliqueGraph &cg) {
-    vector<vector<u32>> cliquesVec(1);
-    DEBUG_PRINTF("graph size:%lu\n", num_vertices(cg));
-    findCliqueGroup(cg, cliquesVec[0]);
-    while (!graph_empty(cg)) {
-        const vector<u32> &c = cliquesVec.back();
-        vector<CliqueVertex> dead;
-        for (const auto &v : vertices_range(cg)) {
-            if (find(c.begin(), c.end(), cg[v].stateId) != c.end()) {
-                dead.push_back(v);
-            }
-        }
-        for (const auto &v : dead) {
-            clear_vertex(v, cg);
-            remove_vertex(v, cg);
-        }
-        if (graph_empty(cg)) {
-            break;
-        }
-        vector<u32> clique;
-        findCliqueGroup(cg, clique);
-        cliquesVec.push_back(clique);
-    }
-
-    // get the independent set with max size
-    size_t max = 0;
-    size_t id = 0;
-    for (size_t j = 0; j < cliquesVec.size(); ++j) {
-        if (cliquesVec[j].size() > max) {
-            max = cliquesVec[j].size();
-            id = j;
-        }
-    }
-
-    DEBUG_PRINTF("clique size:%lu\n", cliquesVec[id].size());
-    return cliquesVec[id];
-}
-
 // if the location of any reset character in one literal are after
 // the end locations where it overlaps with other literals,
 // then the literals are mutual exclusive
@@ -110,6 +110,20 @@ GENERATE_NFA_DECL(nfaExecLimEx512_4)
 GENERATE_NFA_DECL(nfaExecLimEx512_5)
 GENERATE_NFA_DECL(nfaExecLimEx512_6)
 GENERATE_NFA_DECL(nfaExecLimEx512_7)
+GENERATE_NFA_DECL(nfaExecLimEx768_1)
+GENERATE_NFA_DECL(nfaExecLimEx768_2)
+GENERATE_NFA_DECL(nfaExecLimEx768_3)
+GENERATE_NFA_DECL(nfaExecLimEx768_4)
+GENERATE_NFA_DECL(nfaExecLimEx768_5)
+GENERATE_NFA_DECL(nfaExecLimEx768_6)
+GENERATE_NFA_DECL(nfaExecLimEx768_7)
+GENERATE_NFA_DECL(nfaExecLimEx1024_1)
+GENERATE_NFA_DECL(nfaExecLimEx1024_2)
+GENERATE_NFA_DECL(nfaExecLimEx1024_3)
+GENERATE_NFA_DECL(nfaExecLimEx1024_4)
+GENERATE_NFA_DECL(nfaExecLimEx1024_5)
+GENERATE_NFA_DECL(nfaExecLimEx1024_6)
+GENERATE_NFA_DECL(nfaExecLimEx1024_7)
 
 #undef GENERATE_NFA_DECL
 #undef GENERATE_NFA_DUMP_DECL
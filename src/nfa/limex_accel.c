@@ -142,6 +142,27 @@ size_t accelScanWrapper(const u8 *accelTable, const union AccelAux *aux,
     return j;
 }
 
+/** \brief Run the PSHUFB shuffle over each 128-bit lane of a multi-register
+ * state vector, combining the results. Used for models wider than 512 bits,
+ * whose permute and compare masks are laid out lane by lane. */
+static really_inline
+u32 shufflePshufbLanes(const void *state, const void *accelPerm,
+                       const void *accelComp, u32 lanes) {
+    const char *s = (const char *)state;
+    const char *perm = (const char *)accelPerm;
+    const char *comp = (const char *)accelComp;
+
+    u32 idx = 0;
+    for (u32 i = 0; i < lanes; i++) {
+        u32 lane_idx = shufflePshufb128(load128(s + i * sizeof(m128)),
+                                        load128(perm + i * sizeof(m128)),
+                                        load128(comp + i * sizeof(m128)));
+        assert((idx & lane_idx) == 0); // should be no shared bits
+        idx |= lane_idx;
+    }
+    return idx;
+}
+
 size_t doAccel32(u32 s, u32 accel, const u8 *accelTable,
                  const union AccelAux *aux, const u8 *input, size_t i,
                  size_t end) {
@@ -208,7 +229,20 @@ size_t doAccel512(const m512 *state, const struct LimExNFA512 *limex,
     DEBUG_PRINTF("using PSHUFB for 512-bit shuffle\n");
     m512 accelPerm = limex->accelPermute;
     m512 accelComp = limex->accelCompare;
-#if !defined(__AVX2__)
+#if defined(__AVX512BW__)
+    u32 idx1 = shufflePshufb128(extract128from512(s, 0),
+                                extract128from512(accelPerm, 0),
+                                extract128from512(accelComp, 0));
+    u32 idx2 = shufflePshufb128(extract128from512(s, 1),
+                                extract128from512(accelPerm, 1),
+                                extract128from512(accelComp, 1));
+    u32 idx3 = shufflePshufb128(extract128from512(s, 2),
+                                extract128from512(accelPerm, 2),
+                                extract128from512(accelComp, 2));
+    u32 idx4 = shufflePshufb128(extract128from512(s, 3),
+                                extract128from512(accelPerm, 3),
+                                extract128from512(accelComp, 3));
+#elif !defined(__AVX2__)
     u32 idx1 = shufflePshufb128(s.lo.lo, accelPerm.lo.lo, accelComp.lo.lo);
     u32 idx2 = shufflePshufb128(s.lo.hi, accelPerm.lo.hi, accelComp.lo.hi);
     u32 idx3 = shufflePshufb128(s.hi.lo, accelPerm.hi.lo, accelComp.hi.lo);
@@ -227,3 +261,23 @@ size_t doAccel512(const m512 *state, const struct LimExNFA512 *limex,
     idx = idx1 | idx2 | idx3 | idx4;
     return accelScanWrapper(accelTable, aux, input, idx, i, end);
 }
+
+size_t doAccel768(const m768 *state, const struct LimExNFA768 *limex,
+                  const u8 *accelTable, const union AccelAux *aux,
+                  const u8 *input, size_t i, size_t end) {
+    DEBUG_PRINTF("using PSHUFB for 768-bit shuffle\n");
+    u32 idx = shufflePshufbLanes(state, &limex->accelPermute,
+                                 &limex->accelCompare,
+                                 sizeof(m768) / sizeof(m128));
+    return accelScanWrapper(accelTable, aux, input, idx, i, end);
+}
+
+size_t doAccel1024(const m1024 *state, const struct LimExNFA1024 *limex,
+                   const u8 *accelTable, const union AccelAux *aux,
+                   const u8 *input, size_t i, size_t end) {
+    DEBUG_PRINTF("using PSHUFB for 1024-bit shuffle\n");
+    u32 idx = shufflePshufbLanes(state, &limex->accelPermute,
+                                 &limex->accelCompare,
+                                 sizeof(m1024) / sizeof(m128));
+    return accelScanWrapper(accelTable, aux, input, idx, i, end);
+}
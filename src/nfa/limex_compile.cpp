@@ -167,7 +167,7 @@ struct build_info {
 
 // Constants for scoring mechanism
 
-#define LAST_LIMEX_NFA LIMEX_NFA_512_7
+#define LAST_LIMEX_NFA LIMEX_NFA_1024_7
 
 const int LIMEX_INITIAL_SCORE = 2000;
 const int SHIFT_COST = 20; // limex: cost per shift mask
@@ -205,11 +205,14 @@ struct DISPATCH_BY_LIMEX_TYPE_INT<sfunc, rv_t, arg_t,
 
 // Given a number of states, find the size of the smallest container NFA it
 // will fit in. We support NFAs of the following sizes: 32, 64, 128, 256, 384,
-// 512.
+// 512, 768, 1024.
 size_t findContainerSize(size_t states) {
     if (states > 256 && states <= 384) {
         return 384;
     }
+    if (states > 512 && states <= 768) {
+        return 768;
+    }
     return 1ULL << (lg2(states - 1) + 1);
 }
 
@@ -1874,7 +1877,7 @@ struct Factory {
     static int score(const build_info &args) {
         const NGHolder &h = args.h;
 
-        // LimEx NFAs are available in sizes from 32 to 512-bit.
+        // LimEx NFAs are available in sizes from 32 to 1024-bit.
         size_t num_states = args.num_states;
 
         size_t sz = findContainerSize(num_states);
@@ -1994,6 +1997,20 @@ MAKE_LIMEX_TRAITS(512, 4)
 MAKE_LIMEX_TRAITS(512, 5)
 MAKE_LIMEX_TRAITS(512, 6)
 MAKE_LIMEX_TRAITS(512, 7)
+MAKE_LIMEX_TRAITS(768, 1)
+MAKE_LIMEX_TRAITS(768, 2)
+MAKE_LIMEX_TRAITS(768, 3)
+MAKE_LIMEX_TRAITS(768, 4)
+MAKE_LIMEX_TRAITS(768, 5)
+MAKE_LIMEX_TRAITS(768, 6)
+MAKE_LIMEX_TRAITS(768, 7)
+MAKE_LIMEX_TRAITS(1024, 1)
+MAKE_LIMEX_TRAITS(1024, 2)
+MAKE_LIMEX_TRAITS(1024, 3)
+MAKE_LIMEX_TRAITS(1024, 4)
+MAKE_LIMEX_TRAITS(1024, 5)
+MAKE_LIMEX_TRAITS(1024, 6)
+MAKE_LIMEX_TRAITS(1024, 7)
 
 } // namespace
 
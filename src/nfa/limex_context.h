@@ -70,6 +70,8 @@ GEN_CONTEXT_STRUCT(128, m128)
 GEN_CONTEXT_STRUCT(256, m256)
 GEN_CONTEXT_STRUCT(384, m384)
 GEN_CONTEXT_STRUCT(512, m512)
+GEN_CONTEXT_STRUCT(768, m768)
+GEN_CONTEXT_STRUCT(1024, m1024)
 
 #undef GEN_CONTEXT_STRUCT
 
@@ -54,6 +54,14 @@ using namespace std;
 namespace ue2 {
 
 template<typename T> struct limex_traits {};
+template<> struct limex_traits<LimExNFA1024> {
+    static const u32 size = 1024;
+    typedef NFAException1024 exception_type;
+};
+template<> struct limex_traits<LimExNFA768> {
+    static const u32 size = 768;
+    typedef NFAException768 exception_type;
+};
 template<> struct limex_traits<LimExNFA512> {
     static const u32 size = 512;
     typedef NFAException512 exception_type;
@@ -494,4 +502,20 @@ LIMEX_DUMP_FNS(m512, 512, 5)
 LIMEX_DUMP_FNS(m512, 512, 6)
 LIMEX_DUMP_FNS(m512, 512, 7)
 
+LIMEX_DUMP_FNS(m768, 768, 1)
+LIMEX_DUMP_FNS(m768, 768, 2)
+LIMEX_DUMP_FNS(m768, 768, 3)
+LIMEX_DUMP_FNS(m768, 768, 4)
+LIMEX_DUMP_FNS(m768, 768, 5)
+LIMEX_DUMP_FNS(m768, 768, 6)
+LIMEX_DUMP_FNS(m768, 768, 7)
+
+LIMEX_DUMP_FNS(m1024, 1024, 1)
+LIMEX_DUMP_FNS(m1024, 1024, 2)
+LIMEX_DUMP_FNS(m1024, 1024, 3)
+LIMEX_DUMP_FNS(m1024, 1024, 4)
+LIMEX_DUMP_FNS(m1024, 1024, 5)
+LIMEX_DUMP_FNS(m1024, 1024, 6)
+LIMEX_DUMP_FNS(m1024, 1024, 7)
+
 } // namespace ue2
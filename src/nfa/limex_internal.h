@@ -122,6 +122,8 @@ typedef m128 u_128;
 typedef m256 u_256;
 typedef m384 u_384;
 typedef m512 u_512;
+typedef m768 u_768;
+typedef m1024 u_1024;
 
 #define CREATE_NFA_LIMEX(size)                                              \
 struct NFAException##size {                                                 \
@@ -177,6 +179,8 @@ CREATE_NFA_LIMEX(128)
 CREATE_NFA_LIMEX(256)
 CREATE_NFA_LIMEX(384)
 CREATE_NFA_LIMEX(512)
+CREATE_NFA_LIMEX(768)
+CREATE_NFA_LIMEX(1024)
 
 /** \brief Structure describing a bounded repeat within the LimEx NFA.
  *
@@ -29,7 +29,7 @@
 #ifndef LIMEX_LIMITS_H
 #define LIMEX_LIMITS_H
 
-#define NFA_MAX_STATES       512 /**< max states in an NFA */
+#define NFA_MAX_STATES      1024 /**< max states in an NFA */
 #define NFA_MAX_ACCEL_STATES   8 /**< max accel states in a NFA */
 #define NFA_MAX_TOP_MASKS     32 /**< max number of MQE_TOP_N event types */
 
@@ -36,6 +36,7 @@
 #include "util/bitutils.h"
 #include "util/compare.h"
 #include "util/simd_utils.h"
+#include "util/simd_utils_ssse3.h"
 #include "ue2common.h"
 
 #include "mcclellan_common_impl.h"
@@ -277,6 +278,337 @@ char mcclellanExec16_i_ni(const struct mcclellan *m, u16 *state, const u8 *buf,
     }
 }
 
+/**
+ * \brief Runs the Sheng core of a McSheng DFA from core state *state, one
+ * PSHUFB per byte, until the DFA leaves the core, dies or reaches c_lim.
+ *
+ * Matches raised inside the core are handled here. On leaving the core,
+ * *state holds the (flagged) McClellan successor of the last byte consumed, to
+ * be handled by the caller as after any other McClellan transition. Returns
+ * MO_MATCHES_PENDING if a match paused a STOP_AT_MATCH scan.
+ */
+static really_inline
+char mcshengCore(const struct mcclellan *m, u16 *state, const u8 **c_inout,
+                 const u8 *c_lim, const u8 *buf, u64a offAdj, NfaCallback cb,
+                 void *ctxt, char single, const u8 **c_final,
+                 enum MatchMode mode, u16 *cached_accept_state,
+                 u32 *cached_accept_id) {
+    const m128 *masks = (const m128 *)((const char *)m - sizeof(struct NFA)
+                                       + m->sheng_offset);
+    const u16 *succ_table = (const u16 *)((const char *)m
+                                          + sizeof(struct mcclellan));
+    const u8 *c = *c_inout;
+    u8 s = (u8)*state;
+    assert(s && s < m->sheng_end);
+
+    m128 cur_state = set16x8(s);
+
+    while (c < c_lim) {
+        cur_state = pshufb(masks[*c], cur_state);
+        u8 tmp = (u8)movd(cur_state);
+        c++;
+
+        if (likely(!(tmp & MCSHENG_STATE_FLAGS))) {
+            s = tmp;
+            continue;
+        }
+
+        if (tmp & MCSHENG_STATE_EXIT) {
+            /* core rows are never sherman, so the plain table applies */
+            *state = succ_table[((u32)s << m->alphaShift)
+                                + m->remap[*(c - 1)]];
+            DEBUG_PRINTF("left core %hhu -> %hu\n", s,
+                         (u16)(*state & STATE_MASK));
+            *c_inout = c;
+            return MO_CONTINUE_MATCHING;
+        }
+
+        if (tmp & MCSHENG_STATE_DEAD) {
+            DEBUG_PRINTF("dead\n");
+            *state = 0;
+            *c_inout = c;
+            return MO_CONTINUE_MATCHING;
+        }
+
+        s = tmp & MCSHENG_STATE_MASK;
+        assert(tmp & MCSHENG_STATE_ACCEPT);
+
+        if (mode == NO_MATCHES) {
+            continue;
+        }
+
+        if (mode == STOP_AT_MATCH) {
+            DEBUG_PRINTF("match - pausing\n");
+            *state = s;
+            *c_final = c - 1;
+            return MO_MATCHES_PENDING;
+        }
+
+        u64a loc = (c - 1) - buf + offAdj + 1;
+        if (single) {
+            DEBUG_PRINTF("reporting %u\n", m->arb_report);
+            if (cb(loc, m->arb_report, ctxt) == MO_HALT_MATCHING) {
+                return MO_HALT_MATCHING;
+            }
+        } else if (doComplexReport(cb, ctxt, m, s, loc, 0, cached_accept_state,
+                                   cached_accept_id) == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING;
+        }
+    }
+
+    *state = s;
+    *c_inout = c;
+    return MO_CONTINUE_MATCHING;
+}
+
+/** \brief McClellan 16 execution for McSheng: as \ref mcclellanExec16_i, but
+ * states below sheng_end are run by \ref mcshengCore. */
+static really_inline
+char mcshengExec16_i(const struct mcclellan *m, u16 *state, const u8 *buf,
+                     size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                     char single, const u8 **c_final, enum MatchMode mode) {
+    assert(ISALIGNED_N(state, 2));
+
+    u16 s = *state;
+    const u8 *c = buf, *c_end = buf + len;
+    const u16 *succ_table = (const u16 *)((const char *)m
+                                          + sizeof(struct mcclellan));
+    assert(ISALIGNED_N(succ_table, 2));
+    const u16 sherman_base = m->sherman_limit;
+    const char *sherman_base_offset
+        = (const char *)m - sizeof(struct NFA) + m->sherman_offset;
+    const u32 as = m->alphaShift;
+    const u16 sheng_end = m->sheng_end;
+
+    s &= STATE_MASK;
+
+    u32 cached_accept_id = 0;
+    u16 cached_accept_state = 0;
+
+    DEBUG_PRINTF("s: %hu, len %zu\n", s, len);
+
+    const u8 *min_accel_offset = c;
+    if (!m->has_accel || len < ACCEL_MIN_LEN) {
+        min_accel_offset = c_end;
+        goto without_accel;
+    }
+
+    goto with_accel;
+
+without_accel:
+    while (c < min_accel_offset && s) {
+        if (s < sheng_end) {
+            char rv = mcshengCore(m, &s, &c, min_accel_offset, buf, offAdj, cb,
+                                  ctxt, single, c_final, mode,
+                                  &cached_accept_state, &cached_accept_id);
+            if (rv == MO_HALT_MATCHING) {
+                return MO_HALT_MATCHING;
+            }
+            if (rv == MO_MATCHES_PENDING) {
+                *state = s;
+                return MO_CONTINUE_MATCHING;
+            }
+            if ((s & STATE_MASK) < sheng_end) {
+                continue; /* still in the core, or dead */
+            }
+        } else {
+            u8 cprime = m->remap[*(c++)];
+            DEBUG_PRINTF("c: %02hhx cp:%02hhx (s=%hu)\n", *(c-1), cprime, s);
+            if (s < sherman_base) {
+                assert(s < m->state_count);
+                s = succ_table[((u32)s << as) + cprime];
+            } else {
+                const char *sherman_state
+                    = findShermanState(m, sherman_base_offset, sherman_base, s);
+                s = doSherman16(sherman_state, cprime, succ_table, as);
+            }
+        }
+        DEBUG_PRINTF("s: %hu (%hu)\n", s, (u16)(s & STATE_MASK));
+
+        if (mode != NO_MATCHES && (s & ACCEPT_FLAG)) {
+            if (mode == STOP_AT_MATCH) {
+                *state = s & STATE_MASK;
+                *c_final = c - 1;
+                return MO_CONTINUE_MATCHING;
+            }
+
+            u64a loc = (c - 1) - buf + offAdj + 1;
+
+            if (single) {
+                DEBUG_PRINTF("reporting %u\n", m->arb_report);
+                if (cb(loc, m->arb_report, ctxt) == MO_HALT_MATCHING) {
+                    return MO_HALT_MATCHING; /* termination requested */
+                }
+            } else if (doComplexReport(cb, ctxt, m, s & STATE_MASK, loc, 0,
+                                       &cached_accept_state,
+                                       &cached_accept_id) == MO_HALT_MATCHING) {
+                return MO_HALT_MATCHING;
+            }
+        }
+
+        s &= STATE_MASK;
+    }
+
+with_accel:
+    while (c < c_end && s) {
+        if (s < sheng_end) {
+            char rv = mcshengCore(m, &s, &c, c_end, buf, offAdj, cb, ctxt,
+                                  single, c_final, mode, &cached_accept_state,
+                                  &cached_accept_id);
+            if (rv == MO_HALT_MATCHING) {
+                return MO_HALT_MATCHING;
+            }
+            if (rv == MO_MATCHES_PENDING) {
+                *state = s;
+                return MO_CONTINUE_MATCHING;
+            }
+            if ((s & STATE_MASK) < sheng_end) {
+                continue; /* still in the core, or dead */
+            }
+        } else {
+            u8 cprime = m->remap[*(c++)];
+            DEBUG_PRINTF("c: %02hhx cp:%02hhx (s=%hu)\n", *(c-1), cprime, s);
+            if (s < sherman_base) {
+                assert(s < m->state_count);
+                s = succ_table[((u32)s << as) + cprime];
+            } else {
+                const char *sherman_state
+                    = findShermanState(m, sherman_base_offset, sherman_base, s);
+                s = doSherman16(sherman_state, cprime, succ_table, as);
+            }
+        }
+        DEBUG_PRINTF("s: %hu (%hu)\n", s, (u16)(s & STATE_MASK));
+
+        if (mode != NO_MATCHES && (s & ACCEPT_FLAG)) {
+            if (mode == STOP_AT_MATCH) {
+                *state = s & STATE_MASK;
+                *c_final = c - 1;
+                return MO_CONTINUE_MATCHING;
+            }
+
+            u64a loc = (c - 1) - buf + offAdj + 1;
+
+            if (single) {
+                DEBUG_PRINTF("reporting %u\n", m->arb_report);
+                if (cb(loc, m->arb_report, ctxt) == MO_HALT_MATCHING) {
+                    return MO_HALT_MATCHING; /* termination requested */
+                }
+            } else if (doComplexReport(cb, ctxt, m, s & STATE_MASK, loc, 0,
+                                       &cached_accept_state,
+                                       &cached_accept_id) == MO_HALT_MATCHING) {
+                return MO_HALT_MATCHING;
+            }
+        } else if (s & ACCEL_FLAG) {
+            DEBUG_PRINTF("skipping\n");
+            const struct mstate_aux *this_aux = get_aux(m, s & STATE_MASK);
+            u32 accel_offset = this_aux->accel_offset;
+
+            assert(accel_offset >= m->aux_offset);
+            assert(accel_offset < m->sherman_offset);
+
+            const union AccelAux *aaux
+                = (const void *)((const char *)m + accel_offset);
+            const u8 *c2 = run_accel(aaux, c, c_end);
+
+            if (c2 < min_accel_offset + BAD_ACCEL_DIST) {
+                min_accel_offset = c2 + BIG_ACCEL_PENALTY;
+            } else {
+                min_accel_offset = c2 + SMALL_ACCEL_PENALTY;
+            }
+
+            if (min_accel_offset >= c_end - ACCEL_MIN_LEN) {
+                min_accel_offset = c_end;
+            }
+
+            DEBUG_PRINTF("advanced %zd, next accel chance in %zd/%zd\n",
+                         c2 - c, min_accel_offset - c2, c_end - c2);
+
+            c = c2;
+            s &= STATE_MASK;
+            goto without_accel;
+        }
+
+        s &= STATE_MASK;
+    }
+
+    if (mode == STOP_AT_MATCH) {
+        *c_final = c_end;
+    }
+    *state = s;
+
+    return MO_CONTINUE_MATCHING;
+}
+
+static never_inline
+char mcshengExec16_i_cb(const struct mcclellan *m, u16 *state, const u8 *buf,
+                        size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                        char single, const u8 **final_point) {
+    return mcshengExec16_i(m, state, buf, len, offAdj, cb, ctxt, single,
+                           final_point, CALLBACK_OUTPUT);
+}
+
+static never_inline
+char mcshengExec16_i_sam(const struct mcclellan *m, u16 *state, const u8 *buf,
+                         size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                         char single, const u8 **final_point) {
+    return mcshengExec16_i(m, state, buf, len, offAdj, cb, ctxt, single,
+                           final_point, STOP_AT_MATCH);
+}
+
+static never_inline
+char mcshengExec16_i_nm(const struct mcclellan *m, u16 *state, const u8 *buf,
+                        size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                        char single, const u8 **final_point) {
+    return mcshengExec16_i(m, state, buf, len, offAdj, cb, ctxt, single,
+                           final_point, NO_MATCHES);
+}
+
+static really_inline
+char mcshengExec16_i_ni(const struct mcclellan *m, u16 *state, const u8 *buf,
+                        size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                        char single, const u8 **final_point,
+                        enum MatchMode mode) {
+    if (mode == CALLBACK_OUTPUT) {
+        return mcshengExec16_i_cb(m, state, buf, len, offAdj, cb, ctxt,
+                                  single, final_point);
+    } else if (mode == STOP_AT_MATCH) {
+        return mcshengExec16_i_sam(m, state, buf, len, offAdj, cb, ctxt,
+                                   single, final_point);
+    } else {
+        assert (mode == NO_MATCHES);
+        return mcshengExec16_i_nm(m, state, buf, len, offAdj, cb, ctxt,
+                                  single, final_point);
+    }
+}
+
+/**
+ * Advances two bytes at once using the wide table, if there is one and the
+ * state passed through in the middle of the pair is not flagged in
+ * slow_flags. Returns 0 if the caller must take a single byte step instead.
+ */
+static really_inline
+char mcclellanWideStep8(const struct mcclellan *m, const u16 *wide_table,
+                        u8 *s, const u8 **c_inout, const u8 *c_end,
+                        u16 slow_flags) {
+    const u8 *c = *c_inout;
+    if (!wide_table || c + 1 >= c_end) {
+        return 0;
+    }
+
+    const u32 as = m->alphaShift;
+    u16 w = wide_table[((u32)*s << (2 * as)) + ((u32)m->remap[c[0]] << as)
+                       + m->remap[c[1]]];
+    if (w & slow_flags) {
+        return 0;
+    }
+
+    DEBUG_PRINTF("c: %02hhx %02hhx wide -> s: %hu\n", c[0], c[1],
+                 (u16)(w & MCCLELLAN_WIDE_STATE_MASK));
+    *s = (u8)(w & MCCLELLAN_WIDE_STATE_MASK);
+    *c_inout = c + 2;
+    return 1;
+}
+
 static really_inline
 char mcclellanExec8_i(const struct mcclellan *m, u8 *state, const u8 *buf,
                       size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
@@ -294,6 +626,15 @@ char mcclellanExec8_i(const struct mcclellan *m, u8 *state, const u8 *buf,
     u16 accel_limit = m->accel_limit_8;
     u16 accept_limit = m->accept_limit_8;
 
+    const u16 *wide_table = NULL;
+    if (m->wide_offset) {
+        wide_table = (const u16 *)((const char *)m + m->wide_offset
+                                   - sizeof(struct NFA));
+    }
+
+    /* middle states which must be seen one byte at a time */
+    const u16 wide_slow_accept = mode == NO_MATCHES ? 0 : MCCLELLAN_WIDE_ACCEPT;
+
     u32 cached_accept_id = 0;
     u16 cached_accept_state = 0;
 
@@ -311,11 +652,14 @@ char mcclellanExec8_i(const struct mcclellan *m, u8 *state, const u8 *buf,
 
 without_accel:
     while (c < min_accel_offset && s) {
-        u8 cprime = m->remap[*(c++)];
-        DEBUG_PRINTF("c: %02hhx '%c' cp:%02hhx\n", *(c-1),
-                     ourisprint(*(c-1)) ? *(c-1) : '?', cprime);
-        s = succ_table[((u32)s << as) + cprime];
-        DEBUG_PRINTF("s: %hhu\n", s);
+        if (!mcclellanWideStep8(m, wide_table, &s, &c, min_accel_offset,
+                                wide_slow_accept)) {
+            u8 cprime = m->remap[*(c++)];
+            DEBUG_PRINTF("c: %02hhx '%c' cp:%02hhx\n", *(c-1),
+                         ourisprint(*(c-1)) ? *(c-1) : '?', cprime);
+            s = succ_table[((u32)s << as) + cprime];
+            DEBUG_PRINTF("s: %hhu\n", s);
+        }
 
         if (mode != NO_MATCHES && s >= accept_limit) {
             if (mode == STOP_AT_MATCH) {
@@ -342,11 +686,14 @@ without_accel:
 
 with_accel:
     while (c < c_end && s) {
-        u8 cprime = m->remap[*(c++)];
-        DEBUG_PRINTF("c: %02hhx '%c' cp:%02hhx\n", *(c-1),
-                     ourisprint(*(c-1)) ? *(c-1) : '?', cprime);
-        s = succ_table[((u32)s << as) + cprime];
-        DEBUG_PRINTF("s: %hhu\n", s);
+        if (!mcclellanWideStep8(m, wide_table, &s, &c, c_end,
+                                MCCLELLAN_WIDE_ACCEL)) {
+            u8 cprime = m->remap[*(c++)];
+            DEBUG_PRINTF("c: %02hhx '%c' cp:%02hhx\n", *(c-1),
+                         ourisprint(*(c-1)) ? *(c-1) : '?', cprime);
+            s = succ_table[((u32)s << as) + cprime];
+            DEBUG_PRINTF("s: %hhu\n", s);
+        }
 
         if (s >= accel_limit) { /* accept_limit >= accel_limit */
             if (mode != NO_MATCHES && s >= accept_limit) {
@@ -455,12 +802,13 @@ void mcclellanCheckEOD(const struct NFA *nfa, u16 s, u64a offset,
     }
 }
 
+/* sheng: non-zero for McSheng, which runs its core states with PSHUFB */
 static really_inline
 char nfaExecMcClellan16_Q2i(const struct NFA *n, u64a offset, const u8 *buffer,
                             const u8 *hend, NfaCallback cb, void *context,
                             struct mq *q, char single, s64a end,
-                            enum MatchMode mode) {
-    assert(n->type == MCCLELLAN_NFA_16);
+                            enum MatchMode mode, char sheng) {
+    assert(n->type == (sheng ? MCSHENG_NFA_16 : MCCLELLAN_NFA_16));
     const struct mcclellan *m = getImplNfa(n);
     s64a sp;
 
@@ -527,10 +875,17 @@ char nfaExecMcClellan16_Q2i(const struct NFA *n, u64a offset, const u8 *buffer,
 
         /* do main buffer region */
         const u8 *final_look;
-        if (mcclellanExec16_i_ni(m, &s, cur_buf + sp, local_ep - sp,
-                                 offset + sp, cb, context, single, &final_look,
-                                 report ? mode : NO_MATCHES)
-            == MO_HALT_MATCHING) {
+        char rv;
+        if (sheng) {
+            rv = mcshengExec16_i_ni(m, &s, cur_buf + sp, local_ep - sp,
+                                    offset + sp, cb, context, single,
+                                    &final_look, report ? mode : NO_MATCHES);
+        } else {
+            rv = mcclellanExec16_i_ni(m, &s, cur_buf + sp, local_ep - sp,
+                                      offset + sp, cb, context, single,
+                                      &final_look, report ? mode : NO_MATCHES);
+        }
+        if (rv == MO_HALT_MATCHING) {
             assert(report);
             *(u16 *)q->state = 0;
             return 0;
@@ -593,14 +948,21 @@ char nfaExecMcClellan16_Q2i(const struct NFA *n, u64a offset, const u8 *buffer,
 static really_inline really_flatten
 char nfaExecMcClellan16_Bi(const struct NFA *n, u64a offset,
                            const u8 *buffer, size_t length,
-                           NfaCallback cb, void *context, char single) {
-    assert(n->type == MCCLELLAN_NFA_16);
+                           NfaCallback cb, void *context, char single,
+                           char sheng) {
+    assert(n->type == (sheng ? MCSHENG_NFA_16 : MCCLELLAN_NFA_16));
     const struct mcclellan *m = getImplNfa(n);
     u16 s = m->start_anchored;
 
-    if (mcclellanExec16_i(m, &s, buffer, length, offset, cb, context, single,
-                          NULL, CALLBACK_OUTPUT)
-        == MO_HALT_MATCHING) {
+    char rv;
+    if (sheng) {
+        rv = mcshengExec16_i(m, &s, buffer, length, offset, cb, context,
+                             single, NULL, CALLBACK_OUTPUT);
+    } else {
+        rv = mcclellanExec16_i(m, &s, buffer, length, offset, cb, context,
+                               single, NULL, CALLBACK_OUTPUT);
+    }
+    if (rv == MO_HALT_MATCHING) {
         return 0;
     }
 
@@ -802,9 +1164,11 @@ char nfaExecMcClellan16_B(const struct NFA *n, u64a offset, const u8 *buffer,
     const struct mcclellan *m = getImplNfa(n);
 
     if (m->flags & MCCLELLAN_FLAG_SINGLE) {
-        return nfaExecMcClellan16_Bi(n, offset, buffer, length, cb, context, 1);
+        return nfaExecMcClellan16_Bi(n, offset, buffer, length, cb, context, 1,
+                                     0);
     } else {
-        return nfaExecMcClellan16_Bi(n, offset, buffer, length, cb, context, 0);
+        return nfaExecMcClellan16_Bi(n, offset, buffer, length, cb, context, 0,
+                                     0);
     }
 }
 
@@ -819,7 +1183,7 @@ char nfaExecMcClellan16_Q(const struct NFA *n, struct mq *q, s64a end) {
 
     return nfaExecMcClellan16_Q2i(n, offset, buffer, hend, cb, context, q,
                                   m->flags & MCCLELLAN_FLAG_SINGLE, end,
-                                  CALLBACK_OUTPUT);
+                                  CALLBACK_OUTPUT, 0);
 }
 
 char nfaExecMcClellan8_reportCurrent(const struct NFA *n, struct mq *q) {
@@ -951,7 +1315,7 @@ char nfaExecMcClellan16_Q2(const struct NFA *n, struct mq *q, s64a end) {
 
     return nfaExecMcClellan16_Q2i(n, offset, buffer, hend, cb, context, q,
                                   m->flags & MCCLELLAN_FLAG_SINGLE, end,
-                                  STOP_AT_MATCH);
+                                  STOP_AT_MATCH, 0);
 }
 
 char nfaExecMcClellan8_QR(const struct NFA *n, struct mq *q, ReportID report) {
@@ -984,7 +1348,60 @@ char nfaExecMcClellan16_QR(const struct NFA *n, struct mq *q, ReportID report) {
 
     char rv = nfaExecMcClellan16_Q2i(n, offset, buffer, hend, cb, context, q,
                                      m->flags & MCCLELLAN_FLAG_SINGLE,
-                                     0 /* end */, NO_MATCHES);
+                                     0 /* end */, NO_MATCHES, 0);
+
+    if (rv && nfaExecMcClellan16_inAccept(n, report, q)) {
+        return MO_MATCHES_PENDING;
+    } else {
+        return rv;
+    }
+}
+
+char nfaExecMcSheng16_B(const struct NFA *n, u64a offset, const u8 *buffer,
+                        size_t length, NfaCallback cb, void *context) {
+    assert(n->type == MCSHENG_NFA_16);
+    const struct mcclellan *m = getImplNfa(n);
+
+    if (m->flags & MCCLELLAN_FLAG_SINGLE) {
+        return nfaExecMcClellan16_Bi(n, offset, buffer, length, cb, context, 1,
+                                     1);
+    } else {
+        return nfaExecMcClellan16_Bi(n, offset, buffer, length, cb, context, 0,
+                                     1);
+    }
+}
+
+char nfaExecMcSheng16_Q(const struct NFA *n, struct mq *q, s64a end) {
+    assert(n->type == MCSHENG_NFA_16);
+    const struct mcclellan *m = getImplNfa(n);
+    const u8 *hend = q->history + q->hlength;
+
+    return nfaExecMcClellan16_Q2i(n, q->offset, q->buffer, hend, q->cb,
+                                  q->context, q,
+                                  m->flags & MCCLELLAN_FLAG_SINGLE, end,
+                                  CALLBACK_OUTPUT, 1);
+}
+
+char nfaExecMcSheng16_Q2(const struct NFA *n, struct mq *q, s64a end) {
+    assert(n->type == MCSHENG_NFA_16);
+    const struct mcclellan *m = getImplNfa(n);
+    const u8 *hend = q->history + q->hlength;
+
+    return nfaExecMcClellan16_Q2i(n, q->offset, q->buffer, hend, q->cb,
+                                  q->context, q,
+                                  m->flags & MCCLELLAN_FLAG_SINGLE, end,
+                                  STOP_AT_MATCH, 1);
+}
+
+char nfaExecMcSheng16_QR(const struct NFA *n, struct mq *q, ReportID report) {
+    assert(n->type == MCSHENG_NFA_16);
+    const struct mcclellan *m = getImplNfa(n);
+    const u8 *hend = q->history + q->hlength;
+
+    char rv = nfaExecMcClellan16_Q2i(n, q->offset, q->buffer, hend, q->cb,
+                                     q->context, q,
+                                     m->flags & MCCLELLAN_FLAG_SINGLE,
+                                     0 /* end */, NO_MATCHES, 1);
 
     if (rv && nfaExecMcClellan16_inAccept(n, report, q)) {
         return MO_MATCHES_PENDING;
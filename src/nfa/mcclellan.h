@@ -81,6 +81,25 @@ char nfaExecMcClellan16_expandState(const struct NFA *nfa, void *dest,
 #define nfaExecMcClellan16_B_Reverse NFA_API_NO_IMPL
 #define nfaExecMcClellan16_zombie_status NFA_API_ZOMBIE_NO_IMPL
 
+// 16-bit McClellan with a Sheng core (McSheng): the states nearest the start
+// are run with PSHUFB transitions, the rest as 16-bit McClellan. Only the scan
+// loops differ; state handling is shared with McClellan 16.
+
+char nfaExecMcSheng16_Q(const struct NFA *n, struct mq *q, s64a end);
+char nfaExecMcSheng16_Q2(const struct NFA *n, struct mq *q, s64a end);
+char nfaExecMcSheng16_QR(const struct NFA *n, struct mq *q, ReportID report);
+
+#define nfaExecMcSheng16_testEOD nfaExecMcClellan16_testEOD
+#define nfaExecMcSheng16_reportCurrent nfaExecMcClellan16_reportCurrent
+#define nfaExecMcSheng16_inAccept nfaExecMcClellan16_inAccept
+#define nfaExecMcSheng16_queueInitState nfaExecMcClellan16_queueInitState
+#define nfaExecMcSheng16_initCompressedState \
+    nfaExecMcClellan16_initCompressedState
+#define nfaExecMcSheng16_queueCompressState nfaExecMcClellan16_queueCompressState
+#define nfaExecMcSheng16_expandState nfaExecMcClellan16_expandState
+#define nfaExecMcSheng16_B_Reverse NFA_API_NO_IMPL
+#define nfaExecMcSheng16_zombie_status NFA_API_ZOMBIE_NO_IMPL
+
 /**
  * Simple streaming mode calls:
  * - always uses the anchored start state regardless if top is set regardless of
@@ -106,4 +125,7 @@ char nfaExecMcClellan8_B(const struct NFA *n, u64a offset, const u8 *buffer,
 char nfaExecMcClellan16_B(const struct NFA *n, u64a offset, const u8 *buffer,
                           size_t length, NfaCallback cb, void *context);
 
+char nfaExecMcSheng16_B(const struct NFA *n, u64a offset, const u8 *buffer,
+                        size_t length, NfaCallback cb, void *context);
+
 #endif
@@ -64,6 +64,23 @@ struct mstate_aux {
 
 #define MCCLELLAN_FLAG_SINGLE 1  /**< we raise only single accept id */
 
+/* Sheng core of a McSheng engine: byte i of shuffle mask c holds the successor
+ * of core state i on character c in its low four bits, plus flags. */
+#define MCSHENG_STATE_MASK   0xf
+#define MCSHENG_STATE_ACCEPT 0x10
+#define MCSHENG_STATE_DEAD   0x20
+#define MCSHENG_STATE_EXIT   0x40 /**< successor lies outside the core */
+#define MCSHENG_STATE_FLAGS  0x70
+#define MCSHENG_MAX_STATES   16   /**< core states, including dead */
+
+/* Two-byte stride table of a McClellan 8 engine: entry (s, c1, c2) holds the
+ * state reached from s on c1 then c2 in its low byte, plus flags describing
+ * the state reached after c1. */
+#define MCCLELLAN_WIDE_STATE_MASK 0xff
+#define MCCLELLAN_WIDE_ACCEPT     0x100 /**< middle state is an accept state */
+#define MCCLELLAN_WIDE_ACCEL      0x200 /**< middle state is >= accel_limit_8 */
+#define MCCLELLAN_WIDE_MAX_SHIFT  4     /**< largest alphaShift given a table */
+
 struct mcclellan {
     u16 state_count; /**< total number of states */
     u32 length; /**< length of dfa in bytes */
@@ -86,6 +103,12 @@ struct mcclellan {
     ReportID arb_report; /**< one of the accepts that this dfa may raise */
     u32 accel_offset; /**< offset of the accel structures from start of NFA */
     u32 haig_offset; /**< reserved for use by Haig, relative to start of NFA */
+    u32 sheng_offset; /**< McSheng only: offset of the 256 core shuffle masks
+                       * relative to the start of the NFA */
+    u16 sheng_end; /**< McSheng only: states below this form the core */
+    u32 wide_offset; /**< McClellan 8 only: offset of the two-byte stride
+                      * table relative to the start of the nfa structure; 0 if
+                      * there is none */
 };
 
 static really_inline
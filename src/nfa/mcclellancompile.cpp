@@ -43,6 +43,7 @@
 #include "util/container.h"
 #include "util/make_unique.h"
 #include "util/order_check.h"
+#include "util/simd_types.h"
 #include "util/ue2_containers.h"
 #include "util/unaligned.h"
 #include "util/verify_types.h"
@@ -51,6 +52,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <map>
 #include <memory>
 #include <set>
@@ -66,6 +68,8 @@ namespace ue2 {
                                    sets of states */
 #define ACCEL_MAX_FLOATING_STOP_CHAR 192 /* accelerating sds is important */
 
+#define MAX_WIDE_TABLE_SIZE (16 * 1024) /* two-byte stride table limit */
+
 
 namespace /* anon */ {
 
@@ -650,9 +654,11 @@ void fillInAux(mstate_aux *aux, dstate_id_t i, const dfa_info &info,
                              : info.raw.start_floating);
 }
 
-/* returns non-zero on error */
+/* returns non-zero on error; states in sheng_core (McSheng only) are given
+ * the lowest ids after dead */
 static
-int allocateFSN16(dfa_info &info, dstate_id_t *sherman_base) {
+int allocateFSN16(dfa_info &info, dstate_id_t *sherman_base,
+                  const vector<dstate_id_t> &sheng_core) {
     info.states[0].impl_id = 0; /* dead is always 0 */
 
     vector<dstate_id_t> norm;
@@ -664,8 +670,16 @@ int allocateFSN16(dfa_info &info, dstate_id_t *sherman_base) {
         return 1;
     }
 
+    vector<bool> in_core(info.size(), false);
+    for (dstate_id_t s : sheng_core) {
+        assert(!info.is_sherman(s));
+        in_core[s] = true;
+    }
+
     for (u32 i = 1; i < info.size(); i++) {
-        if (info.is_sherman(i)) {
+        if (in_core[i]) {
+            continue;
+        } else if (info.is_sherman(i)) {
             sherm.push_back(i);
         } else {
             norm.push_back(i);
@@ -673,6 +687,9 @@ int allocateFSN16(dfa_info &info, dstate_id_t *sherman_base) {
     }
 
     dstate_id_t next_norm = 1;
+    for (const dstate_id_t &s : sheng_core) {
+        info.states[s].impl_id = next_norm++;
+    }
     for (const dstate_id_t &s : norm) {
         info.states[s].impl_id = next_norm++;
     }
@@ -690,10 +707,93 @@ int allocateFSN16(dfa_info &info, dstate_id_t *sherman_base) {
     return (next_sherman - 1) != ((next_sherman - 1) & STATE_MASK);
 }
 
+/**
+ * \brief Picks the Sheng core of a McSheng DFA: the non-accelerable states
+ * closest to the start states, in breadth-first order, up to one fewer than
+ * the number of lanes in a shuffle mask (lane 0 is the dead state).
+ *
+ * Accelerable states are left out, as they run faster as McClellan states,
+ * but the search continues through them.
+ * Core states are made non-sherman, as leaving the core reads their full
+ * transition table row.
+ */
+static
+vector<dstate_id_t> findShengCore(dfa_info &info) {
+    vector<dstate_id_t> core;
+    vector<bool> seen(info.size(), false);
+    seen[DEAD_STATE] = true;
+
+    deque<dstate_id_t> pending;
+    for (dstate_id_t start : {info.raw.start_floating,
+                              info.raw.start_anchored}) {
+        if (!seen[start]) {
+            seen[start] = true;
+            pending.push_back(start);
+        }
+    }
+
+    while (!pending.empty() && core.size() < MCSHENG_MAX_STATES - 1) {
+        dstate_id_t s = pending.front();
+        pending.pop_front();
+
+        if (!info.is_accel(s)) {
+            core.push_back(s);
+            info.extra[s].shermanState = false;
+        }
+
+        for (u16 j = 0; j < info.impl_alpha_size; j++) {
+            dstate_id_t succ = info.states[s].next[j];
+            if (!seen[succ]) {
+                seen[succ] = true;
+                pending.push_back(succ);
+            }
+        }
+    }
+
+    DEBUG_PRINTF("sheng core of %zu states\n", core.size());
+    return core;
+}
+
+/** \brief Fills in the core shuffle masks of a McSheng DFA. Must be called
+ * once impl ids have been allocated. */
+static
+void fillShengMasks(const dfa_info &info, const vector<dstate_id_t> &core,
+                    m128 *masks) {
+    const u16 sheng_end = verify_u16(core.size() + 1);
+
+    for (u32 c = 0; c < N_CHARS; c++) {
+        u8 mask[sizeof(m128)];
+        /* lane 0 is dead; lanes past the core are never selected */
+        memset(mask, MCSHENG_STATE_DEAD, sizeof(mask));
+
+        for (dstate_id_t s : core) {
+            u16 fs = info.implId(s);
+            assert(fs && fs < sheng_end);
+            dstate_id_t succ = info.states[s].next[info.alpha_remap[c]];
+            u16 succ_id = info.implId(succ);
+
+            if (succ == DEAD_STATE) {
+                mask[fs] = MCSHENG_STATE_DEAD;
+            } else if (succ_id >= sheng_end) {
+                mask[fs] = verify_u8(fs) | MCSHENG_STATE_EXIT;
+            } else {
+                mask[fs] = verify_u8(succ_id);
+                if (!info.states[succ].reports.empty()) {
+                    mask[fs] |= MCSHENG_STATE_ACCEPT;
+                }
+            }
+        }
+
+        memcpy(&masks[c], mask, sizeof(mask));
+    }
+}
+
+/* use_sheng: build a McSheng DFA; returns nullptr if it has no useful core */
 static
 aligned_unique_ptr<NFA> mcclellanCompile16(dfa_info &info,
-                                           const CompileContext &cc) {
-    DEBUG_PRINTF("building mcclellan 16\n");
+                                           const CompileContext &cc,
+                                           bool use_sheng = false) {
+    DEBUG_PRINTF("building mcclellan 16%s\n", use_sheng ? " (sheng)" : "");
 
     vector<u32> reports; /* index in ri for the appropriate report list */
     vector<u32> reports_eod; /* as above */
@@ -704,8 +804,20 @@ aligned_unique_ptr<NFA> mcclellanCompile16(dfa_info &info,
     u8 alphaShift = info.getAlphaShift();
     assert(alphaShift <= 8);
 
+    /* acceleration info is needed before state allocation to pick the core */
+    populateAccelerationInfo(info, &accelCount, cc.grey);
+
+    vector<dstate_id_t> sheng_core;
+    if (use_sheng) {
+        sheng_core = findShengCore(info);
+        if (sheng_core.empty()) {
+            DEBUG_PRINTF("no sheng core\n");
+            return nullptr;
+        }
+    }
+
     u16 count_real_states;
-    if (allocateFSN16(info, &count_real_states)) {
+    if (allocateFSN16(info, &count_real_states, sheng_core)) {
         DEBUG_PRINTF("failed to allocate state numbers, %zu states total\n",
                      info.size());
         return nullptr;
@@ -713,7 +825,6 @@ aligned_unique_ptr<NFA> mcclellanCompile16(dfa_info &info,
 
     unique_ptr<raw_report_info> ri
         = info.strat.gatherReports(reports, reports_eod, &single, &arb);
-    populateAccelerationInfo(info, &accelCount, cc.grey);
 
     size_t tran_size = (1 << info.getAlphaShift())
         * sizeof(u16) * count_real_states;
@@ -726,8 +837,10 @@ aligned_unique_ptr<NFA> mcclellanCompile16(dfa_info &info,
                                     + ri->getReportListSize(), 32);
     size_t sherman_offset = ROUNDUP_16(accel_offset + accel_size);
     size_t sherman_size = calcShermanRegionSize(info);
+    size_t sheng_offset = ROUNDUP_16(sherman_offset + sherman_size);
+    size_t sheng_size = use_sheng ? sizeof(m128) * N_CHARS : 0;
 
-    size_t total_size = sherman_offset + sherman_size;
+    size_t total_size = sheng_offset + sheng_size;
 
     accel_offset -= sizeof(NFA); /* adj accel offset to be relative to m */
     assert(ISALIGNED_N(accel_offset, alignof(union AccelAux)));
@@ -748,7 +861,7 @@ aligned_unique_ptr<NFA> mcclellanCompile16(dfa_info &info,
 
     /* copy in the mc header information */
     m->sherman_offset = sherman_offset;
-    m->sherman_end = total_size;
+    m->sherman_end = sherman_offset + sherman_size;
     m->sherman_limit = count_real_states;
 
     /* do normal states */
@@ -836,6 +949,13 @@ aligned_unique_ptr<NFA> mcclellanCompile16(dfa_info &info,
 
     markEdges(nfa.get(), succ_table, info);
 
+    if (use_sheng) {
+        nfa->type = MCSHENG_NFA_16;
+        m->sheng_offset = verify_u32(sheng_offset);
+        m->sheng_end = verify_u16(sheng_core.size() + 1);
+        fillShengMasks(info, sheng_core, (m128 *)(nfa_base + sheng_offset));
+    }
+
     return nfa;
 }
 
@@ -913,9 +1033,63 @@ void allocateFSN8(dfa_info &info, u16 *accel_limit, u16 *accept_limit) {
     }
 }
 
+/**
+ * Size of the two-byte stride table for a McClellan 8 engine, or zero if the
+ * alphabet is too large or the table would not fit comfortably in cache.
+ */
+static
+size_t wideTableSize(const dfa_info &info, const Grey &grey) {
+    if (!grey.allowWideMcClellan) {
+        return 0;
+    }
+
+    u8 alphaShift = info.getAlphaShift();
+    if (alphaShift > MCCLELLAN_WIDE_MAX_SHIFT) {
+        return 0;
+    }
+
+    size_t wide_size = sizeof(u16) * info.size() << (2 * alphaShift);
+    if (wide_size > MAX_WIDE_TABLE_SIZE) {
+        DEBUG_PRINTF("wide table too large (%zu)\n", wide_size);
+        return 0;
+    }
+
+    return wide_size;
+}
+
+/**
+ * Fills in the two-byte stride table from the finished single byte table.
+ * Pairs passing through an accept or accel state are flagged so that the
+ * runtime can step through them one byte at a time.
+ */
+static
+void fillWideTable8(const mcclellan *m, const u8 *succ_table, u16 *wide) {
+    const u32 as = m->alphaShift;
+    const u32 alpha = 1U << as;
+
+    for (u32 s = 0; s < m->state_count; s++) {
+        for (u32 c1 = 0; c1 < alpha; c1++) {
+            u8 mid = succ_table[(s << as) + c1];
+            u16 flags = 0;
+            if (mid >= m->accept_limit_8) {
+                flags |= MCCLELLAN_WIDE_ACCEPT;
+            }
+            if (mid >= m->accel_limit_8) {
+                flags |= MCCLELLAN_WIDE_ACCEL;
+            }
+
+            for (u32 c2 = 0; c2 < alpha; c2++) {
+                u8 succ = succ_table[((u32)mid << as) + c2];
+                wide[(s << (2 * as)) + (c1 << as) + c2] = flags | succ;
+            }
+        }
+    }
+}
+
 static
 aligned_unique_ptr<NFA> mcclellanCompile8(dfa_info &info,
-                                          const CompileContext &cc) {
+                                          const CompileContext &cc,
+                                          bool allow_wide) {
     DEBUG_PRINTF("building mcclellan 8\n");
 
     vector<u32> reports;
@@ -934,13 +1108,17 @@ aligned_unique_ptr<NFA> mcclellanCompile8(dfa_info &info,
     size_t accel_size = info.strat.accelSize() * accelCount;
     size_t accel_offset = ROUNDUP_N(aux_offset + aux_size
                                      + ri->getReportListSize(), 32);
-    size_t total_size = accel_offset + accel_size;
+    size_t wide_size = allow_wide ? wideTableSize(info, cc.grey) : 0;
+    size_t wide_offset = ROUNDUP_16(accel_offset + accel_size);
+    size_t total_size = wide_size ? wide_offset + wide_size
+                                  : accel_offset + accel_size;
 
     DEBUG_PRINTF("aux_size %zu\n", aux_size);
     DEBUG_PRINTF("aux_offset %zu\n", aux_offset);
     DEBUG_PRINTF("rl size %u\n", ri->getReportListSize());
     DEBUG_PRINTF("accel_size %zu\n", accel_size);
     DEBUG_PRINTF("accel_offset %zu\n", accel_offset);
+    DEBUG_PRINTF("wide_size %zu\n", wide_size);
     DEBUG_PRINTF("total_size %zu\n", total_size);
 
     accel_offset -= sizeof(NFA); /* adj accel offset to be relative to m */
@@ -979,6 +1157,11 @@ aligned_unique_ptr<NFA> mcclellanCompile8(dfa_info &info,
 
     assert(accel_offset + sizeof(NFA) <= total_size);
 
+    if (wide_size) {
+        m->wide_offset = verify_u32(wide_offset);
+        fillWideTable8(m, succ_table, (u16 *)(nfa_base + wide_offset));
+    }
+
     DEBUG_PRINTF("rl size %zu\n", ri->size());
 
     return nfa;
@@ -1174,7 +1357,8 @@ void fillAccelOut(const dfa_info &info, set<dstate_id_t> *accel_states) {
 
 aligned_unique_ptr<NFA> mcclellanCompile_i(raw_dfa &raw, dfa_build_strat &strat,
                                            const CompileContext &cc,
-                                           set<dstate_id_t> *accel_states) {
+                                           set<dstate_id_t> *accel_states,
+                                           bool wide) {
     u16 total_daddy = 0;
     dfa_info info(strat);
     bool using8bit = cc.grey.allowMcClellan8 && info.size() <= 256;
@@ -1202,7 +1386,7 @@ aligned_unique_ptr<NFA> mcclellanCompile_i(raw_dfa &raw, dfa_build_strat &strat,
     if (!using8bit) {
         nfa = mcclellanCompile16(info, cc);
     } else {
-        nfa = mcclellanCompile8(info, cc);
+        nfa = mcclellanCompile8(info, cc, wide);
     }
 
     if (has_eod_reports) {
@@ -1220,7 +1404,47 @@ aligned_unique_ptr<NFA> mcclellanCompile_i(raw_dfa &raw, dfa_build_strat &strat,
 aligned_unique_ptr<NFA> mcclellanCompile(raw_dfa &raw, const CompileContext &cc,
                                          set<dstate_id_t> *accel_states) {
     mcclellan_build_strat mbs(raw);
-    return mcclellanCompile_i(raw, mbs, cc, accel_states);
+    return mcclellanCompile_i(raw, mbs, cc, accel_states, true);
+}
+
+aligned_unique_ptr<NFA> mcshengCompile(raw_dfa &raw, const CompileContext &cc) {
+    if (!cc.grey.allowMcSheng) {
+        return nullptr;
+    }
+
+    mcclellan_build_strat mbs(raw);
+    dfa_info info(mbs);
+
+    if (cc.grey.allowMcClellan8 && info.size() <= 256) {
+        /* McClellan 8 is already cheap enough per byte */
+        DEBUG_PRINTF("small enough for mcclellan 8\n");
+        return nullptr;
+    }
+
+    if (!cc.streaming) { /* as for mcclellan */
+        raw.stripExtraEodReports();
+    }
+
+    bool has_eod_reports = raw.hasEodReports();
+    bool any_cyclic_near_anchored_state = is_cyclic_near(raw,
+                                                         raw.start_anchored);
+
+    for (u32 i = 0; i < info.size(); i++) {
+        find_better_daddy(info, i, false, any_cyclic_near_anchored_state,
+                          cc.grey);
+    }
+
+    aligned_unique_ptr<NFA> nfa = mcclellanCompile16(info, cc, true);
+    if (!nfa) {
+        return nullptr;
+    }
+
+    if (has_eod_reports) {
+        nfa->flags |= NFA_ACCEPTS_EOD;
+    }
+
+    DEBUG_PRINTF("compile done\n");
+    return nfa;
 }
 
 size_t mcclellan_build_strat::accelSize(void) const {
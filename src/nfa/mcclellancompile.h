@@ -100,11 +100,23 @@ ue2::aligned_unique_ptr<NFA>
 mcclellanCompile(raw_dfa &raw, const CompileContext &cc,
                  std::set<dstate_id_t> *accel_states = nullptr);
 
-/* used internally by mcclellan/haig/gough compile process */
+/**
+ * \brief Builds a McSheng DFA: McClellan 16 with the states nearest the start
+ * run as a Sheng core.
+ *
+ * Returns nullptr if McSheng is disabled, if the DFA is small enough for
+ * McClellan 8 or if no core can be found.
+ */
+ue2::aligned_unique_ptr<NFA>
+mcshengCompile(raw_dfa &raw, const CompileContext &cc);
+
+/* used internally by mcclellan/haig/gough compile process; wide permits a
+ * two-byte stride table to be added to a McClellan 8 engine */
 ue2::aligned_unique_ptr<NFA>
 mcclellanCompile_i(raw_dfa &raw, dfa_build_strat &strat,
                    const CompileContext &cc,
-                   std::set<dstate_id_t> *accel_states = nullptr);
+                   std::set<dstate_id_t> *accel_states = nullptr,
+                   bool wide = false);
 
 /**
  * \brief Returns the width of the character reach at start.
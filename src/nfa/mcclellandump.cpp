@@ -72,7 +72,7 @@ const mstate_aux *getAux(const NFA *n, dstate_id_t i) {
 
 static
 void mcclellanGetTransitions(const NFA *n, u16 s, u16 *t) {
-    assert(isMcClellanType(n->type));
+    assert(isMcClellanType(n->type) || isMcShengType(n->type));
     const mcclellan *m = (const mcclellan *)getImplNfa(n);
     const mstate_aux *aux = getAux(n, s);
     const u32 as = m->alphaShift;
@@ -268,7 +268,7 @@ void dumpDotPreambleDfa(FILE *f) {
 }
 
 void nfaExecMcClellan16_dumpDot(const NFA *nfa, FILE *f) {
-    assert(nfa->type == MCCLELLAN_NFA_16);
+    assert(nfa->type == MCCLELLAN_NFA_16 || nfa->type == MCSHENG_NFA_16);
     const mcclellan *m = (const mcclellan *)getImplNfa(nfa);
 
     dumpDotPreambleDfa(f);
@@ -286,6 +286,11 @@ void nfaExecMcClellan16_dumpDot(const NFA *nfa, FILE *f) {
     fprintf(f, "}\n");
 }
 
+void nfaExecMcSheng16_dumpDot(const NFA *nfa, FILE *f) {
+    /* the core is a view of the ordinary transition table */
+    nfaExecMcClellan16_dumpDot(nfa, f);
+}
+
 void nfaExecMcClellan8_dumpDot(const NFA *nfa, FILE *f) {
     assert(nfa->type == MCCLELLAN_NFA_8);
     const mcclellan *m = (const mcclellan *)getImplNfa(nfa);
@@ -415,6 +420,28 @@ void nfaExecMcClellan16_dumpText(const NFA *nfa, FILE *f) {
     dumpTextReverse(nfa, f);
 }
 
+void nfaExecMcSheng16_dumpText(const NFA *nfa, FILE *f) {
+    assert(nfa->type == MCSHENG_NFA_16);
+    const mcclellan *m = (const mcclellan *)getImplNfa(nfa);
+    const mstate_aux *aux =
+        (const mstate_aux *)((const char *)nfa + m->aux_offset);
+
+    fprintf(f, "mcsheng 16\n");
+    dumpCommonHeader(f, m);
+    fprintf(f, "sherman_limit: %d, sherman_end: %d\n", (int)m->sherman_limit,
+            (int)m->sherman_end);
+    fprintf(f, "sheng_end: %hu (core states 1-%d)\n", m->sheng_end,
+            (int)m->sheng_end - 1);
+    fprintf(f, "\n");
+
+    describeAlphabet(f, m);
+    dumpTransitions(f, nfa, m, aux);
+    dumpAccelMasks(f, m, aux);
+
+    fprintf(f, "\n");
+    dumpTextReverse(nfa, f);
+}
+
 void nfaExecMcClellan8_dumpText(const NFA *nfa, FILE *f) {
     assert(nfa->type == MCCLELLAN_NFA_8);
     const mcclellan *m = (const mcclellan *)getImplNfa(nfa);
@@ -425,6 +452,7 @@ void nfaExecMcClellan8_dumpText(const NFA *nfa, FILE *f) {
     dumpCommonHeader(f, m);
     fprintf(f, "accel_limit: %hu, accept_limit %hu\n", m->accel_limit_8,
             m->accept_limit_8);
+    fprintf(f, "wide table: %s\n", m->wide_offset ? "yes" : "no");
     fprintf(f, "\n");
 
     describeAlphabet(f, m);
@@ -46,6 +46,8 @@ void nfaExecMcClellan8_dumpDot(const struct NFA *nfa, FILE *file);
 void nfaExecMcClellan16_dumpDot(const struct NFA *nfa, FILE *file);
 void nfaExecMcClellan8_dumpText(const struct NFA *nfa, FILE *file);
 void nfaExecMcClellan16_dumpText(const struct NFA *nfa, FILE *file);
+void nfaExecMcSheng16_dumpDot(const struct NFA *nfa, FILE *file);
+void nfaExecMcSheng16_dumpText(const struct NFA *nfa, FILE *file);
 
 /* These functions are shared with the Haig dump code. */
 
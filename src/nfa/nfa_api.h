@@ -156,6 +156,20 @@ char nfaQueueExec(const struct NFA *nfa, struct mq *q, s64a end);
  */
 char nfaQueueExecToMatch(const struct NFA *nfa, struct mq *q, s64a end);
 
+/**
+ * Main execution function that doesn't perform the checks and optimisations of
+ * nfaQueueExec() (early rejection based on offset/width, trimming of the
+ * queue). Used by container engines, which have already made these checks for
+ * themselves.
+ */
+char nfaQueueExec_raw(const struct NFA *nfa, struct mq *q, s64a end);
+
+/**
+ * Version of nfaQueueExecToMatch() that doesn't perform the checks and
+ * optimisations of that function. Used by container engines.
+ */
+char nfaQueueExec2_raw(const struct NFA *nfa, struct mq *q, s64a end);
+
 /**
  * Report matches at the current queue location.
  *
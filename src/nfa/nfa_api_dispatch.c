@@ -33,6 +33,8 @@
 
 #include "nfa_api_queue.h"
 #include "nfa_internal.h"
+#include "budget.h"
+#include "profile.h"
 #include "ue2common.h"
 
 // Engine implementations.
@@ -42,6 +44,8 @@
 #include "limex.h"
 #include "mcclellan.h"
 #include "mpv.h"
+#include "sheng.h"
+#include "tamarama.h"
 
 #define DISPATCH_CASE(dc_ltype, dc_ftype, dc_subtype, dc_func_call) \
     case dc_ltype##_NFA_##dc_subtype:                               \
@@ -87,6 +91,20 @@
         DISPATCH_CASE(LIMEX,   LimEx,   512_5, dbnt_func);    \
         DISPATCH_CASE(LIMEX,   LimEx,   512_6, dbnt_func);    \
         DISPATCH_CASE(LIMEX,   LimEx,   512_7, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_1, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_2, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_3, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_4, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_5, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_6, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_7, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_1, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_2, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_3, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_4, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_5, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_6, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_7, dbnt_func);   \
         DISPATCH_CASE(MCCLELLAN, McClellan, 8, dbnt_func);    \
         DISPATCH_CASE(MCCLELLAN, McClellan, 16, dbnt_func);   \
         DISPATCH_CASE(GOUGH, Gough, 8, dbnt_func);            \
@@ -98,6 +116,9 @@
         DISPATCH_CASE(LBR, Lbr, Shuf, dbnt_func);             \
         DISPATCH_CASE(LBR, Lbr, Truf, dbnt_func);             \
         DISPATCH_CASE(CASTLE, Castle, 0, dbnt_func);          \
+        DISPATCH_CASE(SHENG, Sheng, 0, dbnt_func);            \
+        DISPATCH_CASE(MCSHENG, McSheng, 16, dbnt_func);       \
+        DISPATCH_CASE(TAMARAMA, Tamarama, 0, dbnt_func);      \
     default:                                                  \
         assert(0);                                            \
     }
@@ -202,6 +223,28 @@ char nfaQueueCanMatch(const struct NFA *nfa, struct mq *q, s64a end,
     return 1;
 }
 
+/** \brief Count an engine invocation for the profiling counters. Queues that
+ * are not part of a scratch (in unit tests, for example) are not counted. */
+static really_inline
+void profileQueueExec(UNUSED const struct mq *q) {
+#ifdef ENABLE_PROFILING
+    if (q->scratch) {
+        profileQueue(q->scratch, (u32)(q - q->scratch->queues));
+    }
+#endif
+}
+
+/** \brief Charge an engine invocation to the scan budget; \a loc is the
+ * location the queue has reached. Returns non-zero if the budget has run out,
+ * in which case the engine must not be run. */
+static really_inline
+char budgetQueueExec(const struct mq *q, s64a loc) {
+    if (!q->scratch) {
+        return 0;
+    }
+    return budgetTick(q->scratch, q->offset + loc);
+}
+
 char nfaQueueExec(const struct NFA *nfa, struct mq *q, s64a end) {
     DEBUG_PRINTF("nfa=%p end=%lld\n", nfa, end);
 #ifdef DEBUG
@@ -239,6 +282,12 @@ char nfaQueueExec(const struct NFA *nfa, struct mq *q, s64a end) {
         return 0;
     }
 
+    if (budgetQueueExec(q, q->items[q->cur].location)) {
+        DEBUG_PRINTF("out of budget, halting\n");
+        return MO_HALT_MATCHING;
+    }
+
+    profileQueueExec(q);
     char rv = nfaQueueExec_i(nfa, q, end);
 
 #ifdef DEBUG
@@ -289,6 +338,12 @@ char nfaQueueExecToMatch(const struct NFA *nfa, struct mq *q, s64a end) {
         return 0;
     }
 
+    if (budgetQueueExec(q, q->items[q->cur].location)) {
+        DEBUG_PRINTF("out of budget, halting\n");
+        return MO_HALT_MATCHING;
+    }
+
+    profileQueueExec(q);
     char rv = nfaQueueExec2_i(nfa, q, end);
     assert(!q->report_current);
     DEBUG_PRINTF("returned rv=%d, q_trimmed=%d\n", rv, q_trimmed);
@@ -305,6 +360,40 @@ char nfaQueueExecToMatch(const struct NFA *nfa, struct mq *q, s64a end) {
     return rv && !q_trimmed && !q_trimmed_ra;
 }
 
+char nfaQueueExec_raw(const struct NFA *nfa, struct mq *q, s64a end) {
+    DEBUG_PRINTF("nfa=%p end=%lld\n", nfa, end);
+#ifdef DEBUG
+    debugQueue(q);
+#endif
+
+    assert(q && q->context && q->state);
+    assert(end >= 0);
+    assert(q->cur < q->end);
+    assert(q->end <= MAX_MQE_LEN);
+    assert(ISALIGNED_CL(nfa) && ISALIGNED_CL(getImplNfa(nfa)));
+    assert(end < q->items[q->end - 1].location
+           || q->items[q->end - 1].type == MQE_END);
+
+    return nfaQueueExec_i(nfa, q, end);
+}
+
+char nfaQueueExec2_raw(const struct NFA *nfa, struct mq *q, s64a end) {
+    DEBUG_PRINTF("nfa=%p end=%lld\n", nfa, end);
+#ifdef DEBUG
+    debugQueue(q);
+#endif
+
+    assert(q && q->context && q->state);
+    assert(end >= 0);
+    assert(q->cur < q->end);
+    assert(q->end <= MAX_MQE_LEN);
+    assert(ISALIGNED_CL(nfa) && ISALIGNED_CL(getImplNfa(nfa)));
+    assert(end < q->items[q->end - 1].location
+           || q->items[q->end - 1].type == MQE_END);
+
+    return nfaQueueExec2_i(nfa, q, end);
+}
+
 char nfaReportCurrentMatches(const struct NFA *nfa, struct mq *q) {
     DISPATCH_BY_NFA_TYPE(_reportCurrent(nfa, q));
     return 0;
@@ -327,6 +416,12 @@ char nfaQueueExecRose(const struct NFA *nfa, struct mq *q, ReportID r) {
     assert(ISALIGNED_CL(nfa) && ISALIGNED_CL(getImplNfa(nfa)));
     assert(!q->report_current);
 
+    if (budgetQueueExec(q, q->end ? q->items[q->end - 1].location : 0)) {
+        DEBUG_PRINTF("out of budget, halting\n");
+        return MO_HALT_MATCHING;
+    }
+
+    profileQueueExec(q);
     return nfaQueueExecRose_i(nfa, q, r);
 }
 
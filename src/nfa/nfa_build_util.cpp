@@ -197,6 +197,20 @@ MAKE_LIMEX_TRAITS(512, 4)
 MAKE_LIMEX_TRAITS(512, 5)
 MAKE_LIMEX_TRAITS(512, 6)
 MAKE_LIMEX_TRAITS(512, 7)
+MAKE_LIMEX_TRAITS(768, 1)
+MAKE_LIMEX_TRAITS(768, 2)
+MAKE_LIMEX_TRAITS(768, 3)
+MAKE_LIMEX_TRAITS(768, 4)
+MAKE_LIMEX_TRAITS(768, 5)
+MAKE_LIMEX_TRAITS(768, 6)
+MAKE_LIMEX_TRAITS(768, 7)
+MAKE_LIMEX_TRAITS(1024, 1)
+MAKE_LIMEX_TRAITS(1024, 2)
+MAKE_LIMEX_TRAITS(1024, 3)
+MAKE_LIMEX_TRAITS(1024, 4)
+MAKE_LIMEX_TRAITS(1024, 5)
+MAKE_LIMEX_TRAITS(1024, 6)
+MAKE_LIMEX_TRAITS(1024, 7)
 
 template<> struct NFATraits<MCCLELLAN_NFA_8> {
     UNUSED static const char *name;
@@ -270,6 +284,30 @@ const has_accel_fn NFATraits<CASTLE_NFA_0>::has_accel = has_accel_generic;
 const char *NFATraits<CASTLE_NFA_0>::name = "Castle";
 #endif
 
+template<> struct NFATraits<SHENG_NFA_0> {
+    UNUSED static const char *name;
+    static const NFACategory category = NFA_OTHER;
+    static const u32 stateAlign = 1;
+    static const bool fast = true;
+    static const has_accel_fn has_accel;
+};
+const has_accel_fn NFATraits<SHENG_NFA_0>::has_accel = has_accel_generic;
+#if defined(DUMP_SUPPORT)
+const char *NFATraits<SHENG_NFA_0>::name = "Sheng";
+#endif
+
+template<> struct NFATraits<MCSHENG_NFA_16> {
+    UNUSED static const char *name;
+    static const NFACategory category = NFA_OTHER;
+    static const u32 stateAlign = 2;
+    static const bool fast = true;
+    static const has_accel_fn has_accel;
+};
+const has_accel_fn NFATraits<MCSHENG_NFA_16>::has_accel = has_accel_dfa;
+#if defined(DUMP_SUPPORT)
+const char *NFATraits<MCSHENG_NFA_16>::name = "McSheng 16";
+#endif
+
 template<> struct NFATraits<LBR_NFA_Dot> {
     UNUSED static const char *name;
     static const NFACategory category = NFA_OTHER;
@@ -330,6 +368,20 @@ const has_accel_fn NFATraits<LBR_NFA_Truf>::has_accel = has_accel_generic;
 const char *NFATraits<LBR_NFA_Truf>::name = "Lim Bounded Repeat (M)";
 #endif
 
+template<> struct NFATraits<TAMARAMA_NFA_0> {
+    UNUSED static const char *name;
+    static const NFACategory category = NFA_OTHER;
+    // Sub-engines run directly on the container's scratch state, so this
+    // must satisfy the most demanding of them.
+    static const u32 stateAlign = 64;
+    static const bool fast = true;
+    static const has_accel_fn has_accel;
+};
+const has_accel_fn NFATraits<TAMARAMA_NFA_0>::has_accel = has_accel_generic;
+#if defined(DUMP_SUPPORT)
+const char *NFATraits<TAMARAMA_NFA_0>::name = "Tamarama";
+#endif
+
 } // namespace
 
 #if defined(DUMP_SUPPORT)
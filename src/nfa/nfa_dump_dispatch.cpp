@@ -40,6 +40,8 @@
 #include "limex.h"
 #include "mcclellandump.h"
 #include "mpv_dump.h"
+#include "shengdump.h"
+#include "tamarama_dump.h"
 
 #ifndef DUMP_SUPPORT
 #error "no dump support"
@@ -92,6 +94,20 @@ namespace ue2 {
         DISPATCH_CASE(LIMEX,   LimEx,   512_5, dbnt_func);    \
         DISPATCH_CASE(LIMEX,   LimEx,   512_6, dbnt_func);    \
         DISPATCH_CASE(LIMEX,   LimEx,   512_7, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_1, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_2, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_3, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_4, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_5, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_6, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_7, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_1, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_2, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_3, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_4, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_5, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_6, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_7, dbnt_func);   \
         DISPATCH_CASE(MCCLELLAN, McClellan, 8, dbnt_func);    \
         DISPATCH_CASE(MCCLELLAN, McClellan, 16, dbnt_func);   \
         DISPATCH_CASE(GOUGH, Gough, 8, dbnt_func);            \
@@ -103,6 +119,9 @@ namespace ue2 {
         DISPATCH_CASE(LBR, Lbr, Shuf, dbnt_func);             \
         DISPATCH_CASE(LBR, Lbr, Truf, dbnt_func);             \
         DISPATCH_CASE(CASTLE, Castle, 0, dbnt_func);          \
+        DISPATCH_CASE(SHENG, Sheng, 0, dbnt_func);            \
+        DISPATCH_CASE(MCSHENG, McSheng, 16, dbnt_func);       \
+        DISPATCH_CASE(TAMARAMA, Tamarama, 0, dbnt_func);      \
     default:                                                  \
         assert(0);                                            \
     }
@@ -86,6 +86,20 @@ enum NFAEngineType {
     LIMEX_NFA_512_5,
     LIMEX_NFA_512_6,
     LIMEX_NFA_512_7,
+    LIMEX_NFA_768_1,
+    LIMEX_NFA_768_2,
+    LIMEX_NFA_768_3,
+    LIMEX_NFA_768_4,
+    LIMEX_NFA_768_5,
+    LIMEX_NFA_768_6,
+    LIMEX_NFA_768_7,
+    LIMEX_NFA_1024_1,
+    LIMEX_NFA_1024_2,
+    LIMEX_NFA_1024_3,
+    LIMEX_NFA_1024_4,
+    LIMEX_NFA_1024_5,
+    LIMEX_NFA_1024_6,
+    LIMEX_NFA_1024_7,
     MCCLELLAN_NFA_8,    /**< magic pseudo nfa */
     MCCLELLAN_NFA_16,   /**< magic pseudo nfa */
     GOUGH_NFA_8,        /**< magic pseudo nfa */
@@ -97,6 +111,9 @@ enum NFAEngineType {
     LBR_NFA_Shuf,       /**< magic pseudo nfa */
     LBR_NFA_Truf,       /**< magic pseudo nfa */
     CASTLE_NFA_0,       /**< magic pseudo nfa */
+    SHENG_NFA_0,        /**< magic pseudo nfa */
+    MCSHENG_NFA_16,     /**< magic pseudo nfa */
+    TAMARAMA_NFA_0,     /**< magic nfa container */
     /** \brief bogus NFA - not used */
     INVALID_NFA
 };
@@ -175,10 +192,22 @@ static really_inline int isGoughType(u8 t) {
     return t == GOUGH_NFA_8 || t == GOUGH_NFA_16;
 }
 
-/** \brief True if the given type (from NFA::type) is a McClellan or Gough DFA.
- * */
+/** \brief True if the given type (from NFA::type) is a Sheng DFA. */
+static really_inline int isShengType(u8 t) {
+    return t == SHENG_NFA_0;
+}
+
+/** \brief True if the given type (from NFA::type) is a McClellan DFA with a
+ * Sheng core. */
+static really_inline int isMcShengType(u8 t) {
+    return t == MCSHENG_NFA_16;
+}
+
+/** \brief True if the given type (from NFA::type) is a McClellan, Gough, Sheng
+ * or McSheng DFA. */
 static really_inline int isDfaType(u8 t) {
-    return isMcClellanType(t) || isGoughType(t);
+    return isMcClellanType(t) || isGoughType(t) || isShengType(t)
+        || isMcShengType(t);
 }
 
 /** \brief True if the given type (from NFA::type) is an NFA. */
@@ -219,6 +248,20 @@ static really_inline int isNfaType(u8 t) {
     case LIMEX_NFA_512_5:
     case LIMEX_NFA_512_6:
     case LIMEX_NFA_512_7:
+    case LIMEX_NFA_768_1:
+    case LIMEX_NFA_768_2:
+    case LIMEX_NFA_768_3:
+    case LIMEX_NFA_768_4:
+    case LIMEX_NFA_768_5:
+    case LIMEX_NFA_768_6:
+    case LIMEX_NFA_768_7:
+    case LIMEX_NFA_1024_1:
+    case LIMEX_NFA_1024_2:
+    case LIMEX_NFA_1024_3:
+    case LIMEX_NFA_1024_4:
+    case LIMEX_NFA_1024_5:
+    case LIMEX_NFA_1024_6:
+    case LIMEX_NFA_1024_7:
         return 1;
     default:
         break;
@@ -233,6 +276,13 @@ int isLbrType(u8 t) {
            t == LBR_NFA_Shuf || t == LBR_NFA_Truf;
 }
 
+/** \brief True if the given type (from NFA::type) is a container engine,
+ * holding other engines. */
+static really_inline
+int isContainerType(u8 t) {
+    return t == TAMARAMA_NFA_0;
+}
+
 static really_inline
 int isMultiTopType(u8 t) {
     return !isDfaType(t) && !isLbrType(t);
@@ -335,6 +335,30 @@ vector<size_t> minResetDistToEnd(const vector<vector<CharReach>> &triggers,
     return out;
 }
 
+bool literalOverlap(const vector<CharReach> &a, const vector<CharReach> &b,
+                    const size_t dist) {
+    for (size_t i = 0; i < b.size(); i++) {
+        if (i > dist) {
+            return true;
+        }
+        size_t overlap_len = b.size() - i;
+        if (overlap_len <= a.size()) {
+            if (matches(a.end() - overlap_len, a.end(), b.begin(),
+                        b.end() - i)) {
+                return false;
+            }
+        } else {
+            assert(overlap_len > a.size());
+            if (matches(a.begin(), a.end(), b.end() - i - a.size(),
+                        b.end() - i)) {
+                return false;
+            }
+        }
+    }
+
+    return b.size() > dist;
+}
+
 #if defined(DEBUG) || defined(DUMP_SUPPORT)
 
 static UNUSED
@@ -84,6 +84,14 @@ minResetDistToEnd(const std::vector<std::vector<CharReach>> &triggers,
 u32 minPeriod(const std::vector<std::vector<CharReach>> &triggers,
               const CharReach &cr, bool *can_reset);
 
+/**
+ * \brief True if trigger \a b always resets an engine that trigger \a a may
+ * have started, i.e. \a a cannot end at or after the reset character that
+ * lies \a dist characters before the end of \a b.
+ */
+bool literalOverlap(const std::vector<CharReach> &a,
+                    const std::vector<CharReach> &b, size_t dist);
+
 } // namespace ue2
 
 #endif // REPEATCOMPILE_H
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Sheng: small DFA engine using PSHUFB for state transitions.
+ */
+
+#ifndef SHENG_INTERNAL_H
+#define SHENG_INTERNAL_H
+
+#include "mcclellan_internal.h" /* for struct report_list */
+#include "ue2common.h"
+#include "util/simd_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** \brief Maximum number of states (including the dead state) that a Sheng
+ * engine can represent: one per byte lane of a 128-bit shuffle mask. */
+#define SHENG_MAX_STATES 16
+
+/* Each byte of a shuffle mask holds the successor state id in its low four
+ * bits; the remaining bits carry flags. Bit 7 must stay clear so that PSHUFB
+ * uses the low four bits of the state as an index rather than zeroing the
+ * lane. */
+#define SHENG_STATE_ACCEPT 0x10
+#define SHENG_STATE_DEAD   0x20
+#define SHENG_STATE_MASK   0xf
+#define SHENG_STATE_FLAG_MASK 0x70
+
+#define SHENG_FLAG_SINGLE_REPORT 0x1 /**< we raise only single accept id */
+
+struct sstate_aux {
+    u32 accept; /**< offset of report list relative to the start of the NFA;
+                 * 0 if none */
+    u32 accept_eod; /**< as above, for EOD reports */
+    u32 top; /**< state to move to on a TOP event */
+};
+
+struct sheng {
+    /** \brief One shuffle mask per input character: byte i of mask c holds the
+     * (flagged) successor of state i on character c. */
+    m128 shuffle_masks[256];
+    u32 length; /**< length of engine in bytes */
+    u32 aux_offset; /**< offset of the sstate_aux array relative to the start
+                     * of the NFA structure */
+    u8 n_states; /**< total number of states, including dead */
+    u8 anchored; /**< anchored start state */
+    u8 floating; /**< floating start state */
+    u8 flags;
+    ReportID report; /**< one of the accepts that this dfa may raise */
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "shengcompile.h"
+
+#include "grey.h"
+#include "mcclellancompile.h"
+#include "nfa_internal.h"
+#include "sheng_internal.h"
+#include "ue2common.h"
+#include "util/alloc.h"
+#include "util/compile_context.h"
+#include "util/verify_types.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace ue2 {
+
+/* Sheng uses the raw state ids directly as implementation ids; the dead state
+ * is always 0. */
+static
+u8 shengStateByte(const raw_dfa &raw, dstate_id_t i) {
+    assert(i < SHENG_MAX_STATES);
+    u8 rv = verify_u8(i);
+    if (i == DEAD_STATE) {
+        rv |= SHENG_STATE_DEAD;
+    }
+    if (!raw.states[i].reports.empty()) {
+        rv |= SHENG_STATE_ACCEPT;
+    }
+    return rv;
+}
+
+static
+void fillShuffleMasks(const raw_dfa &raw, sheng *sh) {
+    for (u32 c = 0; c < N_CHARS; c++) {
+        u8 mask[sizeof(m128)];
+        /* unused lanes lead to the dead state */
+        memset(mask, SHENG_STATE_DEAD, sizeof(mask));
+
+        for (dstate_id_t i = 0; i < raw.states.size(); i++) {
+            dstate_id_t succ = raw.states[i].next[raw.alpha_remap[c]];
+            mask[i] = shengStateByte(raw, succ);
+        }
+
+        memcpy(&sh->shuffle_masks[c], mask, sizeof(mask));
+    }
+}
+
+aligned_unique_ptr<NFA> shengCompile(raw_dfa &raw, const CompileContext &cc) {
+    if (!cc.grey.allowSheng) {
+        DEBUG_PRINTF("sheng not allowed\n");
+        return nullptr;
+    }
+
+    if (raw.states.size() > SHENG_MAX_STATES) {
+        DEBUG_PRINTF("too many states for sheng (%zu)\n", raw.states.size());
+        return nullptr;
+    }
+
+    DEBUG_PRINTF("building sheng, %zu states\n", raw.states.size());
+
+    if (!cc.streaming) { /* as in McClellan: only strip in block mode */
+        raw.stripExtraEodReports();
+    }
+
+    vector<u32> reports;
+    vector<u32> reports_eod;
+    ReportID arb;
+    u8 single;
+
+    mcclellan_build_strat mbs(raw);
+    unique_ptr<raw_report_info> ri
+        = mbs.gatherReports(reports, reports_eod, &single, &arb);
+
+    size_t aux_size = sizeof(sstate_aux) * raw.states.size();
+    size_t aux_offset = ROUNDUP_16(sizeof(NFA) + sizeof(sheng));
+    size_t total_size = ROUNDUP_16(aux_offset + aux_size
+                                   + ri->getReportListSize());
+
+    DEBUG_PRINTF("aux_offset %zu, rl size %u, total_size %zu\n", aux_offset,
+                 ri->getReportListSize(), total_size);
+
+    aligned_unique_ptr<NFA> nfa = aligned_zmalloc_unique<NFA>(total_size);
+    char *nfa_base = (char *)nfa.get();
+
+    nfa->type = SHENG_NFA_0;
+    nfa->length = verify_u32(total_size);
+    nfa->nPositions = verify_u32(raw.states.size());
+    nfa->scratchStateSize = 1;
+    nfa->streamStateSize = 1;
+    if (raw.hasEodReports()) {
+        nfa->flags |= NFA_ACCEPTS_EOD;
+    }
+
+    sheng *sh = (sheng *)getMutableImplNfa(nfa.get());
+    sh->length = verify_u32(total_size);
+    sh->aux_offset = verify_u32(aux_offset);
+    sh->n_states = verify_u8(raw.states.size());
+    sh->anchored = verify_u8(raw.start_anchored);
+    sh->floating = verify_u8(raw.start_floating);
+    sh->report = arb;
+    if (single) {
+        sh->flags |= SHENG_FLAG_SINGLE_REPORT;
+    }
+
+    fillShuffleMasks(raw, sh);
+
+    vector<u32> reportOffsets;
+    ri->fillReportLists(nfa.get(), aux_offset + aux_size, reportOffsets);
+
+    sstate_aux *aux = (sstate_aux *)(nfa_base + aux_offset);
+    for (dstate_id_t i = 0; i < raw.states.size(); i++) {
+        const dstate &ds = raw.states[i];
+        aux[i].accept = ds.reports.empty() ? 0 : reportOffsets[reports[i]];
+        aux[i].accept_eod = ds.reports_eod.empty()
+                                ? 0 : reportOffsets[reports_eod[i]];
+        aux[i].top = i ? ds.next[raw.alpha_remap[TOP]] : raw.start_floating;
+    }
+
+    DEBUG_PRINTF("compile done\n");
+    return nfa;
+}
+
+} // namespace ue2
@@ -354,7 +354,7 @@ const u8 *shuftiDoubleExec(m128 mask1_lo, m128 mask1_hi,
     return buf_end;
 }
 
-#else // AVX2 - 256 wide shuftis
+#elif !defined(__AVX512BW__) // AVX2 - 256 wide shuftis
 
 #ifdef DEBUG
 DUMP_MSK(256)
@@ -620,4 +620,263 @@ const u8 *shuftiDoubleExec(m128 mask1_lo, m128 mask1_hi,
     return buf_end;
 }
 
-#endif //AVX2
+#else // AVX-512BW - 512 wide shuftis
+
+#ifdef DEBUG
+DUMP_MSK(512)
+#endif
+
+#define GET_LO_4(chars) and512(chars, low4bits)
+#define GET_HI_4(chars) rshift8x64(andnot512(low4bits, chars), 4)
+
+/* z has a bit set for every byte that may match */
+static really_inline
+const u8 *firstMatch(const u8 *buf, u64a z) {
+    if (unlikely(z)) {
+        u32 pos = ctz64(z);
+        assert(pos < 64);
+        return buf + pos;
+    } else {
+        return NULL; // no match
+    }
+}
+
+static really_inline
+const u8 *lastMatch(const u8 *buf, u64a z) {
+    if (unlikely(z)) {
+        u32 pos = clz64(z);
+        DEBUG_PRINTF("buf=%p, pos=%u\n", buf, pos);
+        assert(pos < 64);
+        return buf + (63 - pos);
+    } else {
+        return NULL; // no match
+    }
+}
+
+/* k selects the bytes of chars that hold valid data */
+static really_inline
+u64a block(m512 mask_lo, m512 mask_hi, m512 chars, const m512 low4bits,
+           const m512 zeroes, u64a k) {
+    m512 c_lo  = pshufb_m512(mask_lo, GET_LO_4(chars));
+    m512 c_hi  = pshufb_m512(mask_hi, GET_HI_4(chars));
+    m512 t     = and512(c_lo, c_hi);
+
+#ifdef DEBUG
+    DEBUG_PRINTF(" chars: "); dumpMsk512AsChars(chars); printf("\n");
+    DEBUG_PRINTF("  char: "); dumpMsk512(chars);        printf("\n");
+    DEBUG_PRINTF("  c_lo: "); dumpMsk512(c_lo);         printf("\n");
+    DEBUG_PRINTF("  c_hi: "); dumpMsk512(c_hi);         printf("\n");
+    DEBUG_PRINTF("     t: "); dumpMsk512(t);            printf("\n");
+#endif
+
+    return ~eq512mask(t, zeroes) & k;
+}
+
+/* takes 128 bit masks, but operates on 512 bits of data */
+const u8 *shuftiExec(m128 mask_lo, m128 mask_hi, const u8 *buf,
+                     const u8 *buf_end) {
+    assert(buf && buf_end);
+    assert(buf < buf_end);
+
+    const m512 zeroes = zeroes512();
+    const m512 low4bits = set64x8(0xf);
+    const m512 wide_mask_lo = set4x128(mask_lo);
+    const m512 wide_mask_hi = set4x128(mask_hi);
+    const u8 *rv;
+
+    // Short cases are handled with a single masked load.
+    size_t len = buf_end - buf;
+    if (len <= 64) {
+        u64a k = ~0ULL >> (64 - len);
+        m512 chars = loadu_maskz512(k, buf);
+        rv = firstMatch(buf, block(wide_mask_lo, wide_mask_hi, chars,
+                                   low4bits, zeroes, k));
+        return rv ? rv : buf_end;
+    }
+
+    size_t min = (size_t)buf % 64;
+
+    // Preconditioning: most of the time our buffer won't be aligned.
+    m512 chars = loadu512(buf);
+    rv = firstMatch(buf, block(wide_mask_lo, wide_mask_hi, chars, low4bits,
+                               zeroes, ~0ULL));
+    if (rv) {
+        return rv;
+    }
+    buf += (64 - min);
+
+    const u8 *last_block = buf_end - 64;
+    while (buf < last_block) {
+        m512 lchars = load512(buf);
+        rv = firstMatch(buf, block(wide_mask_lo, wide_mask_hi, lchars,
+                                   low4bits, zeroes, ~0ULL));
+        if (rv) {
+            return rv;
+        }
+        buf += 64;
+    }
+
+    // Use an unaligned load to mop up the last 64 bytes and get an accurate
+    // picture to buf_end.
+    assert(buf <= buf_end && buf >= buf_end - 64);
+    chars = loadu512(buf_end - 64);
+    rv = firstMatch(buf_end - 64, block(wide_mask_lo, wide_mask_hi, chars,
+                                        low4bits, zeroes, ~0ULL));
+    if (rv) {
+        return rv;
+    }
+
+    return buf_end;
+}
+
+/* takes 128 bit masks, but operates on 512 bits of data */
+const u8 *rshuftiExec(m128 mask_lo, m128 mask_hi, const u8 *buf,
+                      const u8 *buf_end) {
+    assert(buf && buf_end);
+    assert(buf < buf_end);
+
+    const m512 zeroes = zeroes512();
+    const m512 low4bits = set64x8(0xf);
+    const m512 wide_mask_lo = set4x128(mask_lo);
+    const m512 wide_mask_hi = set4x128(mask_hi);
+    const u8 *rv;
+
+    // Short cases are handled with a single masked load.
+    size_t len = buf_end - buf;
+    if (len <= 64) {
+        u64a k = ~0ULL >> (64 - len);
+        m512 chars = loadu_maskz512(k, buf);
+        rv = lastMatch(buf, block(wide_mask_lo, wide_mask_hi, chars,
+                                  low4bits, zeroes, k));
+        return rv ? rv : buf - 1;
+    }
+
+    // Preconditioning: most of the time our buffer won't be aligned.
+    m512 chars = loadu512(buf_end - 64);
+    rv = lastMatch(buf_end - 64, block(wide_mask_lo, wide_mask_hi, chars,
+                                       low4bits, zeroes, ~0ULL));
+    if (rv) {
+        return rv;
+    }
+    buf_end = (const u8 *)((size_t)buf_end & ~((size_t)0x3f));
+
+    const u8 *last_block = buf + 64;
+    while (buf_end > last_block) {
+        buf_end -= 64;
+        m512 lchars = load512(buf_end);
+        rv = lastMatch(buf_end, block(wide_mask_lo, wide_mask_hi, lchars,
+                                      low4bits, zeroes, ~0ULL));
+        if (rv) {
+            return rv;
+        }
+    }
+
+    // Use an unaligned load to mop up the last 64 bytes and get an accurate
+    // picture to buf.
+    chars = loadu512(buf);
+    rv = lastMatch(buf, block(wide_mask_lo, wide_mask_hi, chars, low4bits,
+                              zeroes, ~0ULL));
+    if (rv) {
+        return rv;
+    }
+
+    return buf - 1;
+}
+
+/* k selects the bytes of chars that hold valid data */
+static really_inline
+u64a block2(m512 mask1_lo, m512 mask1_hi, m512 mask2_lo, m512 mask2_hi,
+            m512 chars, const m512 low4bits, const m512 ones, u64a k) {
+    m512 chars_lo = GET_LO_4(chars);
+    m512 chars_hi = GET_HI_4(chars);
+    m512 c_lo  = pshufb_m512(mask1_lo, chars_lo);
+    m512 c_hi  = pshufb_m512(mask1_hi, chars_hi);
+    m512 t     = or512(c_lo, c_hi);
+
+#ifdef DEBUG
+    DEBUG_PRINTF(" chars: "); dumpMsk512AsChars(chars); printf("\n");
+    DEBUG_PRINTF("  char: "); dumpMsk512(chars);        printf("\n");
+    DEBUG_PRINTF("  c_lo: "); dumpMsk512(c_lo);         printf("\n");
+    DEBUG_PRINTF("  c_hi: "); dumpMsk512(c_hi);         printf("\n");
+    DEBUG_PRINTF("     t: "); dumpMsk512(t);            printf("\n");
+#endif
+
+    m512 c2_lo  = pshufb_m512(mask2_lo, chars_lo);
+    m512 c2_hi  = pshufb_m512(mask2_hi, chars_hi);
+    // Bytes past the end of the data must not rule out a match that starts
+    // on the last valid byte, so they are cleared before the shift.
+    m512 c2     = _mm512_maskz_mov_epi8(k, or512(c2_lo, c2_hi));
+    m512 t2     = or512(t, shift512Right8Bits(c2));
+
+#ifdef DEBUG
+    DEBUG_PRINTF(" c2_lo: "); dumpMsk512(c2_lo);        printf("\n");
+    DEBUG_PRINTF(" c2_hi: "); dumpMsk512(c2_hi);        printf("\n");
+    DEBUG_PRINTF("    t2: "); dumpMsk512(t2);           printf("\n");
+#endif
+
+    return ~eq512mask(t2, ones) & k;
+}
+
+/* takes 128 bit masks, but operates on 512 bits of data */
+const u8 *shuftiDoubleExec(m128 mask1_lo, m128 mask1_hi,
+                           m128 mask2_lo, m128 mask2_hi,
+                           const u8 *buf, const u8 *buf_end) {
+    assert(buf && buf_end);
+    assert(buf < buf_end);
+
+    const m512 ones = ones512();
+    const m512 low4bits = set64x8(0xf);
+    const m512 wide_mask1_lo = set4x128(mask1_lo);
+    const m512 wide_mask1_hi = set4x128(mask1_hi);
+    const m512 wide_mask2_lo = set4x128(mask2_lo);
+    const m512 wide_mask2_hi = set4x128(mask2_hi);
+    const u8 *rv;
+
+    // Short cases are handled with a single masked load.
+    size_t len = buf_end - buf;
+    if (len <= 64) {
+        u64a k = ~0ULL >> (64 - len);
+        m512 chars = loadu_maskz512(k, buf);
+        rv = firstMatch(buf, block2(wide_mask1_lo, wide_mask1_hi,
+                                    wide_mask2_lo, wide_mask2_hi, chars,
+                                    low4bits, ones, k));
+        return rv ? rv : buf_end;
+    }
+
+    size_t min = (size_t)buf % 64;
+
+    // Preconditioning: most of the time our buffer won't be aligned.
+    m512 chars = loadu512(buf);
+    rv = firstMatch(buf, block2(wide_mask1_lo, wide_mask1_hi, wide_mask2_lo,
+                                wide_mask2_hi, chars, low4bits, ones, ~0ULL));
+    if (rv) {
+        return rv;
+    }
+    buf += (64 - min);
+
+    const u8 *last_block = buf_end - 64;
+    while (buf < last_block) {
+        m512 lchars = load512(buf);
+        rv = firstMatch(buf, block2(wide_mask1_lo, wide_mask1_hi,
+                                    wide_mask2_lo, wide_mask2_hi, lchars,
+                                    low4bits, ones, ~0ULL));
+        if (rv) {
+            return rv;
+        }
+        buf += 64;
+    }
+
+    // Use an unaligned load to mop up the last 64 bytes and get an accurate
+    // picture to buf_end.
+    chars = loadu512(buf_end - 64);
+    rv = firstMatch(buf_end - 64, block2(wide_mask1_lo, wide_mask1_hi,
+                                         wide_mask2_lo, wide_mask2_hi, chars,
+                                         low4bits, ones, ~0ULL));
+    if (rv) {
+        return rv;
+    }
+
+    return buf_end;
+}
+
+#endif // AVX512BW
@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Tamarama: container engine for exclusive engines, runtime code.
+ *
+ * The container's queue carries tops for all of its sub-engines. It is run by
+ * copying the run of events that belongs to the live sub-engine onto a
+ * sub-queue and handing that to the sub-engine. A top for another sub-engine
+ * ends the run: the live sub-engine is run up to it (it is dead by then, as
+ * the trigger for the new sub-engine kills it) and the new sub-engine takes
+ * over the shared state.
+ */
+
+#include "tamarama.h"
+
+#include "tamarama_internal.h"
+#include "nfa_api.h"
+#include "nfa_api_queue.h"
+#include "nfa_api_util.h"
+#include "nfa_internal.h"
+#include "util/partial_store.h"
+#include "ue2common.h"
+
+static really_inline
+const u32 *getBaseTop(const struct Tamarama *t) {
+    return (const u32 *)((const char *)t + sizeof(struct Tamarama));
+}
+
+static really_inline
+const struct NFA *getSubEngine(const struct Tamarama *t, u32 idx) {
+    assert(idx < t->numSubEngines);
+    const u32 *offsets = getBaseTop(t) + t->numSubEngines;
+    const char *base = (const char *)t - sizeof(struct NFA);
+    const struct NFA *sub = (const struct NFA *)(base + offsets[idx]);
+    assert(ISALIGNED_CL(sub));
+    return sub;
+}
+
+static really_inline
+u32 loadActiveIdx(const struct Tamarama *t, const void *streamState) {
+    return partial_load_u32(streamState, t->activeIdxSize);
+}
+
+static really_inline
+void storeActiveIdx(const struct Tamarama *t, void *streamState, u32 idx) {
+    partial_store_u32(streamState, idx, t->activeIdxSize);
+}
+
+/** \brief Returns the sub-engine that owns the given container top. */
+static really_inline
+u32 findEngineForTop(const struct Tamarama *t, u32 top) {
+    const u32 *baseTop = getBaseTop(t);
+    u32 lo = 0, hi = t->numSubEngines;
+    while (hi - lo > 1) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (baseTop[mid] <= top) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    DEBUG_PRINTF("top %u -> engine %u\n", top, lo);
+    return lo;
+}
+
+static really_inline
+char isTopEvent(u32 type) {
+    return type >= MQE_TOP_FIRST;
+}
+
+/** \brief Sets up q1 to drive sub-engine idx with the state, buffers and
+ * callbacks of the container's queue q. The sub-queue is left empty. */
+static really_inline
+void initSubQueue(const struct Tamarama *t, const struct mq *q, struct mq *q1,
+                  u32 idx) {
+    q1->nfa = getSubEngine(t, idx);
+    q1->cur = 0;
+    q1->end = 0;
+    q1->state = q->state;
+    q1->streamState = q->streamState + t->activeIdxSize;
+    q1->offset = q->offset;
+    q1->buffer = q->buffer;
+    q1->length = q->length;
+    q1->history = q->history;
+    q1->hlength = q->hlength;
+    q1->scratch = q->scratch;
+    q1->report_current = q->report_current;
+    q1->cb = q->cb;
+    q1->som_cb = q->som_cb;
+    q1->context = q->context;
+}
+
+/** \brief Appends an event to a sub-queue. Unlike pushQueue(), duplicates are
+ * kept, so that sub-queue items stay in step with the container's queue. */
+static really_inline
+void pushSubEvent(struct mq *q1, u32 type, s64a loc, u64a som) {
+    assert(q1->end < MAX_MQE_LEN);
+    struct mq_item *item = &q1->items[q1->end++];
+    item->type = type;
+    item->location = loc;
+    item->som = som;
+}
+
+/**
+ * \brief Copies the start event of the container's queue and the run of tops
+ * for the live sub-engine that follows it onto the sub-queue, terminated by
+ * an MQE_END.
+ *
+ * Returns the number of container queue items after the start that have a
+ * counterpart on the sub-queue. *switching is set if the run was ended by a
+ * top for another sub-engine.
+ */
+static really_inline
+u32 fillSubQueue(const struct Tamarama *t, const struct mq *q, struct mq *q1,
+                 u32 activeIdx, char *switching) {
+    const struct NFA *sub = q1->nfa;
+    const u32 base = getBaseTop(t)[activeIdx];
+    const char multi_top = isMultiTopType(sub->type);
+
+    assert(q_cur_type(q) == MQE_START);
+    const struct mq_item *start = &q->items[q->cur];
+    pushSubEvent(q1, MQE_START, start->location, start->som);
+
+    *switching = 0;
+    u32 i = q->cur + 1;
+    for (; i < q->end; i++) {
+        const struct mq_item *item = &q->items[i];
+        if (item->type == MQE_END) {
+            pushSubEvent(q1, MQE_END, item->location, item->som);
+            return i - q->cur;
+        }
+
+        assert(isTopEvent(item->type));
+        u32 top = item->type - MQE_TOP_FIRST;
+        if (findEngineForTop(t, top) != activeIdx) {
+            *switching = 1;
+            pushSubEvent(q1, MQE_END, item->location, 0);
+            return i - q->cur;
+        }
+
+        u32 event = multi_top ? MQE_TOP_FIRST + (top - base) : MQE_TOP;
+        pushSubEvent(q1, event, item->location, item->som);
+    }
+
+    return i - q->cur - 1;
+}
+
+/**
+ * \brief Makes the sub-engine owning the top at the head of the queue (just
+ * after the start event) the live one, initialising its state there.
+ */
+static really_inline
+void switchEngine(const struct Tamarama *t, struct mq *q) {
+    assert(q->cur + 1 < q->end);
+    const struct mq_item *item = &q->items[q->cur + 1];
+    assert(isTopEvent(item->type));
+
+    u32 idx = findEngineForTop(t, item->type - MQE_TOP_FIRST);
+    DEBUG_PRINTF("switching to engine %u at %lld\n", idx, item->location);
+    storeActiveIdx(t, q->streamState, idx);
+
+    struct mq q1;
+    initSubQueue(t, q, &q1, idx);
+    nfaQueueInitState(q1.nfa, &q1);
+
+    // Nothing was alive before the top, so the start can be brought forward.
+    q->items[q->cur].location = item->location;
+}
+
+static really_inline
+char tamaramaExec(const struct NFA *n, struct mq *q, s64a end,
+                  char to_match) {
+    const struct Tamarama *t = getImplNfa(n);
+    const u32 none = t->numSubEngines;
+
+    while (1) {
+        assert(q->cur < q->end);
+        assert(q_cur_type(q) == MQE_START);
+        u32 activeIdx = loadActiveIdx(t, q->streamState);
+
+        if (activeIdx == none) {
+            if (q->cur + 1 == q->end
+                || !isTopEvent(q->items[q->cur + 1].type)) {
+                DEBUG_PRINTF("no live engine\n");
+                q->cur = q->end;
+                return 0;
+            }
+            if (q->items[q->cur + 1].location > end) {
+                DEBUG_PRINTF("next top is beyond end\n");
+                q->items[q->cur].location = end;
+                return MO_ALIVE;
+            }
+            switchEngine(t, q);
+            continue;
+        }
+
+        struct mq q1;
+        initSubQueue(t, q, &q1, activeIdx);
+        char switching;
+        u32 copied = fillSubQueue(t, q, &q1, activeIdx, &switching);
+
+        char rv = to_match ? nfaQueueExec2_raw(q1.nfa, &q1, end)
+                           : nfaQueueExec_raw(q1.nfa, &q1, end);
+        q->report_current = q1.report_current;
+        DEBUG_PRINTF("engine %u returned %d\n", activeIdx, rv);
+
+        if (q1.cur == q1.end) {
+            if (!switching) {
+                q->cur = q->end;
+                return rv;
+            }
+
+            // The trigger for the next engine has killed this one.
+            u32 next = q->cur + copied;
+            storeActiveIdx(t, q->streamState, none);
+            q->cur = next - 1;
+            q->items[q->cur].type = MQE_START;
+            q->items[q->cur].location = q->items[next].location;
+            q->items[q->cur].som = 0;
+            continue;
+        }
+
+        // The sub-engine stopped early; rewind our queue to match its queue.
+        assert(q1.items[q1.cur].type == MQE_START);
+        u32 remaining = q1.end - q1.cur - 1;
+        assert(remaining <= copied);
+        q->cur += copied - remaining;
+        q->items[q->cur] = q1.items[q1.cur];
+
+        if (rv || q->cur + 1 == q->end) {
+            return rv;
+        }
+
+        // The engine died, but there are tops left to process.
+        storeActiveIdx(t, q->streamState, none);
+    }
+}
+
+char nfaExecTamarama0_Q(const struct NFA *n, struct mq *q, s64a end) {
+    DEBUG_PRINTF("entry, end=%lld\n", end);
+    return tamaramaExec(n, q, end, 0);
+}
+
+char nfaExecTamarama0_Q2(const struct NFA *n, struct mq *q, s64a end) {
+    DEBUG_PRINTF("entry, end=%lld\n", end);
+    return tamaramaExec(n, q, end, 1);
+}
+
+char nfaExecTamarama0_QR(const struct NFA *n, struct mq *q, ReportID report) {
+    DEBUG_PRINTF("entry\n");
+    const struct Tamarama *t = getImplNfa(n);
+    const u32 none = t->numSubEngines;
+
+    if (q->cur == q->end) {
+        return 1;
+    }
+
+    while (1) {
+        assert(q_cur_type(q) == MQE_START);
+        u32 activeIdx = loadActiveIdx(t, q->streamState);
+
+        if (activeIdx == none) {
+            if (q->cur + 1 == q->end
+                || !isTopEvent(q->items[q->cur + 1].type)) {
+                q->cur = q->end;
+                return 0;
+            }
+            switchEngine(t, q);
+            continue;
+        }
+
+        struct mq q1;
+        initSubQueue(t, q, &q1, activeIdx);
+        char switching;
+        u32 copied = fillSubQueue(t, q, &q1, activeIdx, &switching);
+
+        if (!switching) {
+            q->cur = q->end;
+            return nfaQueueExecRose(q1.nfa, &q1, report);
+        }
+
+        nfaQueueExecRose(q1.nfa, &q1, MO_INVALID_IDX);
+
+        u32 next = q->cur + copied;
+        storeActiveIdx(t, q->streamState, none);
+        q->cur = next - 1;
+        q->items[q->cur].type = MQE_START;
+        q->items[q->cur].location = q->items[next].location;
+        q->items[q->cur].som = 0;
+    }
+}
+
+char nfaExecTamarama0_reportCurrent(const struct NFA *n, struct mq *q) {
+    const struct Tamarama *t = getImplNfa(n);
+    u32 activeIdx = loadActiveIdx(t, q->streamState);
+    if (activeIdx == t->numSubEngines) {
+        return 1;
+    }
+
+    struct mq q1;
+    initSubQueue(t, q, &q1, activeIdx);
+    const struct mq_item *item = &q->items[q->cur];
+    pushSubEvent(&q1, item->type, item->location, item->som);
+    return nfaReportCurrentMatches(q1.nfa, &q1);
+}
+
+char nfaExecTamarama0_inAccept(const struct NFA *n, ReportID report,
+                               struct mq *q) {
+    const struct Tamarama *t = getImplNfa(n);
+    u32 activeIdx = loadActiveIdx(t, q->streamState);
+    if (activeIdx == t->numSubEngines) {
+        return 0;
+    }
+
+    struct mq q1;
+    initSubQueue(t, q, &q1, activeIdx);
+    const struct mq_item *item = &q->items[q->cur];
+    pushSubEvent(&q1, item->type, item->location, item->som);
+    return nfaInAcceptState(q1.nfa, report, &q1);
+}
+
+char nfaExecTamarama0_testEOD(const struct NFA *n, const char *state,
+                              const char *streamState, u64a offset,
+                              NfaCallback callback, SomNfaCallback som_cb,
+                              void *context) {
+    const struct Tamarama *t = getImplNfa(n);
+    u32 activeIdx = loadActiveIdx(t, streamState);
+    if (activeIdx == t->numSubEngines) {
+        return 0;
+    }
+
+    const struct NFA *sub = getSubEngine(t, activeIdx);
+    if (!nfaAcceptsEod(sub)) {
+        return 0;
+    }
+
+    return nfaCheckFinalState(sub, state, streamState + t->activeIdxSize,
+                              offset, callback, som_cb, context);
+}
+
+char nfaExecTamarama0_queueInitState(const struct NFA *n, struct mq *q) {
+    const struct Tamarama *t = getImplNfa(n);
+    storeActiveIdx(t, q->streamState, t->numSubEngines);
+    return 0;
+}
+
+char nfaExecTamarama0_initCompressedState(const struct NFA *n,
+                                          UNUSED u64a offset, void *state,
+                                          UNUSED u8 key) {
+    const struct Tamarama *t = getImplNfa(n);
+    storeActiveIdx(t, state, t->numSubEngines);
+    return 0;
+}
+
+char nfaExecTamarama0_queueCompressState(const struct NFA *n,
+                                         const struct mq *q, s64a loc) {
+    const struct Tamarama *t = getImplNfa(n);
+    u32 activeIdx = loadActiveIdx(t, q->streamState);
+    if (activeIdx == t->numSubEngines) {
+        return 0;
+    }
+
+    struct mq q1;
+    initSubQueue(t, q, &q1, activeIdx);
+    if (q->cur < q->end) {
+        const struct mq_item *item = &q->items[q->cur];
+        pushSubEvent(&q1, item->type, item->location, item->som);
+    }
+    return nfaQueueCompressState(q1.nfa, &q1, loc);
+}
+
+char nfaExecTamarama0_expandState(const struct NFA *n, void *dest,
+                                  const void *src, u64a offset, u8 key) {
+    const struct Tamarama *t = getImplNfa(n);
+    u32 activeIdx = loadActiveIdx(t, src);
+    if (activeIdx == t->numSubEngines) {
+        return 0;
+    }
+
+    const struct NFA *sub = getSubEngine(t, activeIdx);
+    return nfaExpandState(sub, dest, (const char *)src + t->activeIdxSize,
+                          offset, key);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Tamarama: container engine for exclusive engines, data structures.
+ */
+
+#ifndef NFA_TAMARAMA_INTERNAL_H
+#define NFA_TAMARAMA_INTERNAL_H
+
+#include "ue2common.h"
+
+/**
+ * \brief Tamarama engine structure.
+ *
+ * A Tamarama holds a set of sub-engines, of which at most one may be alive at
+ * any time: the triggers of each engine are known to kill all of the others.
+ * The sub-engines share a single queue and a single state region, with the
+ * index of the live sub-engine stored at the front of stream state (equal to
+ * numSubEngines if none is live).
+ *
+ * The top space of the container is partitioned between the sub-engines:
+ * container top (baseTop[i] + t) is top t of sub-engine i.
+ *
+ * Memory layout:
+ *
+ *     struct NFA
+ *     struct Tamarama
+ *     u32 baseTop[numSubEngines]
+ *     u32 subEngineOffset[numSubEngines] (relative to the start of the NFA)
+ *     sub-engines, each cache-line aligned
+ */
+struct Tamarama {
+    u32 numSubEngines;  //!< number of sub-engines
+    u8 activeIdxSize;   //!< bytes of stream state used for the active index
+};
+
+#endif // NFA_TAMARAMA_INTERNAL_H
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Tamarama: container engine for exclusive engines, compiler code.
+ */
+
+#include "tamaramacompile.h"
+
+#include "tamarama_internal.h"
+#include "nfa_internal.h"
+#include "repeatcompile.h"
+#include "util/verify_types.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace ue2 {
+
+aligned_unique_ptr<NFA> buildTamarama(const vector<const NFA *> &subs,
+                                      const vector<u32> &baseTop) {
+    assert(!subs.empty());
+    assert(subs.size() == baseTop.size());
+    assert(baseTop[0] == 0);
+    assert(is_sorted(baseTop.begin(), baseTop.end()));
+
+    const u32 numSubEngines = verify_u32(subs.size());
+    const u32 activeIdxSize = calcPackedBytes(numSubEngines + 1);
+
+    size_t offset = sizeof(NFA) + sizeof(Tamarama)
+                    + 2 * sizeof(u32) * numSubEngines;
+    vector<u32> subOffset;
+    for (const NFA *sub : subs) {
+        assert(!isContainerType(sub->type));
+        offset = ROUNDUP_CL(offset);
+        subOffset.push_back(verify_u32(offset));
+        offset += sub->length;
+    }
+    const size_t total_size = offset;
+    DEBUG_PRINTF("%u sub-engines, total size %zu\n", numSubEngines,
+                 total_size);
+
+    aligned_unique_ptr<NFA> nfa = aligned_zmalloc_unique<NFA>(total_size);
+    nfa->type = verify_u8(TAMARAMA_NFA_0);
+    nfa->length = verify_u32(total_size);
+
+    // The container's properties must cover whichever sub-engine is live.
+    u32 maxScratch = 0;
+    u32 maxStream = 0;
+    bool boundedWidth = true;
+    bool boundedOffset = true;
+    nfa->minWidth = ~0U;
+    for (const NFA *sub : subs) {
+        nfa->flags |= sub->flags & NFA_ACCEPTS_EOD;
+        nfa->nPositions += sub->nPositions;
+        maxScratch = max(maxScratch, sub->scratchStateSize);
+        maxStream = max(maxStream, sub->streamStateSize);
+        nfa->minWidth = min(nfa->minWidth, sub->minWidth);
+        boundedWidth &= sub->maxWidth != 0;
+        nfa->maxWidth = max(nfa->maxWidth, sub->maxWidth);
+        boundedOffset &= sub->maxOffset != 0;
+        nfa->maxOffset = max(nfa->maxOffset, sub->maxOffset);
+    }
+    if (!boundedWidth) {
+        nfa->maxWidth = 0;
+    }
+    if (!boundedOffset) {
+        nfa->maxOffset = 0;
+    }
+    nfa->scratchStateSize = maxScratch;
+    nfa->streamStateSize = activeIdxSize + maxStream;
+
+    char *ptr = (char *)nfa.get();
+    Tamarama *t = (Tamarama *)getMutableImplNfa(nfa.get());
+    t->numSubEngines = numSubEngines;
+    t->activeIdxSize = verify_u8(activeIdxSize);
+
+    u32 *tops = (u32 *)(ptr + sizeof(NFA) + sizeof(Tamarama));
+    u32 *offsets = tops + numSubEngines;
+    for (u32 i = 0; i < numSubEngines; i++) {
+        tops[i] = baseTop[i];
+        offsets[i] = subOffset[i];
+        memcpy(ptr + subOffset[i], subs[i], subs[i]->length);
+    }
+
+    return nfa;
+}
+
+} // namespace ue2
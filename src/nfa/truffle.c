@@ -39,6 +39,8 @@
 
 #define shift128r(a, b) _mm_srli_epi64((a), (b))
 
+#if !defined(__AVX512BW__)
+
 static really_inline
 const u8 *firstMatch(const u8 *buf, u32 z) {
     if (unlikely(z != 0xffff)) {
@@ -233,4 +235,147 @@ const u8 *rtruffleExec(m128 shuf_mask_lo_highclear,
     return buf - 1;
 }
 
+#else // AVX-512BW
+
+/* z has a bit set for every byte that is in the class */
+static really_inline
+const u8 *firstMatch(const u8 *buf, u64a z) {
+    if (unlikely(z)) {
+        u32 pos = ctz64(z);
+        assert(pos < 64);
+        return buf + pos;
+    }
+
+    return NULL; // no match
+}
+
+static really_inline
+const u8 *lastMatch(const u8 *buf, u64a z) {
+    if (unlikely(z)) {
+        u32 pos = clz64(z);
+        assert(pos < 64);
+        return buf + (63 - pos);
+    }
+
+    return NULL; // no match
+}
+
+static really_inline
+u64a block(m512 shuf_mask_lo_highclear, m512 shuf_mask_lo_highset, m512 v) {
+
+    m512 highconst = set64x8(0x80);
+    m512 shuf_mask_hi = _mm512_set1_epi64(0x8040201008040201);
+
+    // and now do the real work
+    m512 shuf1 = pshufb_m512(shuf_mask_lo_highclear, v);
+    m512 t1 = xor512(v, highconst);
+    m512 shuf2 = pshufb_m512(shuf_mask_lo_highset, t1);
+    m512 t2 = andnot512(highconst, rshift8x64(v, 4));
+    m512 shuf3 = pshufb_m512(shuf_mask_hi, t2);
+    m512 tmp = and512(or512(shuf1, shuf2), shuf3);
+
+    return ~eq512mask(tmp, zeroes512());
+}
+
+const u8 *truffleExec(m128 shuf_mask_lo_highclear,
+                      m128 shuf_mask_lo_highset,
+                      const u8 *buf, const u8 *buf_end) {
+    DEBUG_PRINTF("len %zu\n", buf_end - buf);
+
+    assert(buf && buf_end);
+    assert(buf < buf_end);
+    const m512 wide_clear = set4x128(shuf_mask_lo_highclear);
+    const m512 wide_set = set4x128(shuf_mask_lo_highset);
+    const u8 *rv;
+
+    // Short cases are handled with a single masked load.
+    size_t len = buf_end - buf;
+    if (len <= 64) {
+        u64a k = ~0ULL >> (64 - len);
+        m512 chars = loadu_maskz512(k, buf);
+        rv = firstMatch(buf, block(wide_clear, wide_set, chars) & k);
+        return rv ? rv : buf_end;
+    }
+
+    size_t min = (size_t)buf % 64;
+
+    // Preconditioning: most of the time our buffer won't be aligned.
+    m512 chars = loadu512(buf);
+    rv = firstMatch(buf, block(wide_clear, wide_set, chars));
+    if (rv) {
+        return rv;
+    }
+    buf += (64 - min);
+
+    const u8 *last_block = buf_end - 64;
+    while (buf < last_block) {
+        m512 lchars = load512(buf);
+        rv = firstMatch(buf, block(wide_clear, wide_set, lchars));
+        if (rv) {
+            return rv;
+        }
+        buf += 64;
+    }
+
+    // Use an unaligned load to mop up the last 64 bytes and get an accurate
+    // picture to buf_end.
+    assert(buf <= buf_end && buf >= buf_end - 64);
+    chars = loadu512(buf_end - 64);
+    rv = firstMatch(buf_end - 64, block(wide_clear, wide_set, chars));
+    if (rv) {
+        return rv;
+    }
+
+    return buf_end;
+}
+
+const u8 *rtruffleExec(m128 shuf_mask_lo_highclear,
+                       m128 shuf_mask_lo_highset,
+                       const u8 *buf, const u8 *buf_end) {
+    DEBUG_PRINTF("len %zu\n", buf_end - buf);
+
+    assert(buf && buf_end);
+    assert(buf < buf_end);
+    const m512 wide_clear = set4x128(shuf_mask_lo_highclear);
+    const m512 wide_set = set4x128(shuf_mask_lo_highset);
+    const u8 *rv;
+
+    // Short cases are handled with a single masked load.
+    size_t len = buf_end - buf;
+    if (len <= 64) {
+        u64a k = ~0ULL >> (64 - len);
+        m512 chars = loadu_maskz512(k, buf);
+        rv = lastMatch(buf, block(wide_clear, wide_set, chars) & k);
+        return rv ? rv : buf - 1;
+    }
+
+    // Preconditioning: most of the time our buffer won't be aligned.
+    m512 chars = loadu512(buf_end - 64);
+    rv = lastMatch(buf_end - 64, block(wide_clear, wide_set, chars));
+    if (rv) {
+        return rv;
+    }
+    buf_end = (const u8 *)((size_t)buf_end & ~((size_t)0x3f));
+
+    const u8 *last_block = buf + 64;
+    while (buf_end > last_block) {
+        buf_end -= 64;
+        m512 lchars = load512(buf_end);
+        rv = lastMatch(buf_end, block(wide_clear, wide_set, lchars));
+        if (rv) {
+            return rv;
+        }
+    }
+
+    // Use an unaligned load to mop up the last 64 bytes and get an accurate
+    // picture to buf.
+    chars = loadu512(buf);
+    rv = lastMatch(buf, block(wide_clear, wide_set, chars));
+    if (rv) {
+        return rv;
+    }
+
+    return buf - 1;
+}
 
+#endif // AVX512BW
@@ -40,6 +40,18 @@ static really_inline
 const u8 *vermSearchAligned(m128 chars, const u8 *buf, const u8 *buf_end,
                             char negate) {
     assert((size_t)buf % 16 == 0);
+#if defined(__AVX512BW__)
+    m512 wide_chars = set4x128(chars);
+    for (; buf + 63 < buf_end; buf += 64) {
+        u64a z = eq512mask(wide_chars, loadu512(buf));
+        if (negate) {
+            z = ~z;
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
     for (; buf + 31 < buf_end; buf += 32) {
         m128 data = load128(buf);
         u32 z1 = movemask128(eq128(chars, data));
@@ -74,6 +86,21 @@ const u8 *vermSearchAlignedNocase(m128 chars, const u8 *buf,
     assert((size_t)buf % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
 
+#if defined(__AVX512BW__)
+    m512 wide_chars = set4x128(chars);
+    m512 wide_casemask = set64x8(CASE_CLEAR);
+    for (; buf + 63 < buf_end; buf += 64) {
+        m512 data = and512(wide_casemask, loadu512(buf));
+        u64a z = eq512mask(wide_chars, data);
+        if (negate) {
+            z = ~z;
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
+
     for (; buf + 31 < buf_end; buf += 32) {
         m128 data = load128(buf);
         u32 z1 = movemask128(eq128(chars, and128(casemask, data)));
@@ -135,6 +162,21 @@ const u8 *vermUnalignNocase(m128 chars, const u8 *buf, char negate) {
 static really_inline
 const u8 *dvermSearchAligned(m128 chars1, m128 chars2, u8 c1, u8 c2,
                              const u8 *buf, const u8 *buf_end) {
+#if defined(__AVX512BW__)
+    m512 wide_chars1 = set4x128(chars1);
+    m512 wide_chars2 = set4x128(chars2);
+    for (; buf + 64 < buf_end; buf += 64) {
+        m512 data = loadu512(buf);
+        u64a z = eq512mask(wide_chars1, data)
+               & (eq512mask(wide_chars2, data) >> 1);
+        if (buf[63] == c1 && buf[64] == c2) {
+            z |= (1ULL << 63);
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
     for (; buf + 16 < buf_end; buf += 16) {
         m128 data = load128(buf);
         u32 z = movemask128(and128(eq128(chars1, data),
@@ -156,6 +198,22 @@ const u8 *dvermSearchAlignedNocase(m128 chars1, m128 chars2, u8 c1, u8 c2,
     assert((size_t)buf % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
 
+#if defined(__AVX512BW__)
+    m512 wide_chars1 = set4x128(chars1);
+    m512 wide_chars2 = set4x128(chars2);
+    m512 wide_casemask = set64x8(CASE_CLEAR);
+    for (; buf + 64 < buf_end; buf += 64) {
+        m512 v = and512(wide_casemask, loadu512(buf));
+        u64a z = eq512mask(wide_chars1, v) & (eq512mask(wide_chars2, v) >> 1);
+        if ((buf[63] & CASE_CLEAR) == c1 && (buf[64] & CASE_CLEAR) == c2) {
+            z |= (1ULL << 63);
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf += 16) {
         m128 data = load128(buf);
         m128 v = and128(casemask, data);
@@ -215,6 +273,18 @@ static really_inline
 const u8 *rvermSearchAligned(m128 chars, const u8 *buf, const u8 *buf_end,
                              char negate) {
     assert((size_t)buf_end % 16 == 0);
+#if defined(__AVX512BW__)
+    m512 wide_chars = set4x128(chars);
+    for (; buf + 63 < buf_end; buf_end -= 64) {
+        u64a z = eq512mask(wide_chars, loadu512(buf_end - 64));
+        if (negate) {
+            z = ~z;
+        }
+        if (unlikely(z)) {
+            return buf_end - 1 - clz64(z);
+        }
+    }
+#endif
     for (; buf + 15 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         u32 z = movemask128(eq128(chars, data));
@@ -234,6 +304,21 @@ const u8 *rvermSearchAlignedNocase(m128 chars, const u8 *buf,
     assert((size_t)buf_end % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
 
+#if defined(__AVX512BW__)
+    m512 wide_chars = set4x128(chars);
+    m512 wide_casemask = set64x8(CASE_CLEAR);
+    for (; buf + 63 < buf_end; buf_end -= 64) {
+        m512 data = and512(wide_casemask, loadu512(buf_end - 64));
+        u64a z = eq512mask(wide_chars, data);
+        if (negate) {
+            z = ~z;
+        }
+        if (unlikely(z)) {
+            return buf_end - 1 - clz64(z);
+        }
+    }
+#endif
+
     for (; buf + 15 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         u32 z = movemask128(eq128(chars, and128(casemask, data)));
@@ -281,6 +366,22 @@ const u8 *rdvermSearchAligned(m128 chars1, m128 chars2, u8 c1, u8 c2,
                               const u8 *buf, const u8 *buf_end) {
     assert((size_t)buf_end % 16 == 0);
 
+#if defined(__AVX512BW__)
+    m512 wide_chars1 = set4x128(chars1);
+    m512 wide_chars2 = set4x128(chars2);
+    for (; buf + 64 < buf_end; buf_end -= 64) {
+        m512 data = loadu512(buf_end - 64);
+        u64a z = eq512mask(wide_chars2, data)
+               & (eq512mask(wide_chars1, data) << 1);
+        if (buf_end[-65] == c1 && buf_end[-64] == c2) {
+            z |= 1;
+        }
+        if (unlikely(z)) {
+            return buf_end - 1 - clz64(z);
+        }
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         u32 z = movemask128(and128(eq128(chars2, data),
@@ -301,6 +402,23 @@ const u8 *rdvermSearchAlignedNocase(m128 chars1, m128 chars2, u8 c1, u8 c2,
     assert((size_t)buf_end % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
 
+#if defined(__AVX512BW__)
+    m512 wide_chars1 = set4x128(chars1);
+    m512 wide_chars2 = set4x128(chars2);
+    m512 wide_casemask = set64x8(CASE_CLEAR);
+    for (; buf + 64 < buf_end; buf_end -= 64) {
+        m512 v = and512(wide_casemask, loadu512(buf_end - 64));
+        u64a z = eq512mask(wide_chars2, v) & (eq512mask(wide_chars1, v) << 1);
+        if ((buf_end[-65] & CASE_CLEAR) == c1
+            && (buf_end[-64] & CASE_CLEAR) == c2) {
+            z |= 1;
+        }
+        if (unlikely(z)) {
+            return buf_end - 1 - clz64(z);
+        }
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         m128 v = and128(casemask, data);
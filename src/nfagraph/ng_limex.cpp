@@ -44,6 +44,7 @@
 #include "ng_util.h"
 #include "ng_width.h"
 #include "ue2common.h"
+#include "compiler/compile_cache.h"
 #include "nfa/limex_compile.h"
 #include "nfa/limex_limits.h"
 #include "nfa/nfa_internal.h"
@@ -54,6 +55,7 @@
 #include "util/ue2_containers.h"
 
 #include <map>
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -409,8 +411,23 @@ constructNFA(const NGHolder &h_in, const ReportManager *rm,
     const u32 hint = INVALID_NFA;
     const bool do_accel = cc.grey.accelerateNFA;
     const bool impl_test_only = false;
-    return constructNFA(h_in, rm, fixed_depth_tops, triggers, compress_state,
-                        do_accel, impl_test_only, hint, cc);
+
+    string key;
+    if (cc.cache) {
+        key = nfaCacheKey(h_in, rm, fixed_depth_tops, triggers, compress_state);
+        aligned_unique_ptr<NFA> n;
+        if (cc.cache->findNfa(key, &n)) {
+            DEBUG_PRINTF("using cached nfa\n");
+            return n;
+        }
+    }
+
+    auto n = constructNFA(h_in, rm, fixed_depth_tops, triggers,
+                          compress_state, do_accel, impl_test_only, hint, cc);
+    if (cc.cache) {
+        cc.cache->addNfa(key, n.get());
+    }
+    return n;
 }
 
 #ifndef RELEASE_BUILD
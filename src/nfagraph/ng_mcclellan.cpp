@@ -40,7 +40,9 @@
 #include "ng_squash.h"
 #include "ng_util.h"
 #include "ue2common.h"
+#include "compiler/compile_cache.h"
 #include "util/bitfield.h"
+#include "util/compile_context.h"
 #include "util/determinise.h"
 #include "util/graph_range.h"
 #include "util/make_unique.h"
@@ -51,6 +53,7 @@
 #include <functional>
 #include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 #include <boost/dynamic_bitset.hpp>
@@ -662,4 +665,33 @@ unique_ptr<raw_dfa> buildMcClellan(const NGHolder &g, const ReportManager *rm,
     return buildMcClellan(g, rm, false, triggers, grey);
 }
 
+unique_ptr<raw_dfa> buildMcClellan(const NGHolder &g, const ReportManager *rm,
+                                   bool single_trigger,
+                                   const vector<vector<CharReach>> &triggers,
+                                   const CompileContext &cc, bool finalChance) {
+    if (!cc.cache || !cc.grey.allowMcClellan) {
+        return buildMcClellan(g, rm, single_trigger, triggers, cc.grey,
+                              finalChance);
+    }
+
+    string key = dfaCacheKey(g, rm, single_trigger, triggers, finalChance);
+    unique_ptr<raw_dfa> rdfa;
+    if (cc.cache->findDfa(key, &rdfa)) {
+        DEBUG_PRINTF("using cached dfa\n");
+        return rdfa;
+    }
+
+    rdfa = buildMcClellan(g, rm, single_trigger, triggers, cc.grey,
+                          finalChance);
+    cc.cache->addDfa(key, rdfa.get());
+    return rdfa;
+}
+
+unique_ptr<raw_dfa> buildMcClellan(const NGHolder &g, const ReportManager *rm,
+                                   const CompileContext &cc) {
+    assert(!is_triggered(g));
+    vector<vector<CharReach>> triggers;
+    return buildMcClellan(g, rm, false, triggers, cc);
+}
+
 } // namespace ue2
@@ -43,6 +43,7 @@ namespace ue2 {
 class CharReach;
 class NGHolder;
 class ReportManager;
+struct CompileContext;
 struct Grey;
 struct raw_dfa;
 
@@ -76,6 +77,20 @@ std::unique_ptr<raw_dfa> buildMcClellan(const NGHolder &g,
                                         const ReportManager *rm,
                                         const Grey &grey);
 
+/**
+ * \brief As above, but uses the compile cache in \a cc (if any) to avoid
+ * repeating a determinisation done by an earlier compile.
+ */
+std::unique_ptr<raw_dfa> buildMcClellan(const NGHolder &g,
+                          const ReportManager *rm, bool single_trigger,
+                          const std::vector<std::vector<CharReach>> &triggers,
+                          const CompileContext &cc, bool finalChance = false);
+
+/** Convenience wrapper for non-triggered engines, using the compile cache */
+std::unique_ptr<raw_dfa> buildMcClellan(const NGHolder &g,
+                                        const ReportManager *rm,
+                                        const CompileContext &cc);
+
 } // namespace ue2
 
 #endif // NG_MCCLELLAN_H
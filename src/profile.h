@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Runtime profiling counters.
+ *
+ * The counters live in scratch and are only compiled in when the library is
+ * built with ENABLE_PROFILING. In other builds every function here is empty,
+ * so the calls in the scan paths compile away entirely.
+ *
+ * Stage timers are inclusive: a stage that runs from inside another (role
+ * evaluation from the literal matcher callback, say) is counted in both.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "hs_runtime.h"
+#include "scratch.h"
+#include "ue2common.h"
+
+#include <string.h>
+
+#ifdef ENABLE_PROFILING
+#if defined(HAVE_C_X86INTRIN_H)
+#include <x86intrin.h>
+#elif defined(HAVE_C_INTRIN_H)
+#include <intrin.h>
+#endif
+
+#if PROF_STAGE_COUNT != HS_PROFILE_STAGE_COUNT
+#error "scratch profile stages do not match HS_PROFILE_STAGE_COUNT"
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** \brief Read the cycle counter at the start of a timed stage. */
+static really_inline
+u64a profileStart(void) {
+#ifdef ENABLE_PROFILING
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/** \brief Account for one entry into the given HS_PROFILE_* stage, which
+ * began at \a start (from \ref profileStart). */
+static really_inline
+void profileStage(UNUSED struct hs_scratch *s, UNUSED u32 stage,
+                  UNUSED u64a start) {
+#ifdef ENABLE_PROFILING
+    assert(stage < PROF_STAGE_COUNT);
+    s->prof.stage_calls[stage]++;
+    s->prof.stage_cycles[stage] += __rdtsc() - start;
+#endif
+}
+
+/** \brief Account for a block or stream write of \a len bytes. */
+static really_inline
+void profileScan(UNUSED struct hs_scratch *s, UNUSED size_t len) {
+#ifdef ENABLE_PROFILING
+    s->prof.scans++;
+    s->prof.bytes += len;
+#endif
+}
+
+/** \brief Account for a match delivered to the user callback. */
+static really_inline
+void profileMatch(UNUSED struct hs_scratch *s) {
+#ifdef ENABLE_PROFILING
+    s->prof.matches++;
+#endif
+}
+
+/** \brief Account for an invocation of the engine on queue \a qi. */
+static really_inline
+void profileQueue(UNUSED struct hs_scratch *s, UNUSED u32 qi) {
+#ifdef ENABLE_PROFILING
+    if (qi < s->queueCount) {
+        s->prof.queue_calls[qi]++;
+    }
+#endif
+}
+
+/** \brief Account for a match of the Rose literal with the given id. */
+static really_inline
+void profileLiteral(UNUSED struct hs_scratch *s, UNUSED u32 id) {
+#ifdef ENABLE_PROFILING
+    if (id < s->prof.literalCount) {
+        s->prof.literal_hits[id]++;
+    }
+#endif
+}
+
+/** \brief Set up the counters of a scratch header that has no counter
+ * arrays, such as the on-stack context used by \ref hs_scan_small. */
+static really_inline
+void profileInit(UNUSED struct hs_scratch *s) {
+#ifdef ENABLE_PROFILING
+    memset(&s->prof, 0, sizeof(s->prof));
+#endif
+}
+
+/** \brief Zero all of the profiling counters in this scratch. */
+static really_inline
+void profileClear(UNUSED struct hs_scratch *s) {
+#ifdef ENABLE_PROFILING
+    struct scratch_profile *p = &s->prof;
+    p->scans = 0;
+    p->bytes = 0;
+    p->matches = 0;
+    memset(p->stage_calls, 0, sizeof(p->stage_calls));
+    memset(p->stage_cycles, 0, sizeof(p->stage_cycles));
+    if (p->queue_calls) {
+        memset(p->queue_calls, 0, s->queueCount * sizeof(u64a));
+    }
+    if (p->literal_hits) {
+        memset(p->literal_hits, 0, p->literalCount * sizeof(u64a));
+    }
+#endif
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PROFILE_H */
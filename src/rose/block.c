@@ -33,6 +33,7 @@
 #include "nfa/nfa_internal.h"
 #include "nfa/nfa_rev_api.h"
 #include "nfa/mcclellan.h"
+#include "profile.h"
 #include "util/fatbit.h"
 #include "rose_sidecar_runtime.h"
 #include "rose.h"
@@ -186,6 +187,128 @@ void init_for_block(const struct RoseEngine *t, struct hs_scratch *scratch,
     init_outfixes_for_block(t, scratch, state, is_small_block);
 }
 
+static really_inline
+void runAnchoredBlock(const struct RoseEngine *t, struct hs_scratch *scratch) {
+    const void *atable = getALiteralMatcher(t);
+    if (!atable) {
+        return;
+    }
+
+    const size_t length = scratch->core_info.len;
+
+    if (t->amatcherMaxBiAnchoredWidth != ROSE_BOUND_INF
+        && length > t->amatcherMaxBiAnchoredWidth) {
+        return;
+    }
+
+    if (length < t->amatcherMinWidth) {
+        return;
+    }
+
+    u64a prof_start = profileStart();
+    runAnchoredTableBlock(t, atable, scratch);
+    profileStage(scratch, HS_PROFILE_ANCHORED, prof_start);
+
+    if (can_stop_matching(scratch)) {
+        return;
+    }
+
+    resetAnchoredLog(t, scratch);
+}
+
+/* Literal callback for a resumed range of a block scan: matches ending before
+ * the start of the range were handled when the previous range was scanned. */
+static
+hwlmcb_rv_t roseRangeCallback(size_t start, size_t end, u32 id, void *ctxt) {
+    struct RoseContext *tctxt = ctxt;
+    if (end < tctxt->range_start) {
+        return tctxt->groups;
+    }
+
+    return roseCallback(start, end, id, ctxt);
+}
+
+/* Runs the floating literal matcher over literal ends in [from, to). */
+static really_inline
+void runFloatingBlock(const struct RoseEngine *t, struct hs_scratch *scratch,
+                      size_t from, size_t to) {
+    const struct HWLM *ftable = getFLiteralMatcher(t);
+    if (!ftable) {
+        return;
+    }
+
+    struct RoseContext *tctxt = &scratch->tctxt;
+    const size_t length = scratch->core_info.len;
+
+    DEBUG_PRINTF("ftable fd=%u fmd %u\n", t->floatingDistance,
+                 t->floatingMinDistance);
+    if (t->noFloatingRoots && tctxt->depth == 1) {
+        DEBUG_PRINTF("skip FLOATING: no inflight matches\n");
+        return;
+    }
+
+    if (t->fmatcherMaxBiAnchoredWidth != ROSE_BOUND_INF
+        && length > t->fmatcherMaxBiAnchoredWidth) {
+        return;
+    }
+
+    if (length < t->fmatcherMinWidth) {
+        return;
+    }
+
+    const u8 *buffer = scratch->core_info.buf;
+    size_t flen = length;
+    if (t->floatingDistance != ROSE_BOUND_INF) {
+        flen = MIN(t->floatingDistance, length);
+    }
+    if (flen <= t->floatingMinDistance) {
+        return;
+    }
+
+    size_t start = t->floatingMinDistance;
+    HWLMCallback cb = roseCallback;
+    if (from) {
+        if (from >= flen) {
+            return;
+        }
+
+        /* a literal ending in range may begin before it */
+        size_t lookback = hwlmMaxLength(ftable) - 1;
+        if (from > start + lookback) {
+            start = from - lookback;
+        }
+        tctxt->range_start = from;
+        cb = roseRangeCallback;
+    }
+    flen = MIN(flen, to);
+    if (flen <= start) {
+        return;
+    }
+
+    DEBUG_PRINTF("BEGIN FLOATING (over %zu/%zu from %zu)\n", flen, length,
+                 start);
+    DEBUG_PRINTF("-- %016llx\n", tctxt->groups);
+    u64a prof_start = profileStart();
+    hwlmExec(ftable, buffer, flen, start, cb, tctxt, tctxt->groups);
+    profileStage(scratch, HS_PROFILE_LITERAL_MATCHER, prof_start);
+}
+
+static really_inline
+void finishBlock(const struct RoseEngine *t, struct hs_scratch *scratch) {
+    struct RoseContext *tctxt = &scratch->tctxt;
+    const size_t length = scratch->core_info.len;
+
+    u8 dummy_delay_mask = 0;
+    if (cleanUpDelayed(length, 0, tctxt, &dummy_delay_mask)
+        == HWLM_TERMINATE_MATCHING) {
+        return;
+    }
+
+    assert(!can_stop_matching(scratch));
+
+    roseCatchUpTo(t, tctxt->state, length, scratch, 0);
+}
+
 void roseBlockExec_i(const struct RoseEngine *t, struct hs_scratch *scratch,
                      RoseCallback callback, RoseCallbackSom som_callback,
                      void *ctx) {
@@ -219,75 +342,66 @@ void roseBlockExec_i(const struct RoseEngine *t, struct hs_scratch *scratch,
 
         DEBUG_PRINTF("BEGIN SMALL BLOCK (over %zu/%zu)\n", sblen, length);
         DEBUG_PRINTF("-- %016llx\n", tctxt->groups);
+        u64a prof_start = profileStart();
         hwlmExec(sbtable, scratch->core_info.buf, sblen, 0, roseCallback,
                  tctxt, tctxt->groups);
+        profileStage(scratch, HS_PROFILE_LITERAL_MATCHER, prof_start);
         goto exit;
     }
 
-    const void *atable = getALiteralMatcher(t);
-
-    if (atable) {
-        if (t->amatcherMaxBiAnchoredWidth != ROSE_BOUND_INF
-            && length > t->amatcherMaxBiAnchoredWidth) {
-            goto skip_atable;
-        }
+    runAnchoredBlock(t, scratch);
 
-        if (length < t->amatcherMinWidth) {
-            goto skip_atable;
-        }
+    if (can_stop_matching(scratch)) {
+        goto exit;
+    }
 
+    runFloatingBlock(t, scratch, 0, length);
 
-        runAnchoredTableBlock(t, atable, scratch);
+exit:
+    finishBlock(t, scratch);
+}
 
-        if (can_stop_matching(scratch)) {
-            goto exit;
-        }
+void roseBlockExecBegin(const struct RoseEngine *t, struct hs_scratch *scratch,
+                        RoseCallback callback, RoseCallbackSom som_callback,
+                        void *ctx) {
+    assert(t);
+    assert(scratch);
+    assert(scratch->core_info.buf);
+    assert(scratch->core_info.len >= ROSE_SMALL_BLOCK_LEN
+           || !t->sbmatcherOffset);
 
-        resetAnchoredLog(t, scratch);
-    skip_atable:;
-    }
+    u8 *state = (u8 *)scratch->core_info.state;
+    init_for_block(t, scratch, callback, som_callback, ctx, state, 0);
 
-    const struct HWLM *ftable = getFLiteralMatcher(t);
-    if (ftable) {
-        DEBUG_PRINTF("ftable fd=%u fmd %u\n", t->floatingDistance,
-            t->floatingMinDistance);
-        if (t->noFloatingRoots && tctxt->depth == 1) {
-            DEBUG_PRINTF("skip FLOATING: no inflight matches\n");
-            goto exit;
-        }
+    runAnchoredBlock(t, scratch);
+}
 
-        if (t->fmatcherMaxBiAnchoredWidth != ROSE_BOUND_INF
-            && length > t->fmatcherMaxBiAnchoredWidth) {
-            goto exit;
-        }
+void roseBlockExecRange(const struct RoseEngine *t, struct hs_scratch *scratch,
+                        size_t from, size_t to) {
+    assert(from < to);
+    assert(to <= scratch->core_info.len);
 
-        if (length < t->fmatcherMinWidth) {
-            goto exit;
-        }
+    if (can_stop_matching(scratch)) {
+        return;
+    }
 
-        const u8 *buffer = scratch->core_info.buf;
-        size_t flen = length;
-        if (t->floatingDistance != ROSE_BOUND_INF) {
-            flen = MIN(t->floatingDistance, length);
-        }
-        if (flen <= t->floatingMinDistance) {
-            goto exit;
-        }
+    runFloatingBlock(t, scratch, from, to);
 
-        DEBUG_PRINTF("BEGIN FLOATING (over %zu/%zu)\n", flen, length);
-        DEBUG_PRINTF("-- %016llx\n", tctxt->groups);
-        hwlmExec(ftable, buffer, flen, t->floatingMinDistance,
-                 roseCallback, tctxt, tctxt->groups);
+    if (to == scratch->core_info.len) {
+        return; /* left to roseBlockExecEnd */
     }
 
-exit:;
-    u8 dummy_delay_mask = 0;
-    if (cleanUpDelayed(length, 0, tctxt, &dummy_delay_mask)
-        == HWLM_TERMINATE_MATCHING) {
+    /* Deliver everything up to the end of the range, so that the work done on
+     * later ranges does not grow with the number of ranges before them. */
+    struct RoseContext *tctxt = &scratch->tctxt;
+    if (can_stop_matching(scratch)
+        || flushQueuedLiterals(tctxt, to) == HWLM_TERMINATE_MATCHING) {
         return;
     }
 
-    assert(!can_stop_matching(scratch));
+    roseCatchUpTo(t, tctxt->state, to, scratch, 0);
+}
 
-    roseCatchUpTo(t, state, length, scratch, 0);
+void roseBlockExecEnd(const struct RoseEngine *t, struct hs_scratch *scratch) {
+    finishBlock(t, scratch);
 }
@@ -26,8 +26,10 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "budget.h"
 #include "catchup.h"
 #include "match.h"
+#include "profile.h"
 #include "rose.h"
 #include "nfa/nfa_rev_api.h"
 #include "nfa/mpv.h"
@@ -956,6 +958,10 @@ hwlmcb_rv_t buildSufPQ(const struct RoseEngine *t, u8 *state, s64a safe_loc,
 
     while (a_qi != MMB_INVALID) {
         DEBUG_PRINTF("catching up qi=%u to %lld\n", a_qi, final_loc);
+        if (budgetTick(scratch, scratch->core_info.buf_offset + safe_loc)) {
+            return HWLM_TERMINATE_MATCHING;
+        }
+
         u32 n_qi = mmbit_iterate(aa, aaCount, a_qi);
 
         s64a second_place_loc
@@ -986,8 +992,8 @@ hwlmcb_rv_t buildSufPQ(const struct RoseEngine *t, u8 *state, s64a safe_loc,
 }
 
 static never_inline
-hwlmcb_rv_t roseCatchUpNfas(const struct RoseEngine *t, u8 *state, s64a loc,
-                            s64a final_loc, struct hs_scratch *scratch) {
+hwlmcb_rv_t roseCatchUpNfas_i(const struct RoseEngine *t, u8 *state, s64a loc,
+                              s64a final_loc, struct hs_scratch *scratch) {
     struct RoseContext *tctxt = &scratch->tctxt;
     assert(t->activeArrayCount);
 
@@ -1015,6 +1021,10 @@ hwlmcb_rv_t roseCatchUpNfas(const struct RoseEngine *t, u8 *state, s64a loc,
             goto exit;
         }
 
+        if (budgetTick(scratch, match_loc + scratch->core_info.buf_offset)) {
+            return HWLM_TERMINATE_MATCHING;
+        }
+
         /* catch up char matches to this point */
         if (roseCatchUpMPV(t, state, match_loc, scratch)
             == HWLM_TERMINATE_MATCHING) {
@@ -1081,6 +1091,15 @@ exit:;
     return HWLM_CONTINUE_MATCHING;
 }
 
+static really_inline
+hwlmcb_rv_t roseCatchUpNfas(const struct RoseEngine *t, u8 *state, s64a loc,
+                            s64a final_loc, struct hs_scratch *scratch) {
+    u64a prof_start = profileStart();
+    hwlmcb_rv_t rv = roseCatchUpNfas_i(t, state, loc, final_loc, scratch);
+    profileStage(scratch, HS_PROFILE_CATCHUP, prof_start);
+    return rv;
+}
+
 static really_inline
 hwlmcb_rv_t roseCatchUpNfasAndMpv(const struct RoseEngine *t, u8 *state,
                                   s64a loc, s64a final_loc,
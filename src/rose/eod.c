@@ -28,6 +28,7 @@
 
 #include "catchup.h"
 #include "match.h"
+#include "profile.h"
 #include "rose_sidecar_runtime.h"
 #include "rose.h"
 #include "util/fatbit.h"
@@ -107,7 +108,10 @@ hwlmcb_rv_t roseEodRunMatcher(const struct RoseEngine *t, u64a offset,
 
     const struct HWLM *etable = getELiteralMatcher(t);
 
+    u64a prof_start = profileStart();
     hwlmExec(etable, eod_data, eod_len, adj, roseCallback, tctxt, tctxt->groups);
+    profileStage(tctxtToScratch(tctxt), HS_PROFILE_LITERAL_MATCHER,
+                 prof_start);
 
     // We may need to fire delayed matches
     u8 dummy_delay_mask = 0;
@@ -71,25 +71,30 @@ void init_sidecar(const struct RoseEngine *t, u8 *state) {
 }
 
 static really_inline
-void init_outfixes(const struct RoseEngine *t, u8 *state) {
+void init_outfixes(const struct RoseEngine *t, u8 *state, u64a offset,
+                   u8 key) {
     /* The active leaf array has been init'ed by the scatter with outfix
      * bits set on */
+    u8 *aa = getActiveLeafArray(t, state);
 
     // Init the NFA state for each outfix.
     for (u32 qi = t->outfixBeginQueue; qi < t->outfixEndQueue; qi++) {
         const struct NfaInfo *info = getNfaInfoByQueue(t, qi);
         const struct NFA *nfa = getNfaByInfo(t, info);
-        nfaInitCompressedState(nfa, 0, state + info->stateOffset,
-                               0 /* assume NUL at start */);
+        if (!nfaInitCompressedState(nfa, offset, state + info->stateOffset,
+                                    key)) {
+            DEBUG_PRINTF("outfix %u dead at offset %llu\n", qi, offset);
+            mmbit_unset(aa, t->activeArrayCount, qi);
+        }
     }
 
     if (t->initMpvNfa != MO_INVALID_IDX) {
         const struct NfaInfo *info = getNfaInfoByQueue(t, t->initMpvNfa);
         const struct NFA *nfa = getNfaByInfo(t, info);
-        nfaInitCompressedState(nfa, 0, state + info->stateOffset,
-                               0 /* assume NUL at start */);
-        mmbit_set(getActiveLeafArray(t, state), t->activeArrayCount,
-                  t->initMpvNfa);
+        if (nfaInitCompressedState(nfa, offset, state + info->stateOffset,
+                                   key)) {
+            mmbit_set(aa, t->activeArrayCount, t->initMpvNfa);
+        }
     }
 }
 
@@ -111,10 +116,30 @@ void roseInitState(const struct RoseEngine *t, u8 *state) {
     }
 
     init_state(t, state);
-    init_outfixes(t, state);
+    init_outfixes(t, state, 0, 0 /* assume NUL at start */);
 
     // Clear the floating matcher state, if any.
     DEBUG_PRINTF("clearing %u bytes of floating matcher state\n",
                  t->floatingStreamState);
     memset(getFloatingMatcherState(t, state), 0, t->floatingStreamState);
 }
+
+void roseResetState(const struct RoseEngine *t, u8 *state, u64a offset,
+                    u8 key) {
+    assert(t);
+    assert(state);
+    assert(ISALIGNED_N(state, 8));
+
+    DEBUG_PRINTF("reset for Rose %p at offset %llu\n", t, offset);
+
+    init_rstate(t, state);
+
+    if (t->smatcherOffset) {
+        init_sidecar(t, state);
+    }
+
+    init_state(t, state);
+    init_outfixes(t, state, offset, key);
+
+    memset(getFloatingMatcherState(t, state), 0, t->floatingStreamState);
+}
@@ -26,11 +26,14 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "budget.h"
 #include "catchup.h"
 #include "counting_miracle.h"
 #include "infix.h"
 #include "match.h"
 #include "miracle.h"
+#include "profile.h"
+#include "rose_program.h"
 #include "rose_sidecar_runtime.h"
 #include "rose.h"
 #include "som/som_runtime.h"
@@ -342,20 +345,16 @@ hwlmcb_rv_t ensureMpvQueueFlushed(const struct RoseEngine *t,
 
 static rose_inline
 hwlmcb_rv_t roseHandleSuffixTrigger(const struct RoseEngine *t,
-                                    const struct RoseRole *tr, u64a som,
+                                    u32 qi, u32 top, u64a som,
                                     u64a end, struct RoseContext *tctxt,
                                     char in_anchored) {
     DEBUG_PRINTF("woot we have a mask/follower/suffix/... role\n");
 
-    assert(tr->suffixOffset);
-
-    const struct NFA *nfa
-        = (const struct NFA *)((const char *)t + tr->suffixOffset);
+    const struct NFA *nfa = getNfaByQueue(t, qi);
     u8 *aa = getActiveLeafArray(t, tctxt->state);
     struct hs_scratch *scratch = tctxtToScratch(tctxt);
     u32 aaCount = t->activeArrayCount;
     u32 qCount = t->queueCount;
-    u32 qi = nfa->queueIndex;
     struct mq *q = &scratch->queues[qi];
     const struct NfaInfo *info = getNfaInfoByQueue(t, qi);
 
@@ -391,7 +390,6 @@ hwlmcb_rv_t roseHandleSuffixTrigger(const struct RoseEngine *t,
         }
     }
 
-    u32 top = tr->suffixEvent;
     assert(top == MQE_TOP || (top >= MQE_TOP_FIRST && top < MQE_INVALID));
     pushQueueSom(q, top, loc, som);
 
@@ -466,14 +464,21 @@ hwlmcb_rv_t roseHandleMatch(const struct RoseEngine *t, u8 *state, ReportID id,
                             char in_anchored) {
     struct hs_scratch *scratch = tctxtToScratch(tctxt);
 
-    if (roseCatchUpTo(t, state, end, scratch, in_anchored)
-        == HWLM_TERMINATE_MATCHING) {
-        return HWLM_TERMINATE_MATCHING;
-    }
+    if (scratch->core_info.unordered) {
+        /* the engines behind us will report their earlier matches when they
+         * are next caught up; no need to interleave them with this one. */
+        DEBUG_PRINTF("firing unordered callback reportId=%u, end=%llu\n", id,
+                     end);
+    } else {
+        if (roseCatchUpTo(t, state, end, scratch, in_anchored)
+            == HWLM_TERMINATE_MATCHING) {
+            return HWLM_TERMINATE_MATCHING;
+        }
 
-    assert(end == tctxt->minMatchOffset);
-    DEBUG_PRINTF("firing callback reportId=%u, end=%llu\n", id, end);
-    updateLastMatchOffset(tctxt, end);
+        assert(end == tctxt->minMatchOffset);
+        DEBUG_PRINTF("firing callback reportId=%u, end=%llu\n", id, end);
+        updateLastMatchOffset(tctxt, end);
+    }
 
     int cb_rv = tctxt->cb(end, id, tctxt->userCtx);
     if (cb_rv == MO_HALT_MATCHING) {
@@ -772,13 +777,11 @@ found_miracle:
 }
 
 static rose_inline
-char roseTestLeftfix(const struct RoseEngine *t, const struct RoseRole *tr,
-                     u64a end, struct RoseContext *tctxt) {
+char roseTestLeftfix(const struct RoseEngine *t, u32 qi, u32 leftfixLag,
+                     ReportID leftfixReport, u64a end,
+                     struct RoseContext *tctxt) {
     struct hs_scratch *scratch = tctxtToScratch(tctxt);
     struct core_info *ci = &scratch->core_info;
-    assert(tr->flags & ROSE_ROLE_FLAG_ROSE);
-
-    u32 qi = tr->leftfixQueue;
 
     u32 ri = queueToLeftIndex(t, qi);
     const struct LeftNfaInfo *left = getLeftTable(t) + ri;
@@ -786,9 +789,9 @@ char roseTestLeftfix(const struct RoseEngine *t, const struct RoseRole *tr,
     DEBUG_PRINTF("testing %s %s %u/%u with lag %u (maxLag=%u)\n",
                  (left->transient ? "transient" : "active"),
                  (left->infix ? "infix" : "prefix"),
-                 ri, qi, tr->leftfixLag, left->maxLag);
+                 ri, qi, leftfixLag, left->maxLag);
 
-    assert(tr->leftfixLag <= left->maxLag);
+    assert(leftfixLag <= left->maxLag);
 
     struct mq *q = scratch->queues + qi;
     u32 qCount = t->queueCount;
@@ -799,7 +802,7 @@ char roseTestLeftfix(const struct RoseEngine *t, const struct RoseRole *tr,
         return 0;
     }
 
-    if (unlikely(end < tr->leftfixLag)) {
+    if (unlikely(end < leftfixLag)) {
         assert(0); /* lag is the literal length */
         return 0;
     }
@@ -839,9 +842,9 @@ char roseTestLeftfix(const struct RoseEngine *t, const struct RoseRole *tr,
         }
     }
 
-    s64a loc = (s64a)end - ci->buf_offset - tr->leftfixLag;
+    s64a loc = (s64a)end - ci->buf_offset - leftfixLag;
     assert(loc >= q_cur_loc(q));
-    assert(tr->leftfixReport != MO_INVALID_IDX);
+    assert(leftfixReport != MO_INVALID_IDX);
 
     if (left->transient) {
         s64a start_loc = loc - left->transient;
@@ -878,7 +881,7 @@ char roseTestLeftfix(const struct RoseEngine *t, const struct RoseRole *tr,
 
         pushQueueNoMerge(q, MQE_END, loc);
 
-        char rv = nfaQueueExecRose(q->nfa, q, tr->leftfixReport);
+        char rv = nfaQueueExecRose(q->nfa, q, leftfixReport);
         if (!rv) { /* nfa is dead */
             DEBUG_PRINTF("leftfix %u died while trying to catch up\n", ri);
             mmbit_unset(getActiveLeftArray(t, tctxt->state), arCount, ri);
@@ -892,76 +895,25 @@ char roseTestLeftfix(const struct RoseEngine *t, const struct RoseRole *tr,
         q->cur = q->end = 0;
         pushQueueAt(q, 0, MQE_START, loc);
 
-        DEBUG_PRINTF("checking for report %u\n", tr->leftfixReport);
+        DEBUG_PRINTF("checking for report %u\n", leftfixReport);
         DEBUG_PRINTF("leftfix done %hhd\n", (signed char)rv);
         return rv == MO_MATCHES_PENDING;
     } else {
-        DEBUG_PRINTF("checking for report %u\n", tr->leftfixReport);
-        char rv = nfaInAcceptState(q->nfa, tr->leftfixReport, q);
+        DEBUG_PRINTF("checking for report %u\n", leftfixReport);
+        char rv = nfaInAcceptState(q->nfa, leftfixReport, q);
         DEBUG_PRINTF("leftfix done %hhd\n", (signed char)rv);
         return rv;
     }
 }
 
 static rose_inline
-void roseSetRole(const struct RoseEngine *t, u8 *state,
-                 struct RoseContext *tctxt, const struct RoseRole *tr) {
-    DEBUG_PRINTF("set role %u on: idx=%u, depth=%u, groups=0x%016llx\n",
-                 (u32)(tr - getRoleTable(t)),
-                 tr->stateIndex, tr->depth, tr->groups);
-    void *role_state = getRoleState(state);
-
-    assert(tr < getRoleTable(t) + t->roleCount);
-
-    int leafNode = !!(tr->stateIndex == MMB_INVALID);
-
-    // If this role is a leaf node, it doesn't have a state index to switch
-    // on and it doesn't need any history stored or other work done. So we can
-    // bail.
-    /* may be a ghost role; still need to set groups */
-    if (leafNode) {
-        tctxt->groups |= tr->groups;
-        DEBUG_PRINTF("role %u is a leaf node, no work to do.\n",
-                (u32)(tr - getRoleTable(t)));
-        return;
-    }
-
-    // Switch this role on in the state bitvector, checking whether it was set
-    // already.
-    char alreadySet = mmbit_set(role_state, t->rolesWithStateCount,
-                                tr->stateIndex);
-
-    // Roles that we've already seen have had most of their bookkeeping done:
-    // all we need to do is update the offset table if this is an
-    // offset-tracking role.
-    if (alreadySet) {
-        DEBUG_PRINTF("role already set\n");
-        if (tr->sidecarEnableOffset) {
-            enable_sidecar(tctxt, tr);
-        }
-        return;
-    }
-
-    // If this role's depth is greater than the current depth, update it
-    update_depth(tctxt, tr);
-
-    // Switch on this role's groups
-    tctxt->groups |= tr->groups;
-
-    if (tr->sidecarEnableOffset) {
-        // We have to enable some sidecar literals
-        enable_sidecar(tctxt, tr);
-    }
-}
-
-static rose_inline
-void roseTriggerInfixes(const struct RoseEngine *t, const struct RoseRole *tr,
+void roseTriggerInfixes(const struct RoseEngine *t, u32 triggerOffset,
                         u64a start, u64a end, struct RoseContext *tctxt) {
     struct core_info *ci = &tctxtToScratch(tctxt)->core_info;
 
     DEBUG_PRINTF("infix time! @%llu\t(s%llu)\n", end, start);
 
-    assert(tr->infixTriggerOffset);
+    assert(triggerOffset);
 
     u32 qCount = t->queueCount;
     u32 arCount = t->activeLeftCount;
@@ -970,7 +922,7 @@ void roseTriggerInfixes(const struct RoseEngine *t, const struct RoseRole *tr,
     s64a loc = (s64a)end - ci->buf_offset;
 
     const struct RoseTrigger *curr_r = (const struct RoseTrigger *)
-        ((const char *)t + tr->infixTriggerOffset);
+        ((const char *)t + triggerOffset);
     assert(ISALIGNED_N(curr_r, alignof(struct RoseTrigger)));
     assert(curr_r->queue != MO_INVALID_IDX); /* shouldn't be here if no
                                               * triggers */
@@ -1055,10 +1007,11 @@ int reachHasBit(const u8 *reach, u8 c) {
  * are satisfied.
  */
 static rose_inline
-int roseCheckLookaround(const struct RoseEngine *t, const struct RoseRole *tr,
-                        u64a end, struct RoseContext *tctxt) {
-    assert(tr->lookaroundIndex != MO_INVALID_IDX);
-    assert(tr->lookaroundCount > 0);
+int roseCheckLookaround(const struct RoseEngine *t, u32 lookaroundIndex,
+                        u32 lookaroundCount, u64a end,
+                        struct RoseContext *tctxt) {
+    assert(lookaroundIndex != MO_INVALID_IDX);
+    assert(lookaroundCount > 0);
 
     const struct core_info *ci = &tctxtToScratch(tctxt)->core_info;
     DEBUG_PRINTF("end=%llu, buf_offset=%llu, buf_end=%llu\n", end,
@@ -1066,12 +1019,12 @@ int roseCheckLookaround(const struct RoseEngine *t, const struct RoseRole *tr,
 
     const u8 *base = (const u8 *)t;
     const s8 *look_base = (const s8 *)(base + t->lookaroundTableOffset);
-    const s8 *look = look_base + tr->lookaroundIndex;
-    const s8 *look_end = look + tr->lookaroundCount;
+    const s8 *look = look_base + lookaroundIndex;
+    const s8 *look_end = look + lookaroundCount;
     assert(look < look_end);
 
     const u8 *reach_base = base + t->lookaroundReachOffset;
-    const u8 *reach = reach_base + tr->lookaroundIndex * REACH_BITVECTOR_LEN;
+    const u8 *reach = reach_base + lookaroundIndex * REACH_BITVECTOR_LEN;
 
     // The following code assumes that the lookaround structures are ordered by
     // increasing offset.
@@ -1144,38 +1097,6 @@ int roseCheckLookaround(const struct RoseEngine *t, const struct RoseRole *tr,
     return 1;
 }
 
-static rose_inline
-int roseCheckRolePreconditions(const struct RoseEngine *t,
-                               const struct RoseRole *tr, u64a end,
-                               struct RoseContext *tctxt) {
-    // If this role can only match at end-of-block, then check that it's so.
-    if (tr->flags & ROSE_ROLE_FLAG_ONLY_AT_END) {
-        struct core_info *ci = &tctxtToScratch(tctxt)->core_info;
-        if (end != ci->buf_offset + ci->len) {
-            DEBUG_PRINTF("role %u should only match at end of data, skipping\n",
-                         (u32)(tr - getRoleTable(t)));
-            return 0;
-        }
-    }
-
-    if (tr->lookaroundIndex != MO_INVALID_IDX) {
-        if (!roseCheckLookaround(t, tr, end, tctxt)) {
-            DEBUG_PRINTF("failed lookaround check\n");
-            return 0;
-        }
-    }
-
-    assert(!tr->leftfixQueue || (tr->flags & ROSE_ROLE_FLAG_ROSE));
-    if (tr->flags & ROSE_ROLE_FLAG_ROSE) {
-        if (!roseTestLeftfix(t, tr, end, tctxt)) {
-            DEBUG_PRINTF("failed leftfix check\n");
-            return 0;
-        }
-    }
-
-    return 1;
-}
-
 static
 int roseNfaEarliestSom(u64a from_offset, UNUSED u64a offset, UNUSED ReportID id,
                        void *context) {
@@ -1185,20 +1106,18 @@ int roseNfaEarliestSom(u64a from_offset, UNUSED u64a offset, UNUSED ReportID id,
 }
 
 static rose_inline
-u64a roseGetHaigSom(const struct RoseEngine *t, const struct RoseRole *tr,
-                    UNUSED u64a end, struct RoseContext *tctxt) {
-    assert(tr->flags & ROSE_ROLE_FLAG_ROSE);
-
-    u32 qi = tr->leftfixQueue;
+u64a roseGetHaigSom(const struct RoseEngine *t, const u32 qi,
+                    UNUSED const u32 leftfixLag,
+                    struct RoseContext *tctxt) {
     u32 ri = queueToLeftIndex(t, qi);
 
     UNUSED const struct LeftNfaInfo *left = getLeftTable(t) + ri;
 
     DEBUG_PRINTF("testing %s prefix %u/%u with lag %u (maxLag=%u)\n",
                  left->transient ? "transient" : "active", ri, qi,
-                 tr->leftfixLag, left->maxLag);
+                 leftfixLag, left->maxLag);
 
-    assert(tr->leftfixLag <= left->maxLag);
+    assert(leftfixLag <= left->maxLag);
 
     struct mq *q = tctxtToScratch(tctxt)->queues + qi;
 
@@ -1217,100 +1136,254 @@ u64a roseGetHaigSom(const struct RoseEngine *t, const struct RoseRole *tr,
     return start;
 }
 
-static really_inline
-hwlmcb_rv_t roseHandleRoleEffects(const struct RoseEngine *t,
-                                  const struct RoseRole *tr, u64a end,
-                                  struct RoseContext *tctxt, char in_anchored,
-                                  int *work_done) {
-    u64a som = 0ULL;
-    if (tr->flags & ROSE_ROLE_FLAG_SOM_ADJUST) {
-        som = end - tr->somAdjust;
-        DEBUG_PRINTF("som requested som %llu = %llu - %u\n", som, end,
-                     tr->somAdjust);
-    } else if (tr->flags & ROSE_ROLE_FLAG_SOM_ROSEFIX) {
-        som = roseGetHaigSom(t, tr, end, tctxt);
-        DEBUG_PRINTF("som from rosefix %llu\n", som);
-    }
-
-    if (tr->infixTriggerOffset) {
-        roseTriggerInfixes(t, tr, som, end, tctxt);
-        tctxt->groups |= tr->groups; /* groups may have been cleared by infix
-                                      * going quiet before */
-    }
-
-    if (tr->suffixOffset) {
-        hwlmcb_rv_t rv = roseHandleSuffixTrigger(t, tr, som, end, tctxt,
-                                                 in_anchored);
-        if (rv != HWLM_CONTINUE_MATCHING) {
-            return rv;
-        }
+// Check that the predecessor bounds are satisfied for a root role with special
+// requirements (anchored, or unanchored but with preceding dots).
+static rose_inline
+char roseCheckRootBounds(u64a end, u32 min_bound, u32 max_bound) {
+    assert(max_bound <= ROSE_BOUND_INF);
+    assert(min_bound <= max_bound);
+
+    if (end < min_bound) {
+        return 0;
     }
+    return max_bound == ROSE_BOUND_INF || end <= max_bound;
+}
 
-    if (tr->reportId != MO_INVALID_IDX) {
-        hwlmcb_rv_t rv;
-        if (tr->flags & ROSE_ROLE_FLAG_REPORT_START) {
-            /* rose role knows its start offset */
-            assert(tr->flags & ROSE_ROLE_FLAG_SOM_ROSEFIX);
-            assert(!(tr->flags & ROSE_ROLE_FLAG_CHAIN_REPORT));
-            if (tr->flags & ROSE_ROLE_FLAG_SOM_REPORT) {
-                rv = roseHandleSomSom(t, tctxt->state, tr->reportId, som, end,
-                                      tctxt, in_anchored);
-            } else {
-                rv = roseHandleSomMatch(t, tctxt->state, tr->reportId, som, end,
-                                        tctxt, in_anchored);
-            }
-        } else {
-            if (tr->flags & ROSE_ROLE_FLAG_SOM_REPORT) {
-                /* do som management */
-                rv = roseHandleSom(t, tctxt->state, tr->reportId, end, tctxt,
-                                  in_anchored);
-            } else if (tr->flags & ROSE_ROLE_FLAG_CHAIN_REPORT) {
-                rv = roseCatchUpAndHandleChainMatch(t, tctxt->state,
-                                                    tr->reportId, end, tctxt,
-                                                    in_anchored);
-            } else {
-                rv = roseHandleMatch(t, tctxt->state, tr->reportId, end, tctxt,
-                                     in_anchored);
-            }
-        }
+static rose_inline
+void roseSetState(const struct RoseEngine *t, struct RoseContext *tctxt,
+                  const struct ROSE_STRUCT_SET_STATE *ri) {
+    DEBUG_PRINTF("set state idx=%u, depth=%u, groups=0x%016llx\n", ri->index,
+                 ri->depth, ri->groups);
+    assert(ri->role < t->roleCount);
+    const struct RoseRole *tr = getRoleTable(t) + ri->role;
 
-        if (rv != HWLM_CONTINUE_MATCHING) {
-            return HWLM_TERMINATE_MATCHING;
+    // Switch this role on in the state bitvector, checking whether it was set
+    // already.
+    char alreadySet = mmbit_set(getRoleState(tctxt->state),
+                                t->rolesWithStateCount, ri->index);
+
+    // Roles that we've already seen have had most of their bookkeeping done:
+    // all we need to do is update the offset table if this is an
+    // offset-tracking role.
+    if (alreadySet) {
+        DEBUG_PRINTF("role already set\n");
+        if (tr->sidecarEnableOffset) {
+            enable_sidecar(tctxt, tr);
         }
+        return;
     }
 
-    roseSetRole(t, tctxt->state, tctxt, tr);
+    // If this role's depth is greater than the current depth, update it
+    update_depth(tctxt, ri->depth);
 
-    *work_done = 1;
+    // Switch on this role's groups
+    tctxt->groups |= ri->groups;
 
-    return HWLM_CONTINUE_MATCHING;
+    if (tr->sidecarEnableOffset) {
+        // We have to enable some sidecar literals
+        enable_sidecar(tctxt, tr);
+    }
 }
 
-static really_inline
-hwlmcb_rv_t roseHandleRole(const struct RoseEngine *t,
-                           const struct RoseRole *tr, u64a end,
-                           struct RoseContext *tctxt, char in_anchored,
-                           int *work_done) {
-    DEBUG_PRINTF("hi role %zd (flags %08x)\n", tr - getRoleTable(t),
-                  tr->flags);
-    if (in_anchored && end > t->floatingMinLiteralMatchOffset) {
-        DEBUG_PRINTF("delay until playback, just do groups/depth now\n");
-        update_depth(tctxt, tr);
-        tctxt->groups |= tr->groups;
-        *work_done = 1;
-        return HWLM_CONTINUE_MATCHING;
-    }
+#define PROGRAM_CASE(name)                                                     \
+    case ROSE_INSTR_##name: {                                                  \
+        DEBUG_PRINTF("instruction: " #name " (%u)\n", ROSE_INSTR_##name);      \
+        const struct ROSE_STRUCT_##name *ri =                                  \
+            (const struct ROSE_STRUCT_##name *)pc;
 
-    if (!roseCheckRolePreconditions(t, tr, end, tctxt)) {
-        return HWLM_CONTINUE_MATCHING;
+#define PROGRAM_NEXT_INSTRUCTION                                               \
+    pc += ROUNDUP_N(sizeof(*ri), ROSE_INSTR_MIN_ALIGN);                        \
+    break;                                                                     \
     }
 
-    /* We now know the role has matched. We can now trigger things that need to
-     * be triggered and record things that need to be recorded.*/
+/**
+ * \brief Run the instruction program for a role that has been switched on by
+ * a literal match at \a end.
+ *
+ * Sets \a work_done if the role was handled (even if only its groups and depth
+ * were updated ahead of anchored playback), so that the caller knows to apply
+ * the literal's squash mask.
+ */
+static really_inline
+hwlmcb_rv_t roseRunRoleProgram(const struct RoseEngine *t, u32 programOffset,
+                               u64a end, struct RoseContext *tctxt,
+                               char in_anchored, int *work_done) {
+    DEBUG_PRINTF("program begins at offset %u\n", programOffset);
+
+    assert(programOffset);
+    assert(programOffset < t->size);
+
+    const char *pc = getByOffset(t, programOffset);
+
+    assert(*(const u8 *)pc != ROSE_INSTR_END);
+
+    /* som value for this role, set by the SOM_* instructions. */
+    u64a som = 0ULL;
+
+    for (;;) {
+        assert(ISALIGNED_N(pc, ROSE_INSTR_MIN_ALIGN));
+        u8 code = *(const u8 *)pc;
+        assert(code <= ROSE_INSTR_END);
+
+        switch ((enum RoseInstructionCode)code) {
+            PROGRAM_CASE(CHECK_ROOT_BOUNDS) {
+                /* root bounds are not checked from the anchored table */
+                if (!in_anchored &&
+                    !roseCheckRootBounds(end, ri->min_bound, ri->max_bound)) {
+                    DEBUG_PRINTF("failed root bounds check\n");
+                    assert(ri->fail_jump); // must progress
+                    pc += ri->fail_jump;
+                    continue;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(ANCHORED_DELAY) {
+                if (in_anchored && end > t->floatingMinLiteralMatchOffset) {
+                    DEBUG_PRINTF("delay until playback, just do groups/depth "
+                                 "now\n");
+                    update_depth(tctxt, ri->depth);
+                    tctxt->groups |= ri->groups;
+                    *work_done = 1;
+                    assert(ri->done_jump); // must progress
+                    pc += ri->done_jump;
+                    continue;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(CHECK_ONLY_EOD) {
+                struct core_info *ci = &tctxtToScratch(tctxt)->core_info;
+                if (end != ci->buf_offset + ci->len) {
+                    DEBUG_PRINTF("should only match at end of data\n");
+                    assert(ri->fail_jump); // must progress
+                    pc += ri->fail_jump;
+                    continue;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(CHECK_LOOKAROUND) {
+                if (!roseCheckLookaround(t, ri->index, ri->count, end,
+                                         tctxt)) {
+                    DEBUG_PRINTF("failed lookaround check\n");
+                    assert(ri->fail_jump); // must progress
+                    pc += ri->fail_jump;
+                    continue;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(CHECK_LEFTFIX) {
+                if (!roseTestLeftfix(t, ri->queue, ri->lag, ri->report, end,
+                                     tctxt)) {
+                    DEBUG_PRINTF("failed leftfix check\n");
+                    assert(ri->fail_jump); // must progress
+                    pc += ri->fail_jump;
+                    continue;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SOM_ADJUST) {
+                assert(ri->distance <= end);
+                som = end - ri->distance;
+                DEBUG_PRINTF("som is (end - %u) = %llu\n", ri->distance, som);
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SOM_LEFTFIX) {
+                som = roseGetHaigSom(t, ri->queue, ri->lag, tctxt);
+                DEBUG_PRINTF("som from leftfix is %llu\n", som);
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(TRIGGER_INFIX) {
+                roseTriggerInfixes(t, ri->offset, som, end, tctxt);
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(TRIGGER_SUFFIX) {
+                if (roseHandleSuffixTrigger(t, ri->queue, ri->event, som, end,
+                                            tctxt, in_anchored) ==
+                    HWLM_TERMINATE_MATCHING) {
+                    return HWLM_TERMINATE_MATCHING;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT) {
+                if (roseHandleMatch(t, tctxt->state, ri->report, end, tctxt,
+                                    in_anchored) == HWLM_TERMINATE_MATCHING) {
+                    return HWLM_TERMINATE_MATCHING;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT_CHAIN) {
+                if (roseCatchUpAndHandleChainMatch(t, tctxt->state, ri->report,
+                                                   end, tctxt, in_anchored) ==
+                    HWLM_TERMINATE_MATCHING) {
+                    return HWLM_TERMINATE_MATCHING;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT_SOM_INT) {
+                if (roseHandleSom(t, tctxt->state, ri->report, end, tctxt,
+                                  in_anchored) == HWLM_TERMINATE_MATCHING) {
+                    return HWLM_TERMINATE_MATCHING;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT_SOM) {
+                if (roseHandleSomSom(t, tctxt->state, ri->report, som, end,
+                                     tctxt, in_anchored) ==
+                    HWLM_TERMINATE_MATCHING) {
+                    return HWLM_TERMINATE_MATCHING;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT_SOM_KNOWN) {
+                if (roseHandleSomMatch(t, tctxt->state, ri->report, som, end,
+                                       tctxt, in_anchored) ==
+                    HWLM_TERMINATE_MATCHING) {
+                    return HWLM_TERMINATE_MATCHING;
+                }
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SET_STATE) {
+                roseSetState(t, tctxt, ri);
+                *work_done = 1;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SET_GROUPS) {
+                tctxt->groups |= ri->groups;
+                DEBUG_PRINTF("set groups 0x%llx -> 0x%llx\n", ri->groups,
+                             tctxt->groups);
+                *work_done = 1;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(END) {
+                DEBUG_PRINTF("finished\n");
+                return HWLM_CONTINUE_MATCHING;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+        }
+    }
 
-    return roseHandleRoleEffects(t, tr, end, tctxt, in_anchored, work_done);
+    assert(0); // unreachable
+    return HWLM_CONTINUE_MATCHING;
 }
 
+#undef PROGRAM_CASE
+#undef PROGRAM_NEXT_INSTRUCTION
+
 static really_inline
 void roseSquashGroup(struct RoseContext *tctxt, const struct RoseLiteral *tl) {
     assert(tl->squashesGroup);
@@ -1395,8 +1468,9 @@ hwlmcb_rv_t roseWalkSparseIterator(const struct RoseEngine *t,
             /* mark role as handled so we don't touch it again in this walk */
             fatbit_set(handled_roles, t->roleCount, role);
 
-            hwlmcb_rv_t rv = roseHandleRole(t, tr, end, tctxt,
-                                            0 /* in_anchored */, &work_done);
+            hwlmcb_rv_t rv = roseRunRoleProgram(t, tr->programOffset, end,
+                                                tctxt, 0 /* in_anchored */,
+                                                &work_done);
             if (rv == HWLM_TERMINATE_MATCHING) {
                 return HWLM_TERMINATE_MATCHING;
             }
@@ -1412,23 +1486,6 @@ hwlmcb_rv_t roseWalkSparseIterator(const struct RoseEngine *t,
     return HWLM_CONTINUE_MATCHING;
 }
 
-// Check that the predecessor bounds are satisfied for a root role with special
-// requirements (anchored, or unanchored but with preceding dots).
-static rose_inline
-char roseCheckRootBounds(const struct RoseEngine *t, const struct RoseRole *tr,
-                         u64a end) {
-    assert(tr->predOffset != ROSE_OFFSET_INVALID);
-    const struct RosePred *tp = getPredTable(t) + tr->predOffset;
-    assert(tp->role == MO_INVALID_IDX);
-
-    // Check history. We only use a subset of our history types for root or
-    // anchored root roles.
-    assert(tp->historyCheck == ROSE_ROLE_HISTORY_NONE ||
-           tp->historyCheck == ROSE_ROLE_HISTORY_ANCH);
-
-    return roseCheckPredHistory(tp, end);
-}
-
 // Walk the set of root roles (roles with depth 1) associated with this literal
 // and set them on.
 static really_inline
@@ -1447,13 +1504,8 @@ char roseWalkRootRoles_i(const struct RoseEngine *t,
         u32 role_offset = *rootRole;
         const struct RoseRole *tr = getRoleByOffset(t, role_offset);
 
-        if (!in_anchored && (tr->flags & ROSE_ROLE_PRED_ROOT)
-            && !roseCheckRootBounds(t, tr, end)) {
-            continue;
-        }
-
-        if (roseHandleRole(t, tr, end, tctxt, in_anchored, &work_done)
-            == HWLM_TERMINATE_MATCHING) {
+        if (roseRunRoleProgram(t, tr->programOffset, end, tctxt, in_anchored,
+                               &work_done) == HWLM_TERMINATE_MATCHING) {
             return 0;
         }
     };
@@ -1490,12 +1542,8 @@ char roseWalkRootRoles_i1(const struct RoseEngine *t,
     u32 role_offset = tl->rootRoleOffset;
     const struct RoseRole *tr = getRoleByOffset(t, role_offset);
 
-    if (!in_anchored && (tr->flags & ROSE_ROLE_PRED_ROOT)
-        && !roseCheckRootBounds(t, tr, end)) {
-        return 1;
-    }
-
-    hwlmcb_rv_t rv = roseHandleRole(t, tr, end, tctxt, in_anchored, &work_done);
+    hwlmcb_rv_t rv = roseRunRoleProgram(t, tr->programOffset, end, tctxt,
+                                        in_anchored, &work_done);
     if (rv == HWLM_TERMINATE_MATCHING) {
         return 0;
     }
@@ -1741,6 +1789,7 @@ hwlmcb_rv_t roseProcessMatch_i(const struct RoseEngine *t, u64a end, u32 id,
     }
 
     assert(id < t->literalCount);
+    profileLiteral(tctxtToScratch(tctxt), id);
     const struct RoseLiteral *tl = &getLiteralTable(t)[id];
     DEBUG_PRINTF("lit id=%u, minDepth=%u, groups=0x%016llx, rootRoleCount=%u\n",
                  id, tl->minDepth, tl->groups, tl->rootRoleCount);
@@ -2067,6 +2116,10 @@ hwlmcb_rv_t roseCallback(size_t start, size_t end, u32 id, void *ctxt) {
         return HWLM_TERMINATE_MATCHING;
     }
 
+    if (budgetLiteral(tctxtToScratch(tctx), real_end)) {
+        return HWLM_TERMINATE_MATCHING;
+    }
+
     if (id < tctx->t->nonbenefits_base_id
         && !roseCheckLiteralBenefits(real_end, end - start + 1, id, tctx)) {
         return tctx->groups;
@@ -2084,7 +2137,9 @@ hwlmcb_rv_t roseCallback(size_t start, size_t end, u32 id, void *ctxt) {
         return HWLM_TERMINATE_MATCHING;
     }
 
+    u64a prof_start = profileStart();
     rv = roseProcessMainMatch(tctx->t, real_end, id, tctx);
+    profileStage(tctxtToScratch(tctx), HS_PROFILE_ROLES, prof_start);
 
     DEBUG_PRINTF("DONE depth=%hhu, groups=0x%016llx\n", tctx->depth,
                  tctx->groups);
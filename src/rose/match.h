@@ -262,8 +262,8 @@ hwlmcb_rv_t cleanUpDelayed(size_t length, u64a offset, struct RoseContext *tctxt
 }
 
 static really_inline
-void update_depth(struct RoseContext *tctxt, const struct RoseRole *tr) {
-    u8 d = MAX(tctxt->depth, tr->depth + 1);
+void update_depth(struct RoseContext *tctxt, u8 depth) {
+    u8 d = MAX(tctxt->depth, depth + 1);
     assert(d >= tctxt->depth);
     DEBUG_PRINTF("depth now %hhu was %hhu\n", d, tctxt->depth);
     tctxt->depth = d;
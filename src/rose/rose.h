@@ -39,35 +39,30 @@
 // Initialise state space for engine use.
 void roseInitState(const struct RoseEngine *t, u8 *state);
 
+// Reinitialise state space as though the stream started afresh at offset,
+// where key is the byte before that offset.
+void roseResetState(const struct RoseEngine *t, u8 *state, u64a offset,
+                    u8 key);
+
 void roseBlockEodExec(const struct RoseEngine *t, u64a offset,
                       struct hs_scratch *scratch);
 void roseBlockExec_i(const struct RoseEngine *t, struct hs_scratch *scratch,
                      RoseCallback callback, RoseCallbackSom som_callback,
                      void *context);
 
-/* assumes core_info in scratch has been init to point to data */
+// Resumable block scan: roseBlockExecBegin, then roseBlockExecRange over
+// consecutive ranges covering the block, then roseBlockExecEnd. Small block
+// scans are not supported.
+void roseBlockExecBegin(const struct RoseEngine *t, struct hs_scratch *scratch,
+                        RoseCallback callback, RoseCallbackSom som_callback,
+                        void *context);
+void roseBlockExecRange(const struct RoseEngine *t, struct hs_scratch *scratch,
+                        size_t from, size_t to);
+void roseBlockExecEnd(const struct RoseEngine *t, struct hs_scratch *scratch);
+
+/* runs the end of block checks once the whole block has been scanned */
 static really_inline
-void roseBlockExec(const struct RoseEngine *t, struct hs_scratch *scratch,
-                   RoseCallback callback, RoseCallbackSom som_callback,
-                   void *context) {
-    assert(t);
-    assert(scratch);
-    assert(scratch->core_info.buf);
-
-    // If this block is shorter than our minimum width, then no pattern in this
-    // RoseEngine could match.
-    /* minWidth checks should have already been performed by the caller */
-    const size_t length = scratch->core_info.len;
-    assert(length >= t->minWidth);
-
-    // Similarly, we may have a maximum width (for engines constructed entirely
-    // of bi-anchored patterns).
-    /* This check is now handled by the interpreter */
-    assert(t->maxBiAnchoredWidth == ROSE_BOUND_INF
-           || length <= t->maxBiAnchoredWidth);
-
-    roseBlockExec_i(t, scratch, callback, som_callback, context);
-
+void roseBlockEod(const struct RoseEngine *t, struct hs_scratch *scratch) {
     if (!t->requiresEodCheck) {
         return;
     }
@@ -93,7 +88,32 @@ void roseBlockExec(const struct RoseEngine *t, struct hs_scratch *scratch,
         return;
     }
 
-    roseBlockEodExec(t, length, scratch);
+    roseBlockEodExec(t, scratch->core_info.len, scratch);
+}
+
+/* assumes core_info in scratch has been init to point to data */
+static really_inline
+void roseBlockExec(const struct RoseEngine *t, struct hs_scratch *scratch,
+                   RoseCallback callback, RoseCallbackSom som_callback,
+                   void *context) {
+    assert(t);
+    assert(scratch);
+    assert(scratch->core_info.buf);
+
+    // If this block is shorter than our minimum width, then no pattern in this
+    // RoseEngine could match.
+    /* minWidth checks should have already been performed by the caller */
+    UNUSED const size_t length = scratch->core_info.len;
+    assert(length >= t->minWidth);
+
+    // Similarly, we may have a maximum width (for engines constructed entirely
+    // of bi-anchored patterns).
+    /* This check is now handled by the interpreter */
+    assert(t->maxBiAnchoredWidth == ROSE_BOUND_INF
+           || length <= t->maxBiAnchoredWidth);
+
+    roseBlockExec_i(t, scratch, callback, som_callback, context);
+    roseBlockEod(t, scratch);
 }
 
 /* assumes core_info in scratch has been init to point to data */
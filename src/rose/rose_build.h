@@ -123,6 +123,9 @@ public:
 
     /** Note that we have seen a SOM pattern. */
     virtual void setSom() = 0;
+
+    /** Note that only the first match is required (\ref HS_MODE_ANYMATCH). */
+    virtual void setAnyMatch() = 0;
 };
 
 // Construct a usable Rose builder.
@@ -1081,7 +1081,7 @@ bool canImplementGraph(RoseBuildImpl *tbi, const RoseInGraph &in, NGHolder &h,
         bool single_trigger = min_offset == max_offset;
 
         DEBUG_PRINTF("trying for mcclellan (%u, %u)\n", min_offset, max_offset);
-        *as_dfa = buildMcClellan(h, &rm, single_trigger, triggers, cc.grey,
+        *as_dfa = buildMcClellan(h, &rm, single_trigger, triggers, cc,
                                  finalChance);
 
         if (*as_dfa) {
@@ -1763,7 +1763,7 @@ bool RoseBuildImpl::addOutfix(const NGHolder &h) {
 
     if (!nfa_states || cc.grey.roseMcClellanOutfix == 2 ||
         (cc.grey.roseMcClellanOutfix == 1 && dfa_cand)) {
-        rdfa = buildMcClellan(h, &rm, cc.grey);
+        rdfa = buildMcClellan(h, &rm, cc);
     }
 
     if (!nfa_states && !rdfa) {
@@ -33,11 +33,13 @@
 #include "hs_compile.h" // for HS_MODE_*
 #include "rose_build_add_internal.h"
 #include "rose_build_anchored.h"
+#include "rose_build_exclusive.h"
 #include "rose_build_infix.h"
 #include "rose_build_lookaround.h"
 #include "rose_build_scatter.h"
 #include "rose_build_util.h"
 #include "rose_build_width.h"
+#include "rose_program.h"
 #include "hwlm/hwlm.h" /* engine types */
 #include "hwlm/hwlm_build.h"
 #include "nfa/castlecompile.h"
@@ -46,7 +48,9 @@
 #include "nfa/nfa_api_queue.h"
 #include "nfa/nfa_build_util.h"
 #include "nfa/nfa_internal.h"
+#include "nfa/shengcompile.h"
 #include "nfa/shufticompile.h"
+#include "nfa/tamaramacompile.h"
 #include "nfagraph/ng_holder.h"
 #include "nfagraph/ng_lbr.h"
 #include "nfagraph/ng_limex.h"
@@ -73,6 +77,7 @@
 #include "util/internal_report.h"
 #include "util/multibit_build.h"
 #include "util/order_check.h"
+#include "util/parallel.h"
 #include "util/queue_index_factory.h"
 #include "util/report_manager.h"
 #include "util/ue2string.h"
@@ -198,6 +203,10 @@ struct build_context : boost::noncopyable {
     /** \brief information about engines to the left of a vertex */
     map<RoseVertex, left_build_info> leftfix_info;
 
+    /** \brief Base of the container top range for each suffix that shares a
+     * Tamarama queue with other exclusive suffixes. */
+    map<suffix_id, u32> suffixTopBase;
+
     /** \brief Number of roles with a state bit.
      * This set by buildInitialRoleTable() and should be constant throughout
      * the rest of the compile.
@@ -401,6 +410,7 @@ void fillStateOffsets(const RoseBuildImpl &tbi, const sidecar *side,
     }
 
     // note: state space for mask nfas is allocated later
+    so->nfaStateBegin = curr_offset;
     so->end = curr_offset;
 }
 
@@ -485,6 +495,42 @@ void findFixedDepthTops(const RoseGraph &g, const set<PredTopPair> &triggers,
     }
 }
 
+/**
+ * \brief Builds the DFA implementation of an engine.
+ *
+ * A Sheng engine is used in place of McClellan when the DFA is small enough
+ * to fit in one shuffle mask per character and McClellan has no acceleration
+ * to offer: Sheng's transition is a single PSHUFB with no table lookups, so
+ * it wins whenever the DFA cannot skip ahead. Larger DFAs that need McClellan
+ * 16 get a McSheng engine instead, which runs the states nearest the start
+ * the same way.
+ */
+static
+aligned_unique_ptr<NFA> buildDfaImpl(raw_dfa &rdfa, const CompileContext &cc) {
+    auto d = mcclellanCompile(rdfa, cc);
+    if (!d) {
+        return d;
+    }
+
+    if (!has_accel(*d)) {
+        auto s = shengCompile(rdfa, cc);
+        if (s) {
+            DEBUG_PRINTF("using sheng in place of mcclellan\n");
+            return s;
+        }
+    }
+
+    if (d->type == MCCLELLAN_NFA_16) {
+        auto ms = mcshengCompile(rdfa, cc);
+        if (ms) {
+            DEBUG_PRINTF("using mcsheng in place of mcclellan 16\n");
+            return ms;
+        }
+    }
+
+    return d;
+}
+
 /**
  * \brief Heuristic for picking between a DFA or NFA implementation of an
  * engine.
@@ -494,7 +540,8 @@ aligned_unique_ptr<NFA> pickImpl(aligned_unique_ptr<NFA> dfa_impl,
                                  aligned_unique_ptr<NFA> nfa_impl) {
     assert(nfa_impl);
     assert(dfa_impl);
-    assert(isMcClellanType(dfa_impl->type));
+    assert(isMcClellanType(dfa_impl->type) || isShengType(dfa_impl->type)
+           || isMcShengType(dfa_impl->type));
 
     // If our NFA is an LBR, it always wins.
     if (isLbrType(nfa_impl->type)) {
@@ -503,7 +550,8 @@ aligned_unique_ptr<NFA> pickImpl(aligned_unique_ptr<NFA> dfa_impl,
 
     bool d_accel = has_accel(*dfa_impl);
     bool n_accel = has_accel(*nfa_impl);
-    bool d_big = dfa_impl->type == MCCLELLAN_NFA_16;
+    bool d_big = dfa_impl->type == MCCLELLAN_NFA_16
+              || dfa_impl->type == MCSHENG_NFA_16;
     bool n_vsmall = nfa_impl->nPositions <= 32;
     bool n_br = has_bounded_repeats(*nfa_impl);
     DEBUG_PRINTF("da %d na %d db %d nvs %d nbr %d\n", (int)d_accel,
@@ -523,8 +571,8 @@ aligned_unique_ptr<NFA> pickImpl(aligned_unique_ptr<NFA> dfa_impl,
             }
         }
     } else {
-        /* favour a McClellan 8, unless the nfa looks really good and the dfa
-         * looks like trouble */
+        /* favour a McClellan 8 or Sheng, unless the nfa looks really good and
+         * the dfa looks like trouble */
         if (!d_accel && n_vsmall && n_accel && !n_br) {
             return nfa_impl;
         } else {
@@ -573,7 +621,7 @@ buildSuffix(const ReportManager &rm, const SomSlotManager &ssm,
     }
 
     if (suff.dfa()) {
-        auto d = mcclellanCompile(*suff.dfa(), cc);
+        auto d = buildDfaImpl(*suff.dfa(), cc);
         assert(d);
         return d;
     }
@@ -600,9 +648,9 @@ buildSuffix(const ReportManager &rm, const SomSlotManager &ssm,
         if (cc.grey.roseMcClellanSuffix == 2 || n->nPositions > 128 ||
             !has_bounded_repeats_other_than_firsts(*n)) {
             auto rdfa = buildMcClellan(holder, &rm, false, triggers.at(0),
-                                       cc.grey);
+                                       cc);
             if (rdfa) {
-                auto d = mcclellanCompile(*rdfa, cc);
+                auto d = buildDfaImpl(*rdfa, cc);
                 assert(d);
                 if (cc.grey.roseMcClellanSuffix != 2) {
                     n = pickImpl(move(d), move(n));
@@ -611,7 +659,7 @@ buildSuffix(const ReportManager &rm, const SomSlotManager &ssm,
                 }
 
                 assert(n);
-                if (isMcClellanType(n->type)) {
+                if (isDfaType(n->type)) {
                     // DFA chosen. We may be able to set some more properties
                     // in the NFA structure here.
                     u64a maxOffset = findMaxOffset(holder, rm);
@@ -719,12 +767,12 @@ makeLeftNfa(const RoseBuildImpl &tbi, left_id &left,
     }
 
     if (left.dfa()) {
-        n = mcclellanCompile(*left.dfa(), cc);
+        n = buildDfaImpl(*left.dfa(), cc);
     } else if (left.graph() && cc.grey.roseMcClellanPrefix == 2 && is_prefix &&
                !is_transient) {
-        auto rdfa = buildMcClellan(*left.graph(), nullptr, cc.grey);
+        auto rdfa = buildMcClellan(*left.graph(), nullptr, cc);
         if (rdfa) {
-            n = mcclellanCompile(*rdfa, cc);
+            n = buildDfaImpl(*rdfa, cc);
         }
     }
 
@@ -746,9 +794,9 @@ makeLeftNfa(const RoseBuildImpl &tbi, left_id &left,
     if (cc.grey.roseMcClellanPrefix == 1 && is_prefix && !left.dfa()
         && left.graph()
         && (!n || !has_bounded_repeats_other_than_firsts(*n) || !is_fast(*n))) {
-        auto rdfa = buildMcClellan(*left.graph(), nullptr, cc.grey);
+        auto rdfa = buildMcClellan(*left.graph(), nullptr, cc);
         if (rdfa) {
-            auto d = mcclellanCompile(*rdfa, cc);
+            auto d = buildDfaImpl(*rdfa, cc);
             assert(d);
             n = pickImpl(move(d), move(n));
         }
@@ -788,6 +836,12 @@ bool buildLeftfixes(const RoseBuildImpl &tbi, QueueIndexFactory &qif,
     map<left_id, set<PredTopPair> > infixTriggers;
     findInfixTriggers(tbi, &infixTriggers);
 
+    /* First, find the vertices that need leftfix engines and the distinct
+     * engines to build, in the order in which they will be assigned queues. */
+    vector<RoseVertex> verts;
+    vector<left_id> to_build;
+    ue2::unordered_set<left_id> to_build_set;
+
     for (auto v : vertices_range(g)) {
         if (!g[v].left) {
             continue;
@@ -806,9 +860,6 @@ bool buildLeftfixes(const RoseBuildImpl &tbi, QueueIndexFactory &qif,
         // our in-edges.
         assert(roseHasTops(g, v));
 
-        NFA *n;
-        u32 qi; // queue index, set below.
-        u32 lag = g[v].left.lag;
         bool is_transient = contains(tbi.transient, leftfix);
 
         if (is_transient && tbi.cc.grey.roseLookaroundMasks) {
@@ -820,6 +871,42 @@ bool buildLeftfixes(const RoseBuildImpl &tbi, QueueIndexFactory &qif,
             }
         }
 
+        verts.push_back(v);
+        if (to_build_set.insert(leftfix).second) {
+            assert(leftfix.haig()
+                   || tbi.isNonRootSuccessor(v) != tbi.isRootSuccessor(v));
+            to_build.push_back(leftfix);
+        }
+    }
+
+    /* Each engine is built independently, so construction may be spread
+     * across threads. */
+    vector<aligned_unique_ptr<NFA>> built(to_build.size());
+    parallel_for(to_build.size(), cc.numThreads, [&](size_t i) {
+        left_id &leftfix = to_build[i];
+        bool is_transient = contains(tbi.transient, leftfix);
+
+        // Need to build NFA, which is either predestined to be a Haig (in
+        // SOM mode) or could be all manner of things.
+        if (leftfix.haig()) {
+            built[i] = goughCompile(*leftfix.haig(), tbi.ssm.somPrecision(),
+                                    cc);
+        } else {
+            built[i] = makeLeftNfa(tbi, leftfix, do_prefix, is_transient,
+                                   infixTriggers, cc);
+        }
+    });
+
+    size_t next_built = 0;
+    for (auto v : verts) {
+        bool is_prefix = tbi.isRootSuccessor(v);
+        left_id leftfix(g[v].left);
+
+        NFA *n;
+        u32 qi; // queue index, set below.
+        u32 lag = g[v].left.lag;
+        bool is_transient = contains(tbi.transient, leftfix);
+
         if (contains(seen, leftfix)) {
             // NFA already built.
             n = seen[leftfix];
@@ -829,17 +916,9 @@ bool buildLeftfixes(const RoseBuildImpl &tbi, QueueIndexFactory &qif,
         } else {
             DEBUG_PRINTF("making %sleftfix\n", is_transient ? "transient " : "");
 
-            aligned_unique_ptr<NFA> nfa;
-
-            // Need to build NFA, which is either predestined to be a Haig (in
-            // SOM mode) or could be all manner of things.
-            if (leftfix.haig()) {
-                nfa = goughCompile(*leftfix.haig(), tbi.ssm.somPrecision(), cc);
-            }  else {
-                assert(tbi.isNonRootSuccessor(v) != tbi.isRootSuccessor(v));
-                nfa = makeLeftNfa(tbi, leftfix, is_prefix, is_transient,
-                                  infixTriggers, cc);
-            }
+            assert(next_built < to_build.size());
+            assert(to_build[next_built] == leftfix);
+            aligned_unique_ptr<NFA> nfa = move(built[next_built++]);
 
             if (!nfa) {
                 assert(!"failed to build leftfix");
@@ -950,7 +1029,7 @@ aligned_unique_ptr<NFA> buildOutfix(RoseBuildImpl &tbi, OutfixInfo &outfix) {
     aligned_unique_ptr<NFA> n;
     if (outfix.rdfa) {
         // Unleash the McClellan!
-        n = mcclellanCompile(*outfix.rdfa, cc);
+        n = buildDfaImpl(*outfix.rdfa, cc);
     } else if (outfix.haig) {
         // Unleash the Goughfish!
         n = goughCompile(*outfix.haig, tbi.ssm.somPrecision(), cc);
@@ -970,9 +1049,9 @@ aligned_unique_ptr<NFA> buildOutfix(RoseBuildImpl &tbi, OutfixInfo &outfix) {
         // Try for a DFA upgrade.
         if (n && cc.grey.roseMcClellanOutfix
             && !has_bounded_repeats_other_than_firsts(*n)) {
-            auto rdfa = buildMcClellan(h, &rm, cc.grey);
+            auto rdfa = buildMcClellan(h, &rm, cc);
             if (rdfa) {
-                auto d = mcclellanCompile(*rdfa, cc);
+                auto d = buildDfaImpl(*rdfa, cc);
                 if (d) {
                     n = pickImpl(move(d), move(n));
                 }
@@ -1074,13 +1153,27 @@ bool prepOutfixes(RoseBuildImpl &tbi,
     /* assume outfixes are just above chain tails in queue indices */
     built_nfas->reserve(tbi.outfixes.size());
 
+    vector<OutfixInfo *> to_build;
     for (auto &out : tbi.outfixes) {
         if (out.chained) {
             continue; /* already done */
         }
+        to_build.push_back(&out);
+    }
+
+    /* Each outfix engine is built independently, so construction may be
+     * spread across threads. */
+    vector<aligned_unique_ptr<NFA>> built(to_build.size());
+    parallel_for(to_build.size(), tbi.cc.numThreads, [&](size_t i) {
+        OutfixInfo &out = *to_build[i];
         DEBUG_PRINTF("building outfix %zd (holder %p rdfa %p)\n",
                      &out - &tbi.outfixes[0], out.holder.get(), out.rdfa.get());
-        auto n = buildOutfix(tbi, out);
+        built[i] = buildOutfix(tbi, out);
+    });
+
+    for (size_t i = 0; i < to_build.size(); i++) {
+        OutfixInfo &out = *to_build[i];
+        auto n = move(built[i]);
         if (!n) {
             assert(0);
             return false;
@@ -1102,11 +1195,63 @@ bool prepOutfixes(RoseBuildImpl &tbi,
     return true;
 }
 
+/**
+ * \brief Finds groups of suffixes that are never alive at the same time, each
+ * of which can be run from a single queue by a Tamarama container.
+ */
+static
+vector<vector<suffix_id>>
+findExclusiveSuffixes(const RoseBuildImpl &tbi,
+                      const map<suffix_id, set<PredTopPair>> &suffixTriggers) {
+    const RoseGraph &g = tbi.g;
+    map<suffix_id, vector<vector<CharReach>>> candidates;
+
+    for (const auto &m : suffixTriggers) {
+        const suffix_id &s = m.first;
+        if (s.haig()) {
+            continue;
+        }
+        if (s.graph() && nfaStuckOn(*s.graph())) {
+            continue;
+        }
+
+        // Exclusion is reasoned about from the literals that trigger the
+        // suffix, so every trigger must come from a literal match.
+        bool ok = true;
+        for (const PredTopPair &t : m.second) {
+            if (tbi.isVirtualVertex(t.pred) || g[t.pred].literals.empty()) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) {
+            continue;
+        }
+
+        map<u32, vector<vector<CharReach>>> triggers;
+        findTriggerSequences(tbi, m.second, &triggers);
+        auto &lits = candidates[s];
+        for (const auto &e : triggers) {
+            insert(&lits, lits.end(), e.second);
+        }
+    }
+
+    return findExclusiveSuffixGroups(candidates, tbi.cc);
+}
+
 static
 void findSuffixes(const RoseBuildImpl &tbi, QueueIndexFactory &qif,
+                  const vector<vector<suffix_id>> &exclusive_groups,
                   map<suffix_id, u32> *suffixes) {
     const RoseGraph &g = tbi.g;
 
+    map<suffix_id, const vector<suffix_id> *> group_of;
+    for (const auto &group : exclusive_groups) {
+        for (const auto &s : group) {
+            group_of[s] = &group;
+        }
+    }
+
     for (auto v : vertices_range(g)) {
         if (!g[v].suffix) {
             continue;
@@ -1124,6 +1269,14 @@ void findSuffixes(const RoseBuildImpl &tbi, QueueIndexFactory &qif,
         u32 queue = qif.get_queue();
         DEBUG_PRINTF("assigning %p to queue %u\n", s.graph(), queue);
         suffixes->insert(make_pair(s, queue));
+
+        // Exclusive suffixes all share one queue.
+        if (contains(group_of, s)) {
+            for (const auto &s2 : *group_of.at(s)) {
+                DEBUG_PRINTF("assigning %p to queue %u\n", s2.graph(), queue);
+                suffixes->insert(make_pair(s2, queue));
+            }
+        }
     }
 }
 
@@ -1146,17 +1299,49 @@ void setSuffixProperties(NFA &n, const suffix_id &suff,
     n.maxOffset = max_offset_value;
 }
 
+/**
+ * \brief Wraps the engines for a group of exclusive suffixes sharing a queue
+ * into a Tamarama container. Each suffix is given its own range of the
+ * container's tops, whose base is recorded in \a suffixTopBase.
+ */
+static
+aligned_unique_ptr<NFA>
+buildExclusiveSuffixes(const vector<pair<suffix_id, const NFA *>> &subs,
+                       const map<suffix_id, set<PredTopPair>> &suffixTriggers,
+                       map<suffix_id, u32> *suffixTopBase) {
+    vector<const NFA *> engines;
+    vector<u32> baseTop;
+    u32 nextTop = 0;
+    for (const auto &sub : subs) {
+        const suffix_id &s = sub.first;
+        u32 maxTop = 0;
+        for (const PredTopPair &t : suffixTriggers.at(s)) {
+            maxTop = max(maxTop, t.top);
+        }
+
+        engines.push_back(sub.second);
+        baseTop.push_back(nextTop);
+        (*suffixTopBase)[s] = nextTop;
+        nextTop += maxTop + 1;
+    }
+
+    return buildTamarama(engines, baseTop);
+}
+
 static
 bool buildSuffixes(const RoseBuildImpl &tbi,
+                   const map<suffix_id, set<PredTopPair>> &suffixTriggers,
                    vector<aligned_unique_ptr<NFA>> *built_nfas,
                    map<suffix_id, u32> *suffixes,
+                   map<suffix_id, u32> *suffixTopBase,
                    set<u32> *no_retrigger_queues) {
-    map<suffix_id, set<PredTopPair> > suffixTriggers;
-    findSuffixTriggers(tbi, &suffixTriggers);
-
-    for (const auto &e : *suffixes) {
-        const suffix_id &s = e.first;
-        const u32 queue = e.second;
+    // Each suffix engine is built independently, so construction may be
+    // spread across threads; the results are then processed in order.
+    const vector<pair<suffix_id, u32>> work(suffixes->begin(),
+                                            suffixes->end());
+    vector<aligned_unique_ptr<NFA>> built(work.size());
+    parallel_for(work.size(), tbi.cc.numThreads, [&](size_t i) {
+        const suffix_id &s = work[i].first;
         const set<PredTopPair> &s_triggers = suffixTriggers.at(s);
 
         map<u32, u32> fixed_depth_tops;
@@ -1165,13 +1350,38 @@ bool buildSuffixes(const RoseBuildImpl &tbi,
         map<u32, vector<vector<CharReach>>> triggers;
         findTriggerSequences(tbi, s_triggers, &triggers);
 
-        auto n = buildSuffix(tbi.rm, tbi.ssm, fixed_depth_tops, triggers,
-                             s, tbi.cc);
-        if (!n) {
+        built[i] = buildSuffix(tbi.rm, tbi.ssm, fixed_depth_tops, triggers, s,
+                               tbi.cc);
+    });
+
+    map<u32, vector<pair<suffix_id, const NFA *>>> by_queue;
+    for (size_t i = 0; i < work.size(); i++) {
+        const suffix_id &s = work[i].first;
+        const u32 queue = work[i].second;
+        if (!built[i]) {
             return false;
         }
 
-        setSuffixProperties(*n, s, tbi.rm);
+        setSuffixProperties(*built[i], s, tbi.rm);
+        built[i]->queueIndex = queue;
+        by_queue[queue].push_back(make_pair(s, built[i].get()));
+    }
+
+    for (size_t i = 0; i < work.size(); i++) {
+        const suffix_id &s = work[i].first;
+        const u32 queue = work[i].second;
+        const auto &subs = by_queue.at(queue);
+
+        aligned_unique_ptr<NFA> n;
+        if (subs.size() == 1) {
+            n = move(built[i]);
+        } else if (s == subs.front().first) {
+            DEBUG_PRINTF("queue %u holds %zu exclusive suffixes\n", queue,
+                         subs.size());
+            n = buildExclusiveSuffixes(subs, suffixTriggers, suffixTopBase);
+        } else {
+            continue;
+        }
 
         n->queueIndex = queue;
         if (s.graph() && nfaStuckOn(*s.graph())) { /* todo: have corresponding
@@ -1303,11 +1513,17 @@ static
 bool buildNfas(RoseBuildImpl &tbi, QueueIndexFactory &qif,
                vector<aligned_unique_ptr<NFA>> *built_nfas,
                map<suffix_id, u32> *suffixes,
+               map<suffix_id, u32> *suffixTopBase,
                map<RoseVertex, left_build_info> *leftfix_info,
                set<u32> *no_retrigger_queues, u32 *leftfixBeginQueue) {
-    findSuffixes(tbi, qif, suffixes);
+    map<suffix_id, set<PredTopPair> > suffixTriggers;
+    findSuffixTriggers(tbi, &suffixTriggers);
+
+    const auto exclusive_groups = findExclusiveSuffixes(tbi, suffixTriggers);
+    findSuffixes(tbi, qif, exclusive_groups, suffixes);
 
-    if (!buildSuffixes(tbi, built_nfas, suffixes, no_retrigger_queues)) {
+    if (!buildSuffixes(tbi, suffixTriggers, built_nfas, suffixes,
+                       suffixTopBase, no_retrigger_queues)) {
         return false;
     }
 
@@ -2306,13 +2522,41 @@ void enforceEngineSizeLimit(const NFA *n, const size_t nfa_size, const Grey &gre
     }
 }
 
+/** \brief Returns the queue event that triggers the suffix of vertex v, which
+ * is run by engine \a n. */
+static
+u32 getSuffixEvent(const RoseGraph &g, RoseVertex v, const NFA &n,
+                   const map<suffix_id, u32> &suffixTopBase) {
+    // Exclusive suffixes sharing a Tamarama each own a range of its tops.
+    auto it = suffixTopBase.find(g[v].suffix);
+    if (it != suffixTopBase.end()) {
+        assert(isContainerType(n.type));
+        u32 top = (u32)MQE_TOP_FIRST + it->second + g[v].suffix.top;
+        assert(top < MQE_INVALID);
+        return top;
+    }
+
+    // DFAs/Puffs have no MQE_TOP_N support, so they get a classic TOP
+    // event.
+    if (!isMultiTopType(n.type)) {
+        assert(!g[v].suffix.graph || onlyOneTop(*g[v].suffix.graph));
+        return MQE_TOP;
+    }
+
+    assert(!g[v].suffix.haig);
+    u32 top = (u32)MQE_TOP_FIRST + g[v].suffix.top;
+    assert(top < MQE_INVALID);
+    return top;
+}
+
 /* copies nfas into the final engine and updates role to reflect nfa offset */
 static
 u32 copyInNFAs(const RoseBuildImpl &tbi, vector<RoseRole> *roleTable,
                const vector<aligned_unique_ptr<NFA>> &built_nfas,
                const set<u32> &no_retrigger_queues, NfaInfo *infos,
                u32 base_nfa_offset,
-               const map<suffix_id, u32> &suffixes, char *ptr) {
+               const map<suffix_id, u32> &suffixes,
+               const map<suffix_id, u32> &suffixTopBase, char *ptr) {
     const RoseGraph &g = tbi.g;
     const CompileContext &cc = tbi.cc;
 
@@ -2322,7 +2566,6 @@ u32 copyInNFAs(const RoseBuildImpl &tbi, vector<RoseRole> *roleTable,
     }
 
     vector<u32> suffix_base(built_nfas.size());
-    vector<bool> classic_top(built_nfas.size(), false);
 
     for (u32 i = 0; i < built_nfas.size(); i++) {
         const NFA *n = built_nfas[i].get();
@@ -2336,10 +2579,6 @@ u32 copyInNFAs(const RoseBuildImpl &tbi, vector<RoseRole> *roleTable,
         memcpy(ptr + base_nfa_offset, n, n->length);
         suffix_base[i] = base_nfa_offset;
 
-        if (!isMultiTopType(n->type)) {
-            classic_top[i] = true;
-        }
-
         infos[i].nfaOffset = base_nfa_offset;
         if (contains(no_retrigger_queues, i)) {
             infos[i].no_retrigger = 1;
@@ -2359,18 +2598,8 @@ u32 copyInNFAs(const RoseBuildImpl &tbi, vector<RoseRole> *roleTable,
         assert(g[v].role < roleTable->size());
         RoseRole &tr = (*roleTable)[g[v].role];
         tr.suffixOffset = suffix_base[nfa_index];
-
-        // DFAs/Puffs have no MQE_TOP_N support, so they get a classic TOP
-        // event.
-        if (classic_top[nfa_index]) {
-            assert(!g[v].suffix.graph || onlyOneTop(*g[v].suffix.graph));
-            tr.suffixEvent = MQE_TOP;
-        } else {
-            assert(!g[v].suffix.haig);
-            u32 top = (u32)MQE_TOP_FIRST + g[v].suffix.top;
-            assert(top < MQE_INVALID);
-            tr.suffixEvent = top;
-        }
+        tr.suffixEvent = getSuffixEvent(g, v, *built_nfas[nfa_index],
+                                        suffixTopBase);
 
         /* mark suffixes triggered by etable literals */
         if (tbi.isInETable(v)) {
@@ -2487,10 +2716,15 @@ void buildSuffixEkeyLists(const RoseBuildImpl &tbi, build_context &bc,
 
     map<u32, vector<u32> > qi_to_ekeys; /* for determinism */
 
+    // Several exclusive suffixes may share a queue.
+    map<u32, set<ReportID>> qi_to_reports;
     for (const auto &e : suffixes) {
-        const suffix_id &s = e.first;
-        u32 qi = e.second;
-        set<u32> ekeys = reportsToEkeys(all_reports(s), tbi.rm);
+        insert(&qi_to_reports[e.second], all_reports(e.first));
+    }
+
+    for (const auto &e : qi_to_reports) {
+        u32 qi = e.first;
+        set<u32> ekeys = reportsToEkeys(e.second, tbi.rm);
 
         if (!ekeys.empty()) {
             qi_to_ekeys[qi] = {ekeys.begin(), ekeys.end()};
@@ -2585,11 +2819,16 @@ void populateNfaInfoBasics(NfaInfo *infos, const vector<OutfixInfo> &outfixes,
         infos[qi].ekeyListOffset = ekeyListOffsets[qi];
     }
 
+    // Several exclusive suffixes may share a queue.
+    map<u32, set<ReportID>> qi_to_reports;
     for (const auto &e : suffixes) {
-        const suffix_id &s = e.first;
-        u32 qi = e.second;
+        insert(&qi_to_reports[e.second], all_reports(e.first));
+    }
+
+    for (const auto &e : qi_to_reports) {
+        u32 qi = e.first;
 
-        if (!hasInternalReport(all_reports(s), rm)) {
+        if (!hasInternalReport(e.second, rm)) {
             infos[qi].only_external = 1;
         }
 
@@ -3565,6 +3804,263 @@ void buildPredTable(const RoseBuildImpl &tbi, build_context &bc,
     }
 }
 
+namespace {
+
+/** \brief A role program under construction. */
+struct RoleProgram {
+    vector<char> bytes;
+
+    /** \brief (instruction offset, jump field offset) pairs for the jumps
+     * that target the END instruction, filled in once that is known. */
+    vector<pair<u32, u32>> end_jumps;
+};
+
+}
+
+template<class Instr>
+static
+Instr makeInstruction(RoseInstructionCode code) {
+    static_assert(is_pod<Instr>::value, "should be pod");
+    Instr ri;
+    memset(&ri, 0, sizeof(ri));
+    ri.code = verify_u8(code);
+    return ri;
+}
+
+template<class Instr>
+static
+u32 addInstruction(RoleProgram &prog, const Instr &ri) {
+    u32 offset = verify_u32(prog.bytes.size());
+    assert(ISALIGNED_N(offset, ROSE_INSTR_MIN_ALIGN));
+    prog.bytes.resize(offset + ROUNDUP_N(sizeof(ri), ROSE_INSTR_MIN_ALIGN));
+    memcpy(prog.bytes.data() + offset, &ri, sizeof(ri));
+    return offset;
+}
+
+/** \brief Add an instruction that jumps to the end of the program, with the
+ * jump held in the u32 field at \a jump_field_offset. */
+template<class Instr>
+static
+void addEndJumpInstruction(RoleProgram &prog, const Instr &ri,
+                           size_t jump_field_offset) {
+    u32 offset = addInstruction(prog, ri);
+    prog.end_jumps.emplace_back(offset, verify_u32(jump_field_offset));
+}
+
+static
+void finishProgram(RoleProgram &prog) {
+    u32 end_offset = addInstruction(prog,
+                            makeInstruction<ROSE_STRUCT_END>(ROSE_INSTR_END));
+    for (const auto &j : prog.end_jumps) {
+        assert(j.first < end_offset);
+        u32 jump = end_offset - j.first;
+        memcpy(prog.bytes.data() + j.first + j.second, &jump, sizeof(jump));
+    }
+}
+
+static
+void makeRoleReport(const RoseRole &tr, RoleProgram &prog) {
+    if (tr.reportId == MO_INVALID_IDX) {
+        return;
+    }
+
+    if (tr.flags & ROSE_ROLE_FLAG_REPORT_START) {
+        // Rose role knows its start offset.
+        assert(tr.flags & ROSE_ROLE_FLAG_SOM_ROSEFIX);
+        assert(!(tr.flags & ROSE_ROLE_FLAG_CHAIN_REPORT));
+        if (tr.flags & ROSE_ROLE_FLAG_SOM_REPORT) {
+            auto ri = makeInstruction<ROSE_STRUCT_REPORT_SOM>(
+                ROSE_INSTR_REPORT_SOM);
+            ri.report = tr.reportId;
+            addInstruction(prog, ri);
+        } else {
+            auto ri = makeInstruction<ROSE_STRUCT_REPORT_SOM_KNOWN>(
+                ROSE_INSTR_REPORT_SOM_KNOWN);
+            ri.report = tr.reportId;
+            addInstruction(prog, ri);
+        }
+    } else if (tr.flags & ROSE_ROLE_FLAG_SOM_REPORT) {
+        auto ri = makeInstruction<ROSE_STRUCT_REPORT_SOM_INT>(
+            ROSE_INSTR_REPORT_SOM_INT);
+        ri.report = tr.reportId;
+        addInstruction(prog, ri);
+    } else if (tr.flags & ROSE_ROLE_FLAG_CHAIN_REPORT) {
+        auto ri = makeInstruction<ROSE_STRUCT_REPORT_CHAIN>(
+            ROSE_INSTR_REPORT_CHAIN);
+        ri.report = tr.reportId;
+        addInstruction(prog, ri);
+    } else {
+        auto ri = makeInstruction<ROSE_STRUCT_REPORT>(ROSE_INSTR_REPORT);
+        ri.report = tr.reportId;
+        addInstruction(prog, ri);
+    }
+}
+
+/**
+ * \brief Build the instruction program for the role of vertex \a v, from the
+ * role entry and preds already constructed for it.
+ *
+ * The instruction order follows the order in which the runtime used to
+ * evaluate the role's flags: checks first (each jumping to END on failure),
+ * then SOM, engine triggers, reports and finally the role's state.
+ */
+static
+void makeRoleProgram(const RoseBuildImpl &tbi, const build_context &bc,
+                     RoseVertex v, const vector<RosePred> &predTable,
+                     const vector<aligned_unique_ptr<NFA>> &built_nfas,
+                     const map<suffix_id, u32> &suffixes,
+                     RoleProgram &prog) {
+    const RoseGraph &g = tbi.g;
+    u32 role = g[v].role;
+    const RoseRole &tr = bc.roleTable.at(role);
+
+    if (tr.flags & ROSE_ROLE_PRED_ROOT) {
+        const RosePred &tp = predTable.at(tr.predOffset);
+        assert(tp.role == MO_INVALID_IDX);
+        assert(tp.historyCheck == ROSE_ROLE_HISTORY_NONE ||
+               tp.historyCheck == ROSE_ROLE_HISTORY_ANCH);
+        if (tp.historyCheck == ROSE_ROLE_HISTORY_ANCH) {
+            auto ri = makeInstruction<ROSE_STRUCT_CHECK_ROOT_BOUNDS>(
+                ROSE_INSTR_CHECK_ROOT_BOUNDS);
+            ri.min_bound = tp.minBound;
+            ri.max_bound = tp.maxBound;
+            addEndJumpInstruction(prog, ri,
+                    offsetof(ROSE_STRUCT_CHECK_ROOT_BOUNDS, fail_jump));
+        }
+    }
+
+    // Roles from the anchored table may have to wait for anchored playback.
+    if (tr.flags & ROSE_ROLE_FLAG_ANCHOR_TABLE) {
+        auto ri = makeInstruction<ROSE_STRUCT_ANCHORED_DELAY>(
+            ROSE_INSTR_ANCHORED_DELAY);
+        ri.depth = tr.depth;
+        ri.groups = tr.groups;
+        addEndJumpInstruction(prog, ri,
+                              offsetof(ROSE_STRUCT_ANCHORED_DELAY, done_jump));
+    }
+
+    if (tr.flags & ROSE_ROLE_FLAG_ONLY_AT_END) {
+        auto ri = makeInstruction<ROSE_STRUCT_CHECK_ONLY_EOD>(
+            ROSE_INSTR_CHECK_ONLY_EOD);
+        addEndJumpInstruction(prog, ri,
+                              offsetof(ROSE_STRUCT_CHECK_ONLY_EOD, fail_jump));
+    }
+
+    if (tr.lookaroundIndex != MO_INVALID_IDX) {
+        auto ri = makeInstruction<ROSE_STRUCT_CHECK_LOOKAROUND>(
+            ROSE_INSTR_CHECK_LOOKAROUND);
+        ri.index = tr.lookaroundIndex;
+        ri.count = tr.lookaroundCount;
+        addEndJumpInstruction(prog, ri,
+                offsetof(ROSE_STRUCT_CHECK_LOOKAROUND, fail_jump));
+    }
+
+    assert(!tr.leftfixQueue || (tr.flags & ROSE_ROLE_FLAG_ROSE));
+    if (tr.flags & ROSE_ROLE_FLAG_ROSE) {
+        auto ri = makeInstruction<ROSE_STRUCT_CHECK_LEFTFIX>(
+            ROSE_INSTR_CHECK_LEFTFIX);
+        ri.queue = tr.leftfixQueue;
+        ri.lag = tr.leftfixLag;
+        ri.report = tr.leftfixReport;
+        addEndJumpInstruction(prog, ri,
+                              offsetof(ROSE_STRUCT_CHECK_LEFTFIX, fail_jump));
+    }
+
+    if (tr.flags & ROSE_ROLE_FLAG_SOM_ADJUST) {
+        auto ri = makeInstruction<ROSE_STRUCT_SOM_ADJUST>(
+            ROSE_INSTR_SOM_ADJUST);
+        ri.distance = tr.somAdjust;
+        addInstruction(prog, ri);
+    } else if (tr.flags & ROSE_ROLE_FLAG_SOM_ROSEFIX) {
+        assert(tr.flags & ROSE_ROLE_FLAG_ROSE);
+        auto ri = makeInstruction<ROSE_STRUCT_SOM_LEFTFIX>(
+            ROSE_INSTR_SOM_LEFTFIX);
+        ri.queue = tr.leftfixQueue;
+        ri.lag = tr.leftfixLag;
+        addInstruction(prog, ri);
+    }
+
+    if (tr.infixTriggerOffset) {
+        auto ri = makeInstruction<ROSE_STRUCT_TRIGGER_INFIX>(
+            ROSE_INSTR_TRIGGER_INFIX);
+        ri.offset = tr.infixTriggerOffset;
+        addInstruction(prog, ri);
+
+        // Groups may have been cleared by an infix going quiet before.
+        auto rg = makeInstruction<ROSE_STRUCT_SET_GROUPS>(
+            ROSE_INSTR_SET_GROUPS);
+        rg.groups = tr.groups;
+        addInstruction(prog, rg);
+    }
+
+    if (g[v].suffix) {
+        u32 qi = suffixes.at(g[v].suffix);
+        assert(qi < built_nfas.size());
+        auto ri = makeInstruction<ROSE_STRUCT_TRIGGER_SUFFIX>(
+            ROSE_INSTR_TRIGGER_SUFFIX);
+        ri.queue = qi;
+        ri.event = getSuffixEvent(g, v, *built_nfas[qi], bc.suffixTopBase);
+        addInstruction(prog, ri);
+    }
+
+    makeRoleReport(tr, prog);
+
+    // Leaf roles have no state index; they may still be ghost roles which
+    // need to set groups.
+    if (tr.stateIndex == MMB_INVALID) {
+        auto ri = makeInstruction<ROSE_STRUCT_SET_GROUPS>(
+            ROSE_INSTR_SET_GROUPS);
+        ri.groups = tr.groups;
+        addInstruction(prog, ri);
+    } else {
+        auto ri = makeInstruction<ROSE_STRUCT_SET_STATE>(
+            ROSE_INSTR_SET_STATE);
+        ri.depth = tr.depth;
+        ri.groups = tr.groups;
+        ri.index = tr.stateIndex;
+        ri.role = role;
+        addInstruction(prog, ri);
+    }
+
+    finishProgram(prog);
+}
+
+/** \brief Build and write out the instruction programs for all literal
+ * roles, once their role entries are otherwise complete. */
+static
+void buildRolePrograms(const RoseBuildImpl &tbi, build_context &bc,
+                       const vector<RosePred> &predTable,
+                       const vector<aligned_unique_ptr<NFA>> &built_nfas,
+                       const map<suffix_id, u32> &suffixes) {
+    const RoseGraph &g = tbi.g;
+
+    // Identical programs are shared.
+    map<vector<char>, u32> program_cache;
+
+    for (RoseVertex v : get_ordered_verts(g)) {
+        if (g[v].role == MO_INVALID_IDX) {
+            continue;
+        }
+
+        RoleProgram prog;
+        makeRoleProgram(tbi, bc, v, predTable, built_nfas, suffixes, prog);
+
+        auto it = program_cache.find(prog.bytes);
+        u32 offset;
+        if (it != program_cache.end()) {
+            offset = it->second;
+        } else {
+            pad_engine_blob(bc, ROSE_INSTR_MIN_ALIGN);
+            offset = add_to_engine_blob(bc, prog.bytes.begin(),
+                                        prog.bytes.end());
+            program_cache.emplace(move(prog.bytes), offset);
+        }
+
+        DEBUG_PRINTF("role %u program at offset %u\n", g[v].role, offset);
+        bc.roleTable.at(g[v].role).programOffset = offset;
+    }
+}
+
 static
 bool hasUsefulStops(const left_build_info &rbi) {
     for (u32 i = 0; i < N_CHARS; i++) {
@@ -3877,8 +4373,9 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     u32 outfixEndQueue = qif.allocated_count();
     u32 leftfixBeginQueue = outfixEndQueue;
 
-    if (!buildNfas(*this, qif, &built_nfas, &suffixes, &bc.leftfix_info,
-                   &no_retrigger_queues, &leftfixBeginQueue)) {
+    if (!buildNfas(*this, qif, &built_nfas, &suffixes, &bc.suffixTopBase,
+                   &bc.leftfix_info, &no_retrigger_queues,
+                   &leftfixBeginQueue)) {
         return nullptr;
     }
     buildCountingMiracles(*this, bc);
@@ -3925,6 +4422,8 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     tie(eodIterMapOffset, eodIterOffset) = buildEodAnchorRoles(*this, bc,
                                                                predTable);
 
+    buildRolePrograms(*this, bc, predTable, built_nfas, suffixes);
+
     vector<RoseSide> sideTable;
     buildSideTable(*this, bc, sideTable);
 
@@ -4109,6 +4608,11 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     u32 dkeyOffset = currOffset;
     currOffset += rm.numDkeys() * sizeof(ReportID);
 
+    const auto exprIds = rm.getExternalIdTable();
+    currOffset = ROUNDUP_N(currOffset, alignof(ReportID));
+    u32 exprIdOffset = currOffset;
+    currOffset += byte_length(exprIds);
+
     aligned_unique_ptr<RoseEngine> engine
         = aligned_zmalloc_unique<RoseEngine>(currOffset);
     assert(engine); // will have thrown bad_alloc otherwise.
@@ -4149,6 +4653,9 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->dkeyCount = rm.numDkeys();
     engine->invDkeyOffset = dkeyOffset;
     copy_bytes(ptr + dkeyOffset, rm.getDkeyToReportTable());
+    engine->exprIdCount = verify_u32(exprIds.size());
+    engine->exprIdOffset = exprIdOffset;
+    copy_bytes(ptr + exprIdOffset, exprIds);
 
     engine->somHorizon = ssm.somPrecision();
     engine->somLocationCount = ssm.numSomSlots();
@@ -4255,6 +4762,7 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->hasOutfixesInSmallBlock = hasNonSmallBlockOutfix(outfixes);
     engine->canExhaust = rm.patternSetCanExhaust();
     engine->hasSom = hasSom;
+    engine->anyMatch = anyMatch;
     engine->anchoredMatches = verify_u32(art.size());
 
     /* populate anchoredDistance, floatingDistance, floatingMinDistance, etc */
@@ -4300,7 +4808,8 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->nfaRegionBegin = base_nfa_offset;
     engine->nfaRegionEnd = copyInNFAs(*this, &bc.roleTable, built_nfas,
                                       no_retrigger_queues, nfa_infos,
-                                      base_nfa_offset, suffixes, ptr);
+                                      base_nfa_offset, suffixes,
+                                      bc.suffixTopBase, ptr);
     // We're done with the NFAs.
     built_nfas.clear();
 
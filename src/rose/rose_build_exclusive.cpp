@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Rose build: grouping of mutually exclusive suffix engines.
+ *
+ * Suffixes that can never be alive at the same time are grouped so that they
+ * can share a single queue and stream state in a Tamarama container, rather
+ * than each being caught up and having its state compressed separately.
+ */
+
+#include "rose_build_exclusive.h"
+
+#include "grey.h"
+#include "rose_build_impl.h"
+#include "nfa/castlecompile.h"
+#include "nfa/rdfa.h"
+#include "nfa/repeatcompile.h"
+#include "nfagraph/ng_holder.h"
+#include "util/clique.h"
+#include "util/compile_context.h"
+#include "util/container.h"
+#include "util/graph.h"
+#include "util/graph_range.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace ue2 {
+
+static
+CharReach getReach(const NGHolder &h) {
+    // An engine with a live floating start never dies.
+    if (proper_out_degree(h.startDs, h)) {
+        return CharReach::dot();
+    }
+
+    CharReach cr;
+    for (auto v : vertices_range(h)) {
+        if (!is_special(v, h)) {
+            cr |= h[v].char_reach;
+        }
+    }
+    return cr;
+}
+
+static
+CharReach getReach(const raw_dfa &rdfa) {
+    CharReach cr;
+    for (u32 s = 0; s < rdfa.states.size(); s++) {
+        if (s == DEAD_STATE) {
+            continue;
+        }
+        const dstate &ds = rdfa.states[s];
+        for (u32 c = 0; c < N_CHARS; c++) {
+            if (ds.next[rdfa.alpha_remap[c]] != DEAD_STATE) {
+                cr.set(c);
+            }
+        }
+    }
+    return cr;
+}
+
+/** \brief Returns the set of characters that can keep the suffix alive. */
+static
+CharReach getReach(const suffix_id &s) {
+    if (s.castle()) {
+        return s.castle()->reach();
+    }
+    if (s.haig()) {
+        return CharReach::dot();
+    }
+    if (s.dfa()) {
+        return getReach(*s.dfa());
+    }
+    assert(s.graph());
+    return getReach(*s.graph());
+}
+
+namespace {
+struct SuffixTriggerInfo {
+    SuffixTriggerInfo(const suffix_id &s,
+                      const vector<vector<CharReach>> &triggers_in)
+        : suffix(s), reach(getReach(s)), triggers(triggers_in) {}
+
+    suffix_id suffix;
+    CharReach reach;
+    vector<vector<CharReach>> triggers;
+};
+}
+
+/**
+ * \brief True if the triggers for \a b always kill \a a and vice versa. This
+ * is the test used by the Castle for its exclusive repeats, with each engine
+ * using its own reach.
+ */
+static
+bool isExclusivePair(const SuffixTriggerInfo &a, const SuffixTriggerInfo &b) {
+    const vector<size_t> a_dist = minResetDistToEnd(a.triggers, b.reach);
+    const vector<size_t> b_dist = minResetDistToEnd(b.triggers, a.reach);
+    for (u32 i = 0; i < a.triggers.size(); i++) {
+        for (u32 j = 0; j < b.triggers.size(); j++) {
+            if (!literalOverlap(a.triggers[i], b.triggers[j], b_dist[j]) ||
+                !literalOverlap(b.triggers[j], a.triggers[i], a_dist[i])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/** \brief Peels off the largest groups of exclusive suffixes in turn. */
+static
+void findGroups(const vector<SuffixTriggerInfo> &info,
+                vector<vector<suffix_id>> &groups) {
+    vector<vector<bool>> exclusive(info.size(), vector<bool>(info.size()));
+    for (u32 i = 0; i < info.size(); i++) {
+        for (u32 j = i + 1; j < info.size(); j++) {
+            if (isExclusivePair(info[i], info[j])) {
+                DEBUG_PRINTF("suffixes %u and %u are exclusive\n", i, j);
+                exclusive[i][j] = exclusive[j][i] = true;
+            }
+        }
+    }
+
+    vector<bool> done(info.size(), false);
+    while (true) {
+        CliqueGraph cg;
+        vector<CliqueVertex> vertices;
+        for (u32 i = 0; i < info.size(); i++) {
+            if (!done[i]) {
+                vertices.push_back(add_vertex(CliqueVertexProps(i), cg));
+            }
+        }
+
+        for (u32 i = 0; i < vertices.size(); i++) {
+            for (u32 j = i + 1; j < vertices.size(); j++) {
+                if (exclusive[cg[vertices[i]].stateId]
+                             [cg[vertices[j]].stateId]) {
+                    add_edge(vertices[i], vertices[j], cg);
+                }
+            }
+        }
+
+        if (vertices.size() < 2 || !num_edges(cg)) {
+            break;
+        }
+
+        vector<u32> clique = removeClique(cg);
+        if (clique.size() < 2) {
+            break;
+        }
+
+        sort(clique.begin(), clique.end());
+        DEBUG_PRINTF("found group of %zu exclusive suffixes\n", clique.size());
+        vector<suffix_id> group;
+        for (u32 id : clique) {
+            group.push_back(info[id].suffix);
+            done[id] = true;
+        }
+        groups.push_back(move(group));
+    }
+}
+
+vector<vector<suffix_id>> findExclusiveSuffixGroups(
+    const map<suffix_id, vector<vector<CharReach>>> &triggers,
+    const CompileContext &cc) {
+    vector<vector<suffix_id>> groups;
+    if (!cc.grey.allowTamarama || !cc.grey.tamaChunkSize) {
+        return groups;
+    }
+
+    // Exclusion analysis is quadratic in the number of suffixes, so they are
+    // considered in chunks.
+    vector<SuffixTriggerInfo> info;
+    for (const auto &m : triggers) {
+        if (m.second.empty()) {
+            continue;
+        }
+        info.emplace_back(m.first, m.second);
+        if (info.size() == cc.grey.tamaChunkSize) {
+            findGroups(info, groups);
+            info.clear();
+        }
+    }
+
+    if (info.size() > 1) {
+        findGroups(info, groups);
+    }
+
+    return groups;
+}
+
+} // namespace ue2
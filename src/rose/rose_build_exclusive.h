@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Rose build: grouping of mutually exclusive suffix engines.
+ */
+
+#ifndef ROSE_BUILD_EXCLUSIVE_H
+#define ROSE_BUILD_EXCLUSIVE_H
+
+#include "ue2common.h"
+#include "util/charreach.h"
+
+#include <map>
+#include <vector>
+
+namespace ue2 {
+
+struct CompileContext;
+struct suffix_id;
+
+/**
+ * \brief Finds groups of suffix engines that can never be alive at the same
+ * time.
+ *
+ * \a triggers holds every literal that may trigger each candidate suffix. Two
+ * suffixes are exclusive if each one's triggers are guaranteed to kill the
+ * other, i.e. they contain a character outside its reach that cannot have
+ * been consumed before the other was last triggered. Each group returned
+ * holds at least two suffixes; suffixes that are not in any group are left
+ * out.
+ */
+std::vector<std::vector<suffix_id>> findExclusiveSuffixGroups(
+    const std::map<suffix_id, std::vector<std::vector<CharReach>>> &triggers,
+    const CompileContext &cc);
+
+} // namespace ue2
+
+#endif // ROSE_BUILD_EXCLUSIVE_H
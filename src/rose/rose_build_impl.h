@@ -387,6 +387,8 @@ public:
 
     void setSom() override { hasSom = true; }
 
+    void setAnyMatch() override { anyMatch = true; }
+
     std::unique_ptr<RoseDedupeAux> generateDedupeAux() const override;
 
     bool hasEodSideLink() const;
@@ -488,6 +490,9 @@ public:
     std::deque<rose_literal_info> literal_info;
     u32 delay_base_id;
     bool hasSom; //!< at least one pattern requires SOM.
+
+    bool anyMatch; //!< only the first match is required.
+
     std::map<size_t, std::vector<std::unique_ptr<raw_dfa>>> anchored_nfas;
     std::map<simple_anchored_info, std::set<u32>> anchored_simple;
     std::map<u32, std::set<u32> > group_to_literal;
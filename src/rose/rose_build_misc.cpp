@@ -75,6 +75,7 @@ RoseBuildImpl::RoseBuildImpl(ReportManager &rm_in, SomSlotManager &ssm_in,
       vertexIndex(0),
       delay_base_id(MO_INVALID_IDX),
       hasSom(false),
+      anyMatch(false),
       group_weak_end(0),
       group_end(0),
       anchored_base_id(MO_INVALID_IDX),
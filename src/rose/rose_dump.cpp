@@ -34,6 +34,7 @@
 #include "rose_dump.h"
 #include "rose_common.h"
 #include "rose_internal.h"
+#include "rose_program.h"
 #include "hs_compile.h"
 #include "ue2common.h"
 #include "nfa/nfa_build_util.h"
@@ -609,12 +610,16 @@ void roseDumpText(const RoseEngine *t, FILE *f) {
     if (t->hasSom) {
         fprintf(f, " hasSom");
     }
+    if (t->anyMatch) {
+        fprintf(f, " anyMatch");
+    }
     if (t->simpleCallback) {
         fprintf(f, " simpleCallback");
     }
     fprintf(f, "\n");
 
     fprintf(f, "dkey count           : %u\n", t->dkeyCount);
+    fprintf(f, "external id count    : %u\n", t->exprIdCount);
     fprintf(f, "som slot count       : %u\n", t->somLocationCount);
     fprintf(f, "som width            : %u bytes\n", t->somHorizon);
     fprintf(f, "rose count           : %u\n", t->roseCount);
@@ -799,6 +804,7 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U8(t, mpvTriggeredByLeaf);
     DUMP_U8(t, canExhaust);
     DUMP_U8(t, hasSom);
+    DUMP_U8(t, anyMatch);
     DUMP_U8(t, somHorizon);
     DUMP_U8(t, simpleCallback);
     DUMP_U32(t, mode);
@@ -806,6 +812,8 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, ekeyCount);
     DUMP_U32(t, dkeyCount);
     DUMP_U32(t, invDkeyOffset);
+    DUMP_U32(t, exprIdCount);
+    DUMP_U32(t, exprIdOffset);
     DUMP_U32(t, somLocationCount);
     DUMP_U32(t, rolesWithStateCount);
     DUMP_U32(t, stateSize);
@@ -885,6 +893,7 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, stateOffsets.somLocation);
     DUMP_U32(t, stateOffsets.somValid);
     DUMP_U32(t, stateOffsets.somWritable);
+    DUMP_U32(t, stateOffsets.nfaStateBegin);
     DUMP_U32(t, stateOffsets.end);
     DUMP_U32(t, boundary.reportEodOffset);
     DUMP_U32(t, boundary.reportZeroOffset);
@@ -956,10 +965,160 @@ void roseDumpRoleStructRaw(const RoseEngine *t, FILE *f) {
         DUMP_U32(p, somAdjust);
         DUMP_U32(p, lookaroundIndex);
         DUMP_U32(p, lookaroundCount);
+        DUMP_U32(p, programOffset);
         fprintf(f, "}\n");
     }
 }
 
+#define PROGRAM_CASE(name)                                                     \
+    case ROSE_INSTR_##name: {                                                  \
+        os << "  " << setw(4) << setfill('0') << (pc - pc_base)      \
+           << ": " #name " (" << (int)ROSE_INSTR_##name << ")" << endl;        \
+        const auto *ri = (const struct ROSE_STRUCT_##name *)pc;
+
+#define PROGRAM_NEXT_INSTRUCTION                                               \
+    pc += ROUNDUP_N(sizeof(*ri), ROSE_INSTR_MIN_ALIGN);                        \
+    break;                                                                     \
+    }
+
+static
+void dumpRoleProgram(ofstream &os, const char *pc) {
+    const char *pc_base = pc;
+    for (;;) {
+        u8 code = *(const u8 *)pc;
+        assert(code <= ROSE_INSTR_END);
+        switch (code) {
+            PROGRAM_CASE(CHECK_ROOT_BOUNDS) {
+                os << "    min_bound " << ri->min_bound << endl;
+                os << "    max_bound " << rose_off(ri->max_bound) << endl;
+                os << "    fail_jump +" << ri->fail_jump << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(ANCHORED_DELAY) {
+                os << "    depth " << u32{ri->depth} << endl;
+                os << "    groups 0x" << hex << ri->groups << dec
+                   << endl;
+                os << "    done_jump +" << ri->done_jump << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(CHECK_ONLY_EOD) {
+                os << "    fail_jump +" << ri->fail_jump << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(CHECK_LOOKAROUND) {
+                os << "    index " << ri->index << endl;
+                os << "    count " << ri->count << endl;
+                os << "    fail_jump +" << ri->fail_jump << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(CHECK_LEFTFIX) {
+                os << "    queue " << ri->queue << endl;
+                os << "    lag " << ri->lag << endl;
+                os << "    report " << ri->report << endl;
+                os << "    fail_jump +" << ri->fail_jump << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SOM_ADJUST) {
+                os << "    distance " << ri->distance << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SOM_LEFTFIX) {
+                os << "    queue " << ri->queue << endl;
+                os << "    lag " << ri->lag << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(TRIGGER_INFIX) {
+                os << "    offset " << ri->offset << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(TRIGGER_SUFFIX) {
+                os << "    queue " << ri->queue << endl;
+                os << "    event " << ri->event << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT) {
+                os << "    report " << ri->report << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT_CHAIN) {
+                os << "    report " << ri->report << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT_SOM_INT) {
+                os << "    report " << ri->report << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT_SOM) {
+                os << "    report " << ri->report << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(REPORT_SOM_KNOWN) {
+                os << "    report " << ri->report << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SET_STATE) {
+                os << "    depth " << u32{ri->depth} << endl;
+                os << "    groups 0x" << hex << ri->groups << dec
+                   << endl;
+                os << "    index " << ri->index << endl;
+                os << "    role " << ri->role << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SET_GROUPS) {
+                os << "    groups 0x" << hex << ri->groups << dec
+                   << endl;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(END) { return; }
+            PROGRAM_NEXT_INSTRUCTION
+
+        default:
+            os << "  UNKNOWN (code " << int{code} << ")" << endl;
+            os << "  <stopping>" << endl;
+            return;
+        }
+    }
+}
+
+#undef PROGRAM_CASE
+#undef PROGRAM_NEXT_INSTRUCTION
+
+static
+void dumpRolePrograms(const RoseEngine *t, const string &filename) {
+    ofstream os(filename);
+    const RoseRole *tr = getRoleTable(t);
+    const RoseRole *tr_end = tr + t->roleCount;
+
+    for (const RoseRole *p = tr; p < tr_end; p++) {
+        os << "Role " << p - tr << endl;
+        if (!p->programOffset) {
+            os << "  <no program>" << endl << endl;
+            continue;
+        }
+        os << "  program at offset " << p->programOffset << endl;
+        dumpRoleProgram(os, (const char *)t + p->programOffset);
+        os << endl;
+    }
+
+    os.close();
+}
+
 void roseDumpComponents(const RoseEngine *t, bool dump_raw, const string &base) {
     dumpComponentInfo(t, base);
     dumpNfas(t, dump_raw, base);
@@ -1028,6 +1187,8 @@ void roseDumpInternals(const RoseEngine *t, const string &base) {
     roseDumpRoleStructRaw(t, f);
     fclose(f);
 
+    dumpRolePrograms(t, base + "/rose_role_programs.txt");
+
     roseDumpComponents(t, true, base);
 }
 
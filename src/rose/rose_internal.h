@@ -326,6 +326,8 @@ struct RoseRole {
     u32 lookaroundIndex; /**< index of lookaround offset/reach in table, or
                           * MO_INVALID_IDX. */
     u32 lookaroundCount; /**< number of lookaround entries. */
+    u32 programOffset; /**< offset to the role's instruction program (see
+                        * rose_program.h), or 0 for fake EOD roles. */
 };
 
 // Structure representing a predecessor relationship
@@ -414,6 +416,10 @@ struct RoseStateOffsets {
     /** Multibit guarding SOM location slots. */
     u32 somWritable;
 
+    /** Start of the stream state of the engines tracked in the active arrays,
+     * which runs up to \ref end. */
+    u32 nfaStateBegin;
+
     /** Total size of Rose state, in bytes. */
     u32 end;
 };
@@ -490,6 +496,8 @@ struct RoseEngine {
     u8  mpvTriggeredByLeaf; /**< need to check (suf|out)fixes for mpv trigger */
     u8  canExhaust; /**< every pattern has an exhaustion key */
     u8  hasSom; /**< has at least one pattern which tracks SOM. */
+    u8  anyMatch; /**< only the first match is reported, see
+                   * \ref HS_MODE_ANYMATCH */
     u8  somHorizon; /**< width in bytes of SOM offset storage (governed by
                         SOM precision) */
     u8  simpleCallback; /**< has only external reports with no bounds checks,
@@ -500,6 +508,9 @@ struct RoseEngine {
     u32 dkeyCount; /**< number of dedupe keys */
     u32 invDkeyOffset; /**< offset to table mapping from dkeys to the external
                          *  report ids */
+    u32 exprIdCount; /**< number of distinct external report ids */
+    u32 exprIdOffset; /**< offset to sorted table of the distinct external
+                        * report ids, see \ref hs_scan_count */
     u32 somLocationCount; /**< number of som locations required */
     u32 rolesWithStateCount; // number of roles with entries in state bitset
     u32 stateSize; /* size of the state bitset
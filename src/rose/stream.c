@@ -36,6 +36,7 @@
 #include "nfa/nfa_api.h"
 #include "nfa/nfa_api_queue.h"
 #include "nfa/nfa_internal.h"
+#include "profile.h"
 #include "util/fatbit.h"
 #include "rose_sidecar_runtime.h"
 #include "rose.h"
@@ -423,8 +424,10 @@ void do_rebuild(const struct RoseEngine *t, const struct HWLM *ftable,
     const u8 *buf = scratch->core_info.hbuf + scratch->core_info.hlen - len;
     DEBUG_PRINTF("BEGIN FLOATING REBUILD over %zu bytes\n", len);
 
+    u64a prof_start = profileStart();
     hwlmExec(ftable, buf, len, 0, roseDelayRebuildCallback, scratch,
              scratch->tctxt.groups);
+    profileStage(scratch, HS_PROFILE_LITERAL_MATCHER, prof_start);
     assert(!can_stop_matching(scratch));
 }
 
@@ -497,7 +500,9 @@ void roseStreamExec(const struct RoseEngine *t, u8 *state,
     const struct anchored_matcher_info *atable = getALiteralMatcher(t);
     if (atable && alen) {
         DEBUG_PRINTF("BEGIN ANCHORED %zu/%u\n", scratch->core_info.hlen, alen);
+        u64a prof_start = profileStart();
         runAnchoredTableStream(t, atable, alen, offset, scratch);
+        profileStage(scratch, HS_PROFILE_ANCHORED, prof_start);
 
         if (can_stop_matching(scratch)) {
             goto exit;
@@ -560,8 +565,10 @@ void roseStreamExec(const struct RoseEngine *t, u8 *state,
         }
 
         DEBUG_PRINTF("BEGIN FLOATING (over %zu/%zu)\n", flen, length);
+        u64a prof_start = profileStart();
         hwlmExecStreaming(ftable, scratch, flen, start, roseCallback, tctxt,
                           tctxt->groups, stream_state);
+        profileStage(scratch, HS_PROFILE_LITERAL_MATCHER, prof_start);
     }
 
 flush_delay_and_exit:
@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "allocator.h"
+#include "budget.h"
 #include "hs_compile.h" /* for HS_MODE_* flags */
 #include "hs_runtime.h"
 #include "hs_internal.h"
@@ -43,14 +44,17 @@
 #include "nfa/nfa_api_util.h"
 #include "nfa/nfa_internal.h"
 #include "nfa/nfa_rev_api.h"
+#include "nfa/sheng.h"
 #include "smallwrite/smallwrite_internal.h"
 #include "rose/rose.h"
 #include "rose/runtime.h"
 #include "database.h"
+#include "profile.h"
 #include "scratch.h"
 #include "som/som_runtime.h"
 #include "som/som_stream.h"
 #include "state.h"
+#include "stream_compress.h"
 #include "ue2common.h"
 #include "util/exhaust.h"
 #include "util/fatbit.h"
@@ -73,6 +77,102 @@ int null_onEvent(UNUSED unsigned id, UNUSED unsigned long long from,
     return 0;
 }
 
+/** \brief Hand any buffered matches to the user's batch handler.
+ *
+ * \return the handler's return value: non-zero if matching should cease. */
+static
+int flushMatchBatch(struct hs_scratch *s) {
+    struct match_batch *b = &s->batch;
+    if (!b->count) {
+        return 0;
+    }
+
+    u32 count = b->count;
+    b->count = 0;
+    DEBUG_PRINTF("delivering batch of %u matches\n", count);
+    return b->handler(b->matches, count, b->context);
+}
+
+/** event handler used by the buffered scan functions: the match is appended to
+ * the batch in scratch, which is only handed to the user when it fills up */
+static
+int batch_onEvent(unsigned id, unsigned long long from, unsigned long long to,
+                  UNUSED unsigned flags, void *ctxt) {
+    struct hs_scratch *s = ctxt;
+    struct match_batch *b = &s->batch;
+    assert(b->count < MATCH_BATCH_SIZE);
+
+    hs_match_t *m = &b->matches[b->count++];
+    m->from = from;
+    m->to = to;
+    m->id = id;
+
+    if (unlikely(b->count == MATCH_BATCH_SIZE)) {
+        return flushMatchBatch(s);
+    }
+    return 0;
+}
+
+/** \brief Prepare scratch for a buffered scan; core info is then populated
+ * with \ref batch_onEvent and the scratch itself as the context. */
+static really_inline
+void initMatchBatch(struct hs_scratch *s, match_batch_handler onBatch,
+                    void *context) {
+    s->batch.handler = onBatch;
+    s->batch.context = context;
+    s->batch.count = 0;
+}
+
+static really_inline
+const u32 *getExprIdTable(const struct RoseEngine *rose) {
+    return (const u32 *)((const char *)rose + rose->exprIdOffset);
+}
+
+/** \brief Find the counter index of \a id in the sorted table of external ids.
+ *
+ * \return the index, or \a count if \a id is not in the table. */
+static really_inline
+u32 findCounterIndex(const u32 *ids, u32 count, u32 id) {
+    /* ids are very often dense, in which case the id is its own index */
+    if (likely(id < count && ids[id] == id)) {
+        return id;
+    }
+
+    u32 lo = 0, hi = count;
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (ids[mid] < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < count && ids[lo] == id ? lo : count;
+}
+
+/** event handler used by the counting scan functions: matches are counted in
+ * the user's counter array and never halt the scan */
+static
+int count_onEvent(unsigned id, UNUSED unsigned long long from,
+                  UNUSED unsigned long long to, UNUSED unsigned flags,
+                  void *ctxt) {
+    const struct match_counter *mc = &((struct hs_scratch *)ctxt)->counter;
+    u32 idx = findCounterIndex(mc->ids, mc->idCount, id);
+    assert(idx < mc->idCount);
+    mc->counts[idx]++;
+    return 0;
+}
+
+/** \brief Prepare scratch for a counting scan; core info is then populated
+ * with \ref count_onEvent and the scratch itself as the context. */
+static really_inline
+void initMatchCounter(struct hs_scratch *s, const struct RoseEngine *rose,
+                      unsigned long long *counts) {
+    s->counter.counts = counts;
+    s->counter.ids = getExprIdTable(rose);
+    s->counter.idCount = rose->exprIdCount;
+}
+
 static really_inline
 u32 getHistoryAmount(const struct RoseEngine *t, u64a offset) {
     return MIN(t->historyRequired, offset);
@@ -120,7 +220,7 @@ static really_inline
 void populateCoreInfo(struct hs_scratch *s, const struct RoseEngine *rose,
                       char *state, match_event_handler onEvent, void *userCtx,
                       const char *data, size_t length, const u8 *history,
-                      size_t hlen, u64a offset, UNUSED unsigned int flags) {
+                      size_t hlen, u64a offset, unsigned int flags) {
     assert(rose);
     s->core_info.userContext = userCtx;
     s->core_info.userCallback = onEvent ? onEvent : null_onEvent;
@@ -129,6 +229,8 @@ void populateCoreInfo(struct hs_scratch *s, const struct RoseEngine *rose,
 
     s->core_info.exhaustionVector = state + rose->stateOffsets.exhausted;
     s->core_info.broken = NOT_BROKEN;
+    /* SOM tracking relies on matches arriving in order. */
+    s->core_info.unordered = (flags & HS_SCAN_FLAG_UNORDERED) && !rose->hasSom;
     s->core_info.buf = (const u8 *)data;
     s->core_info.len = length;
     s->core_info.hbuf = history;
@@ -136,6 +238,7 @@ void populateCoreInfo(struct hs_scratch *s, const struct RoseEngine *rose,
     s->core_info.buf_offset = offset;
 
     /* and some stuff not actually in core info */
+    budgetDisable(s);
     s->som_set_now_offset = ~0ULL;
     s->deduper.current_report_offset = ~0ULL;
     s->deduper.som_log_dirty = 1; /* som logs have not been cleared */
@@ -184,7 +287,8 @@ int roseAdaptor_i(u64a offset, ReportID id, void *context, char is_simple,
     assert(isExternalReport(ri)); /* only external reports should reach here */
 
     s32 offset_adj = ri->offsetAdjust;
-    UNUSED u32 dkey = ri->dkey;
+    /* deduplication relies on matches arriving in order of offset */
+    UNUSED u32 dkey = ci->unordered ? MO_INVALID_IDX : ri->dkey;
     u64a to_offset = offset;
     u64a from_offset = 0;
     UNUSED u32 dkeyCount = rose->dkeyCount;
@@ -206,6 +310,12 @@ int roseAdaptor_i(u64a offset, ReportID id, void *context, char is_simple,
         return MO_HALT_MATCHING;
     }
 
+    /* each match is charged to the scan budget: for engines run without rose
+     * (sole outfix, small write) this is the only check */
+    if (unlikely(budgetTick(scratch, offset))) {
+        return MO_HALT_MATCHING;
+    }
+
     if (!is_simple && ri->hasBounds) {
         assert(ri->minOffset || ri->minLength || ri->maxOffset < MAX_OFFSET);
         assert(ri->minOffset <= ri->maxOffset);
@@ -302,6 +412,7 @@ int roseAdaptor_i(u64a offset, ReportID id, void *context, char is_simple,
     }
 #endif
 
+    profileMatch(scratch);
     halt = ci->userCallback((unsigned int)ri->onmatch, from_offset, to_offset,
                             flags, ci->userContext);
 #ifdef DEDUPE_MATCHES
@@ -318,6 +429,12 @@ exit:
 
     if (!is_simple && ri->ekey != END_EXHAUST) {
         markAsMatched(ci->exhaustionVector, ri->ekey);
+        if (unlikely(rose->anyMatch)) {
+            /* all patterns share this ekey, so nothing further can match */
+            DEBUG_PRINTF("any-match database, halting after first match\n");
+            ci->broken = BROKEN_EXHAUSTED;
+            return MO_HALT_MATCHING;
+        }
         return MO_CONTINUE_MATCHING;
     } else {
         return ROSE_CONTINUE_MATCHING_NO_EXHAUST;
@@ -348,6 +465,10 @@ int roseSomAdaptor_i(u64a from_offset, u64a to_offset, ReportID id,
         return MO_HALT_MATCHING;
     }
 
+    if (unlikely(budgetTick(scratch, to_offset))) {
+        return MO_HALT_MATCHING;
+    }
+
     if (!is_simple && ri->hasBounds) {
         assert(ri->minOffset || ri->minLength || ri->maxOffset < MAX_OFFSET);
         if (to_offset < ri->minOffset || to_offset > ri->maxOffset) {
@@ -448,6 +569,7 @@ int roseSomAdaptor_i(u64a from_offset, u64a to_offset, ReportID id,
     }
 #endif
 
+    profileMatch(scratch);
     halt = ci->userCallback((unsigned int)ri->onmatch, from_offset, to_offset,
                             flags, ci->userContext);
 
@@ -499,6 +621,10 @@ hwlmcb_rv_t hwlmAdaptor(UNUSED size_t start, size_t end, u32 direct_id,
     struct core_info *ci = &scratch->core_info;
     u64a real_end = (u64a)end + ci->buf_offset + 1;
 
+    if (budgetLiteral(scratch, real_end)) {
+        return HWLM_TERMINATE_MATCHING;
+    }
+
     if (isLiteralMDR(direct_id)) {
         return multiDirectAdaptor(real_end, direct_id, context, ci, 0, 0);
     }
@@ -524,6 +650,10 @@ hwlmcb_rv_t hwlmSimpleAdaptor(UNUSED size_t start, size_t end, u32 direct_id,
     struct core_info *ci = &scratch->core_info;
     u64a real_end = (u64a)end + ci->buf_offset + 1;
 
+    if (budgetLiteral(scratch, real_end)) {
+        return HWLM_TERMINATE_MATCHING;
+    }
+
     if (isLiteralMDR(direct_id)) {
         return multiDirectAdaptor(real_end, direct_id, context, ci, 1, 0);
     }
@@ -550,6 +680,10 @@ hwlmcb_rv_t hwlmSomAdaptor(UNUSED size_t start, size_t end, u32 direct_id,
     struct core_info *ci = &scratch->core_info;
     u64a real_end = (u64a)end + ci->buf_offset + 1;
 
+    if (budgetLiteral(scratch, real_end)) {
+        return HWLM_TERMINATE_MATCHING;
+    }
+
     if (isLiteralMDR(direct_id)) {
         return multiDirectAdaptor(real_end, direct_id, context, ci, 0, 1);
     }
@@ -575,6 +709,10 @@ hwlmcb_rv_t hwlmSimpleSomAdaptor(UNUSED size_t start, size_t end, u32 direct_id,
     struct core_info *ci = &scratch->core_info;
     u64a real_end = (u64a)end + ci->buf_offset + 1;
 
+    if (budgetLiteral(scratch, real_end)) {
+        return HWLM_TERMINATE_MATCHING;
+    }
+
     if (isLiteralMDR(direct_id)) {
         return multiDirectAdaptor(real_end, direct_id, context, ci, 1, 1);
     }
@@ -702,8 +840,10 @@ void pureLiteralBlockExec(const struct RoseEngine *rose,
     size_t length = scratch->core_info.len;
     DEBUG_PRINTF("rose engine %d\n", rose->runtimeImpl);
 
+    u64a prof_start = profileStart();
     hwlmExec(ftable, buffer, length, 0, selectHwlmAdaptor(rose), scratch,
              rose->initialGroups);
+    profileStage(scratch, HS_PROFILE_LITERAL_MATCHER, prof_start);
 }
 
 static really_inline
@@ -730,6 +870,30 @@ void initQueue(struct mq *q, u32 qi, const struct RoseEngine *t,
                  info->stateOffset, *(u32 *)q->state);
 }
 
+/** \brief True if the engine is a DFA that can be run by \ref dfaBlockExec. */
+static really_inline
+char isBlockDfaType(u8 t) {
+    return isMcClellanType(t) || isShengType(t) || isMcShengType(t);
+}
+
+/** \brief Run a McClellan, Sheng or McSheng DFA over a whole block. A DFA
+ * needs no queue or scratch state, so this is used in place of the queue
+ * machinery wherever the engine is known to be a DFA. */
+static really_inline
+void dfaBlockExec(const struct NFA *nfa, u64a offset, const u8 *buffer,
+                  size_t length, RoseCallback cb, void *context) {
+    assert(isBlockDfaType(nfa->type));
+    if (nfa->type == MCCLELLAN_NFA_8) {
+        nfaExecMcClellan8_B(nfa, offset, buffer, length, cb, context);
+    } else if (nfa->type == MCCLELLAN_NFA_16) {
+        nfaExecMcClellan16_B(nfa, offset, buffer, length, cb, context);
+    } else if (nfa->type == MCSHENG_NFA_16) {
+        nfaExecMcSheng16_B(nfa, offset, buffer, length, cb, context);
+    } else {
+        nfaExecSheng0_B(nfa, offset, buffer, length, cb, context);
+    }
+}
+
 static never_inline
 void soleOutfixBlockExec(const struct RoseEngine *t,
                          struct hs_scratch *scratch) {
@@ -750,6 +914,12 @@ void soleOutfixBlockExec(const struct RoseEngine *t,
         return;
     }
 
+    if (isBlockDfaType(nfa->type)) {
+        dfaBlockExec(nfa, 0, scratch->core_info.buf, scratch->core_info.len,
+                     selectAdaptor(t), scratch);
+        return;
+    }
+
     struct mq *q = scratch->queues;
     initQueue(q, 0, t, scratch);
     q->length = len; /* adjust for rev_accel */
@@ -789,53 +959,63 @@ void runSmallWriteEngine(const struct SmallWriteEngine *smwr,
     size_t local_alen = length - smwr->start_offset;
     const u8 *local_buffer = buffer + smwr->start_offset;
 
-    assert(isMcClellanType(nfa->type));
-    if (nfa->type == MCCLELLAN_NFA_8) {
-        nfaExecMcClellan8_B(nfa, smwr->start_offset, local_buffer,
-                            local_alen, selectAdaptor(rose), scratch);
-    } else {
-        nfaExecMcClellan16_B(nfa, smwr->start_offset, local_buffer,
-                             local_alen, selectAdaptor(rose), scratch);
-    }
+    dfaBlockExec(nfa, smwr->start_offset, local_buffer, local_alen,
+                 selectAdaptor(rose), scratch);
 }
 
-HS_PUBLIC_API
-hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
-                   unsigned flags, hs_scratch_t *scratch,
-                   match_event_handler onEvent, void *userCtx) {
-    if (unlikely(!scratch || !data)) {
-        return HS_INVALID;
-    }
+/** \brief Reset the per-block fields of core_info so that a scratch already
+ * populated by \ref populateCoreInfo can be reused for another block. */
+static really_inline
+void resetCoreInfoForBlock(struct hs_scratch *s, void *userCtx,
+                           const char *data, size_t length) {
+    s->core_info.userContext = userCtx;
+    s->core_info.broken = NOT_BROKEN;
+    s->core_info.buf = (const u8 *)data;
+    s->core_info.len = length;
 
-    hs_error_t err = validDatabase(db);
-    if (unlikely(err != HS_SUCCESS)) {
-        return err;
-    }
+    s->som_set_now_offset = ~0ULL;
+    s->deduper.current_report_offset = ~0ULL;
+    s->deduper.som_log_dirty = 1; /* som logs have not been cleared */
+}
 
-    const struct RoseEngine *rose = hs_get_bytecode(db);
-    if (unlikely(!ISALIGNED_16(rose))) {
-        return HS_INVALID;
+/** \brief Delivers the matches that wait on the end of a block, once the
+ * engines have scanned all of it. */
+static really_inline
+hs_error_t finishBlockScan(const struct RoseEngine *rose,
+                           struct hs_scratch *scratch) {
+    if (told_to_stop_matching(scratch)) {
+        return HS_SCAN_TERMINATED;
     }
 
-    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
-        return HS_DB_MODE_ERROR;
+    if (out_of_budget(scratch)) {
+        return HS_SCAN_BUDGET_EXCEEDED;
     }
 
-    if (unlikely(!validScratch(rose, scratch))) {
-        return HS_INVALID;
+    if (rose->hasSom) {
+        int halt = flushStoredSomMatches(scratch, ~0ULL);
+        if (halt) {
+            return HS_SCAN_TERMINATED;
+        }
     }
 
-    if (rose->minWidth > length) {
-        DEBUG_PRINTF("minwidth=%u > length=%u\n", rose->minWidth, length);
-        return HS_SUCCESS;
+    if (rose->boundary.reportEodOffset) {
+        processReportList(rose, rose->boundary.reportEodOffset,
+                          scratch->core_info.len, scratch);
     }
 
-    prefetch_data(data, length);
+    DEBUG_PRINTF("done. told_to_stop_matching=%d\n",
+                 told_to_stop_matching(scratch));
+    return told_to_stop_matching(scratch) ? HS_SCAN_TERMINATED : HS_SUCCESS;
+}
 
-    /* populate core info in scratch */
-    populateCoreInfo(scratch, rose, scratch->bstate, onEvent, userCtx, data,
-                     length, NULL, 0, 0, flags);
+/** \brief Scan a single block; core info must already be populated and the
+ * scan budget, if any, started. */
+static really_inline
+hs_error_t scanBlock(const struct RoseEngine *rose,
+                     struct hs_scratch *scratch) {
+    size_t length = scratch->core_info.len;
 
+    profileScan(scratch, length);
     clearEvec(scratch->core_info.exhaustionVector, rose);
 
     if (!length) {
@@ -851,7 +1031,7 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
     }
 
     if (rose->minWidthExcludingBoundaries > length) {
-        DEBUG_PRINTF("minWidthExcludingBoundaries=%u > length=%u\n",
+        DEBUG_PRINTF("minWidthExcludingBoundaries=%u > length=%zu\n",
                      rose->minWidthExcludingBoundaries, length);
         goto done_scan;
     }
@@ -860,7 +1040,7 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
     // of bi-anchored patterns).
     if (rose->maxBiAnchoredWidth != ROSE_BOUND_INF
         && length > rose->maxBiAnchoredWidth) {
-        DEBUG_PRINTF("block len=%u longer than maxBAWidth=%u\n", length,
+        DEBUG_PRINTF("block len=%zu longer than maxBAWidth=%u\n", length,
                      rose->maxBiAnchoredWidth);
         goto done_scan;
     }
@@ -873,7 +1053,7 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
         // Apply the small write engine if and only if the block (buffer) is
         // small enough. Otherwise, we allow rose &co to deal with it.
         if (length < smwr->largestBuffer) {
-            DEBUG_PRINTF("Attempting small write of block %u bytes long.\n",
+            DEBUG_PRINTF("Attempting small write of block %zu bytes long.\n",
                          length);
             runSmallWriteEngine(smwr, scratch);
             goto done_scan;
@@ -895,20 +1075,7 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
     }
 
 done_scan:
-    if (told_to_stop_matching(scratch)) {
-        return HS_SCAN_TERMINATED;
-    }
-
-    if (rose->hasSom) {
-        int halt = flushStoredSomMatches(scratch, ~0ULL);
-        if (halt) {
-            return HS_SCAN_TERMINATED;
-        }
-    }
-
-    if (rose->boundary.reportEodOffset) {
-        processReportList(rose, rose->boundary.reportEodOffset, length, scratch);
-    }
+    return finishBlockScan(rose, scratch);
 
 set_retval:
     DEBUG_PRINTF("done. told_to_stop_matching=%d\n",
@@ -916,126 +1083,773 @@ set_retval:
     return told_to_stop_matching(scratch) ? HS_SCAN_TERMINATED : HS_SUCCESS;
 }
 
+/** \brief Shared argument and database checks for the block mode entry
+ * points. On success, the bytecode is returned in \a rose_out. */
 static really_inline
-void maintainHistoryBuffer(const struct RoseEngine *rose, char *state,
-                           const char *buffer, size_t length) {
-    if (!rose->historyRequired) {
-        return;
+hs_error_t validBlockScan(const hs_database_t *db, const hs_scratch_t *scratch,
+                          const struct RoseEngine **rose_out) {
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
     }
 
-    // Hopefully few of our users are scanning no data.
-    if (unlikely(length == 0)) {
-        DEBUG_PRINTF("zero-byte scan\n");
-        return;
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
     }
 
-    char *his_state = state + rose->stateOffsets.history;
-
-    if (length < rose->historyRequired) {
-        size_t shortfall = rose->historyRequired - length;
-        memmove(his_state, his_state + rose->historyRequired - shortfall,
-                shortfall);
+    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
+        return HS_DB_MODE_ERROR;
     }
-    size_t amount = MIN(rose->historyRequired, length);
 
-    memcpy(his_state + rose->historyRequired - amount, buffer + length - amount,
-           amount);
-#ifdef DEBUG_HISTORY
-    printf("History [%u] : ", rose->historyRequired);
-    for (size_t i = 0; i < rose->historyRequired; i++) {
-        printf(" %02hhx", his_state[i]);
+    if (unlikely(!validScratch(rose, scratch))) {
+        return HS_INVALID;
     }
-    printf("\n");
-#endif
+
+    *rose_out = rose;
+    return HS_SUCCESS;
 }
 
-static really_inline
-void init_stream(struct hs_stream *s, const struct RoseEngine *rose) {
-    s->rose = rose;
-    s->offset = 0;
+HS_PUBLIC_API
+hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
+                   unsigned flags, hs_scratch_t *scratch,
+                   match_event_handler onEvent, void *userCtx) {
+    if (unlikely(!scratch || !data)) {
+        return HS_INVALID;
+    }
 
-    u8 *state = (u8 *)getMultiState(s);
+    const struct RoseEngine *rose = NULL;
+    hs_error_t err = validBlockScan(db, scratch, &rose);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
 
-    roseInitState(rose, state);
+    if (rose->minWidth > length) {
+        DEBUG_PRINTF("minwidth=%u > length=%u\n", rose->minWidth, length);
+        return HS_SUCCESS;
+    }
 
-    clearEvec((char *)state + rose->stateOffsets.exhausted, rose);
+    prefetch_data(data, length);
 
-    // SOM state multibit structures.
-    initSomState(rose, state);
+    /* populate core info in scratch */
+    populateCoreInfo(scratch, rose, scratch->bstate, onEvent, userCtx, data,
+                     length, NULL, 0, 0, flags);
+
+    budgetStart(scratch);
+    return scanBlock(rose, scratch);
 }
 
 HS_PUBLIC_API
-hs_error_t hs_open_stream(const hs_database_t *db, UNUSED unsigned flags,
-                          hs_stream_t **stream) {
-    if (unlikely(!stream)) {
+hs_error_t hs_scan_batch(const hs_database_t *db, const hs_block_t *blocks,
+                         unsigned int count, unsigned int flags,
+                         hs_scratch_t *scratch, match_event_handler onEvent) {
+    if (unlikely(!scratch || !blocks)) {
         return HS_INVALID;
     }
 
-    *stream = NULL;
-
-    hs_error_t err = validDatabase(db);
+    const struct RoseEngine *rose = NULL;
+    hs_error_t err = validBlockScan(db, scratch, &rose);
     if (unlikely(err != HS_SUCCESS)) {
         return err;
     }
 
-    const struct RoseEngine *rose = hs_get_bytecode(db);
-    if (unlikely(!ISALIGNED_16(rose))) {
-        return HS_INVALID;
+    /* Reject a bad batch before any block is scanned, so that no matches are
+     * delivered for a call that fails. */
+    for (u32 i = 0; i < count; i++) {
+        if (unlikely(!blocks[i].data)) {
+            DEBUG_PRINTF("block %u has no data\n", i);
+            return HS_INVALID;
+        }
     }
 
-    if (unlikely(rose->mode != HS_MODE_STREAM)) {
-        return HS_DB_MODE_ERROR;
-    }
+    /* The database, scratch and callback are shared by every block, so core
+     * info is populated once and only the per-block fields are reset. */
+    populateCoreInfo(scratch, rose, scratch->bstate, onEvent, NULL, NULL, 0,
+                     NULL, 0, 0, flags);
 
-    size_t stateSize = rose->stateOffsets.end;
-    struct hs_stream *s = hs_stream_alloc(sizeof(struct hs_stream) + stateSize);
-    if (unlikely(!s)) {
-        return HS_NOMEM;
+    if (count) {
+        prefetch_data(blocks[0].data, blocks[0].length);
     }
 
-    init_stream(s, rose);
-
-    *stream = s;
-    return HS_SUCCESS;
-}
+    hs_error_t rv = HS_SUCCESS;
+    for (u32 i = 0; i < count; i++) {
+        const hs_block_t *b = &blocks[i];
+        assert(b->data);
 
+        /* Pull in the next block while this one is being scanned. */
+        if (i + 1 < count) {
+            prefetch_data(b[1].data, b[1].length);
+        }
 
-static really_inline
-void rawEodExec(hs_stream_t *id, hs_scratch_t *scratch) {
-    const struct RoseEngine *rose = id->rose;
-    char *state = getMultiState(id);
-    u8 broken = getBroken(state);
+        if (rose->minWidth > b->length) {
+            DEBUG_PRINTF("block %u: minwidth=%u > length=%u\n", i,
+                         rose->minWidth, b->length);
+            continue;
+        }
 
-    if (broken) {
-        DEBUG_PRINTF("stream already broken\n");
-        assert(broken == BROKEN_FROM_USER || broken == BROKEN_EXHAUSTED);
-        return;
-    }
+        DEBUG_PRINTF("block %u/%u len=%u\n", i, count, b->length);
+        resetCoreInfoForBlock(scratch, b->context, b->data, b->length);
+        budgetStart(scratch);
 
-    if (isAllExhausted(rose, scratch->core_info.exhaustionVector)) {
-        DEBUG_PRINTF("stream exhausted\n");
-        return;
+        hs_error_t block_rv = scanBlock(rose, scratch);
+        if (block_rv != HS_SUCCESS && rv != HS_SCAN_TERMINATED) {
+            rv = block_rv;
+        }
     }
 
-    roseEodExec(rose, (u8 *)state, id->offset, scratch, selectAdaptor(rose),
-                selectSomAdaptor(rose), scratch);
+    return rv;
 }
 
-static never_inline
-void soleOutfixEodExec(hs_stream_t *id, hs_scratch_t *scratch) {
-    const struct RoseEngine *t = id->rose;
-    char *state = getMultiState(id);
-    u8 broken = getBroken(state);
-
-    if (broken) {
-        DEBUG_PRINTF("stream already broken\n");
-        assert(broken == BROKEN_FROM_USER || broken == BROKEN_EXHAUSTED);
-        return;
+HS_PUBLIC_API
+hs_error_t hs_scan_buffered(const hs_database_t *db, const char *data,
+                            unsigned length, unsigned flags,
+                            hs_scratch_t *scratch, match_batch_handler onBatch,
+                            void *context) {
+    if (unlikely(!scratch || !data || !onBatch)) {
+        return HS_INVALID;
     }
 
-    if (isAllExhausted(t, scratch->core_info.exhaustionVector)) {
-        DEBUG_PRINTF("stream exhausted\n");
-        return;
+    const struct RoseEngine *rose = NULL;
+    hs_error_t err = validBlockScan(db, scratch, &rose);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    if (rose->minWidth > length) {
+        DEBUG_PRINTF("minwidth=%u > length=%u\n", rose->minWidth, length);
+        return HS_SUCCESS;
+    }
+
+    prefetch_data(data, length);
+
+    initMatchBatch(scratch, onBatch, context);
+    populateCoreInfo(scratch, rose, scratch->bstate, batch_onEvent, scratch,
+                     data, length, NULL, 0, 0, flags);
+
+    budgetStart(scratch);
+    hs_error_t rv = scanBlock(rose, scratch);
+    if (flushMatchBatch(scratch)) {
+        rv = HS_SCAN_TERMINATED;
+    }
+    return rv;
+}
+
+/** \brief Fetch and check the bytecode for the counter query functions. */
+static really_inline
+hs_error_t counterBytecode(const hs_database_t *db,
+                           const struct RoseEngine **rose_out) {
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    *rose_out = rose;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_counter_size(const hs_database_t *db, unsigned int *count) {
+    if (!count) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose = NULL;
+    hs_error_t err = counterBytecode(db, &rose);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    *count = rose->exprIdCount;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_counter_index(const hs_database_t *db, unsigned int id,
+                            unsigned int *index) {
+    if (!index) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose = NULL;
+    hs_error_t err = counterBytecode(db, &rose);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    u32 idx = findCounterIndex(getExprIdTable(rose), rose->exprIdCount, id);
+    if (idx == rose->exprIdCount) {
+        return HS_INVALID;
+    }
+
+    *index = idx;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan_count(const hs_database_t *db, const char *data,
+                         unsigned length, unsigned flags,
+                         hs_scratch_t *scratch, unsigned long long *counts) {
+    if (unlikely(!scratch || !data || !counts)) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose = NULL;
+    hs_error_t err = validBlockScan(db, scratch, &rose);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    if (rose->minWidth > length) {
+        DEBUG_PRINTF("minwidth=%u > length=%u\n", rose->minWidth, length);
+        return HS_SUCCESS;
+    }
+
+    prefetch_data(data, length);
+
+    initMatchCounter(scratch, rose, counts);
+    populateCoreInfo(scratch, rose, scratch->bstate, count_onEvent, scratch,
+                     data, length, NULL, 0, 0, flags);
+
+    budgetStart(scratch);
+    return scanBlock(rose, scratch);
+}
+
+/** \brief Largest block mode state that \ref hs_scan_small will place on the
+ * stack. */
+#define SMALL_SCAN_MAX_STATE 512
+
+/** \brief Returns non-zero if the database can be scanned with the small
+ * on-stack context used by \ref hs_scan_small.
+ *
+ * This is the case for pure literal databases and for a sole outfix that is a
+ * DFA: neither needs engine queues, NFA state or the catchup machinery. SOM
+ * needs its own logs and is excluded, and the dedupe logs and state must fit
+ * in the small fixed-size buffers of the context. */
+static really_inline
+char smallScanSupported(const struct RoseEngine *rose) {
+    if (rose->hasSom) {
+        return 0;
+    }
+
+    if (rose->stateOffsets.end > SMALL_SCAN_MAX_STATE) {
+        DEBUG_PRINTF("state too large (%u bytes)\n", rose->stateOffsets.end);
+        return 0;
+    }
+
+    if (rose->dkeyCount > MIN_FAT_SIZE * 8) {
+        DEBUG_PRINTF("too many dkeys (%u)\n", rose->dkeyCount);
+        return 0;
+    }
+
+    switch (rose->runtimeImpl) {
+    case ROSE_RUNTIME_PURE_LITERAL:
+        return 1;
+    case ROSE_RUNTIME_SINGLE_OUTFIX:
+        return isBlockDfaType(getNfaByQueue(rose, 0)->type);
+    default:
+        return 0;
+    }
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan_small(const hs_database_t *db, const char *data,
+                         unsigned length, unsigned flags,
+                         match_event_handler onEvent, void *userCtx) {
+    if (unlikely(!data)) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    if (!smallScanSupported(rose)) {
+        return HS_SCRATCH_REQUIRED;
+    }
+
+    if (rose->minWidth > length) {
+        DEBUG_PRINTF("minwidth=%u > length=%u\n", rose->minWidth, length);
+        return HS_SUCCESS;
+    }
+
+    prefetch_data(data, length);
+
+    /* Only the scratch header is used: the core info, the broken flag and the
+     * dedupe logs, which all fit on the stack along with the block state. */
+    struct hs_scratch scratch;
+    char ALIGN_CL_DIRECTIVE state[SMALL_SCAN_MAX_STATE];
+    struct fatbit ALIGN_DIRECTIVE dedupe_log[2];
+
+    scratch.magic = SCRATCH_MAGIC;
+    scratch.bstate = state;
+    scratch.bStateSize = rose->stateOffsets.end;
+    scratch.queueCount = 0;
+    scratch.queues = NULL;
+    scratch.deduper.log[0] = &dedupe_log[0];
+    scratch.deduper.log[1] = &dedupe_log[1];
+    scratch.deduper.log_size = rose->dkeyCount;
+    memset(&scratch.budget, 0, sizeof(scratch.budget));
+    profileInit(&scratch);
+
+    populateCoreInfo(&scratch, rose, state, onEvent, userCtx, data, length,
+                     NULL, 0, 0, flags);
+
+    return scanBlock(rose, &scratch);
+}
+
+/** \brief A resumable block mode scan, see \ref hs_open_block_scan. */
+struct hs_block_scan {
+    const struct RoseEngine *rose;
+    struct hs_scratch *scratch;
+    u64a offset; /**< bytes of the block scanned so far */
+    hs_error_t status; /**< sticky result once matching has stopped */
+    char whole; /**< block is left to a single \ref scanBlock */
+    char started; /**< engines have been initialised for the block */
+    char outfix_alive; /**< sole outfix has not died */
+};
+
+/** \brief Returns non-zero if the block should be scanned a range at a time.
+ * Blocks that are handled by the small block or small write engines, or that
+ * cannot match by width, are quickly scanned in one go. */
+static really_inline
+char blockScanRanges(const struct RoseEngine *rose, size_t length) {
+    if (!length || rose->minWidthExcludingBoundaries > length
+        || rose->minWidth > length) {
+        return 0;
+    }
+
+    if (rose->maxBiAnchoredWidth != ROSE_BOUND_INF
+        && length > rose->maxBiAnchoredWidth) {
+        return 0;
+    }
+
+    if (rose->smallWriteOffset
+        && length < getSmallWrite(rose)->largestBuffer) {
+        return 0;
+    }
+
+    if (rose->runtimeImpl == ROSE_RUNTIME_FULL_ROSE
+        && length < ROSE_SMALL_BLOCK_LEN && rose->sbmatcherOffset) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Literal callback for a resumed range of a pure literal block scan: matches
+ * ending before the start of the range were handled with the previous range. */
+static
+hwlmcb_rv_t pureLiteralRangeAdaptor(size_t start, size_t end, u32 direct_id,
+                                    void *context) {
+    struct hs_scratch *scratch = context;
+    if (end < scratch->tctxt.range_start) {
+        return HWLM_CONTINUE_MATCHING;
+    }
+
+    HWLMCallback cb = selectHwlmAdaptor(scratch->core_info.rose);
+    return cb(start, end, direct_id, context);
+}
+
+static really_inline
+void pureLiteralBlockRange(const struct RoseEngine *rose,
+                           struct hs_scratch *scratch, size_t from,
+                           size_t to) {
+    const struct HWLM *ftable = getFLiteralMatcher(rose);
+    const u8 *buffer = scratch->core_info.buf;
+
+    size_t start = 0;
+    HWLMCallback cb = selectHwlmAdaptor(rose);
+    if (from) {
+        /* a literal ending in range may begin before it */
+        size_t lookback = hwlmMaxLength(ftable) - 1;
+        start = from > lookback ? from - lookback : 0;
+        scratch->tctxt.range_start = from;
+        cb = pureLiteralRangeAdaptor;
+    }
+
+    u64a prof_start = profileStart();
+    hwlmExec(ftable, buffer, to, start, cb, scratch, rose->initialGroups);
+    profileStage(scratch, HS_PROFILE_LITERAL_MATCHER, prof_start);
+}
+
+/** \brief Starts the sole outfix for a resumable scan. DFAs are run through
+ * the queue machinery here, as \ref dfaBlockExec cannot be resumed.
+ * Returns zero if the engine cannot match in this block. */
+static really_inline
+char soleOutfixBlockBegin(const struct RoseEngine *t,
+                          struct hs_scratch *scratch) {
+    const struct NFA *nfa = getNfaByQueue(t, 0);
+
+    size_t len = nfaRevAccelCheck(nfa, scratch->core_info.buf,
+                                  scratch->core_info.len);
+    if (!len) {
+        return 0;
+    }
+
+    struct mq *q = scratch->queues;
+    initQueue(q, 0, t, scratch);
+    q->length = len; /* adjust for rev_accel */
+    nfaQueueInitState(nfa, q);
+    pushQueueAt(q, 0, MQE_START, 0);
+    pushQueueAt(q, 1, MQE_TOP, 0);
+    return 1;
+}
+
+static really_inline
+char soleOutfixBlockRange(struct hs_scratch *scratch, size_t to) {
+    struct mq *q = scratch->queues;
+    pushQueueNoMerge(q, MQE_END, to);
+    if (!nfaQueueExec(q->nfa, q, to)) {
+        return 0;
+    }
+
+    q->cur = q->end = 0;
+    pushQueueAt(q, 0, MQE_START, to);
+    return 1;
+}
+
+static really_inline
+void soleOutfixBlockEnd(struct hs_scratch *scratch) {
+    struct mq *q = scratch->queues;
+    const struct NFA *nfa = q->nfa;
+    if (nfaAcceptsEod(nfa) && q->length == scratch->core_info.len) {
+        nfaCheckFinalState(nfa, q->state, q->streamState, q->length,
+                           q->cb, q->som_cb, scratch);
+    }
+}
+
+static
+void beginBlockScan(struct hs_block_scan *scan) {
+    const struct RoseEngine *rose = scan->rose;
+    struct hs_scratch *scratch = scan->scratch;
+
+    profileScan(scratch, scratch->core_info.len);
+    clearEvec(scratch->core_info.exhaustionVector, rose);
+
+    if (rose->boundary.reportZeroOffset) {
+        processReportList(rose, rose->boundary.reportZeroOffset, 0, scratch);
+    }
+
+    if (can_stop_matching(scratch)) {
+        return;
+    }
+
+    initSomState(rose, (u8 *)scratch->core_info.state);
+
+    switch (rose->runtimeImpl) {
+    default:
+        assert(0);
+    case ROSE_RUNTIME_FULL_ROSE:
+        roseBlockExecBegin(rose, scratch, selectAdaptor(rose),
+                           selectSomAdaptor(rose), scratch);
+        break;
+    case ROSE_RUNTIME_PURE_LITERAL:
+        break;
+    case ROSE_RUNTIME_SINGLE_OUTFIX:
+        scan->outfix_alive = soleOutfixBlockBegin(rose, scratch);
+        break;
+    }
+}
+
+static
+void scanBlockRange(struct hs_block_scan *scan, size_t from, size_t to) {
+    const struct RoseEngine *rose = scan->rose;
+    struct hs_scratch *scratch = scan->scratch;
+
+    DEBUG_PRINTF("range [%zu,%zu) of %zu\n", from, to, scratch->core_info.len);
+
+    if (can_stop_matching(scratch)) {
+        return;
+    }
+
+    switch (rose->runtimeImpl) {
+    default:
+        assert(0);
+    case ROSE_RUNTIME_FULL_ROSE:
+        roseBlockExecRange(rose, scratch, from, to);
+        break;
+    case ROSE_RUNTIME_PURE_LITERAL:
+        pureLiteralBlockRange(rose, scratch, from, to);
+        break;
+    case ROSE_RUNTIME_SINGLE_OUTFIX:
+        if (scan->outfix_alive) {
+            scan->outfix_alive = soleOutfixBlockRange(scratch, to);
+        }
+        break;
+    }
+}
+
+static
+hs_error_t endBlockScan(struct hs_block_scan *scan) {
+    const struct RoseEngine *rose = scan->rose;
+    struct hs_scratch *scratch = scan->scratch;
+
+    if (!can_stop_matching(scratch)) {
+        switch (rose->runtimeImpl) {
+        default:
+            assert(0);
+        case ROSE_RUNTIME_FULL_ROSE:
+            roseBlockExecEnd(rose, scratch);
+            roseBlockEod(rose, scratch);
+            break;
+        case ROSE_RUNTIME_PURE_LITERAL:
+            break;
+        case ROSE_RUNTIME_SINGLE_OUTFIX:
+            if (scan->outfix_alive) {
+                soleOutfixBlockEnd(scratch);
+            }
+            break;
+        }
+    }
+
+    return finishBlockScan(rose, scratch);
+}
+
+static
+hs_error_t advanceBlockScan(struct hs_block_scan *scan, u64a max_bytes) {
+    struct hs_scratch *scratch = scan->scratch;
+    const u64a length = scratch->core_info.len;
+
+    if (scan->status != HS_SUCCESS || !max_bytes) {
+        return scan->status;
+    }
+
+    if (scan->whole) {
+        if (scan->started) {
+            return HS_SUCCESS;
+        }
+        /* hs_scan() does nothing at all for blocks shorter than minWidth */
+        if (scan->rose->minWidth <= length) {
+            scan->status = scanBlock(scan->rose, scratch);
+        }
+        scan->started = 1;
+        scan->offset = length;
+        return scan->status;
+    }
+
+    u64a to = scan->offset + MIN(max_bytes, length - scan->offset);
+    if (to == scan->offset) {
+        return HS_SUCCESS;
+    }
+
+    if (!scan->started) {
+        beginBlockScan(scan);
+        scan->started = 1;
+    }
+
+    scanBlockRange(scan, scan->offset, to);
+    scan->offset = to;
+
+    if (told_to_stop_matching(scratch)) {
+        scan->status = HS_SCAN_TERMINATED;
+    }
+    return scan->status;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_open_block_scan(const hs_database_t *db, const char *data,
+                              unsigned long long length, unsigned flags,
+                              hs_scratch_t *scratch,
+                              match_event_handler onEvent, void *context,
+                              hs_block_scan_t **scan) {
+    if (unlikely(!scratch || !data || !scan)) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose = NULL;
+    hs_error_t err = validBlockScan(db, scratch, &rose);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    if (unlikely(length != (size_t)length)) {
+        DEBUG_PRINTF("length %llu not addressable\n", length);
+        return HS_INVALID;
+    }
+
+    struct hs_block_scan *s = hs_misc_alloc(sizeof(struct hs_block_scan));
+    if (!s) {
+        return HS_NOMEM;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->rose = rose;
+    s->scratch = scratch;
+    s->status = HS_SUCCESS;
+    s->whole = !blockScanRanges(rose, length);
+
+    populateCoreInfo(scratch, rose, scratch->bstate, onEvent, context, data,
+                     length, NULL, 0, 0, flags);
+
+    *scan = s;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_advance_block_scan(hs_block_scan_t *scan,
+                                 unsigned long long max_bytes,
+                                 unsigned long long *offset) {
+    if (unlikely(!scan)) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = advanceBlockScan(scan, max_bytes);
+    if (offset) {
+        *offset = scan->offset;
+    }
+    return err;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_finish_block_scan(hs_block_scan_t *scan) {
+    if (unlikely(!scan)) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = advanceBlockScan(scan, ~0ULL);
+    if (err == HS_SUCCESS && !scan->whole) {
+        err = endBlockScan(scan);
+    }
+
+    hs_misc_free(scan);
+    return err;
+}
+
+static really_inline
+void maintainHistoryBuffer(const struct RoseEngine *rose, char *state,
+                           const char *buffer, size_t length) {
+    if (!rose->historyRequired) {
+        return;
+    }
+
+    // Hopefully few of our users are scanning no data.
+    if (unlikely(length == 0)) {
+        DEBUG_PRINTF("zero-byte scan\n");
+        return;
+    }
+
+    char *his_state = state + rose->stateOffsets.history;
+
+    if (length < rose->historyRequired) {
+        size_t shortfall = rose->historyRequired - length;
+        memmove(his_state, his_state + rose->historyRequired - shortfall,
+                shortfall);
+    }
+    size_t amount = MIN(rose->historyRequired, length);
+
+    memcpy(his_state + rose->historyRequired - amount, buffer + length - amount,
+           amount);
+#ifdef DEBUG_HISTORY
+    printf("History [%u] : ", rose->historyRequired);
+    for (size_t i = 0; i < rose->historyRequired; i++) {
+        printf(" %02hhx", his_state[i]);
+    }
+    printf("\n");
+#endif
+}
+
+static really_inline
+void init_stream(struct hs_stream *s, const struct RoseEngine *rose) {
+    s->rose = rose;
+    s->offset = 0;
+
+    u8 *state = (u8 *)getMultiState(s);
+
+    roseInitState(rose, state);
+
+    clearEvec((char *)state + rose->stateOffsets.exhausted, rose);
+
+    // SOM state multibit structures.
+    initSomState(rose, state);
+}
+
+HS_PUBLIC_API
+hs_error_t hs_open_stream(const hs_database_t *db, UNUSED unsigned flags,
+                          hs_stream_t **stream) {
+    if (unlikely(!stream)) {
+        return HS_INVALID;
+    }
+
+    *stream = NULL;
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_STREAM)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    size_t stateSize = rose->stateOffsets.end;
+    struct hs_stream *s = hs_stream_alloc(sizeof(struct hs_stream) + stateSize);
+    if (unlikely(!s)) {
+        return HS_NOMEM;
+    }
+
+    init_stream(s, rose);
+
+    *stream = s;
+    return HS_SUCCESS;
+}
+
+
+static really_inline
+void rawEodExec(hs_stream_t *id, hs_scratch_t *scratch) {
+    const struct RoseEngine *rose = id->rose;
+    char *state = getMultiState(id);
+    u8 broken = getBroken(state);
+
+    if (broken) {
+        DEBUG_PRINTF("stream already broken\n");
+        assert(broken == BROKEN_FROM_USER || broken == BROKEN_EXHAUSTED);
+        return;
+    }
+
+    if (isAllExhausted(rose, scratch->core_info.exhaustionVector)) {
+        DEBUG_PRINTF("stream exhausted\n");
+        return;
+    }
+
+    roseEodExec(rose, (u8 *)state, id->offset, scratch, selectAdaptor(rose),
+                selectSomAdaptor(rose), scratch);
+}
+
+static never_inline
+void soleOutfixEodExec(hs_stream_t *id, hs_scratch_t *scratch) {
+    const struct RoseEngine *t = id->rose;
+    char *state = getMultiState(id);
+    u8 broken = getBroken(state);
+
+    if (broken) {
+        DEBUG_PRINTF("stream already broken\n");
+        assert(broken == BROKEN_FROM_USER || broken == BROKEN_EXHAUSTED);
+        return;
+    }
+
+    if (isAllExhausted(t, scratch->core_info.exhaustionVector)) {
+        DEBUG_PRINTF("stream exhausted\n");
+        return;
     }
 
     assert(t->outfixEndQueue == 1);
@@ -1108,72 +1922,158 @@ void report_eod_matches(hs_stream_t *id, hs_scratch_t *scratch,
         }
     }
 
-    if (rose->hasSom && !told_to_stop_matching(scratch)) {
-        int halt = flushStoredSomMatches(scratch, ~0ULL);
-        if (halt) {
-            DEBUG_PRINTF("told to stop matching\n");
-            scratch->core_info.broken = BROKEN_FROM_USER;
-            DEBUG_PRINTF("broken = %hhd\n", scratch->core_info.broken);
-        }
+    if (rose->hasSom && !told_to_stop_matching(scratch)) {
+        int halt = flushStoredSomMatches(scratch, ~0ULL);
+        if (halt) {
+            DEBUG_PRINTF("told to stop matching\n");
+            scratch->core_info.broken = BROKEN_FROM_USER;
+            DEBUG_PRINTF("broken = %hhd\n", scratch->core_info.broken);
+        }
+    }
+}
+
+HS_PUBLIC_API
+hs_error_t hs_copy_stream(hs_stream_t **to_id, const hs_stream_t *from_id) {
+    if (!to_id) {
+        return HS_INVALID;
+    }
+
+    *to_id = NULL;
+
+    if (!from_id || !from_id->rose) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose = from_id->rose;
+    size_t stateSize = sizeof(struct hs_stream) + rose->stateOffsets.end;
+
+    struct hs_stream *s = hs_stream_alloc(stateSize);
+    if (!s) {
+        return HS_NOMEM;
+    }
+
+    memcpy(s, from_id, stateSize);
+
+    *to_id = s;
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_reset_and_copy_stream(hs_stream_t *to_id,
+                                    const hs_stream_t *from_id,
+                                    hs_scratch_t *scratch,
+                                    match_event_handler onEvent,
+                                    void *context) {
+    if (!from_id || !from_id->rose) {
+        return HS_INVALID;
+    }
+
+    if (!to_id || to_id->rose != from_id->rose) {
+        return HS_INVALID;
+    }
+
+    if (to_id == from_id) {
+        return HS_INVALID;
+    }
+
+    if (onEvent) {
+        if (!scratch || !validScratch(to_id->rose, scratch)) {
+            return HS_INVALID;
+        }
+        report_eod_matches(to_id, scratch, onEvent, context);
+    }
+
+    size_t stateSize
+        = sizeof(struct hs_stream) + from_id->rose->stateOffsets.end;
+
+    memcpy(to_id, from_id, stateSize);
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_compress_stream(const hs_stream_t *stream, char *buf,
+                              size_t buf_space, size_t *used_space) {
+    if (unlikely(!stream || !stream->rose || !used_space)) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(!buf && buf_space)) {
+        return HS_INVALID;
+    }
+
+    size_t len = compressStream(stream, buf, buf_space);
+    *used_space = len;
+    if (len > buf_space) {
+        return HS_INSUFFICIENT_SPACE;
     }
+
+    return HS_SUCCESS;
 }
 
 HS_PUBLIC_API
-hs_error_t hs_copy_stream(hs_stream_t **to_id, const hs_stream_t *from_id) {
-    if (!to_id) {
+hs_error_t hs_expand_stream(const hs_database_t *db, hs_stream_t **stream,
+                            const char *buf, size_t buf_size) {
+    if (unlikely(!stream || !buf)) {
         return HS_INVALID;
     }
 
-    *to_id = NULL;
+    *stream = NULL;
 
-    if (!from_id || !from_id->rose) {
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
         return HS_INVALID;
     }
 
-    const struct RoseEngine *rose = from_id->rose;
-    size_t stateSize = sizeof(struct hs_stream) + rose->stateOffsets.end;
+    if (unlikely(rose->mode != HS_MODE_STREAM)) {
+        return HS_DB_MODE_ERROR;
+    }
 
-    struct hs_stream *s = hs_stream_alloc(stateSize);
-    if (!s) {
-        return HS_NOMEM;
+    if (!validStreamImage(rose, buf, buf_size)) {
+        return HS_INVALID;
     }
 
-    memcpy(s, from_id, stateSize);
+    size_t stateSize = rose->stateOffsets.end;
+    struct hs_stream *s = hs_stream_alloc(sizeof(struct hs_stream) + stateSize);
+    if (unlikely(!s)) {
+        return HS_NOMEM;
+    }
 
-    *to_id = s;
+    expandStream(s, rose, buf, buf_size);
+    *stream = s;
 
     return HS_SUCCESS;
 }
 
 HS_PUBLIC_API
-hs_error_t hs_reset_and_copy_stream(hs_stream_t *to_id,
-                                    const hs_stream_t *from_id,
-                                    hs_scratch_t *scratch,
-                                    match_event_handler onEvent,
-                                    void *context) {
-    if (!from_id || !from_id->rose) {
-        return HS_INVALID;
-    }
-
-    if (!to_id || to_id->rose != from_id->rose) {
+hs_error_t hs_reset_and_expand_stream(hs_stream_t *to_stream,
+                                      const char *buf, size_t buf_size,
+                                      hs_scratch_t *scratch,
+                                      match_event_handler onEvent,
+                                      void *context) {
+    if (unlikely(!to_stream || !to_stream->rose || !buf)) {
         return HS_INVALID;
     }
 
-    if (to_id == from_id) {
+    const struct RoseEngine *rose = to_stream->rose;
+    if (!validStreamImage(rose, buf, buf_size)) {
         return HS_INVALID;
     }
 
     if (onEvent) {
-        if (!scratch || !validScratch(to_id->rose, scratch)) {
+        if (!scratch || !validScratch(rose, scratch)) {
             return HS_INVALID;
         }
-        report_eod_matches(to_id, scratch, onEvent, context);
+        report_eod_matches(to_stream, scratch, onEvent, context);
     }
 
-    size_t stateSize
-        = sizeof(struct hs_stream) + from_id->rose->stateOffsets.end;
-
-    memcpy(to_id, from_id, stateSize);
+    expandStream(to_stream, rose, buf, buf_size);
 
     return HS_SUCCESS;
 }
@@ -1201,7 +2101,7 @@ void rawStreamExec(struct hs_stream *stream_state, struct hs_scratch *scratch) {
     roseStreamExec(rose, rose_state, scratch, selectAdaptor(rose),
                    selectSomAdaptor(rose), scratch);
 
-    if (!told_to_stop_matching(scratch) &&
+    if (!can_stop_matching(scratch) &&
         isAllExhausted(rose, scratch->core_info.exhaustionVector)) {
         DEBUG_PRINTF("stream exhausted\n");
         scratch->core_info.broken = BROKEN_EXHAUSTED;
@@ -1242,10 +2142,12 @@ void pureLiteralStreamExec(struct hs_stream *stream_state,
     // start the match region at zero.
     const size_t start = 0;
 
+    u64a prof_start = profileStart();
     hwlmExecStreaming(ftable, scratch, len2, start, selectHwlmAdaptor(rose),
                       scratch, rose->initialGroups, hwlm_stream_state);
+    profileStage(scratch, HS_PROFILE_LITERAL_MATCHER, prof_start);
 
-    if (!told_to_stop_matching(scratch) &&
+    if (!can_stop_matching(scratch) &&
         isAllExhausted(rose, scratch->core_info.exhaustionVector)) {
         DEBUG_PRINTF("stream exhausted\n");
         scratch->core_info.broken = BROKEN_EXHAUSTED;
@@ -1282,14 +2184,14 @@ void soleOutfixStreamExec(struct hs_stream *stream_state,
 
     if (nfaQueueExec(q->nfa, q, scratch->core_info.len)) {
         nfaQueueCompressState(nfa, q, scratch->core_info.len);
-    } else if (!told_to_stop_matching(scratch)) {
+    } else if (!can_stop_matching(scratch)) {
         scratch->core_info.broken = BROKEN_EXHAUSTED;
     }
 }
 
 static inline
 hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
-                                   unsigned length, UNUSED unsigned flags,
+                                   unsigned length, unsigned flags,
                                    hs_scratch_t *scratch,
                                    match_event_handler onEvent, void *context) {
     if (unlikely(!id || !scratch || !data || !validScratch(id->rose, scratch))) {
@@ -1325,6 +2227,8 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
                      id->offset, flags);
     assert(scratch->core_info.hlen <= id->offset
            && scratch->core_info.hlen <= rose->historyRequired);
+    profileScan(scratch, length);
+    budgetStart(scratch);
 
     prefetch_data(data, length);
 
@@ -1350,6 +2254,18 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
         soleOutfixStreamExec(id, scratch);
     }
 
+    if (unlikely(out_of_budget(scratch))) {
+        /* The engines were abandoned part-way through this write, so their
+         * state is not usable. Restart them at the end of the write, keeping
+         * the history and exhaustion state, so that the stream can go on. */
+        u64a end = id->offset + length;
+        roseResetState(rose, (u8 *)state, end, (u8)data[length - 1]);
+        initSomState(rose, (u8 *)state);
+        maintainHistoryBuffer(rose, state, data, length);
+        id->offset = end;
+        return HS_SCAN_BUDGET_EXCEEDED;
+    }
+
     if (rose->hasSom && !told_to_stop_matching(scratch)) {
         int halt = flushStoredSomMatches(scratch, ~0ULL);
         if (halt) {
@@ -1382,6 +2298,75 @@ hs_error_t hs_scan_stream(hs_stream_t *id, const char *data, unsigned length,
                                        onEvent, context);
 }
 
+/** \brief Maximum number of cache lines of stream state that \ref
+ * hs_scan_streams will prefetch ahead of scanning a stream. */
+#define STREAM_PREFETCH_LINES 16
+
+/** \brief Prefetch the start of a stream's state, if the stream handle passes
+ * the same checks that \ref hs_scan_stream_internal will apply to it; we must
+ * not follow a bad or stale handle to its Rose engine and state. */
+static really_inline
+void prefetch_stream_state(const struct hs_stream *id,
+                           const struct hs_scratch *scratch) {
+    if (!id || !validScratch(id->rose, scratch)) {
+        return;
+    }
+    const struct RoseEngine *rose = id->rose;
+    const char *state = getMultiStateConst(id);
+    u32 len = MIN(rose->stateOffsets.end, STREAM_PREFETCH_LINES * 64);
+    for (u32 i = 0; i < len; i += 64) {
+        __builtin_prefetch(state + i);
+    }
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan_streams(const hs_stream_block_t *blocks, unsigned int count,
+                           unsigned int flags, hs_scratch_t *scratch,
+                           match_event_handler onEvent) {
+    if (unlikely(!blocks || !scratch)) {
+        return HS_INVALID;
+    }
+
+    /* The writes are software pipelined: the hs_stream header for write i + 2
+     * is fetched first, as we need it to validate the handle and locate the
+     * stream state; once write i + 1's handle has been checked, its stream
+     * state and data are fetched while write i is scanned. */
+    for (u32 i = 0; i < MIN(count, 2); i++) {
+        __builtin_prefetch(blocks[i].id);
+    }
+    if (count) {
+        prefetch_stream_state(blocks[0].id, scratch);
+    }
+
+    hs_error_t rv = HS_SUCCESS;
+    for (u32 i = 0; i < count; i++) {
+        const hs_stream_block_t *b = &blocks[i];
+
+        if (i + 2 < count) {
+            __builtin_prefetch(b[2].id);
+        }
+        if (i + 1 < count) {
+            prefetch_stream_state(b[1].id, scratch);
+            prefetch_data(b[1].data, b[1].length);
+        }
+
+        DEBUG_PRINTF("write %u/%u stream=%p len=%u\n", i, count, b->id,
+                     b->length);
+        hs_error_t err = hs_scan_stream_internal(b->id, b->data, b->length,
+                                                 flags, scratch, onEvent,
+                                                 b->context);
+        if (err == HS_SCAN_TERMINATED || err == HS_SCAN_BUDGET_EXCEEDED) {
+            if (rv != HS_SCAN_TERMINATED) {
+                rv = err;
+            }
+        } else if (unlikely(err != HS_SUCCESS)) {
+            return err;
+        }
+    }
+
+    return rv;
+}
+
 HS_PUBLIC_API
 hs_error_t hs_close_stream(hs_stream_t *id, hs_scratch_t *scratch,
                            match_event_handler onEvent, void *context) {
@@ -1401,6 +2386,75 @@ hs_error_t hs_close_stream(hs_stream_t *id, hs_scratch_t *scratch,
     return HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t hs_scan_stream_buffered(hs_stream_t *id, const char *data,
+                                   unsigned length, unsigned flags,
+                                   hs_scratch_t *scratch,
+                                   match_batch_handler onBatch, void *context) {
+    if (unlikely(!id || !scratch || !onBatch
+                 || !validScratch(id->rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    initMatchBatch(scratch, onBatch, context);
+    hs_error_t rv = hs_scan_stream_internal(id, data, length, flags, scratch,
+                                            batch_onEvent, scratch);
+    if (flushMatchBatch(scratch)) {
+        /* matches from this write were only seen by the user now, so the
+         * stream is terminated here rather than during the scan */
+        setBroken(getMultiState(id), BROKEN_FROM_USER);
+        rv = HS_SCAN_TERMINATED;
+    }
+    return rv;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_close_stream_buffered(hs_stream_t *id, hs_scratch_t *scratch,
+                                    match_batch_handler onBatch,
+                                    void *context) {
+    if (!id || !scratch || !onBatch || !validScratch(id->rose, scratch)) {
+        return HS_INVALID;
+    }
+
+    initMatchBatch(scratch, onBatch, context);
+    report_eod_matches(id, scratch, batch_onEvent, scratch);
+    flushMatchBatch(scratch);
+
+    hs_stream_free(id);
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan_stream_count(hs_stream_t *id, const char *data,
+                                unsigned length, unsigned flags,
+                                hs_scratch_t *scratch,
+                                unsigned long long *counts) {
+    if (unlikely(!id || !scratch || !counts
+                 || !validScratch(id->rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    initMatchCounter(scratch, id->rose, counts);
+    return hs_scan_stream_internal(id, data, length, flags, scratch,
+                                   count_onEvent, scratch);
+}
+
+HS_PUBLIC_API
+hs_error_t hs_close_stream_count(hs_stream_t *id, hs_scratch_t *scratch,
+                                 unsigned long long *counts) {
+    if (!id || !scratch || !counts || !validScratch(id->rose, scratch)) {
+        return HS_INVALID;
+    }
+
+    initMatchCounter(scratch, id->rose, counts);
+    report_eod_matches(id, scratch, count_onEvent, scratch);
+
+    hs_stream_free(id);
+
+    return HS_SUCCESS;
+}
+
 HS_PUBLIC_API
 hs_error_t hs_reset_stream(hs_stream_t *id, UNUSED unsigned int flags,
                            hs_scratch_t *scratch, match_event_handler onEvent,
@@ -1421,6 +2475,212 @@ hs_error_t hs_reset_stream(hs_stream_t *id, UNUSED unsigned int flags,
     return HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t hs_open_stream_at(const hs_database_t *db, UNUSED unsigned flags,
+                             void *buf, size_t buf_size,
+                             hs_stream_t **stream) {
+    if (unlikely(!stream)) {
+        return HS_INVALID;
+    }
+
+    *stream = NULL;
+
+    if (unlikely(!buf)) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(!ISALIGNED_N(buf, 8))) {
+        return HS_BAD_ALIGN;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_STREAM)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    if (buf_size < sizeof(struct hs_stream) + rose->stateOffsets.end) {
+        return HS_INSUFFICIENT_SPACE;
+    }
+
+    struct hs_stream *s = buf;
+    init_stream(s, rose);
+
+    *stream = s;
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_close_stream_at(hs_stream_t *id, hs_scratch_t *scratch,
+                              match_event_handler onEvent, void *context) {
+    if (!id || !id->rose) {
+        return HS_INVALID;
+    }
+
+    if (onEvent) {
+        if (!scratch || !validScratch(id->rose, scratch)) {
+            return HS_INVALID;
+        }
+        report_eod_matches(id, scratch, onEvent, context);
+    }
+
+    id->rose = NULL; /* closed */
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_alloc_stream_pool(const hs_database_t *db, unsigned int count,
+                                hs_stream_pool_t **pool) {
+    if (!pool) {
+        return HS_INVALID;
+    }
+
+    *pool = NULL;
+
+    if (!count) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (!ISALIGNED_16(rose)) {
+        return HS_INVALID;
+    }
+
+    if (rose->mode != HS_MODE_STREAM) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    size_t slot_size = ROUNDUP_CL(sizeof(struct hs_stream)
+                                  + rose->stateOffsets.end);
+    size_t header_size = sizeof(struct hs_stream_pool) + count * sizeof(u32);
+    if ((SIZE_MAX - header_size - 64) / slot_size < count) {
+        return HS_NOMEM;
+    }
+
+    /* header and links, padding for cacheline alignment, then slots */
+    size_t alloc_size = header_size + 64 + count * slot_size;
+    char *mem = hs_stream_alloc(alloc_size);
+    err = hs_check_alloc(mem);
+    if (err != HS_SUCCESS) {
+        hs_stream_free(mem);
+        return err;
+    }
+
+    struct hs_stream_pool *p = (struct hs_stream_pool *)mem;
+    p->magic = STREAM_POOL_MAGIC;
+    p->count = count;
+    p->slot_size = slot_size;
+    p->rose = rose;
+    p->next = (u32 *)(mem + sizeof(struct hs_stream_pool));
+    p->slots = ROUNDUP_PTR(mem + header_size, 64);
+    p->pool_alloc = mem;
+
+    for (u32 i = 0; i < count; i++) {
+        p->next[i] = i + 1 < count ? i + 1 : STREAM_POOL_END;
+        struct hs_stream *s = (struct hs_stream *)(p->slots + i * slot_size);
+        s->rose = NULL;
+    }
+    p->free_head = 0;
+
+    *pool = p;
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_free_stream_pool(hs_stream_pool_t *pool) {
+    if (!pool) {
+        return HS_SUCCESS;
+    }
+
+    if (pool->magic != STREAM_POOL_MAGIC) {
+        return HS_INVALID;
+    }
+
+    pool->magic = 0;
+    hs_stream_free(pool->pool_alloc);
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_open_stream_pooled(hs_stream_pool_t *pool, UNUSED unsigned flags,
+                                 hs_stream_t **stream) {
+    if (unlikely(!stream)) {
+        return HS_INVALID;
+    }
+
+    *stream = NULL;
+
+    if (unlikely(!pool || pool->magic != STREAM_POOL_MAGIC)) {
+        return HS_INVALID;
+    }
+
+    u32 slot = pool->free_head;
+    if (slot == STREAM_POOL_END) {
+        return HS_NOMEM;
+    }
+    pool->free_head = pool->next[slot];
+
+    struct hs_stream *s = (struct hs_stream *)(pool->slots
+                                               + slot * pool->slot_size);
+    assert(!s->rose);
+    init_stream(s, pool->rose);
+
+    *stream = s;
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_close_stream_pooled(hs_stream_pool_t *pool, hs_stream_t *id,
+                                  hs_scratch_t *scratch,
+                                  match_event_handler onEvent, void *context) {
+    if (unlikely(!pool || pool->magic != STREAM_POOL_MAGIC || !id)) {
+        return HS_INVALID;
+    }
+
+    /* the stream must be an open stream in one of our slots */
+    const char *slots = pool->slots;
+    const char *p = (const char *)id;
+    if (p < slots || p >= slots + (size_t)pool->count * pool->slot_size) {
+        return HS_INVALID;
+    }
+    size_t delta = (size_t)(p - slots);
+    if (delta % pool->slot_size || id->rose != pool->rose) {
+        return HS_INVALID;
+    }
+
+    if (onEvent) {
+        if (!scratch || !validScratch(id->rose, scratch)) {
+            return HS_INVALID;
+        }
+        report_eod_matches(id, scratch, onEvent, context);
+    }
+
+    u32 slot = (u32)(delta / pool->slot_size);
+    id->rose = NULL;
+    pool->next[slot] = pool->free_head;
+    pool->free_head = slot;
+
+    return HS_SUCCESS;
+}
+
 HS_PUBLIC_API
 hs_error_t hs_stream_size(const hs_database_t *db, size_t *stream_size) {
     if (!stream_size) {
@@ -1471,7 +2731,7 @@ void dumpData(const char *data, size_t len) {
 HS_PUBLIC_API
 hs_error_t hs_scan_vector(const hs_database_t *db, const char * const * data,
                           const unsigned int *length, unsigned int count,
-                          UNUSED unsigned int flags, hs_scratch_t *scratch,
+                          unsigned int flags, hs_scratch_t *scratch,
                           match_event_handler onEvent, void *context) {
     if (unlikely(!scratch || !data || !length)) {
         return HS_INVALID;
@@ -1506,7 +2766,7 @@ hs_error_t hs_scan_vector(const hs_database_t *db, const char * const * data,
         dumpData(data[i], length[i]);
 #endif
         hs_error_t ret
-            = hs_scan_stream_internal(id, data[i], length[i], 0, scratch,
+            = hs_scan_stream_internal(id, data[i], length[i], flags, scratch,
                                       onEvent, context);
         if (ret != HS_SUCCESS) {
             return ret;
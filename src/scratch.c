@@ -36,6 +36,7 @@
 #include "allocator.h"
 #include "hs_internal.h"
 #include "hs_runtime.h"
+#include "profile.h"
 #include "scratch.h"
 #include "state.h"
 #include "ue2common.h"
@@ -84,7 +85,13 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
 
     size_t delay_size = mmbit_size(proto->delay_count) * DELAY_SLOT_COUNT;
 
-    size_t nfa_context_size = 2 * sizeof(struct NFAContext512) + 127;
+    size_t nfa_context_size = 2 * sizeof(struct NFAContext1024) + 127;
+
+#ifdef ENABLE_PROFILING
+    size_t prof_size = (queueCount + proto->prof.literalCount) * sizeof(u64a);
+#else
+    size_t prof_size = 0;
+#endif
 
     // the size is all the allocated stuff, not including the struct itself
     size_t size = queue_size + 63
@@ -102,7 +109,9 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
                   + som_now_size
                   + som_attempted_size
                   + som_attempted_store_size
-                  + proto->sideScratchSize + 15;
+                  + proto->sideScratchSize + 15
+                  + MATCH_BATCH_SIZE * sizeof(hs_match_t) + 7
+                  + prof_size;
 
     /* the struct plus the allocated stuff plus padding for cacheline
      * alignment */
@@ -176,11 +185,11 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     current = ROUNDUP_PTR(current, 64);
     assert(ISALIGNED_CL(current));
     s->nfaContext = current;
-    current += sizeof(struct NFAContext512);
+    current += sizeof(struct NFAContext1024);
     current = ROUNDUP_PTR(current, 64);
     assert(ISALIGNED_CL(current));
     s->nfaContextSom = current;
-    current += sizeof(struct NFAContext512);
+    current += sizeof(struct NFAContext1024);
 
     assert(ISALIGNED_N(current, 8));
     s->deduper.som_start_log[0] = (u64a *)current;
@@ -218,6 +227,20 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     s->side_scratch = (void *)current;
     current += proto->sideScratchSize;
 
+    current = ROUNDUP_PTR(current, 8);
+    s->batch.matches = (hs_match_t *)current;
+    current += MATCH_BATCH_SIZE * sizeof(hs_match_t);
+
+#ifdef ENABLE_PROFILING
+    /* counters start from zero in every newly allocated scratch */
+    current = ROUNDUP_PTR(current, 8);
+    s->prof.queue_calls = (u64a *)current;
+    current += queueCount * sizeof(u64a);
+    s->prof.literal_hits = (u64a *)current;
+    current += s->prof.literalCount * sizeof(u64a);
+    profileClear(s);
+#endif
+
     current = ROUNDUP_PTR(current, 64);
     assert(ISALIGNED_CL(current));
     s->fullState = (char *)current;
@@ -370,6 +393,13 @@ hs_error_t hs_alloc_scratch(const hs_database_t *db, hs_scratch_t **scratch) {
         proto->deduper.log_size = rose->dkeyCount;
     }
 
+#ifdef ENABLE_PROFILING
+    if (rose->literalCount > proto->prof.literalCount) {
+        resize = 1;
+        proto->prof.literalCount = rose->literalCount;
+    }
+#endif
+
     if (resize) {
         if (*scratch) {
             hs_scratch_free((*scratch)->scratch_alloc);
@@ -435,3 +465,76 @@ hs_error_t hs_scratch_size(const hs_scratch_t *scratch, size_t *size) {
 
     return HS_SUCCESS;
 }
+
+HS_PUBLIC_API
+hs_error_t hs_scratch_profile(const hs_scratch_t *scratch,
+                              hs_profile_t *profile) {
+    if (!profile || !scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+
+#ifdef ENABLE_PROFILING
+    const struct scratch_profile *p = &scratch->prof;
+    profile->scans = p->scans;
+    profile->bytes = p->bytes;
+    profile->matches = p->matches;
+    for (u32 i = 0; i < PROF_STAGE_COUNT; i++) {
+        profile->stages[i].calls = p->stage_calls[i];
+        profile->stages[i].cycles = p->stage_cycles[i];
+    }
+    profile->queue_count = scratch->queueCount;
+    profile->queue_calls = p->queue_calls;
+    profile->literal_count = p->literalCount;
+    profile->literal_hits = p->literal_hits;
+    return HS_SUCCESS;
+#else
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_reset_scratch_profile(hs_scratch_t *scratch) {
+    if (!scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+
+#ifdef ENABLE_PROFILING
+    profileClear(scratch);
+    return HS_SUCCESS;
+#else
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_set_scratch_budget(hs_scratch_t *scratch,
+                                 const hs_scan_budget_t *budget) {
+    if (!scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+
+    if (budget) {
+        scratch->budget.max_literals = budget->max_literal_matches;
+        scratch->budget.max_cycles = budget->max_cycles;
+    } else {
+        scratch->budget.max_literals = 0;
+        scratch->budget.max_cycles = 0;
+    }
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scratch_budget_offset(const hs_scratch_t *scratch,
+                                    unsigned long long *offset) {
+    if (!offset || !scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+
+    *offset = scratch->budget.offset;
+    return HS_SUCCESS;
+}
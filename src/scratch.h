@@ -84,6 +84,10 @@ struct catchup_pq {
  * raised (i.e. all its exhaustion keys are on.) */
 #define BROKEN_EXHAUSTED 2
 
+/** \brief Value indicating that the current scan has exceeded its work
+ * budget. Unlike the other values, this is never stored in stream state. */
+#define BROKEN_BUDGET    3
+
 /** \brief Core information about the current scan, used everywhere. */
 struct core_info {
     void *userContext; /**< user-supplied context */
@@ -96,6 +100,8 @@ struct core_info {
     char *state; /**< full stream state */
     char *exhaustionVector; /**< pointer to evec for this stream */
     char broken;  /**< user told us to stop, or exhausted */
+    char unordered; /**< matches may be reported out of order, see
+                     * \ref HS_SCAN_FLAG_UNORDERED */
     const u8 *buf; /**< main scan buffer */
     size_t len; /**< length of main scan buffer in bytes */
     const u8 *hbuf; /**< history buffer */
@@ -134,6 +140,9 @@ struct RoseContext {
     u64a side_curr; /**< current location of the sidecar scan (abs offset) */
     u32 curr_qi;    /**< currently executing main queue index during
                      * \ref nfaQueueExec */
+    u64a range_start; /**< literal matches ending before this index were
+                       * handled by an earlier range of a resumable block
+                       * scan */
 };
 
 struct match_deduper {
@@ -145,6 +154,64 @@ struct match_deduper {
     u8 som_log_dirty;
 };
 
+/** \brief Number of matches held in scratch by the buffered scan functions
+ * before they are handed to the user's batch handler. */
+#define MATCH_BATCH_SIZE 128
+
+struct hs_match;
+
+/** \brief Match buffer used for batched delivery, see \ref hs_scan_buffered.
+ *
+ * While a buffered scan is running, core_info.userCallback appends to this
+ * buffer rather than calling out to the user. */
+struct match_batch {
+    /** \brief user-supplied batch handler */
+    int (*handler)(const struct hs_match *matches, unsigned int count,
+                   void *ctx);
+    void *context; /**< user-supplied context for the handler */
+    struct hs_match *matches; /**< MATCH_BATCH_SIZE entries */
+    u32 count; /**< number of matches currently buffered */
+};
+
+/** \brief Per-expression match counters, see \ref hs_scan_count.
+ *
+ * While a counting scan is running, core_info.userCallback increments the
+ * counter for each match rather than calling out to the user. */
+struct match_counter {
+    unsigned long long *counts; /**< user-supplied counter array */
+    const u32 *ids; /**< sorted external ids; index is the counter index */
+    u32 idCount; /**< number of entries in ids */
+};
+
+/** \brief Work budget for a single scan, see budget.h. */
+struct scan_budget {
+    u64a max_literals; /**< literal match limit per scan, 0 if unlimited */
+    u64a max_cycles; /**< cycle limit per scan, 0 if unlimited */
+    u64a literal_limit; /**< literal match limit for the current scan */
+    u64a literals; /**< literal matches in the current scan */
+    u64a deadline; /**< timestamp counter deadline, 0 if none */
+    u64a offset; /**< offset reached when the budget was exceeded */
+    u32 ticks; /**< events since the deadline was last checked */
+};
+
+#ifdef ENABLE_PROFILING
+/** \brief Number of scan stages timed by the profiling counters; see the
+ * HS_PROFILE_* stage constants in hs_runtime.h. */
+#define PROF_STAGE_COUNT 5
+
+/** \brief Runtime profiling counters, see profile.h. */
+struct scratch_profile {
+    u64a scans; /**< blocks and stream writes scanned */
+    u64a bytes; /**< bytes scanned */
+    u64a matches; /**< matches delivered to the user callback */
+    u64a stage_calls[PROF_STAGE_COUNT]; /**< entries into each stage */
+    u64a stage_cycles[PROF_STAGE_COUNT]; /**< cycles spent in each stage */
+    u64a *queue_calls; /**< engine invocations, indexed by queue */
+    u64a *literal_hits; /**< Rose literal matches, indexed by literal id */
+    u32 literalCount; /**< number of entries in literal_hits */
+};
+#endif
+
 /** \brief Hyperscan scratch region header.
  *
  * NOTE: there is no requirement that scratch is 16-byte aligned, as it is
@@ -198,6 +265,12 @@ struct ALIGN_CL_DIRECTIVE hs_scratch {
     struct mmbit_sparse_state sparse_iter_state[MAX_SPARSE_ITER_STATES];
     union sidecar_enabled_any ALIGN_CL_DIRECTIVE side_enabled;
     struct sidecar_scratch *side_scratch;
+    struct match_batch batch; /**< buffer for batched match delivery */
+    struct match_counter counter; /**< counters for counting scans */
+    struct scan_budget budget; /**< work limits for each scan */
+#ifdef ENABLE_PROFILING
+    struct scratch_profile prof;
+#endif
 };
 
 static really_inline
@@ -227,6 +300,11 @@ char told_to_stop_matching(const struct hs_scratch *scratch) {
     return scratch->core_info.broken == BROKEN_FROM_USER;
 }
 
+static really_inline
+char out_of_budget(const struct hs_scratch *scratch) {
+    return scratch->core_info.broken == BROKEN_BUDGET;
+}
+
 static really_inline
 char can_stop_matching(const struct hs_scratch *scratch) {
     return scratch->core_info.broken != NOT_BROKEN;
@@ -123,7 +123,7 @@ void SmallWriteBuildImpl::add(const NGWrapper &w) {
 
     // Now we can actually build the McClellan DFA
     assert(h->kind == NFA_OUTFIX);
-    auto r = buildMcClellan(*h, &rm, cc.grey);
+    auto r = buildMcClellan(*h, &rm, cc);
 
     // If we couldn't build a McClellan DFA for this portion, we won't be able
     // build a smwr which represents the pattern set
@@ -192,7 +192,7 @@ bool SmallWriteBuildImpl::determiniseLiterals() {
         NGHolder h;
         DEBUG_PRINTF("determinising %s\n", dumpString(cand.first).c_str());
         lit_to_graph(&h, cand.first, cand.second);
-        temp_dfas.push_back(buildMcClellan(h, &rm, cc.grey));
+        temp_dfas.push_back(buildMcClellan(h, &rm, cc));
 
         // If we couldn't build a McClellan DFA for this portion, then we
         // can't SmallWrite optimize the entire graph, so we can't
@@ -39,6 +39,7 @@
  */
 
 #include "hs_internal.h"
+#include "profile.h"
 #include "som_runtime.h"
 #include "scratch.h"
 #include "ue2common.h"
@@ -177,8 +178,10 @@ void setSomLocRevNfa(struct hs_scratch *scratch, struct fatbit *som_set_now,
     DEBUG_PRINTF("som_store[%u] set to %llu\n", som_loc, som_store[som_loc]);
 }
 
-void handleSomInternal(struct hs_scratch *scratch,
-                       const struct internal_report *ri, const u64a to_offset) {
+static really_inline
+void handleSomInternal_i(struct hs_scratch *scratch,
+                         const struct internal_report *ri,
+                         const u64a to_offset) {
     assert(scratch);
     assert(ri);
     DEBUG_PRINTF("-->som action required at %llu\n", to_offset);
@@ -352,10 +355,17 @@ void handleSomInternal(struct hs_scratch *scratch,
     return;
 }
 
-// Returns the SOM offset.
-u64a handleSomExternal(struct hs_scratch *scratch,
-                       const struct internal_report *ri,
-                       const u64a to_offset) {
+void handleSomInternal(struct hs_scratch *scratch,
+                       const struct internal_report *ri, const u64a to_offset) {
+    u64a prof_start = profileStart();
+    handleSomInternal_i(scratch, ri, to_offset);
+    profileStage(scratch, HS_PROFILE_SOM, prof_start);
+}
+
+static really_inline
+u64a handleSomExternal_i(struct hs_scratch *scratch,
+                         const struct internal_report *ri,
+                         const u64a to_offset) {
     assert(scratch);
     assert(ri);
 
@@ -407,6 +417,16 @@ u64a handleSomExternal(struct hs_scratch *scratch,
     return 0;
 }
 
+// Returns the SOM offset.
+u64a handleSomExternal(struct hs_scratch *scratch,
+                       const struct internal_report *ri,
+                       const u64a to_offset) {
+    u64a prof_start = profileStart();
+    u64a som = handleSomExternal_i(scratch, ri, to_offset);
+    profileStage(scratch, HS_PROFILE_SOM, prof_start);
+    return som;
+}
+
 void setSomFromSomAware(struct hs_scratch *scratch,
                         const struct internal_report *ri, u64a from_offset,
                         u64a to_offset) {
@@ -484,6 +504,7 @@ int clearSomLog(struct hs_scratch *scratch, u64a offset, struct fatbit *log,
              it != MMB_INVALID; it = fatbit_iterate(log, dkeyCount, it)) {
         u64a from_offset = starts[it];
         u32 onmatch = dkey_to_report[it];
+        profileMatch(scratch);
         int halt = ci->userCallback(onmatch, from_offset, offset, flags,
                                     ci->userContext);
         if (halt) {
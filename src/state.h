@@ -59,6 +59,29 @@ struct hs_stream {
     u64a offset;
 };
 
+#define STREAM_POOL_MAGIC 0x53504f4f
+
+/** \brief Marks the end of the stream pool free list. */
+#define STREAM_POOL_END 0xffffffffU
+
+/** \brief Pool of fixed-size stream slots.
+ *
+ * Allocated in one piece: this header, followed by the free list links (one
+ * u32 per slot) and then, from the next cache line, the slots themselves.
+ * Free slots form a singly-linked list through \ref next. A slot that is not
+ * in use has a NULL rose pointer, which lets us catch double closes.
+ */
+struct hs_stream_pool {
+    u32 magic;
+    u32 count;      /**< number of slots */
+    u32 free_head;  /**< first free slot, or STREAM_POOL_END */
+    size_t slot_size; /**< bytes per slot, a multiple of the cache line */
+    const struct RoseEngine *rose;
+    char *slots;    /**< first slot, cache-line aligned */
+    u32 *next;      /**< free list links */
+    void *pool_alloc; /**< allocation, as returned by the stream allocator */
+};
+
 #define getMultiState(hs_s)      ((char *)(hs_s) + sizeof(*(hs_s)))
 #define getMultiStateConst(hs_s) ((const char *)(hs_s) + sizeof(*(hs_s)))
 
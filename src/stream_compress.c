@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Stream state compression.
+ *
+ * The full stream state is sized for the worst case. An image stores only
+ * the parts of it that are live:
+ *
+ *  - a header holding the stream offset and the size of the Rose state;
+ *  - the Rose state up to the history buffer, verbatim;
+ *  - only the valid bytes of the history buffer, of which there are fewer
+ *    than its full size near the start of the stream;
+ *  - the rest of the Rose state, up to the engine states, verbatim;
+ *  - the stream state of each engine marked in the active leaf and active
+ *    leftfix arrays, in queue order. Inactive engines are skipped: their
+ *    state is reinitialised before it is next used.
+ *
+ * The active arrays are in the verbatim part, so the layout of an image can
+ * be computed from the image alone, which lets us validate it completely
+ * before restoring it.
+ */
+
+#include "stream_compress.h"
+
+#include "state.h"
+#include "nfa/nfa_internal.h"
+#include "rose/rose_internal.h"
+#include "util/multibit.h"
+
+#include <string.h>
+
+#define STREAM_IMAGE_MAGIC 0x49535348 /* "HSSI" */
+
+/** \brief Header at the start of every stream image. */
+struct stream_image_header {
+    u32 magic;
+    u32 state_size; /**< Rose state size of the database */
+    u64a offset;    /**< stream offset */
+};
+
+enum image_op {
+    IMAGE_SIZE,     /**< compute the image size only */
+    IMAGE_COMPRESS, /**< copy from the stream state to the image */
+    IMAGE_EXPAND    /**< copy from the image to the stream state */
+};
+
+/** \brief Source and destination of a walk over the image layout. */
+struct image_io {
+    enum image_op op;
+    const u8 *state_in; /**< IMAGE_COMPRESS: stream state */
+    char *img_out;      /**< IMAGE_COMPRESS: image body */
+    const char *img_in; /**< IMAGE_EXPAND: image body */
+    u8 *state_out;      /**< IMAGE_EXPAND: stream state */
+};
+
+static really_inline
+void transfer(const struct image_io *io, size_t state_off, size_t img_off,
+              size_t len) {
+    switch (io->op) {
+    case IMAGE_COMPRESS:
+        memcpy(io->img_out + img_off, io->state_in + state_off, len);
+        break;
+    case IMAGE_EXPAND:
+        memcpy(io->state_out + state_off, io->img_in + img_off, len);
+        break;
+    default:
+        break;
+    }
+}
+
+static really_inline
+size_t transferEngine(const struct image_io *io, const struct RoseEngine *rose,
+                      u32 qi, size_t img_off) {
+    const struct NfaInfo *info = getNfaInfoByQueue(rose, qi);
+    const struct NFA *nfa = getNfaByInfo(rose, info);
+    transfer(io, info->stateOffset, img_off, nfa->streamStateSize);
+    return nfa->streamStateSize;
+}
+
+/**
+ * \brief Walk the image layout, returning the size of the image body (which
+ * follows the header).
+ *
+ * \a arrays is the Rose state region holding the active arrays: the stream
+ * state when compressing, or the verbatim region of the image otherwise.
+ */
+static
+size_t walkImage(const struct image_io *io, const struct RoseEngine *rose,
+                 u64a offset, const u8 *arrays) {
+    const struct RoseStateOffsets *so = &rose->stateOffsets;
+    size_t len = 0;
+
+    /* the active arrays must be in the verbatim region */
+    assert(so->activeLeafArray < so->history);
+    assert(so->activeLeftArray + so->activeLeftArray_size <= so->history);
+
+    transfer(io, 0, len, so->history);
+    len += so->history;
+
+    u32 hist = (u32)MIN(rose->historyRequired, offset);
+    transfer(io, so->history + rose->historyRequired - hist, len, hist);
+    len += hist;
+
+    u32 rest = so->history + rose->historyRequired;
+    assert(rest <= so->nfaStateBegin);
+    transfer(io, rest, len, so->nfaStateBegin - rest);
+    len += so->nfaStateBegin - rest;
+
+    if (rose->activeArrayCount) {
+        const u8 *aa = arrays + so->activeLeafArray;
+        u32 aaCount = rose->activeArrayCount;
+        for (u32 qi = mmbit_iterate(aa, aaCount, MMB_INVALID);
+             qi != MMB_INVALID; qi = mmbit_iterate(aa, aaCount, qi)) {
+            len += transferEngine(io, rose, qi, len);
+        }
+    }
+
+    if (rose->activeLeftCount) {
+        const u8 *ara = arrays + so->activeLeftArray;
+        u32 arCount = rose->activeLeftCount;
+        const struct LeftNfaInfo *left = getLeftTable(rose);
+        for (u32 ri = mmbit_iterate(ara, arCount, MMB_INVALID);
+             ri != MMB_INVALID; ri = mmbit_iterate(ara, arCount, ri)) {
+            if (left[ri].transient) {
+                continue; /* state lives in scratch */
+            }
+            len += transferEngine(io, rose, rose->leftfixBeginQueue + ri, len);
+        }
+    }
+
+    return len;
+}
+
+size_t compressStream(const struct hs_stream *stream, char *buf,
+                      size_t buf_space) {
+    assert(stream && stream->rose);
+    const struct RoseEngine *rose = stream->rose;
+    const u8 *state = (const u8 *)getMultiStateConst(stream);
+
+    struct image_io io;
+    memset(&io, 0, sizeof(io));
+    io.op = IMAGE_SIZE;
+
+    size_t len = sizeof(struct stream_image_header)
+               + walkImage(&io, rose, stream->offset, state);
+    if (len > buf_space) {
+        return len;
+    }
+
+    struct stream_image_header hdr;
+    hdr.magic = STREAM_IMAGE_MAGIC;
+    hdr.state_size = rose->stateOffsets.end;
+    hdr.offset = stream->offset;
+    memcpy(buf, &hdr, sizeof(hdr));
+
+    io.op = IMAGE_COMPRESS;
+    io.state_in = state;
+    io.img_out = buf + sizeof(hdr);
+    UNUSED size_t body = walkImage(&io, rose, stream->offset, state);
+    assert(sizeof(hdr) + body == len);
+    return len;
+}
+
+char validStreamImage(const struct RoseEngine *rose, const char *buf,
+                      size_t buf_size) {
+    assert(rose);
+    const struct RoseStateOffsets *so = &rose->stateOffsets;
+
+    struct stream_image_header hdr;
+    if (!buf || buf_size < sizeof(hdr)) {
+        return 0;
+    }
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (hdr.magic != STREAM_IMAGE_MAGIC || hdr.state_size != so->end) {
+        DEBUG_PRINTF("image is not for this database\n");
+        return 0;
+    }
+
+    /* The verbatim region holding the active arrays must be present before
+     * we can use them to size the rest of the image. */
+    size_t body_size = buf_size - sizeof(hdr);
+    if (body_size < so->history) {
+        return 0;
+    }
+
+    struct image_io io;
+    memset(&io, 0, sizeof(io));
+    io.op = IMAGE_SIZE;
+    const u8 *arrays = (const u8 *)buf + sizeof(hdr);
+    if (walkImage(&io, rose, hdr.offset, arrays) != body_size) {
+        DEBUG_PRINTF("image size mismatch\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+void expandStream(struct hs_stream *stream, const struct RoseEngine *rose,
+                  const char *buf, UNUSED size_t buf_size) {
+    assert(stream && rose);
+    assert(validStreamImage(rose, buf, buf_size));
+
+    struct stream_image_header hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+
+    stream->rose = rose;
+    stream->offset = hdr.offset;
+    u8 *state = (u8 *)getMultiState(stream);
+    memset(state, 0, rose->stateOffsets.end);
+
+    struct image_io io;
+    memset(&io, 0, sizeof(io));
+    io.op = IMAGE_EXPAND;
+    io.img_in = buf + sizeof(hdr);
+    io.state_out = state;
+    UNUSED size_t len = walkImage(&io, rose, hdr.offset,
+                                  (const u8 *)io.img_in);
+    assert(sizeof(hdr) + len == buf_size);
+}
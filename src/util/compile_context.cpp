@@ -36,11 +36,14 @@ namespace ue2 {
 
 CompileContext::CompileContext(bool in_isStreaming, bool in_isVectored,
                                const target_t &in_target_info,
-                               const Grey &in_grey)
+                               const Grey &in_grey, u32 in_numThreads,
+                               CompileCache *in_cache)
     : streaming(in_isStreaming || in_isVectored),
       vectored(in_isVectored),
       target_info(in_target_info),
-      grey(in_grey) {
+      grey(in_grey),
+      numThreads(in_numThreads ? in_numThreads : 1),
+      cache(in_cache) {
 }
 
 } // namespace ue2
@@ -35,14 +35,18 @@
 
 #include "target_info.h"
 #include "grey.h"
+#include "ue2common.h"
 
 namespace ue2 {
 
+class CompileCache;
+
 /** \brief Structure for describing the compile environment: grey box settings,
  * target arch, mode flags, etc. */
 struct CompileContext {
     CompileContext(bool isStreaming, bool isVectored,
-                   const target_t &target_info, const Grey &grey);
+                   const target_t &target_info, const Grey &grey,
+                   u32 numThreads = 1, CompileCache *cache = nullptr);
 
     const bool streaming; /* streaming or vectored mode */
     const bool vectored;
@@ -52,6 +56,14 @@ struct CompileContext {
 
     /** \brief Greybox structure, allows tuning of all sorts of behaviour. */
     const Grey grey;
+
+    /** \brief Number of threads that independent parts of the compile may be
+     * spread across. Always at least one. */
+    const u32 numThreads;
+
+    /** \brief Cache of compile artefacts from earlier compiles, or nullptr if
+     * caching is not in use. */
+    CompileCache *const cache;
 };
 
 } // namespace ue2
@@ -50,6 +50,25 @@
 #define BMI (1 << 3)
 #define AVX2 (1 << 5)
 #define BMI2 (1 << 8)
+#define AVX512F (1 << 16)
+#define AVX512BW (1 << 30)
+
+// ECX (leaf 1)
+#define OSXSAVE (1 << 27)
+
+// XCR0 bits: SSE, AVX and the three AVX-512 state components
+#define XCR0_AVX512 0xe6
+
+static __inline
+u64a xgetbv(unsigned int op) {
+#if defined(_WIN32)
+    return _xgetbv(op);
+#else
+    unsigned int a, d;
+    __asm__ volatile("xgetbv" : "=a"(a), "=d"(d) : "c"(op));
+    return ((u64a)d << 32) + a;
+#endif
+}
 
 static __inline
 void cpuid(unsigned int op, unsigned int leaf, unsigned int *eax,
@@ -74,6 +93,7 @@ u64a cpuid_flags(void) {
     cpuid(1, 0, &eax, &ebx, &ecx, &edx);
 
     /* ECX and EDX contain capability flags */
+    int has_osxsave = !!(ecx & OSXSAVE);
 
     ecx = 0;
     cpuid(7, 0, &eax, &ebx, &ecx, &edx);
@@ -82,10 +102,22 @@ u64a cpuid_flags(void) {
         cap |= HS_CPU_FEATURES_AVX2;
     }
 
-#if !defined(__AVX2__)
+    /* AVX-512 also requires the OS to save the extended register state. */
+    if ((ebx & AVX512F) && (ebx & AVX512BW) && has_osxsave
+        && (xgetbv(0) & XCR0_AVX512) == XCR0_AVX512) {
+        cap |= HS_CPU_FEATURES_AVX512;
+    }
+
+    /* A fat runtime carries its own AVX2 and AVX-512 code, so the features
+     * the host has are usable whatever this file was built for. */
+#if !defined(FAT_RUNTIME) && !defined(__AVX2__)
     cap &= ~HS_CPU_FEATURES_AVX2;
 #endif
 
+#if !defined(FAT_RUNTIME) && !defined(__AVX512BW__)
+    cap &= ~HS_CPU_FEATURES_AVX512;
+#endif
+
     return cap;
 }
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Helpers for running independent pieces of compile work on several
+ * threads.
+ */
+
+#ifndef UTIL_PARALLEL_H
+#define UTIL_PARALLEL_H
+
+#include "ue2common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace ue2 {
+
+/**
+ * \brief Resolves a requested thread count: zero means one thread per
+ * hardware thread on the host.
+ */
+static inline
+u32 resolveThreadCount(u32 threads) {
+    if (threads) {
+        return threads;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * \brief Calls \a func(i) for every i in [0, count), using up to \a threads
+ * threads (including the calling thread).
+ *
+ * The calls must be independent of one another: each may only write to state
+ * owned by its own index. Items are handed out in index order, so with a
+ * single thread this is an ordinary loop.
+ *
+ * If any call throws, the remaining items are still processed, and the
+ * exception thrown for the lowest index is rethrown to the caller once all
+ * threads have finished. This is the same exception a serial loop would have
+ * thrown first.
+ */
+template<class Func>
+void parallel_for(size_t count, u32 threads, Func func) {
+    if (threads <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                func(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    size_t num_workers = std::min(count, (size_t)threads);
+    std::vector<std::thread> pool;
+    pool.reserve(num_workers - 1);
+    for (size_t i = 1; i < num_workers; i++) {
+        try {
+            pool.emplace_back(worker);
+        } catch (const std::system_error &) {
+            break; // carry on with the threads we have
+        }
+    }
+    worker();
+    for (auto &t : pool) {
+        t.join();
+    }
+
+    for (const auto &e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+} // namespace ue2
+
+#endif // UTIL_PARALLEL_H
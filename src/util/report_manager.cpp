@@ -39,6 +39,7 @@
 
 #include <deque>
 #include <map>
+#include <set>
 #include <sstream>
 #include <vector>
 
@@ -127,6 +128,21 @@ vector<ReportID> ReportManager::getDkeyToReportTable() const {
     return rv;
 }
 
+vector<ReportID> ReportManager::getExternalIdTable() const {
+    set<ReportID> ids;
+    for (const auto &m : externalIdMap) {
+        ids.insert(m.first);
+    }
+    for (const auto &ir : reportIds) {
+        if (isExternalReport(ir)) {
+            ids.insert(ir.onmatch);
+        }
+    }
+
+    DEBUG_PRINTF("%zu external ids\n", ids.size());
+    return vector<ReportID>(ids.begin(), ids.end());
+}
+
 void ReportManager::assignDkeys(const RoseBuild *rose) {
     DEBUG_PRINTF("assigning...\n");
 
@@ -87,6 +87,11 @@ public:
 
     std::vector<ReportID> getDkeyToReportTable() const;
 
+    /** \brief Sorted table of the distinct external report ids. The position
+     * of an id in this table is its dense counter index, as used by the match
+     * counting scan functions. */
+    std::vector<ReportID> getExternalIdTable() const;
+
     /** \brief Return a const reference to the table of Report
      * structures. */
     const std::vector<Report> &reports() const { return reportIds; }
@@ -68,9 +68,19 @@ typedef __m256i m256;
 typedef struct ALIGN_AVX_DIRECTIVE {m128 lo; m128 hi;} m256;
 #endif
 
-// these should align to 16 and 32 respectively
+// these should align to 16 and 64 respectively
 typedef struct {m128 lo; m128 mid; m128 hi;} m384;
-typedef struct {m256 lo; m256 hi;} m512;
+#if defined(__AVX512BW__)
+typedef __m512i m512;
+#else
+// cacheline aligned so that layout matches the native AVX-512 type
+typedef struct ALIGN_CL_DIRECTIVE {m256 lo; m256 hi;} m512;
+#endif
+
+// multi-register types for the largest LimEx models; these align to 32 and 64
+// respectively, and are made up of the widest native type available
+typedef struct {m256 lo; m256 mid; m256 hi;} m768;
+typedef struct {m512 lo; m512 hi;} m1024;
 
 #endif /* SIMD_TYPES_H */
 
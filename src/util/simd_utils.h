@@ -990,7 +990,11 @@ char testbit384(const m384 *ptr, unsigned int n) {
  **** 512-bit Primitives
  ****/
 
-#if defined(USE_GCC_COMPOUND_STATEMENTS)
+#if defined(__AVX512BW__)
+static really_inline m512 and512(m512 a, m512 b) {
+    return _mm512_and_si512(a, b);
+}
+#elif defined(USE_GCC_COMPOUND_STATEMENTS)
 #define and512(a, b) ({                                                 \
     m512 rv_and512;                                                     \
     rv_and512.lo = and256((a).lo, (b).lo);                              \
@@ -1006,7 +1010,11 @@ static really_inline m512 and512(m512 a, m512 b) {
 }
 #endif
 
-#if defined(USE_GCC_COMPOUND_STATEMENTS)
+#if defined(__AVX512BW__)
+static really_inline m512 or512(m512 a, m512 b) {
+    return _mm512_or_si512(a, b);
+}
+#elif defined(USE_GCC_COMPOUND_STATEMENTS)
 #define or512(a, b) ({                                                  \
     m512 rv_or512;                                                      \
     rv_or512.lo = or256((a).lo, (b).lo);                                \
@@ -1022,7 +1030,11 @@ static really_inline m512 or512(m512 a, m512 b) {
 }
 #endif
 
-#if defined(USE_GCC_COMPOUND_STATEMENTS)
+#if defined(__AVX512BW__)
+static really_inline m512 xor512(m512 a, m512 b) {
+    return _mm512_xor_si512(a, b);
+}
+#elif defined(USE_GCC_COMPOUND_STATEMENTS)
 #define xor512(a, b) ({                                                 \
     m512 rv_xor512;                                                     \
     rv_xor512.lo = xor256((a).lo, (b).lo);                              \
@@ -1038,7 +1050,11 @@ static really_inline m512 xor512(m512 a, m512 b) {
 }
 #endif
 
-#if defined(USE_GCC_COMPOUND_STATEMENTS)
+#if defined(__AVX512BW__)
+static really_inline m512 not512(m512 a) {
+    return _mm512_ternarylogic_epi64(a, a, a, 0x55);
+}
+#elif defined(USE_GCC_COMPOUND_STATEMENTS)
 #define not512(a) ({                                                    \
     m512 rv_not512;                                                     \
     rv_not512.lo = not256((a).lo);                                      \
@@ -1054,7 +1070,11 @@ static really_inline m512 not512(m512 a) {
 }
 #endif
 
-#if defined(USE_GCC_COMPOUND_STATEMENTS)
+#if defined(__AVX512BW__)
+static really_inline m512 andnot512(m512 a, m512 b) {
+    return _mm512_andnot_si512(a, b);
+}
+#elif defined(USE_GCC_COMPOUND_STATEMENTS)
 #define andnot512(a, b) ({                                              \
     m512 rv_andnot512;                                                  \
     rv_andnot512.lo = andnot256((a).lo, (b).lo);                        \
@@ -1072,7 +1092,9 @@ static really_inline m512 andnot512(m512 a, m512 b) {
 
 // The shift amount is an immediate, so we define these operations as macros on
 // Intel SIMD (using a GNU C extension).
-#if defined(USE_GCC_COMPOUND_STATEMENTS)
+#if defined(__AVX512BW__)
+#define shift512(a, b)  _mm512_slli_epi64((a), (b))
+#elif defined(USE_GCC_COMPOUND_STATEMENTS)
 #define shift512(a, b)  ({                                              \
     m512 rv_shift512;                                                   \
     rv_shift512.lo = shift256(a.lo, b);                                 \
@@ -1089,21 +1111,35 @@ static really_inline m512 shift512(m512 a, unsigned b) {
 #endif
 
 static really_inline m512 zeroes512(void) {
+#if defined(__AVX512BW__)
+    return _mm512_setzero_si512();
+#else
     m512 rv = {zeroes256(), zeroes256()};
     return rv;
+#endif
 }
 
 static really_inline m512 ones512(void) {
+#if defined(__AVX512BW__)
+    return _mm512_set1_epi8(0xff);
+#else
     m512 rv = {ones256(), ones256()};
     return rv;
+#endif
 }
 
 static really_inline int diff512(m512 a, m512 b) {
+#if defined(__AVX512BW__)
+    return !!_mm512_cmpneq_epi8_mask(a, b);
+#else
     return diff256(a.lo, b.lo) || diff256(a.hi, b.hi);
+#endif
 }
 
 static really_inline int isnonzero512(m512 a) {
-#if !defined(__AVX2__)
+#if defined(__AVX512BW__)
+    return !!_mm512_test_epi64_mask(a, a);
+#elif !defined(__AVX2__)
     m128 x = or128(a.lo.lo, a.lo.hi);
     m128 y = or128(a.hi.lo, a.hi.hi);
     return isnonzero128(or128(x, y));
@@ -1118,7 +1154,9 @@ static really_inline int isnonzero512(m512 a) {
  * mask indicating which 32-bit words contain differences.
  */
 static really_inline u32 diffrich512(m512 a, m512 b) {
-#if defined(__AVX2__)
+#if defined(__AVX512BW__)
+    return _mm512_cmpneq_epi32_mask(a, b);
+#elif defined(__AVX2__)
     return diffrich256(a.lo, b.lo) | (diffrich256(a.hi, b.hi) << 8);
 #else
     a.lo.lo = _mm_cmpeq_epi32(a.lo.lo, b.lo.lo);
@@ -1143,13 +1181,21 @@ static really_inline u32 diffrich64_512(m512 a, m512 b) {
 // aligned load
 static really_inline m512 load512(const void *ptr) {
     assert(ISALIGNED_16(ptr));
+#if defined(__AVX512BW__)
+    // callers only guarantee 16-byte alignment
+    return _mm512_loadu_si512(ptr);
+#else
     m512 rv = { load256(ptr), load256((const char *)ptr + 32) };
     return rv;
+#endif
 }
 
 // aligned store
 static really_inline void store512(void *ptr, m512 a) {
-#if defined(__AVX2__)
+#if defined(__AVX512BW__)
+    assert(ISALIGNED_16(ptr));
+    _mm512_storeu_si512(ptr, a);
+#elif defined(__AVX2__)
     m512 *x = (m512 *)ptr;
     store256(&x->lo, a.lo);
     store256(&x->hi, a.hi);
@@ -1162,8 +1208,12 @@ static really_inline void store512(void *ptr, m512 a) {
 
 // unaligned load
 static really_inline m512 loadu512(const void *ptr) {
+#if defined(__AVX512BW__)
+    return _mm512_loadu_si512(ptr);
+#else
     m512 rv = { loadu256(ptr), loadu256((const char *)ptr + 32) };
     return rv;
+#endif
 }
 
 // packed unaligned store of first N bytes
@@ -1182,6 +1232,56 @@ m512 loadbytes512(const void *ptr, unsigned int n) {
     return a;
 }
 
+#if defined(__AVX512BW__)
+// switches on bit N in the given vector.
+static really_inline
+void setbit512(m512 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    u8 *bytes = (u8 *)ptr;
+    bytes[n / 8] |= 1U << (n % 8);
+}
+
+// switches off bit N in the given vector.
+static really_inline
+void clearbit512(m512 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    u8 *bytes = (u8 *)ptr;
+    bytes[n / 8] &= ~(1U << (n % 8));
+}
+
+// tests bit N in the given vector.
+static really_inline
+char testbit512(const m512 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    const u8 *bytes = (const u8 *)ptr;
+    return !!(bytes[n / 8] & (1U << (n % 8)));
+}
+
+// extracts 128-bit lane N (an immediate) from the given vector.
+#define extract128from512(a, imm) _mm512_extracti32x4_epi32(a, imm)
+
+#define rshift8x64(a, b)    _mm512_srli_epi64((a), (b))
+#define eq512mask(a, b)     ((u64a)_mm512_cmpeq_epi8_mask((a), (b)))
+#define shift512Right8Bits(a) _mm512_bsrli_epi128((a), 1)
+
+static really_inline
+m512 set64x8(u8 in) {
+    return _mm512_set1_epi8(in);
+}
+
+static really_inline
+m512 set4x128(m128 a) {
+    return _mm512_broadcast_i32x4(a);
+}
+
+// masked unaligned load: bytes not selected by k are zeroed and not accessed.
+static really_inline
+m512 loadu_maskz512(u64a k, const void *ptr) {
+    return _mm512_maskz_loadu_epi8(k, ptr);
+}
+
+#else // !AVX512BW
+
 // switches on bit N in the given vector.
 static really_inline
 void setbit512(m512 *ptr, unsigned int n) {
@@ -1266,4 +1366,351 @@ char testbit512(const m512 *ptr, unsigned int n) {
 #endif
 }
 
+#endif // AVX512BW
+
+/****
+ **** 768-bit Primitives
+ ****/
+
+static really_inline m768 and768(m768 a, m768 b) {
+    m768 rv;
+    rv.lo = and256(a.lo, b.lo);
+    rv.mid = and256(a.mid, b.mid);
+    rv.hi = and256(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m768 or768(m768 a, m768 b) {
+    m768 rv;
+    rv.lo = or256(a.lo, b.lo);
+    rv.mid = or256(a.mid, b.mid);
+    rv.hi = or256(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m768 xor768(m768 a, m768 b) {
+    m768 rv;
+    rv.lo = xor256(a.lo, b.lo);
+    rv.mid = xor256(a.mid, b.mid);
+    rv.hi = xor256(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m768 not768(m768 a) {
+    m768 rv;
+    rv.lo = not256(a.lo);
+    rv.mid = not256(a.mid);
+    rv.hi = not256(a.hi);
+    return rv;
+}
+
+static really_inline m768 andnot768(m768 a, m768 b) {
+    m768 rv;
+    rv.lo = andnot256(a.lo, b.lo);
+    rv.mid = andnot256(a.mid, b.mid);
+    rv.hi = andnot256(a.hi, b.hi);
+    return rv;
+}
+
+// The shift amount is an immediate, so we define these operations as macros on
+// Intel SIMD (using a GNU C extension).
+#if defined(__GNUC__)
+#define shift768(a, b)  ({                                              \
+    m768 rv_shift768;                                                   \
+    rv_shift768.lo = shift256((a).lo, b);                               \
+    rv_shift768.mid = shift256((a).mid, b);                             \
+    rv_shift768.hi = shift256((a).hi, b);                               \
+    rv_shift768;                                                        \
+})
+#else
+static really_inline m768 shift768(m768 a, unsigned b) {
+    m768 rv;
+    rv.lo = shift256(a.lo, b);
+    rv.mid = shift256(a.mid, b);
+    rv.hi = shift256(a.hi, b);
+    return rv;
+}
+#endif
+
+static really_inline m768 zeroes768(void) {
+    m768 rv = {zeroes256(), zeroes256(), zeroes256()};
+    return rv;
+}
+
+static really_inline m768 ones768(void) {
+    m768 rv = {ones256(), ones256(), ones256()};
+    return rv;
+}
+
+static really_inline int diff768(m768 a, m768 b) {
+    return diff256(a.lo, b.lo) || diff256(a.mid, b.mid) ||
+           diff256(a.hi, b.hi);
+}
+
+static really_inline int isnonzero768(m768 a) {
+    m256 t = or256(a.lo, a.mid);
+    return isnonzero256(or256(t, a.hi));
+}
+
+/**
+ * "Rich" version of diff768(). Takes two vectors a and b and returns a 24-bit
+ * mask indicating which 32-bit words contain differences.
+ */
+static really_inline u32 diffrich768(m768 a, m768 b) {
+    return diffrich256(a.lo, b.lo) | (diffrich256(a.mid, b.mid) << 8) |
+           (diffrich256(a.hi, b.hi) << 16);
+}
+
+/**
+ * "Rich" version of diff768(), 64-bit variant. Takes two vectors a and b and
+ * returns a 24-bit mask indicating which 64-bit words contain differences.
+ */
+static really_inline u32 diffrich64_768(m768 a, m768 b) {
+    u32 d = diffrich768(a, b);
+    return (d | (d >> 1)) & 0x55555555;
+}
+
+// aligned load
+static really_inline m768 load768(const void *ptr) {
+    m768 rv = { load256(ptr), load256((const char *)ptr + 32),
+                load256((const char *)ptr + 64) };
+    return rv;
+}
+
+// aligned store
+static really_inline void store768(void *ptr, m768 a) {
+    m768 *x = (m768 *)ptr;
+    store256(&x->lo, a.lo);
+    store256(&x->mid, a.mid);
+    store256(&x->hi, a.hi);
+}
+
+// unaligned load
+static really_inline m768 loadu768(const void *ptr) {
+    m768 rv = { loadu256(ptr), loadu256((const char *)ptr + 32),
+                loadu256((const char *)ptr + 64) };
+    return rv;
+}
+
+// packed unaligned store of first N bytes
+static really_inline
+void storebytes768(void *ptr, m768 a, unsigned int n) {
+    assert(n <= sizeof(a));
+    memcpy(ptr, &a, n);
+}
+
+// packed unaligned load of first N bytes, pad with zero
+static really_inline
+m768 loadbytes768(const void *ptr, unsigned int n) {
+    m768 a = zeroes768();
+    assert(n <= sizeof(a));
+    memcpy(&a, ptr, n);
+    return a;
+}
+
+// switches on bit N in the given vector.
+static really_inline
+void setbit768(m768 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    m256 *sub;
+    if (n < 256) {
+        sub = &ptr->lo;
+    } else if (n < 512) {
+        sub = &ptr->mid;
+    } else {
+        sub = &ptr->hi;
+    }
+    setbit256(sub, n % 256);
+}
+
+// switches off bit N in the given vector.
+static really_inline
+void clearbit768(m768 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    m256 *sub;
+    if (n < 256) {
+        sub = &ptr->lo;
+    } else if (n < 512) {
+        sub = &ptr->mid;
+    } else {
+        sub = &ptr->hi;
+    }
+    clearbit256(sub, n % 256);
+}
+
+// tests bit N in the given vector.
+static really_inline
+char testbit768(const m768 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    const m256 *sub;
+    if (n < 256) {
+        sub = &ptr->lo;
+    } else if (n < 512) {
+        sub = &ptr->mid;
+    } else {
+        sub = &ptr->hi;
+    }
+    return testbit256(sub, n % 256);
+}
+
+/****
+ **** 1024-bit Primitives
+ ****/
+
+static really_inline m1024 and1024(m1024 a, m1024 b) {
+    m1024 rv;
+    rv.lo = and512(a.lo, b.lo);
+    rv.hi = and512(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m1024 or1024(m1024 a, m1024 b) {
+    m1024 rv;
+    rv.lo = or512(a.lo, b.lo);
+    rv.hi = or512(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m1024 xor1024(m1024 a, m1024 b) {
+    m1024 rv;
+    rv.lo = xor512(a.lo, b.lo);
+    rv.hi = xor512(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m1024 not1024(m1024 a) {
+    m1024 rv;
+    rv.lo = not512(a.lo);
+    rv.hi = not512(a.hi);
+    return rv;
+}
+
+static really_inline m1024 andnot1024(m1024 a, m1024 b) {
+    m1024 rv;
+    rv.lo = andnot512(a.lo, b.lo);
+    rv.hi = andnot512(a.hi, b.hi);
+    return rv;
+}
+
+// The shift amount is an immediate, so we define these operations as macros on
+// Intel SIMD (using a GNU C extension).
+#if defined(__GNUC__)
+#define shift1024(a, b)  ({                                             \
+    m1024 rv_shift1024;                                                 \
+    rv_shift1024.lo = shift512((a).lo, b);                              \
+    rv_shift1024.hi = shift512((a).hi, b);                              \
+    rv_shift1024;                                                       \
+})
+#else
+static really_inline m1024 shift1024(m1024 a, unsigned b) {
+    m1024 rv;
+    rv.lo = shift512(a.lo, b);
+    rv.hi = shift512(a.hi, b);
+    return rv;
+}
+#endif
+
+static really_inline m1024 zeroes1024(void) {
+    m1024 rv = {zeroes512(), zeroes512()};
+    return rv;
+}
+
+static really_inline m1024 ones1024(void) {
+    m1024 rv = {ones512(), ones512()};
+    return rv;
+}
+
+static really_inline int diff1024(m1024 a, m1024 b) {
+    return diff512(a.lo, b.lo) || diff512(a.hi, b.hi);
+}
+
+static really_inline int isnonzero1024(m1024 a) {
+    return isnonzero512(or512(a.lo, a.hi));
+}
+
+/**
+ * "Rich" version of diff1024(). Takes two vectors a and b and returns a 32-bit
+ * mask indicating which 32-bit words contain differences.
+ */
+static really_inline u32 diffrich1024(m1024 a, m1024 b) {
+    return diffrich512(a.lo, b.lo) | (diffrich512(a.hi, b.hi) << 16);
+}
+
+/**
+ * "Rich" version of diff1024(), 64-bit variant. Takes two vectors a and b and
+ * returns a 32-bit mask indicating which 64-bit words contain differences.
+ */
+static really_inline u32 diffrich64_1024(m1024 a, m1024 b) {
+    u32 d = diffrich1024(a, b);
+    return (d | (d >> 1)) & 0x55555555;
+}
+
+// aligned load
+static really_inline m1024 load1024(const void *ptr) {
+    m1024 rv = { load512(ptr), load512((const char *)ptr + 64) };
+    return rv;
+}
+
+// aligned store
+static really_inline void store1024(void *ptr, m1024 a) {
+    m1024 *x = (m1024 *)ptr;
+    store512(&x->lo, a.lo);
+    store512(&x->hi, a.hi);
+}
+
+// unaligned load
+static really_inline m1024 loadu1024(const void *ptr) {
+    m1024 rv = { loadu512(ptr), loadu512((const char *)ptr + 64) };
+    return rv;
+}
+
+// packed unaligned store of first N bytes
+static really_inline
+void storebytes1024(void *ptr, m1024 a, unsigned int n) {
+    assert(n <= sizeof(a));
+    memcpy(ptr, &a, n);
+}
+
+// packed unaligned load of first N bytes, pad with zero
+static really_inline
+m1024 loadbytes1024(const void *ptr, unsigned int n) {
+    m1024 a = zeroes1024();
+    assert(n <= sizeof(a));
+    memcpy(&a, ptr, n);
+    return a;
+}
+
+// switches on bit N in the given vector.
+static really_inline
+void setbit1024(m1024 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    if (n < 512) {
+        setbit512(&ptr->lo, n);
+    } else {
+        setbit512(&ptr->hi, n - 512);
+    }
+}
+
+// switches off bit N in the given vector.
+static really_inline
+void clearbit1024(m1024 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    if (n < 512) {
+        clearbit512(&ptr->lo, n);
+    } else {
+        clearbit512(&ptr->hi, n - 512);
+    }
+}
+
+// tests bit N in the given vector.
+static really_inline
+char testbit1024(const m1024 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    if (n < 512) {
+        return testbit512(&ptr->lo, n);
+    } else {
+        return testbit512(&ptr->hi, n - 512);
+    }
+}
+
 #endif
@@ -77,6 +77,13 @@ m128 pshufb(m128 a, m128 b) {
     return result;
 }
 
+#if defined(__AVX512BW__)
+static really_inline
+m512 pshufb_m512(m512 a, m512 b) {
+    return _mm512_shuffle_epi8(a, b);
+}
+#endif
+
 #if defined(__AVX2__)
 
 static really_inline
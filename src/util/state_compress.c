@@ -546,7 +546,12 @@ m512 loadcompressed512_32bit(const void *ptr, m512 mvec) {
                   expand32(v[14], m[14]), expand32(v[15], m[15]) };
 
     m512 xvec;
-#if !defined(__AVX2__)
+#if defined(__AVX512BW__)
+    xvec = _mm512_set_epi32(x[15], x[14], x[13], x[12],
+                            x[11], x[10], x[9], x[8],
+                            x[7], x[6], x[5], x[4],
+                            x[3], x[2], x[1], x[0]);
+#elif !defined(__AVX2__)
     xvec.lo.lo = _mm_set_epi32(x[3], x[2], x[1], x[0]);
     xvec.lo.hi = _mm_set_epi32(x[7], x[6], x[5], x[4]);
     xvec.hi.lo = _mm_set_epi32(x[11], x[10], x[9], x[8]);
@@ -581,7 +586,10 @@ m512 loadcompressed512_64bit(const void *ptr, m512 mvec) {
                   expand64(v[4], m[4]), expand64(v[5], m[5]),
                   expand64(v[6], m[6]), expand64(v[7], m[7]) };
 
-#if !defined(__AVX2__)
+#if defined(__AVX512BW__)
+    m512 xvec = _mm512_set_epi64(x[7], x[6], x[5], x[4],
+                                 x[3], x[2], x[1], x[0]);
+#elif !defined(__AVX2__)
     m512 xvec = { .lo = { _mm_set_epi64x(x[1], x[0]),
                           _mm_set_epi64x(x[3], x[2]) },
                   .hi = { _mm_set_epi64x(x[5], x[4]),
@@ -602,3 +610,106 @@ void loadcompressed512(m512 *x, const void *ptr, const m512 *m,
     *x = loadcompressed512_32bit(ptr, *m);
 #endif
 }
+
+/*
+ * 768-bit and 1024-bit store/load.
+ *
+ * These are only used by the largest LimEx models, so rather than unrolling
+ * each chunk by hand we loop over the vector one GPR-sized chunk at a time.
+ */
+
+#if defined(ARCH_64_BIT)
+#define CHUNK_T u64a
+#define CHUNK_POPCOUNT popcount64
+#define CHUNK_COMPRESS compress64
+#define CHUNK_EXPAND expand64
+#define CHUNK_PACK pack_bits_64
+#define CHUNK_UNPACK unpack_bits_64
+#else
+#define CHUNK_T u32
+#define CHUNK_POPCOUNT popcount32
+#define CHUNK_COMPRESS compress32
+#define CHUNK_EXPAND expand32
+#define CHUNK_PACK pack_bits_32
+#define CHUNK_UNPACK unpack_bits_32
+#endif
+
+#define MAX_WIDE_CHUNKS (sizeof(m1024) / sizeof(CHUNK_T))
+
+static really_inline
+void storecompressed_wide(void *ptr, const void *xvec, const void *mvec,
+                          size_t len) {
+    const u32 count = len / sizeof(CHUNK_T);
+    assert(count <= MAX_WIDE_CHUNKS);
+
+    // First, decompose our vectors into chunks.
+    CHUNK_T x[MAX_WIDE_CHUNKS];
+    memcpy(x, xvec, len);
+    CHUNK_T m[MAX_WIDE_CHUNKS];
+    memcpy(m, mvec, len);
+
+    // Count the number of bits of compressed state we're writing out per
+    // chunk and compress each chunk individually.
+    u32 bits[MAX_WIDE_CHUNKS];
+    CHUNK_T v[MAX_WIDE_CHUNKS];
+    for (u32 i = 0; i < count; i++) {
+        bits[i] = CHUNK_POPCOUNT(m[i]);
+        v[i] = CHUNK_COMPRESS(x[i], m[i]);
+    }
+
+    // Write packed data out.
+    CHUNK_PACK(ptr, v, bits, count);
+}
+
+static really_inline
+void loadcompressed_wide(void *xvec, const void *ptr, const void *mvec,
+                         size_t len) {
+    const u32 count = len / sizeof(CHUNK_T);
+    assert(count <= MAX_WIDE_CHUNKS);
+
+    CHUNK_T m[MAX_WIDE_CHUNKS];
+    memcpy(m, mvec, len);
+
+    u32 bits[MAX_WIDE_CHUNKS];
+    for (u32 i = 0; i < count; i++) {
+        bits[i] = CHUNK_POPCOUNT(m[i]);
+    }
+
+    CHUNK_T v[MAX_WIDE_CHUNKS];
+    CHUNK_UNPACK(v, (const u8 *)ptr, bits, count);
+
+    CHUNK_T x[MAX_WIDE_CHUNKS];
+    for (u32 i = 0; i < count; i++) {
+        x[i] = CHUNK_EXPAND(v[i], m[i]);
+    }
+
+    memcpy(xvec, x, len);
+}
+
+void storecompressed768(void *ptr, const m768 *x, const m768 *m,
+                        UNUSED u32 bytes) {
+    storecompressed_wide(ptr, x, m, sizeof(m768));
+}
+
+void loadcompressed768(m768 *x, const void *ptr, const m768 *m,
+                       UNUSED u32 bytes) {
+    loadcompressed_wide(x, ptr, m, sizeof(m768));
+}
+
+void storecompressed1024(void *ptr, const m1024 *x, const m1024 *m,
+                         UNUSED u32 bytes) {
+    storecompressed_wide(ptr, x, m, sizeof(m1024));
+}
+
+void loadcompressed1024(m1024 *x, const void *ptr, const m1024 *m,
+                        UNUSED u32 bytes) {
+    loadcompressed_wide(x, ptr, m, sizeof(m1024));
+}
+
+#undef MAX_WIDE_CHUNKS
+#undef CHUNK_T
+#undef CHUNK_POPCOUNT
+#undef CHUNK_COMPRESS
+#undef CHUNK_EXPAND
+#undef CHUNK_PACK
+#undef CHUNK_UNPACK
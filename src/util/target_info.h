@@ -47,6 +47,10 @@ struct target_t {
     // is_compatible() or some such.
     bool can_run_on_code_built_for(const target_t &code_target) const;
 
+    bool operator==(const target_t &b) const {
+        return tune == b.tune && cpu_features == b.cpu_features;
+    }
+
 private:
     u32 tune;
     u64a cpu_features;
@@ -49,6 +49,8 @@
 #define load_m256(a)        load256(a)
 #define load_m384(a)        load384(a)
 #define load_m512(a)        load512(a)
+#define load_m768(a)        load768(a)
+#define load_m1024(a)       load1024(a)
 
 // Unaligned loads
 #define loadu_u8(a)          (*(const u8 *)(a))
@@ -59,6 +61,8 @@
 #define loadu_m256(a)        loadu256(a)
 #define loadu_m384(a)        loadu384(a)
 #define loadu_m512(a)        loadu512(a)
+#define loadu_m768(a)        loadu768(a)
+#define loadu_m1024(a)       loadu1024(a)
 
 // Aligned stores
 #define store_u8(ptr, a)    do { *(u8 *)(ptr) = (a); } while(0)
@@ -69,6 +73,8 @@
 #define store_m256(ptr, a)  store256(ptr, a)
 #define store_m384(ptr, a)  store384(ptr, a)
 #define store_m512(ptr, a)  store512(ptr, a)
+#define store_m768(ptr, a)  store768(ptr, a)
+#define store_m1024(ptr, a) store1024(ptr, a)
 
 // Unaligned stores
 #define storeu_u8(ptr, a)    do { *(u8 *)(ptr) = (a); } while(0)
@@ -87,6 +93,8 @@
 #define zero_m256           zeroes256()
 #define zero_m384           zeroes384()
 #define zero_m512           zeroes512()
+#define zero_m768           zeroes768()
+#define zero_m1024          zeroes1024()
 
 #define ones_u8             0xff
 #define ones_u32            0xfffffffful
@@ -95,6 +103,8 @@
 #define ones_m256           ones256()
 #define ones_m384           ones384()
 #define ones_m512           ones512()
+#define ones_m768           ones768()
+#define ones_m1024          ones1024()
 
 #define or_u8(a, b)         ((a) | (b))
 #define or_u32(a, b)        ((a) | (b))
@@ -103,6 +113,8 @@
 #define or_m256(a, b)       (or256(a, b))
 #define or_m384(a, b)       (or384(a, b))
 #define or_m512(a, b)       (or512(a, b))
+#define or_m768(a, b)       (or768(a, b))
+#define or_m1024(a, b)      (or1024(a, b))
 
 #define and_u8(a, b)        ((a) & (b))
 #define and_u32(a, b)       ((a) & (b))
@@ -111,6 +123,8 @@
 #define and_m256(a, b)      (and256(a, b))
 #define and_m384(a, b)      (and384(a, b))
 #define and_m512(a, b)      (and512(a, b))
+#define and_m768(a, b)      (and768(a, b))
+#define and_m1024(a, b)     (and1024(a, b))
 
 #define not_u8(a)           (~(a))
 #define not_u32(a)          (~(a))
@@ -119,6 +133,8 @@
 #define not_m256(a)         (not256(a))
 #define not_m384(a)         (not384(a))
 #define not_m512(a)         (not512(a))
+#define not_m768(a)         (not768(a))
+#define not_m1024(a)        (not1024(a))
 
 #define andnot_u8(a, b)     ((~(a)) & (b))
 #define andnot_u32(a, b)    ((~(a)) & (b))
@@ -127,6 +143,8 @@
 #define andnot_m256(a, b)   (andnot256(a, b))
 #define andnot_m384(a, b)   (andnot384(a, b))
 #define andnot_m512(a, b)   (andnot512(a, b))
+#define andnot_m768(a, b)   (andnot768(a, b))
+#define andnot_m1024(a, b)  (andnot1024(a, b))
 
 #define shift_u32(a, b)     ((a) << (b))
 #define shift_u64a(a, b)    ((a) << (b))
@@ -134,6 +152,8 @@
 #define shift_m256(a, b)    (shift256(a, b))
 #define shift_m384(a, b)    (shift384(a, b))
 #define shift_m512(a, b)    (shift512(a, b))
+#define shift_m768(a, b)    (shift768(a, b))
+#define shift_m1024(a, b)   (shift1024(a, b))
 
 #define isZero_u8(a)        ((a) == 0)
 #define isZero_u32(a)       ((a) == 0)
@@ -142,6 +162,8 @@
 #define isZero_m256(a)      (!isnonzero256(a))
 #define isZero_m384(a)      (!isnonzero384(a))
 #define isZero_m512(a)      (!isnonzero512(a))
+#define isZero_m768(a)      (!isnonzero768(a))
+#define isZero_m1024(a)     (!isnonzero1024(a))
 
 #define isNonZero_u8(a)     ((a) != 0)
 #define isNonZero_u32(a)    ((a) != 0)
@@ -150,6 +172,8 @@
 #define isNonZero_m256(a)   (isnonzero256(a))
 #define isNonZero_m384(a)   (isnonzero384(a))
 #define isNonZero_m512(a)   (isnonzero512(a))
+#define isNonZero_m768(a)   (isnonzero768(a))
+#define isNonZero_m1024(a)  (isnonzero1024(a))
 
 #define diffrich_u32(a, b)  ((a) != (b))
 #define diffrich_u64a(a, b) ((a) != (b) ? 3 : 0) //TODO: impl 32bit granularity
@@ -157,6 +181,8 @@
 #define diffrich_m256(a, b) (diffrich256(a, b))
 #define diffrich_m384(a, b) (diffrich384(a, b))
 #define diffrich_m512(a, b) (diffrich512(a, b))
+#define diffrich_m768(a, b) (diffrich768(a, b))
+#define diffrich_m1024(a, b) (diffrich1024(a, b))
 
 #define diffrich64_u32(a, b)  ((a) != (b))
 #define diffrich64_u64a(a, b) ((a) != (b) ? 1 : 0)
@@ -164,6 +190,8 @@
 #define diffrich64_m256(a, b) (diffrich64_256(a, b))
 #define diffrich64_m384(a, b) (diffrich64_384(a, b))
 #define diffrich64_m512(a, b) (diffrich64_512(a, b))
+#define diffrich64_m768(a, b) (diffrich64_768(a, b))
+#define diffrich64_m1024(a, b) (diffrich64_1024(a, b))
 
 #define noteq_u8(a, b)      ((a) != (b))
 #define noteq_u32(a, b)     ((a) != (b))
@@ -172,16 +200,22 @@
 #define noteq_m256(a, b)    (diff256(a, b))
 #define noteq_m384(a, b)    (diff384(a, b))
 #define noteq_m512(a, b)    (diff512(a, b))
+#define noteq_m768(a, b)    (diff768(a, b))
+#define noteq_m1024(a, b)   (diff1024(a, b))
 
 #define partial_store_m128(ptr, v, sz) storebytes128(ptr, v, sz)
 #define partial_store_m256(ptr, v, sz) storebytes256(ptr, v, sz)
 #define partial_store_m384(ptr, v, sz) storebytes384(ptr, v, sz)
 #define partial_store_m512(ptr, v, sz) storebytes512(ptr, v, sz)
+#define partial_store_m768(ptr, v, sz) storebytes768(ptr, v, sz)
+#define partial_store_m1024(ptr, v, sz) storebytes1024(ptr, v, sz)
 
 #define partial_load_m128(ptr, sz) loadbytes128(ptr, sz)
 #define partial_load_m256(ptr, sz) loadbytes256(ptr, sz)
 #define partial_load_m384(ptr, sz) loadbytes384(ptr, sz)
 #define partial_load_m512(ptr, sz) loadbytes512(ptr, sz)
+#define partial_load_m768(ptr, sz) loadbytes768(ptr, sz)
+#define partial_load_m1024(ptr, sz) loadbytes1024(ptr, sz)
 
 #define store_compressed_u32(ptr, x, m)     storecompressed32(ptr, x, m)
 #define store_compressed_u64a(ptr, x, m)    storecompressed64(ptr, x, m)
@@ -189,6 +223,8 @@
 #define store_compressed_m256(ptr, x, m)    storecompressed256(ptr, x, m)
 #define store_compressed_m384(ptr, x, m)    storecompressed384(ptr, x, m)
 #define store_compressed_m512(ptr, x, m)    storecompressed512(ptr, x, m)
+#define store_compressed_m768(ptr, x, m)    storecompressed768(ptr, x, m)
+#define store_compressed_m1024(ptr, x, m)   storecompressed1024(ptr, x, m)
 
 #define load_compressed_u32(x, ptr, m)      loadcompressed32(x, ptr, m)
 #define load_compressed_u64a(x, ptr, m)     loadcompressed64(x, ptr, m)
@@ -196,6 +232,8 @@
 #define load_compressed_m256(x, ptr, m)     loadcompressed256(x, ptr, m)
 #define load_compressed_m384(x, ptr, m)     loadcompressed384(x, ptr, m)
 #define load_compressed_m512(x, ptr, m)     loadcompressed512(x, ptr, m)
+#define load_compressed_m768(x, ptr, m)     loadcompressed768(x, ptr, m)
+#define load_compressed_m1024(x, ptr, m)    loadcompressed1024(x, ptr, m)
 
 static really_inline void clearbit_u32(u32 *p, u32 n) {
     assert(n < sizeof(*p) * 8);
@@ -209,6 +247,8 @@ static really_inline void clearbit_u64a(u64a *p, u32 n) {
 #define clearbit_m256(ptr, n)   (clearbit256(ptr, n))
 #define clearbit_m384(ptr, n)   (clearbit384(ptr, n))
 #define clearbit_m512(ptr, n)   (clearbit512(ptr, n))
+#define clearbit_m768(ptr, n)   (clearbit768(ptr, n))
+#define clearbit_m1024(ptr, n)  (clearbit1024(ptr, n))
 
 static really_inline char testbit_u32(const u32 *p, u32 n) {
     assert(n < sizeof(*p) * 8);
@@ -222,5 +262,7 @@ static really_inline char testbit_u64a(const u64a *p, u32 n) {
 #define testbit_m256(ptr, n)    (testbit256(ptr, n))
 #define testbit_m384(ptr, n)    (testbit384(ptr, n))
 #define testbit_m512(ptr, n)    (testbit512(ptr, n))
+#define testbit_m768(ptr, n)    (testbit768(ptr, n))
+#define testbit_m1024(ptr, n)   (testbit1024(ptr, n))
 
 #endif
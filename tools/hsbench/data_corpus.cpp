@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "data_corpus.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+using namespace std;
+
+namespace {
+
+// pcap file format constants
+static const uint32_t PCAP_MAGIC = 0xa1b2c3d4;
+static const uint32_t PCAP_MAGIC_NSEC = 0xa1b23c4d;
+static const size_t PCAP_FILE_HEADER_LEN = 24;
+static const size_t PCAP_RECORD_HEADER_LEN = 16;
+
+// link types we know how to unwrap
+static const uint32_t LINKTYPE_ETHERNET = 1;
+static const uint32_t LINKTYPE_RAW = 101;
+static const uint32_t LINKTYPE_LINUX_SLL = 113;
+
+static const uint16_t ETHERTYPE_IP = 0x0800;
+static const uint16_t ETHERTYPE_VLAN = 0x8100;
+static const uint16_t ETHERTYPE_IPV6 = 0x86dd;
+
+static const uint8_t IPPROTO_TCP_NUM = 6;
+static const uint8_t IPPROTO_UDP_NUM = 17;
+
+/** \brief Byte-order-aware reader over the whole capture. */
+class PcapReader {
+public:
+    PcapReader(const string &data_in, bool swapped_in)
+        : data(data_in), swapped(swapped_in) {}
+
+    uint32_t read32(size_t offset) const {
+        uint32_t v;
+        memcpy(&v, data.data() + offset, sizeof(v));
+        return swapped ? __builtin_bswap32(v) : v;
+    }
+
+private:
+    const string &data;
+    bool swapped;
+};
+
+static
+uint16_t readBE16(const unsigned char *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+/** \brief Addresses, ports and protocol: identifies a stream. */
+typedef tuple<string, string, uint16_t, uint16_t, uint8_t> FiveTuple;
+
+/**
+ * \brief Extract the transport payload and five-tuple from a network-layer
+ * packet. Returns false if the packet is not TCP or UDP over IP.
+ */
+static
+bool decodeIP(const unsigned char *pkt, size_t len, FiveTuple *ft,
+              size_t *payload_off, size_t *payload_len) {
+    if (len < 1) {
+        return false;
+    }
+
+    size_t ip_hlen;
+    size_t ip_len;
+    uint8_t proto;
+    string src, dst;
+
+    unsigned int version = pkt[0] >> 4;
+    if (version == 4) {
+        if (len < 20) {
+            return false;
+        }
+        ip_hlen = (pkt[0] & 0xf) * 4;
+        ip_len = readBE16(pkt + 2);
+        // ignore all but the first fragment
+        if (readBE16(pkt + 6) & 0x1fff) {
+            return false;
+        }
+        proto = pkt[9];
+        src.assign((const char *)pkt + 12, 4);
+        dst.assign((const char *)pkt + 16, 4);
+    } else if (version == 6) {
+        if (len < 40) {
+            return false;
+        }
+        ip_hlen = 40;
+        ip_len = 40 + readBE16(pkt + 4);
+        proto = pkt[6]; // extension headers are not followed
+        src.assign((const char *)pkt + 8, 16);
+        dst.assign((const char *)pkt + 24, 16);
+    } else {
+        return false;
+    }
+
+    if (ip_hlen < 20 || ip_len < ip_hlen) {
+        return false;
+    }
+    if (ip_len > len) {
+        ip_len = len; // truncated by the capture
+    }
+    if (ip_hlen + 8 > ip_len) {
+        return false;
+    }
+
+    const unsigned char *l4 = pkt + ip_hlen;
+    size_t l4_hlen;
+    if (proto == IPPROTO_TCP_NUM) {
+        if (ip_hlen + 20 > ip_len) {
+            return false;
+        }
+        l4_hlen = (l4[12] >> 4) * 4;
+        if (l4_hlen < 20) {
+            return false;
+        }
+    } else if (proto == IPPROTO_UDP_NUM) {
+        l4_hlen = 8;
+    } else {
+        return false;
+    }
+
+    if (ip_hlen + l4_hlen > ip_len) {
+        return false;
+    }
+
+    *ft = make_tuple(src, dst, readBE16(l4), readBE16(l4 + 2), proto);
+    *payload_off = ip_hlen + l4_hlen;
+    *payload_len = ip_len - ip_hlen - l4_hlen;
+    return true;
+}
+
+/** \brief Skip the link-layer header; returns false for packets that do not
+ * carry IP. */
+static
+bool skipLinkLayer(uint32_t linktype, const unsigned char *pkt, size_t len,
+                   size_t *offset) {
+    switch (linktype) {
+    case LINKTYPE_RAW:
+        *offset = 0;
+        return true;
+    case LINKTYPE_LINUX_SLL: {
+        if (len < 16) {
+            return false;
+        }
+        uint16_t type = readBE16(pkt + 14);
+        *offset = 16;
+        return type == ETHERTYPE_IP || type == ETHERTYPE_IPV6;
+    }
+    case LINKTYPE_ETHERNET: {
+        size_t off = 12;
+        if (len < off + 2) {
+            return false;
+        }
+        uint16_t type = readBE16(pkt + off);
+        while (type == ETHERTYPE_VLAN) {
+            off += 4;
+            if (len < off + 2) {
+                return false;
+            }
+            type = readBE16(pkt + off);
+        }
+        *offset = off + 2;
+        return type == ETHERTYPE_IP || type == ETHERTYPE_IPV6;
+    }
+    default:
+        return false;
+    }
+}
+
+static
+bool isPcap(const string &data, bool *swapped) {
+    if (data.size() < PCAP_FILE_HEADER_LEN) {
+        return false;
+    }
+    uint32_t magic;
+    memcpy(&magic, data.data(), sizeof(magic));
+    if (magic == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC) {
+        *swapped = false;
+        return true;
+    }
+    magic = __builtin_bswap32(magic);
+    if (magic == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC) {
+        *swapped = true;
+        return true;
+    }
+    return false;
+}
+
+static
+vector<DataBlock> readPcap(const string &data, bool swapped) {
+    PcapReader reader(data, swapped);
+    uint32_t linktype = reader.read32(20);
+    if (linktype != LINKTYPE_ETHERNET && linktype != LINKTYPE_RAW &&
+        linktype != LINKTYPE_LINUX_SLL) {
+        ostringstream oss;
+        oss << "Unsupported pcap link type " << linktype;
+        throw DataCorpusError(oss.str());
+    }
+
+    vector<DataBlock> blocks;
+    map<FiveTuple, unsigned int> streams;
+
+    size_t pos = PCAP_FILE_HEADER_LEN;
+    while (pos + PCAP_RECORD_HEADER_LEN <= data.size()) {
+        size_t caplen = reader.read32(pos + 8);
+        pos += PCAP_RECORD_HEADER_LEN;
+        if (caplen > data.size() - pos) {
+            throw DataCorpusError("Truncated pcap record");
+        }
+
+        const unsigned char *pkt = (const unsigned char *)data.data() + pos;
+        pos += caplen;
+
+        size_t link_len;
+        if (!skipLinkLayer(linktype, pkt, caplen, &link_len)) {
+            continue;
+        }
+
+        FiveTuple ft;
+        size_t off, len;
+        if (!decodeIP(pkt + link_len, caplen - link_len, &ft, &off, &len) ||
+            !len) {
+            continue;
+        }
+
+        auto it = streams.emplace(ft, (unsigned int)streams.size()).first;
+        const char *payload = (const char *)pkt + link_len + off;
+        blocks.emplace_back((unsigned int)blocks.size(), it->second,
+                            string(payload, len));
+    }
+
+    return blocks;
+}
+
+static
+vector<DataBlock> readRaw(const string &data, size_t block_size) {
+    vector<DataBlock> blocks;
+    for (size_t pos = 0; pos < data.size(); pos += block_size) {
+        blocks.emplace_back((unsigned int)blocks.size(), 0,
+                            data.substr(pos, block_size));
+    }
+    return blocks;
+}
+
+} // namespace
+
+vector<DataBlock> readCorpus(const string &filename, size_t block_size) {
+    ifstream f(filename, ios::binary);
+    if (!f.good()) {
+        throw DataCorpusError("Unable to open corpus file: " + filename);
+    }
+    string data((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+    if (f.bad()) {
+        throw DataCorpusError("Unable to read corpus file: " + filename);
+    }
+
+    bool swapped;
+    if (isPcap(data, &swapped)) {
+        return readPcap(data, swapped);
+    }
+
+    if (!block_size) {
+        throw DataCorpusError("Block size must be non-zero");
+    }
+    return readRaw(data, block_size);
+}
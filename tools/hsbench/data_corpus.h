@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DATA_CORPUS_H
+#define DATA_CORPUS_H
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** \brief A unit of corpus data: the payload of one packet, or one slice of
+ * a raw file. */
+struct DataBlock {
+    DataBlock(unsigned int id_in, unsigned int stream_id_in,
+              std::string payload_in)
+        : id(id_in), stream_id(stream_id_in), payload(std::move(payload_in)) {}
+
+    unsigned int id;        //!< index of this block in the corpus
+    unsigned int stream_id; //!< dense stream index, from zero
+    std::string payload;
+};
+
+class DataCorpusError : public std::runtime_error {
+public:
+    explicit DataCorpusError(const std::string &msg)
+        : std::runtime_error(msg) {}
+};
+
+/**
+ * \brief Read a corpus from the given file.
+ *
+ * A pcap capture is split into the TCP and UDP payloads of its IPv4 and IPv6
+ * packets, with the packets of each five-tuple forming a stream. Any other
+ * file is treated as raw data in a single stream, split into blocks of
+ * \a block_size bytes.
+ *
+ * Throws DataCorpusError on failure.
+ */
+std::vector<DataBlock> readCorpus(const std::string &filename,
+                                  size_t block_size);
+
+#endif // DATA_CORPUS_H
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "engine_hyperscan.h"
+
+#include "timer.h"
+#include "ExpressionParser.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+ScanCorpus::ScanCorpus(const vector<DataBlock> &blocks_in, ScanMode mode)
+    : blocks(blocks_in), stream_count(0), bytes(0) {
+    for (const auto &b : blocks) {
+        stream_count = max(stream_count, b.stream_id + 1);
+        bytes += b.payload.size();
+    }
+
+    if (mode == ScanMode::VECTORED) {
+        vectored.resize(stream_count);
+        for (const auto &b : blocks) {
+            Vectored &v = vectored[b.stream_id];
+            v.data.push_back(b.payload.data());
+            v.length.push_back((unsigned int)b.payload.size());
+        }
+    }
+}
+
+EngineContext::EngineContext(const hs_scratch_t *proto) {
+    hs_error_t err = hs_clone_scratch(proto, &scratch);
+    if (err != HS_SUCCESS) {
+        cerr << "Unable to clone scratch space (error " << err << ")."
+             << endl;
+        exit(1);
+    }
+}
+
+EngineContext::~EngineContext() {
+    hs_free_scratch(scratch);
+}
+
+static
+int onMatch(unsigned int, unsigned long long, unsigned long long,
+            unsigned int, void *ctx) {
+    ++((EngineContext *)ctx)->matches;
+    return 0;
+}
+
+EngineHyperscan::EngineHyperscan(hs_database_t *db_in, ScanMode mode,
+                                 double compile_secs_in)
+    : db(db_in), scan_mode(mode), compile_secs(compile_secs_in) {
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    if (err != HS_SUCCESS) {
+        cerr << "Unable to allocate scratch space (error " << err << ")."
+             << endl;
+        exit(1);
+    }
+}
+
+EngineHyperscan::~EngineHyperscan() {
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+unique_ptr<EngineContext> EngineHyperscan::makeContext() const {
+    return unique_ptr<EngineContext>(new EngineContext(scratch));
+}
+
+void EngineHyperscan::scanCorpus(const ScanCorpus &corpus,
+                                 EngineContext &ctx) const {
+    switch (scan_mode) {
+    case ScanMode::BLOCK:
+        scanBlocks(corpus, ctx);
+        break;
+    case ScanMode::STREAMING:
+        scanStreams(corpus, ctx);
+        break;
+    case ScanMode::VECTORED:
+        scanVectored(corpus, ctx);
+        break;
+    }
+}
+
+static
+void checkScan(hs_error_t err, const char *what) {
+    if (err != HS_SUCCESS) {
+        cerr << what << " failed (error " << err << ")." << endl;
+        exit(1);
+    }
+}
+
+void EngineHyperscan::scanBlocks(const ScanCorpus &corpus,
+                                 EngineContext &ctx) const {
+    for (const auto &b : corpus.blocks) {
+        hs_error_t err = hs_scan(db, b.payload.data(),
+                                 (unsigned int)b.payload.size(), 0,
+                                 ctx.scratch, onMatch, &ctx);
+        checkScan(err, "hs_scan");
+    }
+}
+
+void EngineHyperscan::scanStreams(const ScanCorpus &corpus,
+                                  EngineContext &ctx) const {
+    ctx.streams.assign(corpus.stream_count, nullptr);
+
+    for (const auto &b : corpus.blocks) {
+        hs_stream_t *&stream = ctx.streams[b.stream_id];
+        if (!stream) {
+            checkScan(hs_open_stream(db, 0, &stream), "hs_open_stream");
+        }
+        hs_error_t err = hs_scan_stream(stream, b.payload.data(),
+                                        (unsigned int)b.payload.size(), 0,
+                                        ctx.scratch, onMatch, &ctx);
+        checkScan(err, "hs_scan_stream");
+    }
+
+    for (auto &stream : ctx.streams) {
+        if (stream) {
+            hs_error_t err = hs_close_stream(stream, ctx.scratch, onMatch,
+                                             &ctx);
+            checkScan(err, "hs_close_stream");
+            stream = nullptr;
+        }
+    }
+}
+
+void EngineHyperscan::scanVectored(const ScanCorpus &corpus,
+                                   EngineContext &ctx) const {
+    for (const auto &v : corpus.vectored) {
+        if (v.data.empty()) {
+            continue;
+        }
+        hs_error_t err = hs_scan_vector(db, v.data.data(), v.length.data(),
+                                        (unsigned int)v.data.size(), 0,
+                                        ctx.scratch, onMatch, &ctx);
+        checkScan(err, "hs_scan_vector");
+    }
+}
+
+size_t EngineHyperscan::bytecodeSize() const {
+    size_t size = 0;
+    hs_database_size(db, &size);
+    return size;
+}
+
+size_t EngineHyperscan::streamStateSize() const {
+    size_t size = 0;
+    if (scan_mode == ScanMode::STREAMING) {
+        hs_stream_size(db, &size);
+    }
+    return size;
+}
+
+size_t EngineHyperscan::scratchSize() const {
+    size_t size = 0;
+    hs_scratch_size(scratch, &size);
+    return size;
+}
+
+string EngineHyperscan::info() const {
+    char *info = nullptr;
+    if (hs_database_info(db, &info) != HS_SUCCESS) {
+        return "unknown";
+    }
+    string s(info);
+    free(info);
+    return s;
+}
+
+unique_ptr<EngineHyperscan>
+buildEngineHyperscan(const ExpressionMap &exprs, ScanMode mode,
+                     unsigned int threads) {
+    vector<string> patterns;
+    vector<unsigned int> flags;
+    vector<unsigned int> ids;
+    vector<hs_expr_ext> ext;
+    bool som = false;
+
+    for (const auto &m : exprs) {
+        string expr;
+        unsigned int f = 0;
+        hs_expr_ext e;
+        if (!readExpression(m.second, expr, &f, &e)) {
+            cerr << "Unable to parse signature " << m.first << ": "
+                 << m.second << endl;
+            exit(1);
+        }
+        som |= !!(f & HS_FLAG_SOM_LEFTMOST);
+        patterns.push_back(expr);
+        flags.push_back(f);
+        ids.push_back(m.first);
+        ext.push_back(e);
+    }
+
+    vector<const char *> c_patterns;
+    vector<const hs_expr_ext_t *> c_ext;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        c_patterns.push_back(patterns[i].c_str());
+        c_ext.push_back(&ext[i]);
+    }
+
+    unsigned int hs_mode = 0;
+    switch (mode) {
+    case ScanMode::BLOCK:
+        hs_mode = HS_MODE_BLOCK;
+        break;
+    case ScanMode::STREAMING:
+        hs_mode = HS_MODE_STREAM;
+        if (som) {
+            hs_mode |= HS_MODE_SOM_HORIZON_LARGE;
+        }
+        break;
+    case ScanMode::VECTORED:
+        hs_mode = HS_MODE_VECTORED;
+        break;
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    Timer timer;
+    timer.start();
+    hs_error_t err = hs_compile_ext_multi_threaded(
+        c_patterns.data(), flags.data(), ids.data(), c_ext.data(),
+        (unsigned int)c_patterns.size(), hs_mode, nullptr, threads, &db,
+        &compile_err);
+    timer.complete();
+
+    if (err != HS_SUCCESS) {
+        cerr << "Compile failed";
+        if (compile_err) {
+            if (compile_err->expression >= 0) {
+                cerr << " for signature "
+                     << ids[compile_err->expression];
+            }
+            cerr << ": " << compile_err->message;
+            hs_free_compile_error(compile_err);
+        }
+        cerr << endl;
+        exit(1);
+    }
+
+    return unique_ptr<EngineHyperscan>(
+        new EngineHyperscan(db, mode, timer.seconds()));
+}
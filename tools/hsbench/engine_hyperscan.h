@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENGINE_HYPERSCAN_H
+#define ENGINE_HYPERSCAN_H
+
+#include "common.h"
+#include "data_corpus.h"
+#include "expressions.h"
+
+#include "hs_compile.h"
+#include "hs_runtime.h"
+
+#include <memory>
+#include <vector>
+
+/** \brief The corpus, laid out for scanning in a particular mode. */
+struct ScanCorpus {
+    ScanCorpus(const std::vector<DataBlock> &blocks, ScanMode mode);
+
+    /** \brief One stream's blocks, in order, for hs_scan_vector. */
+    struct Vectored {
+        std::vector<const char *> data;
+        std::vector<unsigned int> length;
+    };
+
+    const std::vector<DataBlock> &blocks;
+    unsigned int stream_count;
+    size_t bytes;
+    std::vector<Vectored> vectored; //!< only populated in vectored mode
+};
+
+/** \brief Per-thread scan state: a scratch cloned from the engine's, plus
+ * the open streams in streaming mode. */
+class EngineContext {
+public:
+    explicit EngineContext(const hs_scratch_t *proto);
+    ~EngineContext();
+
+    EngineContext(const EngineContext &) = delete;
+    EngineContext &operator=(const EngineContext &) = delete;
+
+    hs_scratch_t *scratch = nullptr;
+    std::vector<hs_stream_t *> streams;
+    size_t matches = 0;
+};
+
+/** \brief A compiled database and the prototype scratch for it. */
+class EngineHyperscan {
+public:
+    EngineHyperscan(hs_database_t *db, ScanMode mode, double compile_secs);
+    ~EngineHyperscan();
+
+    EngineHyperscan(const EngineHyperscan &) = delete;
+    EngineHyperscan &operator=(const EngineHyperscan &) = delete;
+
+    std::unique_ptr<EngineContext> makeContext() const;
+
+    /** \brief Scan the whole corpus once in the engine's mode, accumulating
+     * matches in the context. */
+    void scanCorpus(const ScanCorpus &corpus, EngineContext &ctx) const;
+
+    ScanMode mode() const { return scan_mode; }
+    double compileSeconds() const { return compile_secs; }
+    size_t bytecodeSize() const;
+    size_t streamStateSize() const;
+    size_t scratchSize() const;
+    std::string info() const;
+
+private:
+    void scanBlocks(const ScanCorpus &corpus, EngineContext &ctx) const;
+    void scanStreams(const ScanCorpus &corpus, EngineContext &ctx) const;
+    void scanVectored(const ScanCorpus &corpus, EngineContext &ctx) const;
+
+    hs_database_t *db;
+    hs_scratch_t *scratch = nullptr;
+    ScanMode scan_mode;
+    double compile_secs;
+};
+
+/**
+ * \brief Compile the given expressions for the given mode, using up to
+ * \a threads compile threads. Exits on failure.
+ */
+std::unique_ptr<EngineHyperscan>
+buildEngineHyperscan(const ExpressionMap &exprs, ScanMode mode,
+                     unsigned int threads);
+
+#endif // ENGINE_HYPERSCAN_H
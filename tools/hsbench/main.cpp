@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief hsbench: measure Hyperscan throughput on a corpus.
+ *
+ * Compiles a pattern set, then scans a corpus (a pcap capture or raw data)
+ * repeatedly from one or more threads, each with its own clone of the
+ * scratch space, and reports compile statistics and scan throughput.
+ * Optionally each pattern is also compiled and timed alone, to find the
+ * patterns that cost the most.
+ */
+
+#include "config.h"
+
+#include "common.h"
+#include "data_corpus.h"
+#include "engine_hyperscan.h"
+#include "expressions.h"
+#include "thread_barrier.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#if defined(HAVE_DECL_PTHREAD_SETAFFINITY_NP)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+struct Options {
+    string sigfile;
+    string corpus;
+    ScanMode mode = ScanMode::BLOCK;
+    size_t block_size = 4096;
+    unsigned int repeats = 20;
+    unsigned int threads = 1;
+    vector<int> cores; //!< if non-empty, one pinned thread per core
+    unsigned int compile_threads = 1;
+    unsigned int per_pattern = 0; //!< number of costliest patterns to show
+};
+
+/** \brief Result of one benchmark thread. */
+struct ThreadResult {
+    double seconds = 0;
+    size_t matches = 0;
+};
+
+} // namespace
+
+static
+void usage(const char *name, const char *error) {
+    cerr << "Usage: " << name << " [OPTIONS] -e PATTERNS -c CORPUS" << endl
+         << endl
+         << "  -e PATH    pattern file, or directory of pattern files" << endl
+         << "  -c FILE    corpus: a pcap capture, or raw data" << endl
+         << "  -B BYTES   block size used to split a raw corpus "
+            "(default 4096)" << endl
+         << "  -N         block mode (default)" << endl
+         << "  -S         streaming mode" << endl
+         << "  -V         vectored mode" << endl
+         << "  -n NUM     scan the corpus NUM times per thread (default 20)"
+         << endl
+         << "  -j NUM     scan from NUM threads" << endl
+         << "  -T CORES   scan from one thread per core in the "
+            "comma-separated list," << endl
+         << "             pinning each thread to its core" << endl
+         << "  -C NUM     compile with NUM threads, 0 for one per hardware "
+            "thread" << endl
+         << "             (default 1)" << endl
+         << "  -P NUM     also time each pattern alone and report the NUM "
+            "costliest" << endl
+         << "  -h         display this help" << endl;
+    if (error) {
+        cerr << endl << "Error: " << error << endl;
+        exit(1);
+    }
+    exit(0);
+}
+
+static
+unsigned int parseUnsigned(const char *name, const char *s) {
+    char *end;
+    unsigned long v = strtoul(s, &end, 10);
+    if (!*s || *end || v > ~0U) {
+        usage(name, "invalid numeric argument");
+    }
+    return (unsigned int)v;
+}
+
+static
+vector<int> parseCores(const char *name, const string &s) {
+    vector<int> cores;
+    istringstream iss(s);
+    string tok;
+    while (getline(iss, tok, ',')) {
+        cores.push_back((int)parseUnsigned(name, tok.c_str()));
+    }
+    if (cores.empty()) {
+        usage(name, "no cores given to -T");
+    }
+    return cores;
+}
+
+static
+Options processArgs(int argc, char *argv[]) {
+    Options opts;
+    const char *name = argv[0];
+    int c;
+    while ((c = getopt(argc, argv, "e:c:B:NSVn:j:T:C:P:h")) != -1) {
+        switch (c) {
+        case 'e':
+            opts.sigfile = optarg;
+            break;
+        case 'c':
+            opts.corpus = optarg;
+            break;
+        case 'B':
+            opts.block_size = parseUnsigned(name, optarg);
+            break;
+        case 'N':
+            opts.mode = ScanMode::BLOCK;
+            break;
+        case 'S':
+            opts.mode = ScanMode::STREAMING;
+            break;
+        case 'V':
+            opts.mode = ScanMode::VECTORED;
+            break;
+        case 'n':
+            opts.repeats = parseUnsigned(name, optarg);
+            break;
+        case 'j':
+            opts.threads = parseUnsigned(name, optarg);
+            break;
+        case 'T':
+            opts.cores = parseCores(name, optarg);
+            break;
+        case 'C':
+            opts.compile_threads = parseUnsigned(name, optarg);
+            break;
+        case 'P':
+            opts.per_pattern = parseUnsigned(name, optarg);
+            break;
+        case 'h':
+            usage(name, nullptr);
+            break;
+        default:
+            usage(name, "unrecognised option");
+            break;
+        }
+    }
+
+    if (optind != argc) {
+        usage(name, "unexpected arguments");
+    }
+    if (opts.sigfile.empty()) {
+        usage(name, "no pattern file given");
+    }
+    if (opts.corpus.empty()) {
+        usage(name, "no corpus given");
+    }
+    if (!opts.block_size) {
+        usage(name, "block size must be non-zero");
+    }
+    if (!opts.repeats) {
+        usage(name, "repeat count must be non-zero");
+    }
+    if (!opts.cores.empty()) {
+        opts.threads = (unsigned int)opts.cores.size();
+    }
+    if (!opts.threads) {
+        usage(name, "thread count must be non-zero");
+    }
+
+    return opts;
+}
+
+static
+void pinToCore(int core) {
+#if defined(HAVE_DECL_PTHREAD_SETAFFINITY_NP)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset)) {
+        cerr << "Warning: unable to pin thread to core " << core << endl;
+    }
+#else
+    cerr << "Warning: thread pinning is not supported on this platform; "
+         << "core " << core << " ignored" << endl;
+#endif
+}
+
+static
+void benchThread(const EngineHyperscan &engine, const ScanCorpus &corpus,
+                 unsigned int repeats, int core, ThreadBarrier &barrier,
+                 ThreadResult &result) {
+    if (core >= 0) {
+        pinToCore(core);
+    }
+
+    auto ctx = engine.makeContext();
+
+    // Start all threads together, so that they contend for the memory
+    // system the same way for the whole run.
+    barrier.wait();
+
+    Timer timer;
+    timer.start();
+    for (unsigned int i = 0; i < repeats; i++) {
+        engine.scanCorpus(corpus, *ctx);
+    }
+    timer.complete();
+
+    result.seconds = timer.seconds();
+    result.matches = ctx->matches;
+}
+
+static
+const char *modeName(ScanMode mode) {
+    switch (mode) {
+    case ScanMode::BLOCK:
+        return "block";
+    case ScanMode::STREAMING:
+        return "streaming";
+    case ScanMode::VECTORED:
+        return "vectored";
+    }
+    return "unknown";
+}
+
+static
+double gbitPerSec(size_t bytes, double secs) {
+    return secs > 0 ? (double)bytes * 8 / secs / 1e9 : 0;
+}
+
+static
+void printEngineInfo(const EngineHyperscan &engine, size_t sig_count) {
+    cout << "Signatures:        " << sig_count << endl
+         << "Hyperscan info:    " << engine.info() << endl
+         << "Compile time:      " << fixed << setprecision(3)
+         << engine.compileSeconds() << " seconds" << endl
+         << "Bytecode size:     " << engine.bytecodeSize() << " bytes"
+         << endl;
+    if (engine.mode() == ScanMode::STREAMING) {
+        cout << "Stream state size: " << engine.streamStateSize() << " bytes"
+             << endl;
+    }
+    cout << "Scratch size:      " << engine.scratchSize() << " bytes" << endl;
+}
+
+static
+void runBenchmark(const EngineHyperscan &engine, const ScanCorpus &corpus,
+                  const Options &opts) {
+    vector<ThreadResult> results(opts.threads);
+    ThreadBarrier barrier(opts.threads);
+    vector<thread> threads;
+
+    for (unsigned int i = 0; i < opts.threads; i++) {
+        int core = opts.cores.empty() ? -1 : opts.cores[i];
+        threads.emplace_back(benchThread, cref(engine), cref(corpus),
+                             opts.repeats, core, ref(barrier),
+                             ref(results[i]));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    size_t per_thread_bytes = corpus.bytes * opts.repeats;
+    double slowest = 0;
+    size_t total_matches = 0;
+    double sum_rate = 0;
+    for (const auto &r : results) {
+        slowest = max(slowest, r.seconds);
+        total_matches += r.matches;
+        sum_rate += gbitPerSec(per_thread_bytes, r.seconds);
+    }
+
+    cout << endl
+         << "Mode:              " << modeName(engine.mode()) << endl
+         << "Threads:           " << opts.threads;
+    if (!opts.cores.empty()) {
+        cout << " (pinned)";
+    }
+    cout << endl
+         << "Repeats:           " << opts.repeats << endl
+         << "Matches per scan:  " << results[0].matches / opts.repeats
+         << endl
+         << "Match rate:        " << setprecision(4)
+         << (corpus.bytes ? (double)results[0].matches / opts.repeats * 1024
+                                / corpus.bytes
+                          : 0)
+         << " matches/kilobyte" << endl
+         << "Time spent:        " << setprecision(3) << slowest
+         << " seconds" << endl
+         << "Throughput:        " << setprecision(3)
+         << sum_rate / opts.threads << " Gbit/s per thread (mean)" << endl
+         << "Aggregate:         "
+         << gbitPerSec(per_thread_bytes * opts.threads, slowest)
+         << " Gbit/s" << endl
+         << "Match throughput:  " << setprecision(0)
+         << (slowest > 0 ? total_matches / slowest : 0) << " matches/sec"
+         << endl;
+}
+
+namespace {
+
+struct PatternCost {
+    unsigned int id;
+    double compile_secs;
+    double scan_secs;
+    size_t bytecode_size;
+    size_t matches;
+};
+
+} // namespace
+
+/** \brief Compile each pattern alone and time a single-threaded scan of the
+ * corpus with it, reporting the costliest. */
+static
+void runPerPattern(const ExpressionMap &exprs, const vector<DataBlock> &blocks,
+                   const Options &opts) {
+    const ScanCorpus corpus(blocks, opts.mode);
+    vector<PatternCost> costs;
+
+    for (const auto &m : exprs) {
+        ExpressionMap single;
+        single.insert(m);
+        auto engine = buildEngineHyperscan(single, opts.mode,
+                                           opts.compile_threads);
+        auto ctx = engine->makeContext();
+
+        Timer timer;
+        timer.start();
+        for (unsigned int i = 0; i < opts.repeats; i++) {
+            engine->scanCorpus(corpus, *ctx);
+        }
+        timer.complete();
+
+        costs.push_back({m.first, engine->compileSeconds(), timer.seconds(),
+                         engine->bytecodeSize(), ctx->matches / opts.repeats});
+    }
+
+    sort(costs.begin(), costs.end(),
+         [](const PatternCost &a, const PatternCost &b) {
+             return a.scan_secs > b.scan_secs;
+         });
+    if (costs.size() > opts.per_pattern) {
+        costs.resize(opts.per_pattern);
+    }
+
+    cout << endl
+         << "Costliest patterns, scanned alone:" << endl
+         << setw(10) << "id" << setw(12) << "Gbit/s" << setw(12)
+         << "matches" << setw(12) << "compile(s)" << setw(12) << "bytecode"
+         << "  pattern" << endl;
+    size_t bytes = corpus.bytes * opts.repeats;
+    for (const auto &c : costs) {
+        cout << setw(10) << c.id << setw(12) << setprecision(3)
+             << gbitPerSec(bytes, c.scan_secs) << setw(12) << c.matches
+             << setw(12) << c.compile_secs << setw(12) << c.bytecode_size
+             << "  " << exprs.at(c.id) << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Options opts = processArgs(argc, argv);
+
+    ExpressionMap exprs;
+    loadExpressions(opts.sigfile, exprs);
+    if (exprs.empty()) {
+        cerr << "No signatures loaded from " << opts.sigfile << endl;
+        return 1;
+    }
+
+    vector<DataBlock> blocks;
+    try {
+        blocks = readCorpus(opts.corpus, opts.block_size);
+    } catch (const DataCorpusError &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    if (blocks.empty()) {
+        cerr << "Corpus " << opts.corpus << " contains no data" << endl;
+        return 1;
+    }
+
+    auto engine = buildEngineHyperscan(exprs, opts.mode,
+                                       opts.compile_threads);
+    const ScanCorpus corpus(blocks, opts.mode);
+
+    printEngineInfo(*engine, exprs.size());
+    cout << "Corpus:            " << blocks.size() << " blocks in "
+         << corpus.stream_count << " streams, " << corpus.bytes << " bytes"
+         << endl;
+
+    runBenchmark(*engine, corpus, opts);
+
+    if (opts.per_pattern) {
+        runPerPattern(exprs, blocks, opts);
+    }
+
+    return 0;
+}
@@ -54,6 +54,12 @@ int singleHandler(unsigned id, unsigned long long from,
     return 0;
 }
 
+// Dummy batch callback: does nothing, returns 0 (keep matching)
+static
+int dummy_batch_cb(const hs_match_t *, unsigned, void *) {
+    return 0;
+}
+
 namespace /* anonymous */ {
 
 // Break the magic number of the given database.
@@ -327,6 +333,136 @@ TEST(HyperscanArgChecks, MultiCompileStreamingNoDatabase) {
     hs_free_compile_error(compile_err);
 }
 
+// hs_compile_lit_multi: Compile a set of literals with no lengths
+TEST(HyperscanArgChecks, LitMultiCompileNoLens) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    const char *expr[] = {"foobar"};
+    hs_error_t err = hs_compile_lit_multi(expr, nullptr, nullptr, nullptr, 1,
+                                          HS_MODE_BLOCK, nullptr, &db,
+                                          &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(db == nullptr);
+    EXPECT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+}
+
+// hs_compile_lit_multi: Compile a set of zero literals
+TEST(HyperscanArgChecks, LitMultiCompileZeroPatterns) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    const char *expr[] = {"foobar"};
+    size_t lens[] = {6};
+    hs_error_t err = hs_compile_lit_multi(expr, nullptr, nullptr, lens, 0,
+                                          HS_MODE_BLOCK, nullptr, &db,
+                                          &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(db == nullptr);
+    EXPECT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+}
+
+// hs_compile_lit: Compile a literal to a NULL database ptr
+TEST(HyperscanArgChecks, LitCompileNoDatabase) {
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_lit("foobar", 0, 6, HS_MODE_BLOCK, nullptr,
+                                    nullptr, &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+}
+
+// hs_compile_ext_multi_threaded: Compile a pattern to a NULL database ptr
+TEST(HyperscanArgChecks, ThreadedCompileNoDatabase) {
+    hs_compile_error_t *compile_err = nullptr;
+    const char *expr[] = {"foobar"};
+    hs_error_t err = hs_compile_ext_multi_threaded(expr, nullptr, nullptr,
+                                                   nullptr, 1, HS_MODE_BLOCK,
+                                                   nullptr, 4, nullptr,
+                                                   &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+}
+
+// hs_compile_ext_multi_threaded: Compile a set of zero patterns
+TEST(HyperscanArgChecks, ThreadedCompileZeroPatterns) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    const char *expr[] = {"foobar"};
+    hs_error_t err = hs_compile_ext_multi_threaded(expr, nullptr, nullptr,
+                                                   nullptr, 0, HS_MODE_BLOCK,
+                                                   nullptr, 4, &db,
+                                                   &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(db == nullptr);
+    EXPECT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+}
+
+// hs_compile_ext_multi_threaded: with several bad patterns, the error for the
+// first of them must be reported, as it is for a single threaded compile
+TEST(HyperscanArgChecks, ThreadedCompileFirstErrorReported) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    const char *expr[] = {"foo", "bar", "(baz", "qux", "[quux"};
+    hs_error_t err = hs_compile_ext_multi_threaded(expr, nullptr, nullptr,
+                                                   nullptr, 5, HS_MODE_BLOCK,
+                                                   nullptr, 4, &db,
+                                                   &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(db == nullptr);
+    ASSERT_TRUE(compile_err != nullptr);
+    EXPECT_EQ(2, compile_err->expression);
+    hs_free_compile_error(compile_err);
+}
+
+// hs_alloc_compile_cache: NULL cache ptr
+TEST(HyperscanArgChecks, AllocCompileCacheNull) {
+    hs_error_t err = hs_alloc_compile_cache(nullptr);
+    EXPECT_EQ(HS_INVALID, err);
+}
+
+// hs_free_compile_cache: NULL cache
+TEST(HyperscanArgChecks, FreeCompileCacheNull) {
+    hs_error_t err = hs_free_compile_cache(nullptr);
+    EXPECT_EQ(HS_SUCCESS, err);
+}
+
+// hs_compile_cache_stats: NULL cache or stats ptr
+TEST(HyperscanArgChecks, CompileCacheStatsNull) {
+    hs_compile_cache_t *cache = nullptr;
+    hs_error_t err = hs_alloc_compile_cache(&cache);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(cache != nullptr);
+
+    hs_compile_cache_stats_t stats;
+    err = hs_compile_cache_stats(nullptr, &stats);
+    EXPECT_EQ(HS_INVALID, err);
+    err = hs_compile_cache_stats(cache, nullptr);
+    EXPECT_EQ(HS_INVALID, err);
+
+    hs_free_compile_cache(cache);
+}
+
+// hs_compile_ext_multi_cached: Compile a pattern to a NULL database ptr
+TEST(HyperscanArgChecks, CachedCompileNoDatabase) {
+    hs_compile_cache_t *cache = nullptr;
+    hs_error_t err = hs_alloc_compile_cache(&cache);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_compile_error_t *compile_err = nullptr;
+    const char *expr[] = {"foobar"};
+    err = hs_compile_ext_multi_cached(expr, nullptr, nullptr, nullptr, 1,
+                                      HS_MODE_BLOCK, nullptr, 1, cache,
+                                      nullptr, &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+
+    hs_free_compile_cache(cache);
+}
+
 // hs_open_stream: Open a stream with a NULL database ptr
 TEST(HyperscanArgChecks, OpenStreamNoDatabase) {
     hs_stream_t *stream = nullptr;
@@ -837,6 +973,160 @@ TEST(HyperscanArgChecks, ResetAndCopyStreamDiffDb) {
     hs_free_database(db2);
 }
 
+// hs_compress_stream: Call with no stream or no used_space
+TEST(HyperscanArgChecks, CompressStreamBadArgs) {
+    hs_stream_t *stream = nullptr;
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[1024];
+    size_t used = 0;
+    err = hs_compress_stream(nullptr, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_compress_stream(stream, buf, sizeof(buf), nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_compress_stream(stream, nullptr, sizeof(buf), &used);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_close_stream(stream, nullptr, nullptr, nullptr);
+    hs_free_database(db);
+}
+
+// hs_expand_stream: Call with bad arguments, or a non-streaming database
+TEST(HyperscanArgChecks, ExpandStreamBadArgs) {
+    hs_stream_t *stream = nullptr;
+    hs_database_t *db = nullptr;
+    hs_database_t *block_db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &block_db,
+                     &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[1024];
+    size_t used = 0;
+    err = hs_compress_stream(stream, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_stream_t *stream2 = nullptr;
+    err = hs_expand_stream(nullptr, &stream2, buf, used);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_expand_stream(db, nullptr, buf, used);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_expand_stream(db, &stream2, nullptr, used);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_expand_stream(db, &stream2, buf, 0);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_expand_stream(block_db, &stream2, buf, used);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+    ASSERT_EQ(nullptr, stream2);
+
+    hs_close_stream(stream, nullptr, nullptr, nullptr);
+    hs_free_database(db);
+    hs_free_database(block_db);
+}
+
+// hs_reset_and_expand_stream: If you specify a callback, you must provide
+// scratch.
+TEST(HyperscanArgChecks, ResetAndExpandStreamNoScratch) {
+    hs_stream_t *stream = nullptr;
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[1024];
+    size_t used = 0;
+    err = hs_compress_stream(stream, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_reset_and_expand_stream(nullptr, buf, used, nullptr, nullptr,
+                                     nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_reset_and_expand_stream(stream, buf, used, nullptr, dummy_cb,
+                                     nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_close_stream(stream, nullptr, nullptr, nullptr);
+    hs_free_database(db);
+}
+
+// hs_open_stream_at: Call with bad arguments, or a non-streaming database
+TEST(HyperscanArgChecks, OpenStreamAtBadArgs) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    unsigned long long buf[128];
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream_at(nullptr, 0, buf, sizeof(buf), &stream);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_open_stream_at(db, 0, nullptr, sizeof(buf), &stream);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_open_stream_at(db, 0, buf, sizeof(buf), nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_open_stream_at(db, 0, buf, sizeof(buf), &stream);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+    ASSERT_EQ(nullptr, stream);
+
+    err = hs_close_stream_at(nullptr, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_free_database(db);
+}
+
+// hs_alloc_stream_pool: Call with bad arguments, or a non-streaming database
+TEST(HyperscanArgChecks, AllocStreamPoolBadArgs) {
+    hs_database_t *db = nullptr;
+    hs_database_t *block_db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &block_db,
+                     &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_stream_pool_t *pool = nullptr;
+    err = hs_alloc_stream_pool(nullptr, 1, &pool);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_alloc_stream_pool(db, 1, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_alloc_stream_pool(db, 0, &pool);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_alloc_stream_pool(block_db, 1, &pool);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+    ASSERT_EQ(nullptr, pool);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream_pooled(nullptr, 0, &stream);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_close_stream_pooled(nullptr, stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_free_stream_pool(nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_free_database(db);
+    hs_free_database(block_db);
+}
+
 // hs_scan: Call with no database
 TEST(HyperscanArgChecks, ScanBlockNoDatabase) {
     hs_database_t *db = nullptr;
@@ -1285,6 +1575,425 @@ TEST(HyperscanArgChecks, ScanVectorNoHandler) {
     hs_free_database(db);
 }
 
+// hs_scan_small: Call with no database
+TEST(HyperscanArgChecks, ScanSmallNoDatabase) {
+    hs_error_t err = hs_scan_small(nullptr, "data", 4, 0, dummy_cb, nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+}
+
+// hs_scan_small: Call with a database built for streaming mode
+TEST(HyperscanArgChecks, ScanSmallStreamingDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    err = hs_scan_small(db, "data", 4, 0, dummy_cb, nullptr);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+
+    // teardown
+    hs_free_database(db);
+}
+
+// hs_scan_small: Call with no data
+TEST(HyperscanArgChecks, ScanSmallNoData) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    err = hs_scan_small(db, nullptr, 4, 0, dummy_cb, nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    hs_free_database(db);
+}
+
+// hs_scan_small: Call with a database that needs scratch
+TEST(HyperscanArgChecks, ScanSmallScratchRequired) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foo.*bar", HS_FLAG_SOM_LEFTMOST,
+                                HS_MODE_BLOCK, nullptr, &db, &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    err = hs_scan_small(db, "data", 4, 0, dummy_cb, nullptr);
+    ASSERT_EQ(HS_SCRATCH_REQUIRED, err);
+
+    // teardown
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with no database
+TEST(HyperscanArgChecks, ScanBatchNoDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    const hs_block_t blocks[] = { { "data", 4, nullptr },
+                                  { "data", 4, nullptr } };
+    err = hs_scan_batch(nullptr, blocks, 2, 0, scratch, dummy_cb);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with a database built for streaming mode
+TEST(HyperscanArgChecks, ScanBatchStreamingDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    const hs_block_t blocks[] = { { "data", 4, nullptr },
+                                  { "data", 4, nullptr } };
+    err = hs_scan_batch(db, blocks, 2, 0, scratch, dummy_cb);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with null block array
+TEST(HyperscanArgChecks, ScanBatchNoBlockArray) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    err = hs_scan_batch(db, nullptr, 2, 0, scratch, dummy_cb);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with a block with null data
+TEST(HyperscanArgChecks, ScanBatchNoDataBlock) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    const hs_block_t blocks[] = { { "data", 4, nullptr },
+                                  { nullptr, 4, nullptr } };
+    err = hs_scan_batch(db, blocks, 2, 0, scratch, dummy_cb);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with no scratch
+TEST(HyperscanArgChecks, ScanBatchNoScratch) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    const hs_block_t blocks[] = { { "data", 4, nullptr },
+                                  { "data", 4, nullptr } };
+    err = hs_scan_batch(db, blocks, 2, 0, nullptr, dummy_cb);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    hs_free_database(db);
+}
+
+// hs_scan_buffered: Call with no batch callback
+TEST(HyperscanArgChecks, ScanBufferedNoCallback) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    err = hs_scan_buffered(db, "foobar", 6, 0, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_buffered: Call with a database built for streaming mode
+TEST(HyperscanArgChecks, ScanBufferedStreamingDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    err = hs_scan_buffered(db, "foobar", 6, 0, scratch, dummy_batch_cb,
+                           nullptr);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_buffered: Call with no scratch
+TEST(HyperscanArgChecks, ScanBufferedNoScratch) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    err = hs_scan_buffered(db, "foobar", 6, 0, nullptr, dummy_batch_cb,
+                           nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    hs_free_database(db);
+}
+
+// hs_scan_stream_buffered: Call with no stream
+TEST(HyperscanArgChecks, ScanStreamBufferedNoStream) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    err = hs_scan_stream_buffered(nullptr, "data", 4, 0, scratch,
+                                  dummy_batch_cb, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_close_stream_buffered: Call with no batch callback
+TEST(HyperscanArgChecks, CloseStreamBufferedNoCallback) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    err = hs_close_stream_buffered(stream, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    err = hs_close_stream(stream, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_counter_size: Call with no database
+TEST(HyperscanArgChecks, CounterSizeNoDatabase) {
+    unsigned int count = 0;
+    hs_error_t err = hs_counter_size(nullptr, &count);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+// hs_counter_index: Call with no index
+TEST(HyperscanArgChecks, CounterIndexNoIndex) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    err = hs_counter_index(db, 0, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    hs_free_database(db);
+}
+
+// hs_scan_count: Call with no counter array
+TEST(HyperscanArgChecks, ScanCountNoCounts) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    err = hs_scan_count(db, "foobar", 6, 0, scratch, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_stream_count: Call with no scratch
+TEST(HyperscanArgChecks, ScanStreamCountNoScratch) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    unsigned long long counts[1] = { 0 };
+    err = hs_scan_stream_count(stream, "foobar", 6, 0, nullptr, counts);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_close_stream_count(stream, nullptr, counts);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    err = hs_close_stream(stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_set_scratch_budget: Call with no scratch
+TEST(HyperscanArgChecks, SetScratchBudgetNoScratch) {
+    hs_scan_budget_t budget;
+    budget.max_literal_matches = 1;
+    budget.max_cycles = 0;
+    hs_error_t err = hs_set_scratch_budget(nullptr, &budget);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+// hs_scratch_budget_offset: Call with no offset
+TEST(HyperscanArgChecks, ScratchBudgetOffsetNoOffset) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    err = hs_scratch_budget_offset(scratch, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    unsigned long long offset;
+    err = hs_scratch_budget_offset(nullptr, &offset);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_open_block_scan: Call with a streaming database
+TEST(HyperscanArgChecks, OpenBlockScanStreamingDatabase) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    hs_block_scan_t *scan = nullptr;
+    err = hs_open_block_scan(db, "data", 4, 0, scratch, dummy_cb, nullptr,
+                             &scan);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+    ASSERT_TRUE(scan == nullptr);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_open_block_scan: Call with no scan pointer
+TEST(HyperscanArgChecks, OpenBlockScanNoScan) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    err = hs_open_block_scan(db, "data", 4, 0, scratch, dummy_cb, nullptr,
+                             nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_advance_block_scan, hs_finish_block_scan: Call with no scan
+TEST(HyperscanArgChecks, AdvanceBlockScanNoScan) {
+    unsigned long long offset = 0;
+    hs_error_t err = hs_advance_block_scan(nullptr, 100, &offset);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_finish_block_scan(nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
 // hs_alloc_scratch: Call with no database
 TEST(HyperscanArgChecks, AllocScratchNoDatabase) {
     hs_scratch_t *scratch = nullptr;
@@ -1976,6 +2685,38 @@ TEST(HyperscanArgChecks, ScratchSizeBadScratch) {
     ASSERT_EQ(HS_INVALID, err);
 }
 
+TEST(HyperscanArgChecks, ScratchProfileNoScratch) {
+    hs_profile_t profile;
+    hs_error_t err = hs_scratch_profile(nullptr, &profile);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+TEST(HyperscanArgChecks, ScratchProfileNoProfile) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_scratch_profile(scratch, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanArgChecks, ScratchProfileBadScratch) {
+    hs_scratch_t *scratch = (hs_scratch_t *)garbage;
+    hs_profile_t profile;
+    hs_error_t err = hs_scratch_profile(scratch, &profile);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+TEST(HyperscanArgChecks, ResetScratchProfileNoScratch) {
+    hs_error_t err = hs_reset_scratch_profile(nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
 // hs_clone_scratch: bad scratch arg
 TEST(HyperscanArgChecks, CloneBadScratch) {
     // Try cloning the scratch
@@ -2267,6 +3008,10 @@ static const unsigned badModeValues[] = {
     HS_MODE_STREAM | HS_MODE_SOM_HORIZON_LARGE | HS_MODE_SOM_HORIZON_SMALL,
     HS_MODE_STREAM | HS_MODE_SOM_HORIZON_LARGE | HS_MODE_SOM_HORIZON_MEDIUM,
     HS_MODE_STREAM | HS_MODE_SOM_HORIZON_MEDIUM | HS_MODE_SOM_HORIZON_SMALL,
+    // The any-match flag is not a mode on its own.
+    HS_MODE_ANYMATCH,
+    // Unrecognised mode flags.
+    HS_MODE_BLOCK | (1U << 31),
 };
 
 INSTANTIATE_TEST_CASE_P(HyperscanArgChecks, BadModeTest,
@@ -29,6 +29,7 @@
 #include "config.h"
 #include <algorithm>
 #include <climits>
+#include <map>
 #include <sstream>
 #include <string>
 
@@ -1148,6 +1149,1351 @@ TEST(HyperscanTestBehaviour, Vectored7) {
     hs_free_database(db);
 }
 
+TEST(HyperscanTestBehaviour, Batch1) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo.*bar", HS_FLAG_DOTALL, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // each block is scanned independently, so only the last two match
+    CallBackContext c[4];
+    const hs_block_t blocks[] = { { "foo", 3, &c[0] },
+                                  { "bar", 3, &c[1] },
+                                  { "foo   bar", 9, &c[2] },
+                                  { "xxfoobarbar", 11, &c[3] } };
+
+    err = hs_scan_batch(db, blocks, 4, 0, scratch, record_cb);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    EXPECT_TRUE(c[0].matches.empty());
+    EXPECT_TRUE(c[1].matches.empty());
+    ASSERT_EQ(1U, c[2].matches.size());
+    EXPECT_EQ(MatchRecord(9, 0), c[2].matches[0]);
+    ASSERT_EQ(2U, c[3].matches.size());
+    EXPECT_EQ(MatchRecord(8, 0), c[3].matches[0]);
+    EXPECT_EQ(MatchRecord(11, 0), c[3].matches[1]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, Batch2) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("$", HS_FLAG_ALLOWEMPTY, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // empty blocks still produce their vacuous end-of-data match
+    const hs_block_t blocks[] = { { "", 0, nullptr },
+                                  { "foo", 3, nullptr },
+                                  { "", 0, nullptr } };
+
+    matchCount = 0;
+    err = hs_scan_batch(db, blocks, 3, 0, scratch, countHandler);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(3U, matchCount);
+
+    matchCount = 0;
+    err = hs_scan_batch(db, blocks, 0, 0, scratch, countHandler);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(0U, matchCount);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, BatchTerminated) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo", 0, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // termination only stops the current block, not the rest of the batch
+    const hs_block_t blocks[] = { { "foofoofoo", 9, nullptr },
+                                  { "barbar", 6, nullptr },
+                                  { "foofoo", 6, nullptr } };
+
+    matchCount = 0;
+    err = hs_scan_batch(db, blocks, 3, 0, scratch, stopHandler);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    EXPECT_EQ(2U, matchCount);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, BatchNullDataMidway) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo", 0, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // a bad block anywhere in the batch fails the call before any block is
+    // scanned, so the matching first block reports nothing
+    const hs_block_t blocks[] = { { "foofoo", 6, nullptr },
+                                  { nullptr, 3, nullptr },
+                                  { "foo", 3, nullptr } };
+
+    matchCount = 0;
+    err = hs_scan_batch(db, blocks, 3, 0, scratch, countHandler);
+    ASSERT_EQ(HS_INVALID, err);
+    EXPECT_EQ(0U, matchCount);
+
+    // the scratch is still usable for a good batch
+    err = hs_scan_batch(db, blocks, 1, 0, scratch, countHandler);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(2U, matchCount);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, ScanSmallLiterals) {
+    hs_error_t err;
+
+    // a pure literal database can be scanned without scratch
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    patterns.push_back(pattern("foobar", 0, 2));
+    patterns.push_back(pattern("BAR", HS_FLAG_CASELESS, 3));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const string data = "xxfoobarbar foo Bar";
+    CallBackContext expected;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&expected);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(6U, expected.matches.size());
+
+    CallBackContext c;
+    err = hs_scan_small(db, data.c_str(), data.size(), 0, record_cb,
+                        (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(expected.matches, c.matches);
+
+    // termination is reported as usual
+    matchCount = 0;
+    err = hs_scan_small(db, data.c_str(), data.size(), 0, stopHandler,
+                        nullptr);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    EXPECT_EQ(1U, matchCount);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, ScanSmallSameMatches) {
+    // whether or not these need scratch, any database that hs_scan_small
+    // accepts must give the same matches as hs_scan
+    const char *exprs[] = { "foo[^\\n]*bar", "^abc", "[a-f]{3}x$", "a.b.c",
+                            "(foo|bar)+baz", "\\d{2,5}" };
+    const string data = "abcfoo bar bazbarfoobaz 12345 abx aXbYc def dddx";
+
+    for (const char *expr : exprs) {
+        SCOPED_TRACE(expr);
+        hs_database_t *db = buildDB(expr, 0, 0, HS_MODE_BLOCK);
+        ASSERT_TRUE(db != nullptr);
+
+        CallBackContext c;
+        hs_error_t err = hs_scan_small(db, data.c_str(), data.size(), 0,
+                                       record_cb, (void *)&c);
+        if (err == HS_SCRATCH_REQUIRED) {
+            hs_free_database(db);
+            continue;
+        }
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        hs_scratch_t *scratch = nullptr;
+        err = hs_alloc_scratch(db, &scratch);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        CallBackContext expected;
+        err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                      (void *)&expected);
+        ASSERT_EQ(HS_SUCCESS, err);
+        EXPECT_EQ(expected.matches, c.matches);
+
+        hs_free_scratch(scratch);
+        hs_free_database(db);
+    }
+}
+
+// Batch callback: records every match in the batch and the number of batches
+// delivered, and halts if asked to
+struct BatchContext {
+    CallBackContext c;
+    unsigned batches = 0;
+};
+
+int record_batch_cb(const hs_match_t *matches, unsigned count, void *ctxt) {
+    BatchContext *b = (BatchContext *)ctxt;
+    EXPECT_LT(0U, count);
+    b->batches++;
+    for (unsigned i = 0; i < count; i++) {
+        b->c.matches.push_back(MatchRecord(matches[i].to, matches[i].id));
+    }
+    return b->c.halt ? 1 : 0;
+}
+
+TEST(HyperscanTestBehaviour, BufferedSameMatches) {
+    hs_error_t err;
+
+    // build a database
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    patterns.push_back(pattern("o[^x]*f", 0, 2));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // enough matches to need several batches
+    string data;
+    for (unsigned i = 0; i < 500; i++) {
+        data += "foo";
+    }
+
+    CallBackContext expected;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&expected);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_LT(500U, expected.matches.size());
+
+    BatchContext b;
+    err = hs_scan_buffered(db, data.c_str(), data.size(), 0, scratch,
+                           record_batch_cb, (void *)&b);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(expected.matches, b.c.matches);
+    EXPECT_LT(1U, b.batches);
+
+    // a scan with no matches delivers no batches
+    b = BatchContext();
+    err = hs_scan_buffered(db, "barbar", 6, 0, scratch, record_batch_cb,
+                           (void *)&b);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(0U, b.batches);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, BufferedTerminated) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo", 0, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    string data;
+    for (unsigned i = 0; i < 1000; i++) {
+        data += "foo";
+    }
+
+    // halting from the first batch stops the scan
+    BatchContext b;
+    b.c.halt = true;
+    err = hs_scan_buffered(db, data.c_str(), data.size(), 0, scratch,
+                           record_batch_cb, (void *)&b);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    EXPECT_EQ(1U, b.batches);
+    EXPECT_GT(1000U, b.c.matches.size());
+
+    // halting from the final flush is reported too
+    b = BatchContext();
+    b.c.halt = true;
+    err = hs_scan_buffered(db, "foo", 3, 0, scratch, record_batch_cb,
+                           (void *)&b);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    EXPECT_EQ(1U, b.batches);
+    EXPECT_EQ(1U, b.c.matches.size());
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, BufferedStream) {
+    hs_error_t err;
+
+    // build a database
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", HS_FLAG_DOTALL, 1));
+    patterns.push_back(pattern("bar$", 0, 2));
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    // every match from a write is delivered before the write returns
+    BatchContext b;
+    err = hs_scan_stream_buffered(stream, "xxfoo", 5, 0, scratch,
+                                  record_batch_cb, (void *)&b);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(0U, b.batches);
+
+    err = hs_scan_stream_buffered(stream, "barbar", 6, 0, scratch,
+                                  record_batch_cb, (void *)&b);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(1U, b.batches);
+    ASSERT_EQ(2U, b.c.matches.size());
+    EXPECT_EQ(MatchRecord(8, 1), b.c.matches[0]);
+    EXPECT_EQ(MatchRecord(11, 1), b.c.matches[1]);
+
+    // the end anchored match arrives on close
+    b = BatchContext();
+    err = hs_close_stream_buffered(stream, scratch, record_batch_cb,
+                                   (void *)&b);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(1U, b.batches);
+    ASSERT_EQ(1U, b.c.matches.size());
+    EXPECT_EQ(MatchRecord(11, 2), b.c.matches[0]);
+
+    // halting terminates the stream
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    b = BatchContext();
+    b.c.halt = true;
+    err = hs_scan_stream_buffered(stream, "foobar", 6, 0, scratch,
+                                  record_batch_cb, (void *)&b);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    err = hs_scan_stream_buffered(stream, "foobar", 6, 0, scratch,
+                                  record_batch_cb, (void *)&b);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    EXPECT_EQ(1U, b.batches);
+    err = hs_close_stream(stream, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// Per-id callback: counts the matches for each id
+int count_per_id_cb(unsigned id, unsigned long long, unsigned long long,
+                    unsigned, void *ctxt) {
+    map<unsigned, unsigned long long> *counts =
+        (map<unsigned, unsigned long long> *)ctxt;
+    (*counts)[id]++;
+    return 0;
+}
+
+TEST(HyperscanTestBehaviour, CountSameAsCallback) {
+    hs_error_t err;
+
+    // build a database with sparse ids, one of which is shared
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1000));
+    patterns.push_back(pattern("o[^x]*f", 0, 7));
+    patterns.push_back(pattern("bar$", 0, 42));
+    patterns.push_back(pattern("ba+r", 0, 42));
+    patterns.push_back(pattern("never", HS_FLAG_SINGLEMATCH, 3));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // counters are ordered by id
+    unsigned int size = 0;
+    err = hs_counter_size(db, &size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(4U, size);
+    const unsigned ids[] = { 3, 7, 42, 1000 };
+    for (unsigned i = 0; i < size; i++) {
+        unsigned int idx = ~0U;
+        err = hs_counter_index(db, ids[i], &idx);
+        ASSERT_EQ(HS_SUCCESS, err);
+        EXPECT_EQ(i, idx);
+    }
+    unsigned int idx = 0;
+    err = hs_counter_index(db, 8, &idx);
+    ASSERT_EQ(HS_INVALID, err);
+
+    string data;
+    for (unsigned i = 0; i < 100; i++) {
+        data += "foobaarfo";
+    }
+    data += "bar";
+
+    map<unsigned, unsigned long long> expected;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, count_per_id_cb,
+                  (void *)&expected);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    vector<unsigned long long> counts(size, 0);
+    err = hs_scan_count(db, data.c_str(), data.size(), 0, scratch,
+                        counts.data());
+    ASSERT_EQ(HS_SUCCESS, err);
+    for (unsigned i = 0; i < size; i++) {
+        EXPECT_EQ(expected[ids[i]], counts[i]);
+    }
+    EXPECT_EQ(0ULL, counts[0]);
+    EXPECT_EQ(101ULL, counts[2]);
+    EXPECT_EQ(100ULL, counts[3]);
+
+    // counts accumulate over calls
+    err = hs_scan_count(db, data.c_str(), data.size(), 0, scratch,
+                        counts.data());
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(202ULL, counts[2]);
+    EXPECT_EQ(200ULL, counts[3]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, CountBudgetExceeded) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    patterns.push_back(pattern("foo[^x]*bar", 0, 2));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    string data;
+    for (unsigned i = 0; i < 1000; i++) {
+        data += "foo";
+    }
+
+    hs_scan_budget_t budget;
+    budget.max_literal_matches = 10;
+    budget.max_cycles = 0;
+    err = hs_set_scratch_budget(scratch, &budget);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    unsigned int size = 0;
+    err = hs_counter_size(db, &size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(2U, size);
+
+    vector<unsigned long long> counts(size, 0);
+    err = hs_scan_count(db, data.c_str(), data.size(), 0, scratch,
+                        counts.data());
+    ASSERT_EQ(HS_SCAN_BUDGET_EXCEEDED, err);
+    EXPECT_GE(10ULL, counts[0]);
+    EXPECT_EQ(0ULL, counts[1]);
+
+    unsigned long long offset = 0;
+    err = hs_scratch_budget_offset(scratch, &offset);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_LT(0ULL, offset);
+    EXPECT_GT(data.size(), offset);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, CountStream) {
+    hs_error_t err;
+
+    // build a database
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", HS_FLAG_DOTALL, 1));
+    patterns.push_back(pattern("bar$", 0, 2));
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    unsigned int size = 0;
+    err = hs_counter_size(db, &size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(2U, size);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    vector<unsigned long long> counts(size, 0);
+    err = hs_scan_stream_count(stream, "xxfoo", 5, 0, scratch, counts.data());
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan_stream_count(stream, "barbar", 6, 0, scratch,
+                               counts.data());
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(2ULL, counts[0]);
+    EXPECT_EQ(0ULL, counts[1]);
+
+    // the end anchored match is counted on close
+    err = hs_close_stream_count(stream, scratch, counts.data());
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(2ULL, counts[0]);
+    EXPECT_EQ(1ULL, counts[1]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, AnyMatchBlock) {
+    hs_error_t err;
+
+    // build an any-match database; SOM flags are ignored
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", HS_FLAG_DOTALL, 10));
+    patterns.push_back(pattern("[0-9]{4}", HS_FLAG_SOM_LEFTMOST, 20));
+    patterns.push_back(pattern("baz$", 0, 30));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK | HS_MODE_ANYMATCH);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // only the first match is reported, with id zero
+    const string data = "12345 foo bar 6789 foobar baz";
+    CallBackContext c;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    EXPECT_EQ(MatchRecord(4, 0), c.matches[0]);
+
+    c.clear();
+    err = hs_scan(db, "xxbaz", 5, 0, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    EXPECT_EQ(MatchRecord(5, 0), c.matches[0]);
+
+    c.clear();
+    err = hs_scan(db, "no match", 8, 0, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(c.matches.empty());
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, AnyMatchStream) {
+    hs_error_t err;
+
+    // build an any-match database
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", HS_FLAG_DOTALL, 10));
+    patterns.push_back(pattern("baz$", 0, 30));
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM | HS_MODE_ANYMATCH);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    CallBackContext c;
+    err = hs_scan_stream(stream, "xxfoo", 5, 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(c.matches.empty());
+
+    err = hs_scan_stream(stream, "barbar", 6, 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    EXPECT_EQ(MatchRecord(8, 0), c.matches[0]);
+
+    // nothing more is reported on this stream, even at end of data
+    err = hs_scan_stream(stream, "foobarbaz", 9, 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(1U, c.matches.size());
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+static
+bool matchRecordLess(const MatchRecord &a, const MatchRecord &b) {
+    return a.to < b.to || (a.to == b.to && a.id < b.id);
+}
+
+// Sort matches and discard duplicates, which unordered mode may report.
+static
+void sortUnique(vector<MatchRecord> &matches) {
+    sort(matches.begin(), matches.end(), matchRecordLess);
+    matches.erase(unique(matches.begin(), matches.end()), matches.end());
+}
+
+TEST(HyperscanTestBehaviour, UnorderedSameMatches) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    patterns.push_back(pattern("foo[^\\n]*bar", 0, 2));
+    patterns.push_back(pattern("b[a-z]{2,5}z", 0, 3));
+    patterns.push_back(pattern("(abc|xyz).{3}def", HS_FLAG_DOTALL, 4));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    string data;
+    for (unsigned i = 0; i < 50; i++) {
+        data += "foo barbaz abc123def foo\nxyz___defbar ";
+    }
+
+    CallBackContext ordered;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&ordered);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_FALSE(ordered.matches.empty());
+    EXPECT_TRUE(is_sorted(ordered.matches.begin(), ordered.matches.end(),
+                          matchRecordLess));
+
+    CallBackContext unordered;
+    err = hs_scan(db, data.c_str(), data.size(), HS_SCAN_FLAG_UNORDERED,
+                  scratch, record_cb, (void *)&unordered);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    sortUnique(ordered.matches);
+    sortUnique(unordered.matches);
+    EXPECT_EQ(ordered.matches, unordered.matches);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, UnorderedStream) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    patterns.push_back(pattern("foo.*bar", HS_FLAG_DOTALL, 2));
+    patterns.push_back(pattern("baz$", 0, 3));
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    const char *writes[] = {"xxfoo", "barfoo", "xxbarbaz", "foobaz"};
+
+    CallBackContext c[2];
+    for (unsigned i = 0; i < 2; i++) {
+        unsigned flags = i ? HS_SCAN_FLAG_UNORDERED : 0;
+        hs_stream_t *stream = nullptr;
+        err = hs_open_stream(db, 0, &stream);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_TRUE(stream != nullptr);
+
+        for (const char *w : writes) {
+            err = hs_scan_stream(stream, w, strlen(w), flags, scratch,
+                                 record_cb, (void *)&c[i]);
+            ASSERT_EQ(HS_SUCCESS, err);
+        }
+
+        err = hs_close_stream(stream, scratch, record_cb, (void *)&c[i]);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    sortUnique(c[0].matches);
+    sortUnique(c[1].matches);
+    EXPECT_EQ(c[0].matches, c[1].matches);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, BudgetLiteralMatches) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    patterns.push_back(pattern("foo[^x]*bar", 0, 2));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    string data;
+    for (unsigned i = 0; i < 1000; i++) {
+        data += "foo";
+    }
+
+    hs_scan_budget_t budget;
+    budget.max_literal_matches = 10;
+    budget.max_cycles = 0;
+    err = hs_set_scratch_budget(scratch, &budget);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SCAN_BUDGET_EXCEEDED, err);
+
+    unsigned long long offset = 0;
+    err = hs_scratch_budget_offset(scratch, &offset);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_LT(0ULL, offset);
+    EXPECT_GT(data.size(), offset);
+    EXPECT_GE(10U, c.matches.size());
+    for (const auto &m : c.matches) {
+        EXPECT_GE(offset, m.to);
+    }
+
+    // without a budget, the whole block is scanned
+    err = hs_set_scratch_budget(scratch, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    c.clear();
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(1000U, c.matches.size());
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, BudgetStreamResumes) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    patterns.push_back(pattern("foo[^x]*bar", 0, 2));
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    string data;
+    for (unsigned i = 0; i < 300; i++) {
+        data += "foo";
+    }
+
+    hs_scan_budget_t budget;
+    budget.max_literal_matches = 10;
+    budget.max_cycles = 0;
+    err = hs_set_scratch_budget(scratch, &budget);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    err = hs_scan_stream(stream, data.c_str(), data.size(), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SCAN_BUDGET_EXCEEDED, err);
+
+    // the stream carries on from the end of the abandoned write
+    err = hs_set_scratch_budget(scratch, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    c.clear();
+    err = hs_scan_stream(stream, "xxfooyybar", 10, 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(2U, c.matches.size());
+    EXPECT_EQ(MatchRecord(905, 1), c.matches[0]);
+    EXPECT_EQ(MatchRecord(910, 2), c.matches[1]);
+
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, BudgetPureLiteral) {
+    hs_error_t err;
+
+    // a database made up only of literals runs no engines
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    string data;
+    for (unsigned i = 0; i < 1000; i++) {
+        data += "foo";
+    }
+
+    hs_scan_budget_t budget;
+    budget.max_literal_matches = 10;
+    budget.max_cycles = 0;
+    err = hs_set_scratch_budget(scratch, &budget);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SCAN_BUDGET_EXCEEDED, err);
+
+    unsigned long long offset = 0;
+    err = hs_scratch_budget_offset(scratch, &offset);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(33ULL, offset);
+    ASSERT_EQ(10U, c.matches.size());
+    EXPECT_EQ(MatchRecord(30, 1), c.matches.back());
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, BudgetSoleOutfix) {
+    hs_error_t err;
+
+    // no literals: the whole database is a single outfix engine
+    vector<pattern> patterns;
+    patterns.push_back(pattern("[a-c][d-f]+[a-c]", 0, 1));
+
+    string data;
+    for (unsigned i = 0; i < 2000; i++) {
+        data += "ad";
+    }
+
+    for (unsigned mode : {HS_MODE_BLOCK, HS_MODE_STREAM}) {
+        SCOPED_TRACE(mode);
+        hs_database_t *db = buildDB(patterns, mode);
+        ASSERT_TRUE(db != nullptr);
+
+        hs_scratch_t *scratch = nullptr;
+        err = hs_alloc_scratch(db, &scratch);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_TRUE(scratch != nullptr);
+
+        // the deadline has passed by the time it is first checked
+        hs_scan_budget_t budget;
+        budget.max_literal_matches = 0;
+        budget.max_cycles = 1;
+        err = hs_set_scratch_budget(scratch, &budget);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        CallBackContext c;
+        if (mode == HS_MODE_BLOCK) {
+            err = hs_scan(db, data.c_str(), data.size(), 0, scratch,
+                          record_cb, (void *)&c);
+        } else {
+            hs_stream_t *stream = nullptr;
+            err = hs_open_stream(db, 0, &stream);
+            ASSERT_EQ(HS_SUCCESS, err);
+            err = hs_scan_stream(stream, data.c_str(), data.size(), 0,
+                                 scratch, record_cb, (void *)&c);
+            hs_close_stream(stream, scratch, nullptr, nullptr);
+        }
+        ASSERT_EQ(HS_SCAN_BUDGET_EXCEEDED, err);
+
+        unsigned long long offset = 0;
+        err = hs_scratch_budget_offset(scratch, &offset);
+        ASSERT_EQ(HS_SUCCESS, err);
+        EXPECT_LT(0ULL, offset);
+        EXPECT_GT(data.size(), offset);
+        EXPECT_GT(1999U, c.matches.size());
+        for (const auto &m : c.matches) {
+            EXPECT_GT(offset, m.to);
+        }
+
+        hs_free_scratch(scratch);
+        hs_free_database(db);
+    }
+}
+
+// Scans data with a resumable block scan in steps of the given size.
+static
+void blockScanSteps(const hs_database_t *db, hs_scratch_t *scratch,
+                    const string &data, unsigned long long step,
+                    CallBackContext *c) {
+    hs_block_scan_t *scan = nullptr;
+    hs_error_t err = hs_open_block_scan(db, data.c_str(), data.size(), 0,
+                                        scratch, record_cb, (void *)c, &scan);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scan != nullptr);
+
+    unsigned long long offset = 0;
+    while (offset < data.size()) {
+        unsigned long long prev = offset;
+        err = hs_advance_block_scan(scan, step, &offset);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_LT(prev, offset);
+    }
+
+    err = hs_finish_block_scan(scan);
+    ASSERT_EQ(HS_SUCCESS, err);
+}
+
+TEST(HyperscanTestBehaviour, BlockScanStepsSameMatches) {
+    vector<vector<pattern>> pattern_sets;
+    // full rose with engines
+    pattern_sets.push_back({pattern("foo", 0, 1),
+                            pattern("foo[^\\n]*bar", 0, 2),
+                            pattern("b[a-z]{2,5}z", 0, 3),
+                            pattern("(abc|xyz).{3}def", HS_FLAG_DOTALL, 4),
+                            pattern("def$", 0, 5)});
+    // literals only
+    pattern_sets.push_back({pattern("barbaz", 0, 1),
+                            pattern("abc123def", 0, 2),
+                            pattern("o\\nx", 0, 3)});
+    // a single outfix
+    pattern_sets.push_back({pattern("a[^\\n]{3,8}f", 0, 1)});
+
+    string data;
+    for (unsigned i = 0; i < 50; i++) {
+        data += "foo barbaz abc123def foo\nxyz___defbar ";
+    }
+    data += "def";
+
+    for (const auto &patterns : pattern_sets) {
+        hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+        ASSERT_TRUE(db != nullptr);
+
+        hs_scratch_t *scratch = nullptr;
+        hs_error_t err = hs_alloc_scratch(db, &scratch);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        CallBackContext whole;
+        err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                      (void *)&whole);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_FALSE(whole.matches.empty());
+        sort(whole.matches.begin(), whole.matches.end(), matchRecordLess);
+
+        for (unsigned long long step : {1ULL, 7ULL, 64ULL, 1000ULL}) {
+            SCOPED_TRACE(step);
+            CallBackContext c;
+            blockScanSteps(db, scratch, data, step, &c);
+            EXPECT_TRUE(is_sorted(c.matches.begin(), c.matches.end(),
+                                  [](const MatchRecord &a,
+                                     const MatchRecord &b) {
+                                      return a.to < b.to;
+                                  }));
+            sort(c.matches.begin(), c.matches.end(), matchRecordLess);
+            EXPECT_EQ(whole.matches, c.matches);
+        }
+
+        hs_free_scratch(scratch);
+        hs_free_database(db);
+    }
+}
+
+TEST(HyperscanTestBehaviour, BlockScanTerminated) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo", 0, 1));
+    patterns.push_back(pattern("bar[^x]*baz", 0, 2));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    string data(500, '_');
+    data.replace(300, 3, "foo");
+    data.replace(400, 3, "foo");
+
+    CallBackContext c;
+    c.halt = true;
+    hs_block_scan_t *scan = nullptr;
+    err = hs_open_block_scan(db, data.c_str(), data.size(), 0, scratch,
+                             record_cb, (void *)&c, &scan);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    unsigned long long offset = 0;
+    err = hs_advance_block_scan(scan, 100, &offset);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(100ULL, offset);
+    EXPECT_TRUE(c.matches.empty());
+
+    err = hs_advance_block_scan(scan, 300, &offset);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    ASSERT_EQ(1U, c.matches.size());
+    EXPECT_EQ(MatchRecord(303, 1), c.matches[0]);
+
+    // nothing more is scanned once the callback has halted the scan
+    err = hs_advance_block_scan(scan, 100, &offset);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    err = hs_finish_block_scan(scan);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    EXPECT_EQ(1U, c.matches.size());
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// A pattern with no literal factors compiles to a small DFA outfix. This one
+// has states that can be accelerated, so it is run by McClellan rather than
+// Sheng; the Sheng engine itself is tested in unit/internal/sheng.cpp.
+TEST(HyperscanTestBehaviour, SmallDfaBlock) {
+    hs_error_t err;
+
+    hs_database_t *db = buildDB("[a-c][d-f]+[a-c]", 0, 1, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    const string data = "aeb.cfffa.adfc";
+    CallBackContext c;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(3U, c.matches.size());
+    EXPECT_EQ(MatchRecord(3, 1), c.matches[0]);
+    EXPECT_EQ(MatchRecord(9, 1), c.matches[1]);
+    EXPECT_EQ(MatchRecord(14, 1), c.matches[2]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, SmallDfaStream) {
+    hs_error_t err;
+
+    hs_database_t *db = buildDB("[a-c][d-f]+[a-c]", 0, 1, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    // DFA state must carry across every write boundary
+    const string data = "aeb.cfffa.adfc";
+    CallBackContext c;
+    for (size_t i = 0; i < data.size(); i++) {
+        err = hs_scan_stream(stream, data.c_str() + i, 1, 0, scratch,
+                             record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_EQ(3U, c.matches.size());
+    EXPECT_EQ(MatchRecord(3, 1), c.matches[0]);
+    EXPECT_EQ(MatchRecord(9, 1), c.matches[1]);
+    EXPECT_EQ(MatchRecord(14, 1), c.matches[2]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// "[ab].{8}[cd]" needs a DFA of more than 256 states, as it must remember
+// which of the last nine bytes were [ab]. Merged with the second pattern, it
+// is run by a McSheng engine, whose core holds the states nearest the start:
+// "e", "eh", "ehh" and the like, including the accept state reached by "ehf".
+// A run of "b" leaves the core, and "e" enters it again. Writes are long
+// enough to miss the small block engine.
+static
+vector<pattern> mcShengPatterns() {
+    vector<pattern> patterns;
+    patterns.push_back(pattern("[ab].{8}[cd]", 0, 1));
+    patterns.push_back(pattern("[e-g][h-j]+[e-g]", 0, 2));
+    return patterns;
+}
+
+static
+string mcShengData() {
+    // "ehf" ends at 63, in the core; the "c" at 80 is nine bytes after the
+    // last "b" at 71; "ejig" ends at 85, back in the core.
+    return string(60, '_') + "ehf" + string(9, 'b') + "_______ec" + "ejig" +
+           string(10, '_');
+}
+
+TEST(HyperscanTestBehaviour, McShengBlock) {
+    hs_error_t err;
+
+    hs_database_t *db = buildDB(mcShengPatterns(), HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    const string data = mcShengData();
+    CallBackContext c;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(3U, c.matches.size());
+    EXPECT_EQ(MatchRecord(63, 2), c.matches[0]);
+    EXPECT_EQ(MatchRecord(81, 1), c.matches[1]);
+    EXPECT_EQ(MatchRecord(85, 2), c.matches[2]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, McShengStream) {
+    hs_error_t err;
+
+    hs_database_t *db = buildDB(mcShengPatterns(), HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    // writes end after "e" and "ej", both in the core, and in the middle of
+    // the run of "b", outside it
+    const string data = mcShengData();
+    const size_t splits[] = { 61, 70, 83, data.size() };
+    CallBackContext c;
+    size_t from = 0;
+    for (size_t to : splits) {
+        err = hs_scan_stream(stream, data.c_str() + from, to - from, 0,
+                             scratch, record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+        from = to;
+    }
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_EQ(3U, c.matches.size());
+    EXPECT_EQ(MatchRecord(63, 2), c.matches[0]);
+    EXPECT_EQ(MatchRecord(81, 1), c.matches[1]);
+    EXPECT_EQ(MatchRecord(85, 2), c.matches[2]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// With a literal in the database as well, the McSheng outfix is run a match at
+// a time (STOP_AT_MATCH) so that its matches are ordered with the literal's.
+TEST(HyperscanTestBehaviour, McShengStopAtMatch) {
+    hs_error_t err;
+
+    vector<pattern> patterns = mcShengPatterns();
+    patterns.push_back(pattern("zzzz", 0, 3));
+
+    // "ehf" ends at 63, in the core, ahead of "zzzz" at 67; the "c" at 84 is
+    // nine bytes after the last "b" at 75; "ejig" ends at 89.
+    const string data = string(60, '_') + "ehf" + "zzzz" + string(9, 'b') +
+                        "_______ec" + "ejig" + string(10, '_');
+
+    for (unsigned mode : { HS_MODE_BLOCK, HS_MODE_STREAM }) {
+        SCOPED_TRACE(mode);
+        hs_database_t *db = buildDB(patterns, mode);
+        ASSERT_TRUE(db != nullptr);
+
+        hs_scratch_t *scratch = nullptr;
+        err = hs_alloc_scratch(db, &scratch);
+        ASSERT_EQ(HS_SUCCESS, err);
+        EXPECT_TRUE(scratch != nullptr);
+
+        CallBackContext c;
+        if (mode == HS_MODE_BLOCK) {
+            err = hs_scan(db, data.c_str(), data.size(), 0, scratch,
+                          record_cb, (void *)&c);
+            ASSERT_EQ(HS_SUCCESS, err);
+        } else {
+            hs_stream_t *stream = nullptr;
+            err = hs_open_stream(db, 0, &stream);
+            ASSERT_EQ(HS_SUCCESS, err);
+            // the first write ends inside "ejig", in the core
+            const size_t split = 87;
+            err = hs_scan_stream(stream, data.c_str(), split, 0, scratch,
+                                 record_cb, (void *)&c);
+            ASSERT_EQ(HS_SUCCESS, err);
+            err = hs_scan_stream(stream, data.c_str() + split,
+                                 data.size() - split, 0, scratch, record_cb,
+                                 (void *)&c);
+            ASSERT_EQ(HS_SUCCESS, err);
+            err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+            ASSERT_EQ(HS_SUCCESS, err);
+        }
+
+        ASSERT_EQ(4U, c.matches.size());
+        EXPECT_EQ(MatchRecord(63, 2), c.matches[0]);
+        EXPECT_EQ(MatchRecord(67, 3), c.matches[1]);
+        EXPECT_EQ(MatchRecord(85, 1), c.matches[2]);
+        EXPECT_EQ(MatchRecord(89, 2), c.matches[3]);
+
+        hs_free_scratch(scratch);
+        hs_free_database(db);
+    }
+}
+
+// DFAs over a small alphabet may consume two bytes per transition; matches
+// must still be reported at both odd and even offsets.
+TEST(HyperscanTestBehaviour, SmallAlphabetDfaOffsets) {
+    hs_error_t err;
+
+    hs_database_t *db = buildDB("a[ab]{5}b", 0, 1, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    const string data = "xabbbbbbxaabababbab.aaaaaabb";
+    CallBackContext c;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(6U, c.matches.size());
+    EXPECT_EQ(MatchRecord(8, 1), c.matches[0]);
+    EXPECT_EQ(MatchRecord(16, 1), c.matches[1]);
+    EXPECT_EQ(MatchRecord(17, 1), c.matches[2]);
+    EXPECT_EQ(MatchRecord(19, 1), c.matches[3]);
+    EXPECT_EQ(MatchRecord(27, 1), c.matches[4]);
+    EXPECT_EQ(MatchRecord(28, 1), c.matches[5]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// Suffixes whose triggers kill each other may share a single engine; matches
+// from each must survive the switch between them, across stream writes.
+TEST(HyperscanTestBehaviour, ExclusiveSuffixesStreaming) {
+    hs_error_t err;
+    vector<pattern> patterns;
+    patterns.push_back(pattern("Xfoo[a-f]+[0-9]{2}z", 0, 1));
+    patterns.push_back(pattern("Ybar[g-m]+[0-9]{2}z", 0, 2));
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    const string data = "Xfooabc12z Ybarghi34z Xfooa1Ybargg99z "
+                        "Xfoof00zYbarm123z";
+    CallBackContext c;
+    for (const char &ch : data) {
+        err = hs_scan_stream(stream, &ch, 1, 0, scratch, record_cb,
+                             (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_EQ(4U, c.matches.size());
+    EXPECT_EQ(MatchRecord(10, 1), c.matches[0]);
+    EXPECT_EQ(MatchRecord(21, 2), c.matches[1]);
+    EXPECT_EQ(MatchRecord(37, 2), c.matches[2]);
+    EXPECT_EQ(MatchRecord(46, 1), c.matches[3]);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
 TEST(regression, UE_1005) {
     hs_error_t err;
     vector<pattern> patterns;
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hs.h"
+#include "test_util.h"
+
+using namespace std;
+
+static
+hs_database_t *buildLitDB(const vector<string> &lits,
+                          const vector<unsigned> &flags,
+                          const vector<unsigned> &ids, unsigned mode) {
+    vector<const char *> ptrs;
+    vector<size_t> lens;
+    for (const auto &s : lits) {
+        ptrs.push_back(s.data());
+        lens.push_back(s.size());
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_lit_multi(ptrs.data(), flags.data(),
+                                          ids.data(), lens.data(),
+                                          (unsigned)lits.size(), mode, nullptr,
+                                          &db, &compile_err);
+    if (err != HS_SUCCESS) {
+        hs_free_compile_error(compile_err);
+        return nullptr;
+    }
+    return db;
+}
+
+TEST(PureLiteral, Metachars) {
+    // Regex metacharacters are matched literally.
+    const vector<string> lits = {"a.b", "(x|y)*", "^$"};
+    hs_database_t *db = buildLitDB(lits, {0, 0, 0}, {1, 2, 3},
+                                   HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    string data = "axb a.b xy (x|y)* ^$";
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(3U, c.matches.size());
+    ASSERT_EQ(MatchRecord(7, 1), c.matches[0]);
+    ASSERT_EQ(MatchRecord(17, 2), c.matches[1]);
+    ASSERT_EQ(MatchRecord(20, 3), c.matches[2]);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(PureLiteral, NulBytes) {
+    const vector<string> lits = {string("a\0b", 3), string("\0\0", 2)};
+    hs_database_t *db = buildLitDB(lits, {0, 0}, {1, 2}, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    string data1("xxa\0", 4);
+    string data2("b\0\0", 3);
+    err = hs_scan_stream(stream, data1.data(), data1.size(), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan_stream(stream, data2.data(), data2.size(), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_EQ(2U, c.matches.size());
+    ASSERT_EQ(MatchRecord(5, 1), c.matches[0]);
+    ASSERT_EQ(MatchRecord(7, 2), c.matches[1]);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(PureLiteral, FlagsAndSingleByte) {
+    // A caseless literal, and a single-byte highlander literal, which cannot
+    // be handed straight to Rose.
+    const vector<string> lits = {"FoO", "z"};
+    hs_database_t *db = buildLitDB(lits, {HS_FLAG_CASELESS,
+                                          HS_FLAG_SINGLEMATCH},
+                                   {1, 2}, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    string data = "zfoozFOOz";
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(3U, c.matches.size());
+    ASSERT_EQ(MatchRecord(1, 2), c.matches[0]);
+    ASSERT_EQ(MatchRecord(4, 1), c.matches[1]);
+    ASSERT_EQ(MatchRecord(8, 1), c.matches[2]);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(PureLiteral, Single) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_lit("a+b", 0, 3, HS_MODE_BLOCK, nullptr, &db,
+                                    &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    string data = "aab a+b";
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(7, 0), c.matches[0]);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(PureLiteral, BadFlags) {
+    const vector<string> lits = {"abc", "def"};
+    hs_database_t *db = buildLitDB(lits, {0, HS_FLAG_DOTALL}, {1, 2},
+                                   HS_MODE_BLOCK);
+    ASSERT_TRUE(db == nullptr);
+
+    db = buildLitDB(lits, {0, HS_FLAG_SINGLEMATCH | HS_FLAG_SOM_LEFTMOST},
+                    {1, 2}, HS_MODE_BLOCK);
+    ASSERT_TRUE(db == nullptr);
+}
+
+TEST(PureLiteral, Empty) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_lit("abc", 0, 0, HS_MODE_BLOCK, nullptr, &db,
+                                    &compile_err);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_TRUE(db == nullptr);
+    ASSERT_TRUE(compile_err != nullptr);
+    ASSERT_EQ(0, compile_err->expression);
+    hs_free_compile_error(compile_err);
+}
@@ -29,6 +29,7 @@
 #include <algorithm>
 #include <array>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -324,3 +325,228 @@ TEST(MPV, UE_2395) {
     hs_free_database(db);
     hs_free_scratch(scratch);
 }
+
+static
+vector<MatchRecord> threadedCompileScan(const vector<const char *> &expr,
+                                        const vector<unsigned> &ids,
+                                        unsigned mode, unsigned threads,
+                                        const string &data) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_threaded(expr.data(), nullptr,
+                                                   ids.data(), nullptr,
+                                                   expr.size(), mode, nullptr,
+                                                   threads, &db, &compile_err);
+    EXPECT_EQ(HS_SUCCESS, err);
+    if (err != HS_SUCCESS) {
+        hs_free_compile_error(compile_err);
+        return vector<MatchRecord>();
+    }
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    EXPECT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    if (mode == HS_MODE_BLOCK) {
+        err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                      (void *)&c);
+        EXPECT_EQ(HS_SUCCESS, err);
+    } else {
+        hs_stream_t *stream = nullptr;
+        err = hs_open_stream(db, 0, &stream);
+        EXPECT_EQ(HS_SUCCESS, err);
+        // write the data a few bytes at a time to exercise stream state
+        for (size_t i = 0; i < data.size(); i += 7) {
+            size_t len = min(data.size() - i, size_t{7});
+            err = hs_scan_stream(stream, data.c_str() + i, len, 0, scratch,
+                                 record_cb, (void *)&c);
+            EXPECT_EQ(HS_SUCCESS, err);
+        }
+        err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+        EXPECT_EQ(HS_SUCCESS, err);
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+    return c.matches;
+}
+
+// A threaded compile must produce a database that matches exactly as the
+// single threaded one does. The patterns are chosen to produce a mix of
+// literals, prefixes, infixes, suffixes and outfixes.
+TEST(ThreadedCompile, SameMatches) {
+    const vector<const char *> expr = {
+        "foobar",
+        "abc.*def",
+        "^[a-f]{3,8}xyz",
+        "hello[^\\n]{2,10}world",
+        "x[0-9]+y[0-9]+z",
+        "(ab|cd)+ef",
+        "\\d{4}-\\d{2}-\\d{2}",
+        "[a-z]+ing\\b",
+        "q.{5}r",
+        "literal\\s+string",
+        "(foo|bar){2,}baz",
+        "[^a]{8}",
+    };
+    vector<unsigned> ids;
+    for (unsigned i = 0; i < expr.size(); i++) {
+        ids.push_back(i + 10);
+    }
+
+    const string data = "abcfedxyz foobarbaz hello, the world x12y34z "
+                        "ababcdef 2016-04-01 running jumping q12345r "
+                        "literal   string foofoobaz abc then def barfoobaz";
+
+    for (unsigned mode : {HS_MODE_BLOCK, HS_MODE_STREAM}) {
+        SCOPED_TRACE(mode);
+        vector<MatchRecord> serial = threadedCompileScan(expr, ids, mode, 1,
+                                                         data);
+        ASSERT_FALSE(serial.empty());
+        for (unsigned threads : {0U, 2U, 4U, 16U}) {
+            SCOPED_TRACE(threads);
+            vector<MatchRecord> threaded =
+                threadedCompileScan(expr, ids, mode, threads, data);
+            ASSERT_EQ(serial, threaded);
+        }
+    }
+}
+
+static
+hs_database_t *cachedCompile(const vector<const char *> &expr,
+                             const vector<unsigned> &ids, unsigned mode,
+                             hs_compile_cache_t *cache,
+                             hs_compile_cache_stats_t *stats) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_cached(expr.data(), nullptr,
+                                                 ids.data(), nullptr,
+                                                 expr.size(), mode, nullptr, 1,
+                                                 cache, &db, &compile_err);
+    EXPECT_EQ(HS_SUCCESS, err);
+    if (err != HS_SUCCESS) {
+        hs_free_compile_error(compile_err);
+        return nullptr;
+    }
+    err = hs_compile_cache_stats(cache, stats);
+    EXPECT_EQ(HS_SUCCESS, err);
+    return db;
+}
+
+static
+vector<MatchRecord> scanBlock(const hs_database_t *db, const string &data) {
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    EXPECT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    EXPECT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+    return c.matches;
+}
+
+// Recompiling with a compile cache must reuse earlier work, and must produce
+// a database that matches exactly as one compiled without the cache.
+TEST(CompileCache, Recompile) {
+    vector<const char *> expr = {
+        "abc.*def",
+        "^[a-f]{3,8}xyz",
+        "hello[^\\n]{2,10}world",
+        "x[0-9]+y[0-9]+z",
+        "(ab|cd)+ef",
+        "q.{5}r",
+    };
+    vector<unsigned> ids = {10, 11, 12, 13, 14, 15};
+    const string data = "abcfedxyz hello, the world x12y34z ababcdef q12345r "
+                        "abc then def cdcdefz";
+
+    hs_compile_cache_t *cache = nullptr;
+    hs_error_t err = hs_alloc_compile_cache(&cache);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // First compile: nothing in the cache.
+    hs_compile_cache_stats_t stats;
+    hs_database_t *db = cachedCompile(expr, ids, HS_MODE_BLOCK, cache, &stats);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ(0U, stats.expression_hits);
+    EXPECT_EQ(expr.size(), stats.expression_misses);
+    EXPECT_EQ(0U, stats.engine_hits);
+    EXPECT_EQ(expr.size(), stats.expressions_cached);
+    hs_free_database(db);
+
+    // Identical compile: every expression and engine comes from the cache.
+    db = cachedCompile(expr, ids, HS_MODE_BLOCK, cache, &stats);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ(expr.size(), stats.expression_hits);
+    EXPECT_EQ(0U, stats.expression_misses);
+    EXPECT_LT(0U, stats.engine_hits);
+    hs_free_database(db);
+
+    // Change one pattern: the others are still reused, and the result
+    // matches as an uncached compile does.
+    expr[3] = "x[0-9]+y[0-9]+(z|w)";
+    db = cachedCompile(expr, ids, HS_MODE_BLOCK, cache, &stats);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ(expr.size() - 1, stats.expression_hits);
+    EXPECT_EQ(1U, stats.expression_misses);
+    EXPECT_EQ(expr.size(), stats.expressions_cached);
+    vector<MatchRecord> cached = scanBlock(db, data);
+    hs_free_database(db);
+
+    hs_compile_error_t *compile_err = nullptr;
+    err = hs_compile_ext_multi(expr.data(), nullptr, ids.data(), nullptr,
+                               expr.size(), HS_MODE_BLOCK, nullptr, &db,
+                               &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    vector<MatchRecord> uncached = scanBlock(db, data);
+    hs_free_database(db);
+    ASSERT_FALSE(uncached.empty());
+    EXPECT_EQ(uncached, cached);
+
+    // A change of mode empties the cache.
+    db = cachedCompile(expr, ids, HS_MODE_STREAM, cache, &stats);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ(0U, stats.expression_hits);
+    EXPECT_EQ(0U, stats.engine_hits);
+    hs_free_database(db);
+
+    hs_free_compile_cache(cache);
+}
+
+// A failed compile leaves the cache usable, and does not evict anything.
+TEST(CompileCache, FailedCompile) {
+    vector<const char *> expr = {"foo.*bar", "b[a-z]{2,5}z"};
+    vector<unsigned> ids = {1, 2};
+
+    hs_compile_cache_t *cache = nullptr;
+    hs_error_t err = hs_alloc_compile_cache(&cache);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_compile_cache_stats_t stats;
+    hs_database_t *db = cachedCompile(expr, ids, HS_MODE_BLOCK, cache, &stats);
+    ASSERT_NE(nullptr, db);
+    hs_free_database(db);
+
+    vector<const char *> bad_expr = {"foo.*bar", "(unclosed"};
+    hs_compile_error_t *compile_err = nullptr;
+    err = hs_compile_ext_multi_cached(bad_expr.data(), nullptr, ids.data(),
+                                      nullptr, bad_expr.size(), HS_MODE_BLOCK,
+                                      nullptr, 1, cache, &db, &compile_err);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(1, compile_err->expression);
+    hs_free_compile_error(compile_err);
+
+    err = hs_compile_cache_stats(cache, &stats);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(expr.size(), stats.expressions_cached);
+
+    db = cachedCompile(expr, ids, HS_MODE_BLOCK, cache, &stats);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ(expr.size(), stats.expression_hits);
+    hs_free_database(db);
+
+    hs_free_compile_cache(cache);
+}
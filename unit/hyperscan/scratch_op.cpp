@@ -286,4 +286,64 @@ TEST(scratch, damagedScratch) {
     hs_free_database(db);
 }
 
+TEST(scratch, profile) {
+    hs_database_t *db = buildDB("foo.*bar", 0, 0, HS_MODE_BLOCK, nullptr);
+    ASSERT_NE(nullptr, db);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const string data = "foo bar foo bar";
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, dummy_cb,
+                  nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_profile_t profile;
+    err = hs_scratch_profile(scratch, &profile);
+#ifdef ENABLE_PROFILING
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(1U, profile.scans);
+    EXPECT_EQ(data.size(), profile.bytes);
+    EXPECT_EQ(2U, profile.matches);
+
+    // clones start afresh
+    hs_scratch_t *clone = nullptr;
+    err = hs_clone_scratch(scratch, &clone);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_profile_t clone_profile;
+    err = hs_scratch_profile(clone, &clone_profile);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(0U, clone_profile.scans);
+    EXPECT_EQ(0U, clone_profile.matches);
+    hs_free_scratch(clone);
+
+    err = hs_reset_scratch_profile(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scratch_profile(scratch, &profile);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(0U, profile.scans);
+    EXPECT_EQ(0U, profile.bytes);
+    EXPECT_EQ(0U, profile.matches);
+    for (unsigned i = 0; i < HS_PROFILE_STAGE_COUNT; i++) {
+        EXPECT_EQ(0U, profile.stages[i].calls);
+        EXPECT_EQ(0U, profile.stages[i].cycles);
+    }
+    for (unsigned i = 0; i < profile.queue_count; i++) {
+        EXPECT_EQ(0U, profile.queue_calls[i]);
+    }
+    for (unsigned i = 0; i < profile.literal_count; i++) {
+        EXPECT_EQ(0U, profile.literal_hits[i]);
+    }
+#else
+    // not available without ENABLE_PROFILING
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_reset_scratch_profile(scratch);
+    ASSERT_EQ(HS_INVALID, err);
+#endif
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
 } // namespace
@@ -483,4 +483,157 @@ TEST(Serialize, DeserializeUnalignedMalloc) {
     free(bytes);
 }
 
+// Returns a cacheline-aligned copy of the given bytes, as mmap() would.
+static
+char *alignedCopy(const char *bytes, size_t len, vector<char> &buf,
+                  size_t offset = 0) {
+    buf.assign(len + 64 + offset, 0);
+    size_t shift = (64 - ((uintptr_t)buf.data() % 64)) % 64;
+    char *p = buf.data() + shift + offset;
+    memcpy(p, bytes, len);
+    return p;
+}
+
+static
+vector<MatchRecord> scanAll(const hs_database_t *db, const string &data) {
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    EXPECT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    EXPECT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+    return c.matches;
+}
+
+// A database image can be used for scanning in place.
+TEST(Serialize, ImageScanInPlace) {
+    hs_database_t *db = buildDB("hatstand.*(badgerbrush|teakettle)", 0, 1,
+                                HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    const string data = "a hatstand, a teakettle and a badgerbrush";
+    vector<MatchRecord> expected = scanAll(db, data);
+    ASSERT_EQ(2U, expected.size());
+
+    char *original_info = nullptr;
+    hs_error_t err = hs_database_info(db, &original_info);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    err = hs_serialize_database_image(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(nullptr, bytes);
+    hs_free_database(db);
+
+    vector<char> buf;
+    char *image = alignedCopy(bytes, length, buf);
+    free(bytes);
+
+    const hs_database_t *mapped = nullptr;
+    err = hs_map_database(image, length, 0, &mapped);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ((const void *)image, (const void *)mapped);
+
+    char *info = nullptr;
+    err = hs_database_info(mapped, &info);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_STREQ(original_info, info);
+    free(info);
+    free(original_info);
+
+    size_t db_len = 0;
+    err = hs_database_size(mapped, &db_len);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(length, db_len);
+
+    EXPECT_EQ(HS_SUCCESS, hs_verify_database(mapped));
+    EXPECT_EQ(expected, scanAll(mapped, data));
+}
+
+// A database image must be cacheline-aligned to be used.
+TEST(Serialize, ImageMisaligned) {
+    hs_database_t *db = buildDB("hatstand.*teakettle", 0, 1, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    hs_error_t err = hs_serialize_database_image(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+
+    vector<char> buf;
+    for (size_t i = 1; i < 64; i++) {
+        SCOPED_TRACE(i);
+        char *image = alignedCopy(bytes, length, buf, i);
+        const hs_database_t *mapped = nullptr;
+        err = hs_map_database(image, length, 0, &mapped);
+        ASSERT_EQ(HS_BAD_ALIGN, err);
+        ASSERT_EQ(nullptr, mapped);
+    }
+
+    free(bytes);
+}
+
+// Corruption is caught when mapping, or later by hs_verify_database() if the
+// check was skipped.
+TEST(Serialize, ImageCorrupt) {
+    hs_database_t *db = buildDB("hatstand.*teakettle", 0, 1, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    hs_error_t err = hs_serialize_database_image(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+
+    vector<char> buf;
+    char *image = alignedCopy(bytes, length, buf);
+    free(bytes);
+    image[length - 1] ^= 0x5a;
+
+    const hs_database_t *mapped = nullptr;
+    err = hs_map_database(image, length, 0, &mapped);
+    ASSERT_NE(HS_SUCCESS, err);
+    ASSERT_EQ(nullptr, mapped);
+
+    err = hs_map_database(image, length, HS_MAP_FLAG_NO_VERIFY, &mapped);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(nullptr, mapped);
+    ASSERT_NE(HS_SUCCESS, hs_verify_database(mapped));
+}
+
+// Database images and serialized databases are not interchangeable.
+TEST(Serialize, ImageNotSerialized) {
+    hs_database_t *db = buildDB("hatstand.*teakettle", 0, 1, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    char *image_bytes = nullptr;
+    size_t image_len = 0;
+    hs_error_t err = hs_serialize_database_image(db, &image_bytes, &image_len);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    err = hs_serialize_database(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+
+    hs_database_t *db2 = nullptr;
+    err = hs_deserialize_database(image_bytes, image_len, &db2);
+    ASSERT_NE(HS_SUCCESS, err);
+
+    vector<char> buf;
+    char *p = alignedCopy(bytes, length, buf);
+    const hs_database_t *mapped = nullptr;
+    err = hs_map_database(p, length, 0, &mapped);
+    ASSERT_NE(HS_SUCCESS, err);
+
+    free(image_bytes);
+    free(bytes);
+}
+
 }
@@ -523,6 +523,384 @@ TEST(StreamUtil, copy_reset_matches) {
     hs_free_database(db);
 }
 
+TEST(StreamUtil, compress_expand1) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    hs_stream_t *stream2 = nullptr;
+
+    CallBackContext c;
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+
+    c.matches.clear();
+
+    // query the image size first
+    size_t len = 0;
+    err = hs_compress_stream(stream, nullptr, 0, &len);
+    ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+    ASSERT_LT(0U, len);
+
+    size_t stream_size;
+    err = hs_stream_size(db, &stream_size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_GE(stream_size, len);
+
+    vector<char> buf(len);
+    size_t used = 0;
+    err = hs_compress_stream(stream, buf.data(), buf.size() - 1, &used);
+    ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+    ASSERT_EQ(len, used);
+
+    err = hs_compress_stream(stream, buf.data(), buf.size(), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(len, used);
+
+    err = hs_expand_stream(db, &stream2, buf.data(), used);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream2 != nullptr);
+
+    // both streams continue from the same point
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(2U, c.matches.size());
+    ASSERT_EQ(MatchRecord(13, 0), c.matches[0]);
+    ASSERT_EQ(MatchRecord(19, 0), c.matches[1]);
+
+    c.matches.clear();
+
+    err = hs_scan_stream(stream2, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(2U, c.matches.size());
+    ASSERT_EQ(MatchRecord(13, 0), c.matches[0]);
+    ASSERT_EQ(MatchRecord(19, 0), c.matches[1]);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    hs_close_stream(stream2, scratch, nullptr, nullptr);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// Active engines (an outfix part-way through a match and a rose with history)
+// must survive the round trip.
+TEST(StreamUtil, compress_expand_engines) {
+    hs_error_t err;
+    vector<pattern> patterns;
+    patterns.push_back(pattern("abc.*def", 0, 1));
+    patterns.push_back(pattern("x[a-z]{10}y", 0, 2));
+    patterns.push_back(pattern("(ab|cd)[^\\n]{4,}ef$", 0, 3));
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const char *writes[] = { "zzabcxqwer", "tyuio", "pyzzdefcdzzz", "zzef" };
+
+    // reference: a stream scanned without interruption
+    CallBackContext expected;
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    for (const char *w : writes) {
+        err = hs_scan_stream(stream, w, strlen(w), 0, scratch, record_cb,
+                             (void *)&expected);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&expected);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_FALSE(expected.matches.empty());
+
+    // compress and expand the stream between every write
+    CallBackContext c;
+    stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    for (const char *w : writes) {
+        err = hs_scan_stream(stream, w, strlen(w), 0, scratch, record_cb,
+                             (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        size_t len = 0;
+        err = hs_compress_stream(stream, nullptr, 0, &len);
+        ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+        vector<char> buf(len);
+        err = hs_compress_stream(stream, buf.data(), buf.size(), &len);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        err = hs_close_stream(stream, nullptr, nullptr, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+        stream = nullptr;
+
+        err = hs_expand_stream(db, &stream, buf.data(), buf.size());
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_EQ(expected.matches, c.matches);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, compress_reset_expand) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar$", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    hs_stream_t *stream2 = nullptr;
+
+    CallBackContext c;
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_open_stream(db, 0, &stream2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_scan_stream(stream, data1, strlen(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, c.matches.size());
+
+    size_t len = 0;
+    hs_compress_stream(stream2, nullptr, 0, &len);
+    vector<char> buf(len);
+    err = hs_compress_stream(stream2, buf.data(), buf.size(), &len);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // stream is reset, delivering its EOD match, and takes on the state of
+    // the fresh stream2
+    err = hs_reset_and_expand_stream(stream, buf.data(), buf.size(), scratch,
+                                     record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(9, 0), c.matches[0]);
+
+    c.matches.clear();
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, c.matches.size());
+
+    hs_close_stream(stream2, scratch, nullptr, nullptr);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, expand_bad_image) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, dummy_cb,
+                         nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    size_t len = 0;
+    hs_compress_stream(stream, nullptr, 0, &len);
+    vector<char> buf(len);
+    err = hs_compress_stream(stream, buf.data(), buf.size(), &len);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_stream_t *stream2 = nullptr;
+
+    // truncated
+    err = hs_expand_stream(db, &stream2, buf.data(), buf.size() - 1);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_EQ(nullptr, stream2);
+
+    // trailing garbage
+    vector<char> longer(buf);
+    longer.push_back('x');
+    err = hs_expand_stream(db, &stream2, longer.data(), longer.size());
+    ASSERT_EQ(HS_INVALID, err);
+
+    // corrupt header
+    vector<char> corrupt(buf);
+    corrupt[0] ^= 0xff;
+    err = hs_expand_stream(db, &stream2, corrupt.data(), corrupt.size());
+    ASSERT_EQ(HS_INVALID, err);
+
+    // a rejected image leaves the target stream alone
+    err = hs_reset_and_expand_stream(stream, corrupt.data(), corrupt.size(),
+                                     nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    CallBackContext c;
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(2U, c.matches.size());
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, open_at) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar$", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    size_t stream_size;
+    err = hs_stream_size(db, &stream_size);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    vector<unsigned long long> mem(stream_size / 8 + 1);
+    char *buf = (char *)mem.data();
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream_at(db, 0, buf, stream_size - 1, &stream);
+    ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+    ASSERT_EQ(nullptr, stream);
+    err = hs_open_stream_at(db, 0, buf + 1, stream_size, &stream);
+    ASSERT_EQ(HS_BAD_ALIGN, err);
+    ASSERT_EQ(nullptr, stream);
+
+    err = hs_open_stream_at(db, 0, buf, stream_size, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ((hs_stream_t *)buf, stream);
+
+    CallBackContext c;
+    err = hs_scan_stream(stream, data1, strlen(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, c.matches.size());
+
+    err = hs_close_stream_at(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(9, 0), c.matches[0]);
+
+    // the memory can be reused for another stream
+    err = hs_open_stream_at(db, 0, buf, stream_size, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream_at(stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, pool) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar$", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    const unsigned int count = 4;
+    hs_stream_pool_t *pool = nullptr;
+    err = hs_alloc_stream_pool(db, count, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(nullptr, pool);
+
+    vector<hs_stream_t *> streams;
+    for (unsigned int i = 0; i < count; i++) {
+        hs_stream_t *stream = nullptr;
+        err = hs_open_stream_pooled(pool, 0, &stream);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_EQ(0U, (size_t)stream % 64);
+        streams.push_back(stream);
+    }
+
+    // pool is full
+    hs_stream_t *extra = nullptr;
+    err = hs_open_stream_pooled(pool, 0, &extra);
+    ASSERT_EQ(HS_NOMEM, err);
+    ASSERT_EQ(nullptr, extra);
+
+    CallBackContext c;
+    for (auto stream : streams) {
+        err = hs_scan_stream(stream, data1, strlen(data1), 0, scratch,
+                             record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    ASSERT_EQ(0U, c.matches.size());
+
+    err = hs_close_stream_pooled(pool, streams[1], scratch, record_cb,
+                                 (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+
+    // double close
+    err = hs_close_stream_pooled(pool, streams[1], nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // the released slot is reused, and the new stream starts afresh
+    err = hs_open_stream_pooled(pool, 0, &extra);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(streams[1], extra);
+
+    c.matches.clear();
+    for (auto stream : streams) {
+        err = hs_close_stream_pooled(pool, stream, scratch, record_cb,
+                                     (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    ASSERT_EQ(count - 1, c.matches.size());
+
+    hs_free_stream_pool(pool);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, pool_foreign_stream) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_pool_t *pool = nullptr;
+    hs_stream_pool_t *pool2 = nullptr;
+    err = hs_alloc_stream_pool(db, 2, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_alloc_stream_pool(db, 2, &pool2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_stream_t *pooled = nullptr;
+    err = hs_open_stream_pooled(pool, 0, &pooled);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // neither a heap stream nor another pool's stream can be released here
+    err = hs_close_stream_pooled(pool, stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_close_stream_pooled(pool2, pooled, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_close_stream_pooled(pool, pooled, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    hs_free_stream_pool(pool);
+    hs_free_stream_pool(pool2);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
 static size_t last_alloc;
 
 static
@@ -768,4 +1146,113 @@ TEST(StreamUtil, StreamAllocUsage) {
     ASSERT_EQ(0, alloc3_called);
 }
 
+
+TEST(StreamUtil, scan_streams1) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    const size_t numStreams = 3;
+    hs_stream_t *streams[numStreams];
+    CallBackContext c[numStreams];
+    for (size_t i = 0; i < numStreams; i++) {
+        err = hs_open_stream(db, 0, &streams[i]);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    // writes to the same stream are scanned in order, so only streams 0 and
+    // 2 see "foo" followed by "bar".
+    const hs_stream_block_t writes[] = {
+        { streams[0], "foo", 3, &c[0] },
+        { streams[1], "bar", 3, &c[1] },
+        { streams[2], "xfoo", 4, &c[2] },
+        { streams[0], "xbar", 4, &c[0] },
+        { streams[1], "foo", 3, &c[1] },
+        { streams[2], "bar", 3, &c[2] },
+    };
+
+    err = hs_scan_streams(writes, 6, 0, scratch, record_cb);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_EQ(1U, c[0].matches.size());
+    ASSERT_EQ(MatchRecord(7, 0), c[0].matches[0]);
+    ASSERT_EQ(0U, c[1].matches.size());
+    ASSERT_EQ(1U, c[2].matches.size());
+    ASSERT_EQ(MatchRecord(7, 0), c[2].matches[0]);
+
+    for (size_t i = 0; i < numStreams; i++) {
+        hs_close_stream(streams[i], scratch, nullptr, nullptr);
+    }
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, scan_streams_terminated) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    hs_stream_t *stream2 = nullptr;
+    CallBackContext c, c2;
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_open_stream(db, 0, &stream2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // stream is terminated by its first match; stream2 carries on.
+    c.halt = 1;
+    const hs_stream_block_t writes[] = {
+        { stream, "foofoo", 6, &c },
+        { stream2, "foo", 3, &c2 },
+        { stream, "foo", 3, &c },
+        { stream2, "foo", 3, &c2 },
+    };
+
+    err = hs_scan_streams(writes, 4, 0, scratch, record_cb);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(3, 0), c.matches[0]);
+    ASSERT_EQ(2U, c2.matches.size());
+    ASSERT_EQ(MatchRecord(3, 0), c2.matches[0]);
+    ASSERT_EQ(MatchRecord(6, 0), c2.matches[1]);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    hs_close_stream(stream2, scratch, nullptr, nullptr);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, scan_streams_bad_args) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const hs_stream_block_t writes[] = {
+        { stream, "foo", 3, nullptr },
+        { nullptr, "foo", 3, nullptr },
+    };
+
+    err = hs_scan_streams(nullptr, 1, 0, scratch, dummy_cb);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_streams(writes, 1, 0, nullptr, dummy_cb);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_streams(writes, 2, 0, scratch, dummy_cb);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_streams(writes, 0, 0, scratch, dummy_cb);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
 }
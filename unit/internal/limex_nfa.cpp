@@ -86,7 +86,7 @@ protected:
 
         full_state = aligned_zmalloc_unique<char>(nfa->scratchStateSize);
         stream_state = aligned_zmalloc_unique<char>(nfa->streamStateSize);
-        nfa_context = aligned_zmalloc_unique<void>(sizeof(NFAContext512));
+        nfa_context = aligned_zmalloc_unique<void>(sizeof(NFAContext1024));
 
         // Mock up a scratch structure that contains the pieces that we need
         // for NFA execution.
@@ -139,7 +139,7 @@ protected:
 
 INSTANTIATE_TEST_CASE_P(
     LimEx, LimExModelTest,
-    Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_512_7));
+    Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_1024_7));
 
 TEST_P(LimExModelTest, StateSize) {
     ASSERT_TRUE(nfa != nullptr);
@@ -334,7 +334,7 @@ protected:
         nfa = constructReversedNFA(g_rev, type, cc);
         ASSERT_TRUE(nfa != nullptr);
 
-        nfa_context = aligned_zmalloc_unique<void>(sizeof(NFAContext512));
+        nfa_context = aligned_zmalloc_unique<void>(sizeof(NFAContext1024));
 
         // Mock up a scratch structure that contains the pieces that we need
         // for reverse NFA execution.
@@ -359,7 +359,7 @@ protected:
 };
 
 INSTANTIATE_TEST_CASE_P(LimExReverse, LimExReverseTest,
-                        Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_512_7));
+                        Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_1024_7));
 
 TEST_P(LimExReverseTest, BlockExecReverse) {
     ASSERT_TRUE(nfa != nullptr);
@@ -404,7 +404,7 @@ protected:
 
         full_state = aligned_zmalloc_unique<char>(nfa->scratchStateSize);
         stream_state = aligned_zmalloc_unique<char>(nfa->streamStateSize);
-        nfa_context = aligned_zmalloc_unique<void>(sizeof(NFAContext512));
+        nfa_context = aligned_zmalloc_unique<void>(sizeof(NFAContext1024));
 
         // Mock up a scratch structure that contains the pieces that we need
         // for NFA execution.
@@ -456,7 +456,7 @@ protected:
 };
 
 INSTANTIATE_TEST_CASE_P(LimExZombie, LimExZombieTest,
-                        Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_512_7));
+                        Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_1024_7));
 
 TEST_P(LimExZombieTest, GetZombieStatus) {
     ASSERT_TRUE(nfa != nullptr);
@@ -218,3 +218,55 @@ TEST(RDoubleVermicelli, Exec5) {
         }
     }
 }
+
+TEST(RVermicelli, ExecMatchVariableLength) {
+    const size_t maxlen = 200;
+    char t1[maxlen + 80];
+    memset(t1, 'b', sizeof(t1));
+
+    // The 'a' just before the start of the buffer must never be reported.
+    for (size_t start = 1; start < 64; start += 7) {
+        const u8 *buf = (const u8 *)t1 + start;
+        t1[start - 1] = 'a';
+        for (size_t len = 1; len <= maxlen; len++) {
+            const u8 *rv = rvermicelliExec('a', 0, buf, buf + len);
+            ASSERT_EQ(buf - 1, rv);
+
+            for (size_t i = 0; i < len; i += 3) {
+                t1[start + i] = i % 2 ? 'a' : 'A';
+                rv = rvermicelliExec('A', 1, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+
+                rv = rnvermicelliExec('b', 0, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i] = 'b';
+            }
+        }
+        t1[start - 1] = 'b';
+    }
+}
+
+TEST(RDoubleVermicelli, ExecMatchVariableLength) {
+    const size_t maxlen = 200;
+    char t1[maxlen + 80];
+    memset(t1, 'b', sizeof(t1));
+
+    for (size_t start = 0; start < 64; start += 7) {
+        const u8 *buf = (const u8 *)t1 + start;
+        for (size_t len = 16; len <= maxlen; len++) {
+            // pairs in the first 16 bytes are left to the caller to confirm
+            for (size_t i = 17; i < len; i += 3) {
+                t1[start + i - 1] = 'a';
+                t1[start + i] = 'C';
+                const u8 *rv = rvermicelliDoubleExec('a', 'C', 0, buf,
+                                                     buf + len);
+                ASSERT_EQ(buf + i, rv);
+
+                rv = rvermicelliDoubleExec('A', 'C', 1, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i - 1] = 'b';
+                t1[start + i] = 'b';
+            }
+        }
+    }
+}
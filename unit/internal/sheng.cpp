@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "gtest/gtest.h"
+
+#include "grey.h"
+#include "compiler/compiler.h"
+#include "nfagraph/ng.h"
+#include "nfagraph/ng_mcclellan.h"
+#include "nfa/nfa_api.h"
+#include "nfa/nfa_api_util.h"
+#include "nfa/nfa_internal.h"
+#include "nfa/rdfa.h"
+#include "nfa/shengcompile.h"
+#include "scratch.h"
+#include "util/alloc.h"
+#include "util/target_info.h"
+
+extern "C" {
+#include "nfa/sheng.h"
+}
+
+using namespace std;
+using namespace testing;
+using namespace ue2;
+
+// Three matches of "foo.*bar": the newline kills the first "foo", and the
+// second half of the data, starting at the first '^', holds all the "bar"s.
+static const string SCAN_DATA = "___foo______\n___foofoo_foo_^^^^^^^^^^^^^^^^^^^^^^__bar_bar______0_______z_____bar";
+
+static
+int onMatch(u64a, ReportID, void *ctx) {
+    unsigned *matches = (unsigned *)ctx;
+    (*matches)++;
+    return MO_CONTINUE_MATCHING;
+}
+
+// The DFA for "foo.*bar" has few enough states for Sheng, which is built
+// directly here rather than left to the heuristics in Rose that choose
+// between the DFA engines.
+class ShengTest : public Test {
+protected:
+    virtual void SetUp() {
+        matches = 0;
+
+        const string expr = "foo.*bar";
+        const unsigned flags = 0;
+        CompileContext cc(false, false, get_current_target(), Grey());
+        ReportManager rm(cc.grey);
+        ParsedExpression parsed(0, expr.c_str(), flags, 0);
+        unique_ptr<NGWrapper> g = buildWrapper(rm, cc, parsed);
+        ASSERT_TRUE(g != nullptr);
+
+        unique_ptr<raw_dfa> rdfa = buildMcClellan(*g, &rm, cc.grey);
+        ASSERT_TRUE(rdfa != nullptr);
+
+        nfa = shengCompile(*rdfa, cc);
+        ASSERT_TRUE(nfa != nullptr);
+
+        full_state = aligned_zmalloc_unique<char>(nfa->scratchStateSize);
+        stream_state = aligned_zmalloc_unique<char>(nfa->streamStateSize);
+
+        // Mock up a scratch structure: Sheng itself needs none of it.
+        scratch = aligned_zmalloc_unique<hs_scratch>(sizeof(struct hs_scratch));
+    }
+
+    virtual void initQueue() {
+        q.nfa = nfa.get();
+        q.cur = 0;
+        q.end = 0;
+        q.state = full_state.get();
+        q.streamState = stream_state.get();
+        q.offset = 0;
+        q.buffer = (const u8 *)SCAN_DATA.c_str();
+        q.length = SCAN_DATA.size();
+        q.history = nullptr;
+        q.hlength = 0;
+        q.scratch = scratch.get();
+        q.report_current = 0;
+        q.cb = onMatch;
+        q.som_cb = nullptr;
+        q.context = &matches;
+    }
+
+    // Match count
+    unsigned matches;
+
+    // Compiled NFA structure.
+    aligned_unique_ptr<NFA> nfa;
+
+    // Space for full state.
+    aligned_unique_ptr<char> full_state;
+
+    // Space for stream state.
+    aligned_unique_ptr<char> stream_state;
+
+    // Mock scratch.
+    aligned_unique_ptr<hs_scratch> scratch;
+
+    // Queue structure.
+    struct mq q;
+};
+
+TEST_F(ShengTest, EngineType) {
+    ASSERT_TRUE(nfa != nullptr);
+    EXPECT_EQ(SHENG_NFA_0, nfa->type);
+    EXPECT_EQ(1U, nfa->scratchStateSize);
+    EXPECT_EQ(1U, nfa->streamStateSize);
+}
+
+TEST_F(ShengTest, BlockExec) {
+    ASSERT_TRUE(nfa != nullptr);
+
+    nfaExecSheng0_B(nfa.get(), 0, (const u8 *)SCAN_DATA.c_str(),
+                    SCAN_DATA.size(), onMatch, &matches);
+
+    ASSERT_EQ(3, matches);
+}
+
+TEST_F(ShengTest, QueueExec) {
+    ASSERT_TRUE(nfa != nullptr);
+    initQueue();
+    nfaQueueInitState(nfa.get(), &q);
+
+    u64a end = SCAN_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+
+    char rv = nfaQueueExec(nfa.get(), &q, end);
+
+    ASSERT_NE(0, rv);
+    ASSERT_EQ(3, matches);
+}
+
+TEST_F(ShengTest, CompressExpand) {
+    ASSERT_TRUE(nfa != nullptr);
+    initQueue();
+    nfaQueueInitState(nfa.get(), &q);
+
+    // Scan up to the first '^': we are in the middle of "foo.*" there.
+    const size_t mid = SCAN_DATA.find('^');
+    q.length = mid;
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, mid);
+    char rv = nfaQueueExec(nfa.get(), &q, mid);
+    ASSERT_NE(0, rv);
+    ASSERT_EQ(0, matches);
+
+    nfaQueueCompressState(nfa.get(), &q, mid);
+
+    // Expand into a new copy and check that it matches the original
+    // uncompressed state.
+    aligned_unique_ptr<char> state_copy =
+        aligned_zmalloc_unique<char>(nfa->scratchStateSize);
+    char *dest = state_copy.get();
+    memset(dest, 0xff, nfa->scratchStateSize);
+    nfaExpandState(nfa.get(), dest, q.streamState, mid,
+                   queue_prev_byte(&q, mid));
+    ASSERT_TRUE(std::equal(dest, dest + nfa->scratchStateSize,
+                           full_state.get()));
+
+    // Carry on from the expanded state as the next stream write would.
+    memset(full_state.get(), 0, nfa->scratchStateSize);
+    nfaExpandState(nfa.get(), full_state.get(), q.streamState, mid,
+                   queue_prev_byte(&q, mid));
+    initQueue();
+    q.offset = mid;
+    q.buffer = (const u8 *)SCAN_DATA.c_str() + mid;
+    q.length = SCAN_DATA.size() - mid;
+    q.history = (const u8 *)SCAN_DATA.c_str();
+    q.hlength = mid;
+
+    u64a end = q.length;
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_END, end);
+    rv = nfaQueueExec(nfa.get(), &q, end);
+    ASSERT_NE(0, rv);
+    ASSERT_EQ(3, matches);
+}
+
+TEST_F(ShengTest, InitCompressedState0) {
+    ASSERT_TRUE(nfa != nullptr);
+
+    // Trivial case: init at zero, like we do with outfixes.
+    char rv = nfaInitCompressedState(nfa.get(), 0, stream_state.get(), '\0');
+    ASSERT_NE(0, rv);
+}
+
+TEST_F(ShengTest, QueueExecToMatch) {
+    ASSERT_TRUE(nfa != nullptr);
+    initQueue();
+    nfaQueueInitState(nfa.get(), &q);
+
+    u64a end = SCAN_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+
+    for (unsigned i = 0; i < 3; i++) {
+        char rv = nfaQueueExecToMatch(nfa.get(), &q, end);
+        ASSERT_EQ(MO_MATCHES_PENDING, rv);
+        ASSERT_EQ(i, matches);
+        ASSERT_NE(0, nfaInAcceptState(nfa.get(), 0, &q));
+        nfaReportCurrentMatches(nfa.get(), &q);
+        ASSERT_EQ(i + 1, matches);
+    }
+
+    // No more.
+    char rv = nfaQueueExecToMatch(nfa.get(), &q, end);
+    ASSERT_EQ(MO_ALIVE, rv);
+    ASSERT_EQ(3, matches);
+}
+
+TEST_F(ShengTest, QueueExecRose) {
+    ASSERT_TRUE(nfa != nullptr);
+    initQueue();
+
+    // For rose, there's no callback or context.
+    q.cb = nullptr;
+    q.context = nullptr;
+
+    nfaQueueInitState(nfa.get(), &q);
+
+    u64a end = SCAN_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+
+    // The data ends with "bar", so the engine is in an accept state.
+    char rv = nfaQueueExecRose(nfa.get(), &q, 0 /* report id */);
+    ASSERT_EQ(MO_MATCHES_PENDING, rv);
+    pushQueue(&q, MQE_START, end);
+    ASSERT_NE(0, nfaInAcceptState(nfa.get(), 0, &q));
+}
+
+TEST_F(ShengTest, CheckFinalState) {
+    ASSERT_TRUE(nfa != nullptr);
+    initQueue();
+    nfaQueueInitState(nfa.get(), &q);
+
+    u64a end = SCAN_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+    nfaQueueExec(nfa.get(), &q, end);
+    ASSERT_EQ(3, matches);
+
+    // "foo.*bar" has no EOD reports, so no more matches are raised.
+    nfaCheckFinalState(nfa.get(), full_state.get(), stream_state.get(), end,
+                       onMatch, nullptr, &matches);
+    ASSERT_EQ(3, matches);
+}
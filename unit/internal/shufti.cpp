@@ -975,3 +975,99 @@ TEST(ReverseShufti, ExecMatch6) {
         ASSERT_EQ((const u8 *)t1 + i, rv);
     }
 }
+
+TEST(Shufti, ExecMatchVariableLength) {
+    m128 lo, hi;
+
+    CharReach chars;
+    chars.set('a');
+
+    int ret = shuftiBuildMasks(chars, &lo, &hi);
+    ASSERT_NE(-1, ret);
+
+    // Covers the short and wide block paths at a range of alignments; the
+    // 'a' just past the end of the buffer must never be reported.
+    const size_t maxlen = 200;
+    char t1[maxlen + 80];
+    memset(t1, 'b', sizeof(t1));
+
+    for (size_t start = 0; start < 64; start += 7) {
+        const u8 *buf = (const u8 *)t1 + start;
+        for (size_t len = 1; len <= maxlen; len++) {
+            t1[start + len] = 'a';
+            const u8 *rv = shuftiExec(lo, hi, buf, buf + len);
+            ASSERT_EQ(buf + len, rv);
+
+            for (size_t i = 0; i < len; i += 3) {
+                t1[start + i] = 'a';
+                rv = shuftiExec(lo, hi, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i] = 'b';
+            }
+            t1[start + len] = 'b';
+        }
+    }
+}
+
+TEST(DoubleShufti, ExecMatchVariableLength) {
+    m128 lo1, hi1, lo2, hi2;
+
+    flat_set<pair<u8, u8>> lits;
+    lits.insert(make_pair('x', 'y'));
+
+    shuftiBuildDoubleMasks(CharReach(), lits, &lo1, &hi1, &lo2, &hi2);
+
+    const size_t maxlen = 200;
+    char t1[maxlen + 64];
+    memset(t1, 'b', sizeof(t1));
+
+    for (size_t start = 0; start < 64; start += 7) {
+        const u8 *buf = (const u8 *)t1 + start;
+        for (size_t len = 64; len <= maxlen; len++) {
+            const u8 *rv = shuftiDoubleExec(lo1, hi1, lo2, hi2, buf, buf + len);
+            ASSERT_EQ(buf + len, rv);
+
+            for (size_t i = 0; i + 1 < len; i += 3) {
+                t1[start + i] = 'x';
+                t1[start + i + 1] = 'y';
+                rv = shuftiDoubleExec(lo1, hi1, lo2, hi2, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i] = 'b';
+                t1[start + i + 1] = 'b';
+            }
+        }
+    }
+}
+
+TEST(ReverseShufti, ExecMatchVariableLength) {
+    m128 lo, hi;
+
+    CharReach chars;
+    chars.set('a');
+
+    int ret = shuftiBuildMasks(chars, &lo, &hi);
+    ASSERT_NE(-1, ret);
+
+    // As above, but the 'a' that must not be reported is just before the
+    // start of the buffer.
+    const size_t maxlen = 200;
+    char t1[maxlen + 80];
+    memset(t1, 'b', sizeof(t1));
+
+    for (size_t start = 1; start < 64; start += 7) {
+        const u8 *buf = (const u8 *)t1 + start;
+        t1[start - 1] = 'a';
+        for (size_t len = 1; len <= maxlen; len++) {
+            const u8 *rv = rshuftiExec(lo, hi, buf, buf + len);
+            ASSERT_EQ(buf - 1, rv);
+
+            for (size_t i = 0; i < len; i += 3) {
+                t1[start + i] = 'a';
+                rv = rshuftiExec(lo, hi, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i] = 'b';
+            }
+        }
+        t1[start - 1] = 'b';
+    }
+}
@@ -408,3 +408,83 @@ TEST(state_compress, m512_2) {
         }
     }
 }
+
+TEST(state_compress, m768_1) {
+    char buf[sizeof(m768)] = { 0 };
+
+    for (u32 i = 0; i < 96; i++) {
+        char mask_raw[96] = { 0 };
+        char val_raw[96] = { 0 };
+
+        memset(val_raw, (i << 2) + 3, 96);
+
+        mask_raw[i] = 0xff;
+        val_raw[i] = i;
+
+        mask_raw[95 - i] = 0xff;
+        val_raw[95 - i] = i;
+
+        m768 val;
+        m768 mask;
+
+        memcpy(&val, val_raw, sizeof(val));
+        memcpy(&mask, mask_raw, sizeof(mask));
+
+        storecompressed768(&buf, &val, &mask, 0);
+
+        m768 val_out;
+        loadcompressed768(&val_out, &buf, &mask, 0);
+
+        EXPECT_TRUE(!diff768(and768(val, mask), val_out));
+
+        mask_raw[i] = 0x3;
+        mask_raw[95 - i] = 0x2f;
+        memcpy(&mask, mask_raw, sizeof(mask));
+        val_raw[i] = 3;
+
+        storecompressed768(&buf, &val, &mask, 0);
+        loadcompressed768(&val_out, &buf, &mask, 0);
+
+        EXPECT_TRUE(!diff768(and768(val, mask), val_out));
+    }
+}
+
+TEST(state_compress, m1024_1) {
+    char buf[sizeof(m1024)] = { 0 };
+
+    for (u32 i = 0; i < 128; i++) {
+        char mask_raw[128] = { 0 };
+        char val_raw[128] = { 0 };
+
+        memset(val_raw, (i << 2) + 3, 128);
+
+        mask_raw[i] = 0xff;
+        val_raw[i] = i;
+
+        mask_raw[127 - i] = 0xff;
+        val_raw[127 - i] = i;
+
+        m1024 val;
+        m1024 mask;
+
+        memcpy(&val, val_raw, sizeof(val));
+        memcpy(&mask, mask_raw, sizeof(mask));
+
+        storecompressed1024(&buf, &val, &mask, 0);
+
+        m1024 val_out;
+        loadcompressed1024(&val_out, &buf, &mask, 0);
+
+        EXPECT_TRUE(!diff1024(and1024(val, mask), val_out));
+
+        mask_raw[i] = 0x3;
+        mask_raw[127 - i] = 0x2f;
+        memcpy(&mask, mask_raw, sizeof(mask));
+        val_raw[i] = 3;
+
+        storecompressed1024(&buf, &val, &mask, 0);
+        loadcompressed1024(&val_out, &buf, &mask, 0);
+
+        EXPECT_TRUE(!diff1024(and1024(val, mask), val_out));
+    }
+}
@@ -614,3 +614,69 @@ TEST(ReverseTruffle, ExecMatch5) {
         ASSERT_EQ((const u8 *)t1 + i, rv);
     }
 }
+
+TEST(Truffle, ExecMatchVariableLength) {
+    m128 mask1, mask2;
+
+    CharReach chars;
+    chars.set('a');
+    chars.set(0xf0);
+
+    truffleBuildMasks(chars, &mask1, &mask2);
+
+    // Covers the short and wide block paths at a range of alignments; the
+    // 'a' just past the end of the buffer must never be reported.
+    const size_t maxlen = 200;
+    u8 t1[maxlen + 80];
+    memset(t1, 'b', sizeof(t1));
+
+    for (size_t start = 0; start < 64; start += 7) {
+        const u8 *buf = t1 + start;
+        for (size_t len = 1; len <= maxlen; len++) {
+            t1[start + len] = 'a';
+            const u8 *rv = truffleExec(mask1, mask2, buf, buf + len);
+            ASSERT_EQ(buf + len, rv);
+
+            for (size_t i = 0; i < len; i += 3) {
+                t1[start + i] = i % 2 ? 'a' : 0xf0;
+                rv = truffleExec(mask1, mask2, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i] = 'b';
+            }
+            t1[start + len] = 'b';
+        }
+    }
+}
+
+TEST(ReverseTruffle, ExecMatchVariableLength) {
+    m128 mask1, mask2;
+
+    CharReach chars;
+    chars.set('a');
+    chars.set(0xf0);
+
+    truffleBuildMasks(chars, &mask1, &mask2);
+
+    // As above, but the 'a' that must not be reported is just before the
+    // start of the buffer.
+    const size_t maxlen = 200;
+    u8 t1[maxlen + 80];
+    memset(t1, 'b', sizeof(t1));
+
+    for (size_t start = 1; start < 64; start += 7) {
+        const u8 *buf = t1 + start;
+        t1[start - 1] = 'a';
+        for (size_t len = 1; len <= maxlen; len++) {
+            const u8 *rv = rtruffleExec(mask1, mask2, buf, buf + len);
+            ASSERT_EQ(buf - 1, rv);
+
+            for (size_t i = 0; i < len; i += 3) {
+                t1[start + i] = i % 2 ? 'a' : 0xf0;
+                rv = rtruffleExec(mask1, mask2, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i] = 'b';
+            }
+        }
+        t1[start - 1] = 'b';
+    }
+}
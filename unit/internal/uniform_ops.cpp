@@ -46,6 +46,8 @@ TEST(Uniform, Sizes) {
     EXPECT_EQ(16U, sizeof(m128));
     EXPECT_EQ(32U, sizeof(m256));
     EXPECT_EQ(64U, sizeof(m512));
+    EXPECT_EQ(96U, sizeof(m768));
+    EXPECT_EQ(128U, sizeof(m1024));
 }
 
 TEST(Uniform, loadstore_u8) {
@@ -153,6 +155,24 @@ TEST(Uniform, loadstore_m512) {
     }
 }
 
+TEST(Uniform, loadstore_m1024) {
+    union {
+        m1024 simd;
+        u32 words[1024/32];
+    } in;
+    for (int i = 0; i < 1024; i++) {
+        memset(&in, 0, sizeof(in));
+        in.words[i/32] = 1 << (i % 32);
+        const char *cin = (const char *)(&in);
+        m1024 out = load_m1024(cin);
+        EXPECT_EQ(0, memcmp(&out, &in, sizeof(out)));
+        void *stored = aligned_zmalloc(1024/8);
+        store_m1024(stored, in.simd);
+        EXPECT_EQ(0, memcmp(stored, &in, sizeof(in)));
+        aligned_free(stored);
+    }
+}
+
 TEST(Uniform, testbit_u32) {
     for (u32 i = 0; i < 32; i++) {
         u32 v = 0;
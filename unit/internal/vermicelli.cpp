@@ -345,3 +345,54 @@ TEST(NVermicelli, Exec4) {
     }
 }
 
+TEST(Vermicelli, ExecMatchVariableLength) {
+    const size_t maxlen = 200;
+    char t1[maxlen + 80];
+    memset(t1, 'b', sizeof(t1));
+
+    // The 'a' just past the end of the buffer must never be reported.
+    for (size_t start = 0; start < 64; start += 7) {
+        const u8 *buf = (const u8 *)t1 + start;
+        for (size_t len = 1; len <= maxlen; len++) {
+            t1[start + len] = 'a';
+            const u8 *rv = vermicelliExec('a', 0, buf, buf + len);
+            ASSERT_EQ(buf + len, rv);
+
+            for (size_t i = 0; i < len; i += 3) {
+                t1[start + i] = i % 2 ? 'a' : 'A';
+                rv = vermicelliExec('A', 1, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+
+                rv = nvermicelliExec('b', 0, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i] = 'b';
+            }
+            t1[start + len] = 'b';
+        }
+    }
+}
+
+TEST(DoubleVermicelli, ExecMatchVariableLength) {
+    const size_t maxlen = 200;
+    char t1[maxlen + 80];
+    memset(t1, 'b', sizeof(t1));
+
+    for (size_t start = 0; start < 64; start += 7) {
+        const u8 *buf = (const u8 *)t1 + start;
+        for (size_t len = 16; len <= maxlen; len++) {
+            // pairs in the final 16 bytes are left to the caller to confirm
+            for (size_t i = 0; i + 17 < len; i += 3) {
+                t1[start + i] = 'a';
+                t1[start + i + 1] = 'C';
+                const u8 *rv = vermicelliDoubleExec('a', 'C', 0, buf,
+                                                    buf + len);
+                ASSERT_EQ(buf + i, rv);
+
+                rv = vermicelliDoubleExec('A', 'C', 1, buf, buf + len);
+                ASSERT_EQ(buf + i, rv);
+                t1[start + i] = 'b';
+                t1[start + i + 1] = 'b';
+            }
+        }
+    }
+}